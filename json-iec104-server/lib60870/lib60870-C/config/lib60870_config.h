@@ -61,10 +61,28 @@
 #define CONFIG_CS104_SUPPORT_SERVER_MODE_CONNECTION_IS_REDUNDANCY_GROUP 1
 
 /**
- * Set the maximum number of client connections
+ * Set the default maximum number of client connections (initial size of the connection table).
+ * CS104_Slave_setMaxOpenConnections can enlarge the table before the server is started.
  */
 #define CONFIG_CS104_MAX_CLIENT_CONNECTIONS 5
 
+/**
+ * Size of the receive buffer of each client connection (only CS104 server).
+ * All APDUs that fit into the buffer are received with a single socket read.
+ * Has to be at least 256 bytes (the maximum APDU size).
+ */
+#define CONFIG_CS104_RECEIVE_BUFFER_SIZE 1024
+
+/**
+ * Compile library with support for the epoll based reactor mode (only CS104 server, Linux only).
+ * See CS104_Slave_setReactorThreads.
+ */
+#ifdef __linux__
+#define CONFIG_CS104_SUPPORT_REACTOR_MODE 1
+#else
+#define CONFIG_CS104_SUPPORT_REACTOR_MODE 0
+#endif
+
 /* activate TCP keep alive mechanism. 1 -> activate */
 #define CONFIG_ACTIVATE_TCP_KEEPALIVE 0
 
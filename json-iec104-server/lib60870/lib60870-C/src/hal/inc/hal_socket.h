@@ -347,6 +347,33 @@ Socket_getPeerAddressStatic(Socket self, char* peerAddressString);
 PAL_API void
 Socket_destroy(Socket self);
 
+/**
+ * \brief get the operating system file descriptor of a socket
+ *
+ * Allows registering the socket with an external event notification mechanism
+ * (e.g. epoll). The descriptor remains owned by the socket instance.
+ *
+ * Implementation of this function is OPTIONAL (required for the CS104 reactor mode).
+ *
+ * \param self the client or connection socket instance
+ *
+ * \return the file descriptor or -1 if not available
+ */
+PAL_API int
+Socket_getFileDescriptor(Socket self);
+
+/**
+ * \brief get the operating system file descriptor of a server socket
+ *
+ * Implementation of this function is OPTIONAL (required for the CS104 reactor mode).
+ *
+ * \param self server socket instance
+ *
+ * \return the file descriptor or -1 if not available
+ */
+PAL_API int
+ServerSocket_getFileDescriptor(ServerSocket self);
+
 /*! @} */
 
 /*! @} */
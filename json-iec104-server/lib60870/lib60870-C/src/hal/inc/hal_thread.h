@@ -43,6 +43,14 @@ typedef void* Semaphore;
 /** Reference to a function that is called when starting the thread */
 typedef void* (*ThreadExecutionFunction) (void*);
 
+/**
+ * \brief Reference to a function that is called in every new thread before its start function
+ *
+ * \param parameter the parameter given to Thread_setStartHandler
+ * \param threadClass the class set with Thread_setClass, or NULL
+ */
+typedef void (*ThreadStartHandler) (void* parameter, const char* threadClass);
+
 /**
  * \brief Create a new Thread instance
  *
@@ -74,6 +82,30 @@ Thread_start(Thread thread);
 PAL_API void
 Thread_destroy(Thread thread);
 
+/**
+ * \brief Set the class of a Thread (e.g. "connection")
+ *
+ * The class is passed to the start handler. It has to be set before the thread
+ * is started and the string has to stay valid while the thread exists.
+ *
+ * \param thread the Thread instance
+ * \param threadClass a static string naming the kind of thread
+ */
+PAL_API void
+Thread_setClass(Thread thread, const char* threadClass);
+
+/**
+ * \brief Install a function that is called in every new thread before its start function
+ *
+ * Allows the application to apply scheduling settings (e.g. CPU affinity or priority)
+ * to threads created inside the library. Install before any thread is started.
+ *
+ * \param handler the handler, or NULL to remove it
+ * \param parameter a parameter that is passed to the handler
+ */
+PAL_API void
+Thread_setStartHandler(ThreadStartHandler handler, void* parameter);
+
 /**
  * \brief Suspend execution of the Thread for the specified number of milliseconds
  */
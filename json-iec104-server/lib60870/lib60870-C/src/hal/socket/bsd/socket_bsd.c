@@ -632,6 +632,18 @@ Socket_write(Socket self, uint8_t* buf, int size)
         return retVal;
 }
 
+int
+Socket_getFileDescriptor(Socket self)
+{
+    return self->fd;
+}
+
+int
+ServerSocket_getFileDescriptor(ServerSocket self)
+{
+    return self->fd;
+}
+
 void
 Socket_destroy(Socket self)
 {
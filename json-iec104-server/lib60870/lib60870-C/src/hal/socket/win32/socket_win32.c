@@ -653,6 +653,21 @@ Socket_write(Socket self, uint8_t* buf, int size)
     return bytes_sent;
 }
 
+int
+Socket_getFileDescriptor(Socket self)
+{
+    /* SOCKET handles cannot be used with the CS104 reactor mode */
+    (void)self;
+    return -1;
+}
+
+int
+ServerSocket_getFileDescriptor(ServerSocket self)
+{
+    (void)self;
+    return -1;
+}
+
 void
 Socket_destroy(Socket self)
 {
@@ -26,8 +26,12 @@ struct sThread {
    pthread_t pthread;
    int state;
    bool autodestroy;
+   const char* threadClass;
 };
 
+static ThreadStartHandler startHandler = NULL;
+static void* startHandlerParameter = NULL;
+
 typedef struct sSemaphore* mSemaphore;
 
 struct sSemaphore
@@ -102,16 +106,36 @@ Thread_create(ThreadExecutionFunction function, void* parameter, bool autodestro
         thread->function = function;
         thread->state = 0;
         thread->autodestroy = autodestroy;
+        thread->threadClass = NULL;
    }
 
    return thread;
 }
 
+static void
+runStartHandler(Thread thread)
+{
+    if (startHandler)
+        startHandler(startHandlerParameter, thread->threadClass);
+}
+
+static void*
+threadRunner(void* parameter)
+{
+    Thread thread = (Thread) parameter;
+
+    runStartHandler(thread);
+
+    return thread->function(thread->parameter);
+}
+
 static void*
 destroyAutomaticThread(void* parameter)
 {
     Thread thread = (Thread) parameter;
 
+    runStartHandler(thread);
+
     thread->function(thread->parameter);
 
     GLOBAL_FREEMEM(thread);
@@ -127,11 +151,24 @@ Thread_start(Thread thread)
        pthread_detach(thread->pthread);
    }
    else
-       pthread_create(&thread->pthread, NULL, thread->function, thread->parameter);
+       pthread_create(&thread->pthread, NULL, threadRunner, thread);
 
    thread->state = 1;
 }
 
+void
+Thread_setClass(Thread thread, const char* threadClass)
+{
+    thread->threadClass = threadClass;
+}
+
+void
+Thread_setStartHandler(ThreadStartHandler handler, void* parameter)
+{
+    startHandler = handler;
+    startHandlerParameter = parameter;
+}
+
 void
 Thread_destroy(Thread thread)
 {
@@ -17,13 +17,26 @@ struct sThread {
 	HANDLE handle;
 	int state;
 	bool autodestroy;
+	const char* threadClass;
 };
 
+static ThreadStartHandler startHandler = NULL;
+static void* startHandlerParameter = NULL;
+
+static void
+runStartHandler(Thread thread)
+{
+	if (startHandler)
+		startHandler(startHandlerParameter, thread->threadClass);
+}
+
 static DWORD WINAPI
 destroyAutomaticThreadRunner(LPVOID parameter)
 {
 	Thread thread = (Thread) parameter;
 
+	runStartHandler(thread);
+
 	thread->function(thread->parameter);
 
 	thread->state = 0;
@@ -38,6 +51,8 @@ threadRunner(LPVOID parameter)
 {
 	Thread thread = (Thread) parameter;
 
+	runStartHandler(thread);
+
 	thread->function(thread->parameter);
 
 	return (DWORD)0;
@@ -53,6 +68,7 @@ Thread_create(ThreadExecutionFunction function, void* parameter, bool autodestro
 	thread->function = function;
 	thread->state = 0;
 	thread->autodestroy = autodestroy;
+	thread->threadClass = NULL;
 
 	if (autodestroy == true)
 		thread->handle = CreateThread(0, 0, destroyAutomaticThreadRunner, thread, CREATE_SUSPENDED, &threadId);
@@ -69,6 +85,19 @@ Thread_start(Thread thread)
 	ResumeThread(thread->handle);
 }
 
+void
+Thread_setClass(Thread thread, const char* threadClass)
+{
+	thread->threadClass = threadClass;
+}
+
+void
+Thread_setStartHandler(ThreadStartHandler handler, void* parameter)
+{
+	startHandler = handler;
+	startHandlerParameter = parameter;
+}
+
 void
 Thread_destroy(Thread thread)
 {
@@ -24,6 +24,10 @@
 #define _CRT_NONSTDC_NO_DEPRECATE
 #endif
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* pthread_setaffinity_np (reactor mode) */
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -53,11 +57,101 @@
 #error Illegal configuration: Define either CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP or CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP or CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS
 #endif
 
+#ifndef CONFIG_CS104_RECEIVE_BUFFER_SIZE
+#define CONFIG_CS104_RECEIVE_BUFFER_SIZE 1024
+#endif
+
+#if (CONFIG_CS104_RECEIVE_BUFFER_SIZE < 256)
+#error Illegal configuration: CONFIG_CS104_RECEIVE_BUFFER_SIZE has to hold at least one APDU (256 bytes)
+#endif
+
+#ifndef CONFIG_CS104_SUPPORT_REACTOR_MODE
+#define CONFIG_CS104_SUPPORT_REACTOR_MODE 0
+#endif
+
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+#if (CONFIG_USE_THREADS != 1) || (CONFIG_USE_SEMAPHORES != 1)
+#error Illegal configuration: CONFIG_CS104_SUPPORT_REACTOR_MODE requires CONFIG_USE_THREADS and CONFIG_USE_SEMAPHORES
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif /* (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1) */
+
+/* connection statistics are written by the connection's thread and read by monitoring threads */
+#if defined(__GNUC__)
+#define STATS_ADD(counter, value) __atomic_fetch_add((counter), (value), __ATOMIC_RELAXED)
+#define STATS_LOAD(counter) __atomic_load_n((counter), __ATOMIC_RELAXED)
+#define STATS_STORE(counter, value) __atomic_store_n((counter), (value), __ATOMIC_RELAXED)
+#else
+#define STATS_ADD(counter, value) (*(counter) += (value))
+#define STATS_LOAD(counter) (*(counter))
+#define STATS_STORE(counter, value) (*(counter) = (value))
+#endif
+
 typedef struct sMasterConnection* MasterConnection;
 
 void
 MasterConnection_close(MasterConnection self);
 
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+
+typedef struct sCS104_Reactor* CS104_Reactor;
+
+typedef enum {
+    REACTOR_SOURCE_LISTEN,
+    REACTOR_SOURCE_WAKEUP,
+    REACTOR_SOURCE_SOCKET,
+    REACTOR_SOURCE_TIMER
+} ReactorSourceType;
+
+/* epoll user data - identifies the object behind a file descriptor */
+struct sReactorSource {
+    ReactorSourceType type;
+    void* object;
+};
+
+struct sCS104_Reactor {
+    CS104_Slave slave;
+    int index;
+
+    int epollFd;
+    int wakeupFd; /* eventfd to interrupt epoll_wait */
+    int wakeupPending; /* set while a wakeup is signaled but not yet handled */
+    int connectionCount; /* entries in connections (written under connectionsLock, read atomic) */
+
+    Thread thread;
+
+    Semaphore connectionsLock; /* protects connections, taken by the accepting reactor and the owner */
+    MasterConnection* connections; /* connections registered with this reactor */
+    MasterConnection* scratch; /* copy of connections for Reactor_getConnections */
+
+    struct sReactorSource wakeupSource;
+    struct sReactorSource listenSource;
+};
+
+/**
+ * Interrupt epoll_wait of the reactor. Multiple wakeups before the reactor
+ * handles the first one cost only one eventfd write.
+ */
+static void
+Reactor_wakeup(CS104_Reactor self)
+{
+    if (__atomic_exchange_n(&(self->wakeupPending), 1, __ATOMIC_ACQ_REL) == 0) {
+        uint64_t value = 1;
+
+        if (write(self->wakeupFd, &value, sizeof(value)) != sizeof(value))
+            DEBUG_PRINT("CS104 SLAVE: failed to wake up reactor %i\n", self->index);
+    }
+}
+
+#endif /* (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1) */
+
 void
 MasterConnection_deactivate(MasterConnection self);
 
@@ -118,6 +212,9 @@ struct sMessageQueue {
     uint64_t entryId; /* ID of next entry; will be increased by one for each new entry */
     uint8_t* buffer;
 
+    int highWaterMark; /* maximum value of entryCounter since creation or last reset */
+    uint64_t droppedEntries; /* number of entries overwritten because the queue was full */
+
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore queueLock;
 #endif
@@ -149,6 +246,9 @@ MessageQueue_create(int maxQueueSize)
 
         self->buffer = (uint8_t*) GLOBAL_CALLOC(1, self->size);
 
+        self->highWaterMark = 0;
+        self->droppedEntries = 0;
+
 #if (CONFIG_USE_SEMAPHORES == 1)
         self->queueLock = Semaphore_create(1);
 #endif
@@ -207,6 +307,45 @@ MessageQueue_getEntryCount(MessageQueue self)
     return count;
 }
 
+static int
+MessageQueue_getHighWaterMark(MessageQueue self, bool reset)
+{
+    int highWaterMark;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->queueLock);
+#endif
+
+    highWaterMark = self->highWaterMark;
+
+    if (reset)
+        self->highWaterMark = self->entryCounter;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->queueLock);
+#endif
+
+    return highWaterMark;
+}
+
+static uint64_t
+MessageQueue_getDroppedEntries(MessageQueue self)
+{
+    uint64_t droppedEntries;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->queueLock);
+#endif
+
+    droppedEntries = self->droppedEntries;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->queueLock);
+#endif
+
+    return droppedEntries;
+}
+
 static int
 MessageQueue_countEntriesUntilEndOfBuffer(MessageQueue self, uint8_t* firstEntry)
 {
@@ -269,7 +408,10 @@ MessageQueue_enqueueASDU(MessageQueue self, CS101_ASDU asdu)
 
             /* remove all entries from last entry to end of buffer */
             if (nextMsgPtr <= self->firstEntry) {
-                self->entryCounter -=  MessageQueue_countEntriesUntilEndOfBuffer(self, self->firstEntry);
+                int removedEntries = MessageQueue_countEntriesUntilEndOfBuffer(self, self->firstEntry);
+
+                self->entryCounter -= removedEntries;
+                self->droppedEntries += removedEntries;
                 self->firstEntry = self->buffer;
             }
 
@@ -286,6 +428,7 @@ MessageQueue_enqueueASDU(MessageQueue self, CS101_ASDU asdu)
             while ((nextMsgPtr + entrySize > self->firstEntry) && (self->entryCounter > 0)) {
 
                 self->entryCounter--;
+                self->droppedEntries++;
 
                 if (self->firstEntry == self->lastInBufferEntry) {
                     self->firstEntry = self->buffer;
@@ -307,6 +450,9 @@ MessageQueue_enqueueASDU(MessageQueue self, CS101_ASDU asdu)
 
     self->entryCounter++;
 
+    if (self->entryCounter > self->highWaterMark)
+        self->highWaterMark = self->entryCounter;
+
     struct sBufferFrame bufferFrame;
 
     Frame frame = BufferFrame_initialize(&bufferFrame, nextMsgPtr + sizeof(struct sMessageQueueEntryInfo), 0);
@@ -1029,7 +1175,11 @@ struct sCS104_Slave {
     int maxHighPrioQueueSize;
 
     int openConnections; /**< number of connected clients */
-    MasterConnection masterConnections[CONFIG_CS104_MAX_CLIENT_CONNECTIONS]; /**< references to all MasterConnection objects */
+    MasterConnection* masterConnections; /**< connection table - MasterConnection objects are created on first use */
+    int connectionTableSize; /**< number of entries in masterConnections */
+    int* freeConnectionSlots; /**< stack of unused masterConnections entries */
+    int freeConnectionSlotCount;
+    MasterConnection* openConnectionList; /**< used connections (openConnections entries) */
 
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore openConnectionsLock;
@@ -1043,6 +1193,9 @@ struct sCS104_Slave {
 
     struct sCS104_APCIParameters conParameters;
 
+    CS104_AckPolicy ackPolicy;
+    int ackDelayMs; /**< maximum delay of an S-frame with CS104_ACK_POLICY_DELAYED */
+
     struct sCS101_AppLayerParameters alParameters;
 
     bool isStarting;
@@ -1067,6 +1220,13 @@ struct sCS104_Slave {
     Thread listeningThread;
 #endif
 
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+    int numberOfReactors; /**< 0 = one thread per connection */
+    bool pinReactorThreads;
+    CS104_Reactor reactors;
+    int nextReactor; /**< first reactor checked for the next accepted connection */
+#endif
+
     ServerSocket serverSocket;
 
     LinkedList plugins;
@@ -1093,6 +1253,9 @@ struct sMasterConnection {
 
     CS104_Slave slave;
 
+    int tableIndex; /* entry in slave->masterConnections */
+    int openListIndex; /* position in slave->openConnectionList while used */
+
     unsigned int isUsed:1;
     unsigned int isActive:1;
     unsigned int isRunning:1;
@@ -1108,16 +1271,31 @@ struct sMasterConnection {
 
     /* timeout T2 handling */
     uint64_t lastConfirmationTime; /* timestamp when the last confirmation message (for I messages) was sent */
+    uint64_t ackDeadline; /* CS104_ACK_POLICY_DELAYED: latest time for the S-frame (UINT64_MAX = none) */
+
+    uint64_t kWindowStallStart; /* time the k-window became full with ASDUs waiting (0 = not full) */
 
     uint64_t nextT3Timeout;
     uint64_t nextTestFRConTimeout; /* timeout T1 when waiting for TEST FR con */
 
     SentASDUSlave* sentASDUs;
 
+    CS104_ConnectionStatistics stats;
+
 #if (CONFIG_USE_THREADS == 1) 
     Thread connectionThread;
 #endif
 
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+    CS104_Reactor reactor; /* reactor handling the connection (NULL = own thread) */
+    int reactorSlot; /* index in reactor->connections */
+    int timerFd; /* timerfd for t1/t2/t3 */
+    uint64_t timerDeadline; /* time the timerfd is armed for (0 = not armed) */
+    struct sReactorSource socketSource;
+    struct sReactorSource timerSource;
+    bool inputPending; /* receive budget used up, socket not drained yet */
+#endif
+
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore sentASDUsLock;
     Semaphore stateLock;
@@ -1125,8 +1303,9 @@ struct sMasterConnection {
 
     HandleSet handleSet;
 
-    uint8_t recvBuffer[260];
-    int recvBufPos;
+    uint8_t recvBuffer[CONFIG_CS104_RECEIVE_BUFFER_SIZE];
+    int recvBufPos; /* start of the first unprocessed message */
+    int recvBufFill; /* number of valid bytes in recvBuffer */
 
     uint8_t sendBuffer[260];
 
@@ -1173,14 +1352,25 @@ initializeMessageQueues(CS104_Slave self, int lowPrioMaxQueueSize, int highPrioM
 #endif /* (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1) */
 
 #if (CONFIG_CS104_SUPPORT_SERVER_MODE_CONNECTION_IS_REDUNDANCY_GROUP == 1)
+static void
+initializeConnectionQueues(CS104_Slave self, MasterConnection con)
+{
+    if (con->lowPrioQueue == NULL)
+        con->lowPrioQueue = MessageQueue_create(self->maxLowPrioQueueSize);
+
+    if (con->highPrioQueue == NULL)
+        con->highPrioQueue = HighPriorityASDUQueue_create(self->maxHighPrioQueueSize);
+}
+
 static void
 initializeConnectionSpecificQueues(CS104_Slave self)
 {
     int i;
 
-    for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-        self->masterConnections[i]->lowPrioQueue = MessageQueue_create(self->maxLowPrioQueueSize);
-        self->masterConnections[i]->highPrioQueue = HighPriorityASDUQueue_create(self->maxHighPrioQueueSize);
+    /* connections that are created later get their queues in getFreeConnection */
+    for (i = 0; i < self->connectionTableSize; i++) {
+        if (self->masterConnections[i])
+            initializeConnectionQueues(self, self->masterConnections[i]);
     }
 }
 
@@ -1189,7 +1379,10 @@ deleteConnectionSpecificQueues(CS104_Slave self)
 {
     int i;
 
-    for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
+    for (i = 0; i < self->connectionTableSize; i++) {
+        if (self->masterConnections[i] == NULL)
+            continue;
+
         if (self->masterConnections[i]->lowPrioQueue) {
             MessageQueue_destroy(self->masterConnections[i]->lowPrioQueue);
             self->masterConnections[i]->lowPrioQueue = NULL;
@@ -1260,6 +1453,55 @@ isStopRunningSet(CS104_Slave self)
 static MasterConnection
 MasterConnection_create(CS104_Slave slave);
 
+/**
+ * Grow the connection table. Entries are only added, so the table can be
+ * resized while no connection is open. Connection objects are created on first use.
+ */
+static bool
+resizeConnectionTable(CS104_Slave self, int size)
+{
+    if (size <= self->connectionTableSize)
+        return true;
+
+    MasterConnection* table = (MasterConnection*) GLOBAL_REALLOC(self->masterConnections, size * sizeof(MasterConnection));
+
+    if (table == NULL)
+        return false;
+
+    self->masterConnections = table;
+
+    int* freeSlots = (int*) GLOBAL_REALLOC(self->freeConnectionSlots, size * sizeof(int));
+
+    if (freeSlots == NULL)
+        return false;
+
+    self->freeConnectionSlots = freeSlots;
+
+    MasterConnection* openList = (MasterConnection*) GLOBAL_REALLOC(self->openConnectionList, size * sizeof(MasterConnection));
+
+    if (openList == NULL)
+        return false;
+
+    self->openConnectionList = openList;
+
+    int added = size - self->connectionTableSize;
+    int i;
+
+    /* new entries go to the bottom of the free stack so that low indices are reused first */
+    memmove(self->freeConnectionSlots + added, self->freeConnectionSlots, self->freeConnectionSlotCount * sizeof(int));
+
+    for (i = 0; i < added; i++) {
+        self->masterConnections[self->connectionTableSize + i] = NULL;
+        self->freeConnectionSlots[i] = size - 1 - i;
+    }
+
+    self->freeConnectionSlotCount += added;
+
+    self->connectionTableSize = size;
+
+    return true;
+}
+
 static CS104_Slave
 createSlave(int maxLowPrioQueueSize, int maxHighPrioQueueSize)
 {
@@ -1283,15 +1525,24 @@ createSlave(int maxLowPrioQueueSize, int maxHighPrioQueueSize)
         self->maxLowPrioQueueSize = maxLowPrioQueueSize;
         self->maxHighPrioQueueSize = maxHighPrioQueueSize;
 
-        {
-            int i;
-
-            for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-                self->masterConnections[i] = MasterConnection_create(self);
-            }
+        self->masterConnections = NULL;
+        self->connectionTableSize = 0;
+        self->freeConnectionSlots = NULL;
+        self->freeConnectionSlotCount = 0;
+        self->openConnectionList = NULL;
+
+        if (resizeConnectionTable(self, CONFIG_CS104_MAX_CLIENT_CONNECTIONS) == false) {
+            GLOBAL_FREEMEM(self->masterConnections);
+            GLOBAL_FREEMEM(self->freeConnectionSlots);
+            GLOBAL_FREEMEM(self->openConnectionList);
+            GLOBAL_FREEMEM(self);
+            return NULL;
         }
 
         self->maxOpenConnections = CONFIG_CS104_MAX_CLIENT_CONNECTIONS;
+
+        self->ackPolicy = CS104_ACK_POLICY_IMMEDIATE;
+        self->ackDelayMs = 0;
 #if (CONFIG_USE_SEMAPHORES == 1)
         self->openConnectionsLock = Semaphore_create(1);
         self->stateLock = Semaphore_create(1);
@@ -1312,6 +1563,13 @@ createSlave(int maxLowPrioQueueSize, int maxHighPrioQueueSize)
         self->listeningThread = NULL;
 #endif
 
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+        self->numberOfReactors = 0;
+        self->pinReactorThreads = false;
+        self->reactors = NULL;
+        self->nextReactor = 0;
+#endif
+
         self->serverSocket = NULL;
 
         self->plugins = NULL;
@@ -1409,20 +1667,58 @@ CS104_Slave_getOpenConnections(CS104_Slave self)
     return openConnections;
 }
 
+/**
+ * Return a connection to the free slots (caller holds openConnectionsLock)
+ */
 static void
-decreaseConnectionCounter(CS104_Slave self)
+releaseConnection(CS104_Slave self, MasterConnection con)
 {
 #if (CONFIG_USE_SEMAPHORES)
-    Semaphore_wait(self->openConnectionsLock);
+    Semaphore_wait(con->stateLock);
+#endif
+
+    bool isUsed = con->isUsed;
+
+    con->isUsed = false;
+
+#if (CONFIG_USE_SEMAPHORES)
+    Semaphore_post(con->stateLock);
 #endif
 
+    if (isUsed == false && (con->openListIndex < 0))
+        return;
+
+    /* remove from the open connection list by moving the last entry into its place */
+    MasterConnection last = self->openConnectionList[self->openConnections - 1];
+
+    self->openConnectionList[con->openListIndex] = last;
+    last->openListIndex = con->openListIndex;
+    con->openListIndex = -1;
+
     self->openConnections--;
 
+    self->freeConnectionSlots[self->freeConnectionSlotCount++] = con->tableIndex;
+}
+
+static void
+freeConnection(CS104_Slave self, MasterConnection con)
+{
+#if (CONFIG_USE_SEMAPHORES)
+    Semaphore_wait(self->openConnectionsLock);
+#endif
+
+    releaseConnection(self, con);
+
 #if (CONFIG_USE_SEMAPHORES)
     Semaphore_post(self->openConnectionsLock);
 #endif
 }
 
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_CONNECTION_IS_REDUNDANCY_GROUP == 1)
+static void
+initializeConnectionQueues(CS104_Slave self, MasterConnection con);
+#endif
+
 static MasterConnection
 getFreeConnection(CS104_Slave self)
 {
@@ -1432,30 +1728,44 @@ getFreeConnection(CS104_Slave self)
     Semaphore_wait(self->openConnectionsLock);
 #endif
 
-    int i;
+    if (self->freeConnectionSlotCount > 0) {
 
-    for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++)
-    {
-        MasterConnection con = self->masterConnections[i];
+        int index = self->freeConnectionSlots[self->freeConnectionSlotCount - 1];
 
-        if (con) {
-#if (CONFIG_USE_SEMAPHORES)
-            Semaphore_wait(con->stateLock);
+        connection = self->masterConnections[index];
+
+        if (connection == NULL) {
+            connection = MasterConnection_create(self);
+
+            if (connection) {
+                connection->tableIndex = index;
+
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_CONNECTION_IS_REDUNDANCY_GROUP == 1)
+                if (self->serverMode == CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP)
+                    initializeConnectionQueues(self, connection);
 #endif
 
-            if (con->isUsed == false) {
-                connection = con;
-                connection->isUsed = true;
-                self->openConnections++;
+                self->masterConnections[index] = connection;
             }
+        }
+
+        if (connection) {
+            self->freeConnectionSlotCount--;
+
+#if (CONFIG_USE_SEMAPHORES)
+            Semaphore_wait(connection->stateLock);
+#endif
+
+            connection->isUsed = true;
 
 #if (CONFIG_USE_SEMAPHORES)
-            Semaphore_post(con->stateLock);
+            Semaphore_post(connection->stateLock);
 #endif
+
+            connection->openListIndex = self->openConnections;
+            self->openConnectionList[self->openConnections] = connection;
+            self->openConnections++;
         }
-        
-        if (connection)
-            break;
     }
 
 #if (CONFIG_USE_SEMAPHORES)
@@ -1468,11 +1778,23 @@ getFreeConnection(CS104_Slave self)
 void
 CS104_Slave_setMaxOpenConnections(CS104_Slave self, int maxOpenConnections)
 {
-    if (CONFIG_CS104_MAX_CLIENT_CONNECTIONS > 0) {
-        if (maxOpenConnections > CONFIG_CS104_MAX_CLIENT_CONNECTIONS)
-            maxOpenConnections = CONFIG_CS104_MAX_CLIENT_CONNECTIONS;
+    /* the connection table can only grow while no connection is open */
+    if ((maxOpenConnections > self->connectionTableSize) && (isRunning(self) == false)) {
+#if (CONFIG_USE_SEMAPHORES)
+        Semaphore_wait(self->openConnectionsLock);
+#endif
+
+        if (resizeConnectionTable(self, maxOpenConnections) == false)
+            DEBUG_PRINT("CS104 SLAVE: failed to resize connection table\n");
+
+#if (CONFIG_USE_SEMAPHORES)
+        Semaphore_post(self->openConnectionsLock);
+#endif
     }
 
+    if (maxOpenConnections > self->connectionTableSize)
+        maxOpenConnections = self->connectionTableSize;
+
     self->maxOpenConnections = maxOpenConnections;
 }
 
@@ -1505,14 +1827,11 @@ CS104_Slave_activate(CS104_Slave self, MasterConnection connectionToActivate)
 #endif
         int i;
 
-        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-            MasterConnection con = self->masterConnections[i];
-
-            if (con) {
-                if (con != connectionToActivate)
-                    MasterConnection_deactivate(con);
-            }
+        for (i = 0; i < self->openConnections; i++) {
+            MasterConnection con = self->openConnectionList[i];
 
+            if (con != connectionToActivate)
+                MasterConnection_deactivate(con);
         }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
@@ -1533,16 +1852,13 @@ CS104_Slave_activate(CS104_Slave self, MasterConnection connectionToActivate)
 
         int i;
 
-        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-            MasterConnection con = self->masterConnections[i];
+        for (i = 0; i < self->openConnections; i++) {
+            MasterConnection con = self->openConnectionList[i];
 
-            if (con) {
-                if (con->redundancyGroup == connectionToActivate->redundancyGroup) {
-                    if (con != connectionToActivate)
-                        MasterConnection_deactivate(con);
-                }
+            if (con->redundancyGroup == connectionToActivate->redundancyGroup) {
+                if (con != connectionToActivate)
+                    MasterConnection_deactivate(con);
             }
-
         }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
@@ -1667,80 +1983,128 @@ readFromSocket(MasterConnection self, uint8_t* buffer, int size)
 }
 
 /**
- * \brief Read message part into receive buffer
+ * \brief Fill the receive buffer with the data that is available on the socket
+ *
+ * A partial message left over from the last read is moved to the start of the buffer
+ * first, so a single read can return any number of complete messages.
  *
- * \return -1 in case of an error, 0 when no complete message can be read, > 0 when a complete message is in buffer
+ * \return number of bytes read, or -1 in case of an error
  */
 static int
-receiveMessage(MasterConnection self)
+fillReceiveBuffer(MasterConnection self)
 {
-    uint8_t* buffer = self->recvBuffer;
-    int bufPos = self->recvBufPos;
-
-    /* read start byte */
-    if (bufPos == 0) {
-        int readFirst = readFromSocket(self, buffer, 1);
+    int readBytes = 0;
 
-        if (readFirst < 1)
-            return readFirst;
+    if (self->recvBufPos > 0) {
+        int remaining = self->recvBufFill - self->recvBufPos;
 
-        if (buffer[0] != 0x68)
-            return -1; /* message error */
+        if (remaining > 0)
+            memmove(self->recvBuffer, self->recvBuffer + self->recvBufPos, remaining);
 
-        bufPos++;
+        self->recvBufFill = remaining;
+        self->recvBufPos = 0;
     }
 
-    /* read length byte */
-    if (bufPos == 1)  {
-        if (readFromSocket(self, buffer + 1, 1) != 1) {
-            self->recvBufPos = 0;
+    while (self->recvBufFill < CONFIG_CS104_RECEIVE_BUFFER_SIZE) {
+        int readCnt = readFromSocket(self, self->recvBuffer + self->recvBufFill,
+                CONFIG_CS104_RECEIVE_BUFFER_SIZE - self->recvBufFill);
+
+        if (readCnt < 0)
             return -1;
-        }
 
-        bufPos++;
+        if (readCnt == 0)
+            break;
+
+        self->recvBufFill += readCnt;
+        readBytes += readCnt;
+
+#if (CONFIG_CS104_SUPPORT_TLS == 1)
+        /* a TLS read returns one record at most - further records can already be buffered by the TLS layer */
+        if (self->tlsSocket != NULL)
+            continue;
+#endif
+
+        break;
     }
 
-    /* read remaining frame */
-    if (bufPos > 1) {
-        int length = buffer[1];
+    return readBytes;
+}
+
+/**
+ * \brief Take the next complete message out of the receive buffer
+ *
+ * The message stays valid until the next call of fillReceiveBuffer.
+ *
+ * \return -1 in case of a framing error, 0 when no complete message is buffered, > 0 size of the message at *msg
+ */
+static int
+getBufferedMessage(MasterConnection self, uint8_t** msg)
+{
+    int available = self->recvBufFill - self->recvBufPos;
+
+    if (available < 1)
+        return 0;
 
-        int remainingLength = length - bufPos + 2;
+    uint8_t* buffer = self->recvBuffer + self->recvBufPos;
 
-        int readCnt = readFromSocket(self, buffer + bufPos, remainingLength);
+    if (buffer[0] != 0x68)
+        return -1; /* message error */
 
-        if (readCnt == remainingLength) {
-            self->recvBufPos = 0;
-            return length + 2;
-        }
-        else if (readCnt == -1) {
-            self->recvBufPos = 0;
-            return -1;
-        }
-        else {
-            self->recvBufPos = bufPos + readCnt;
-            return 0;
-        }
-    }
+    if (available < 2)
+        return 0;
 
-    self->recvBufPos = bufPos;
-    return 0;
+    int msgSize = buffer[1] + 2;
+
+    if (available < msgSize)
+        return 0;
+
+    self->recvBufPos += msgSize;
+
+    *msg = buffer;
+
+    return msgSize;
+}
+
+static void
+countFrame(MasterConnection self, uint8_t* msg, bool sent)
+{
+    CS104_ConnectionStatistics* stats = &(self->stats);
+    uint64_t* counter;
+
+    if ((msg[2] & 0x01) == 0)
+        counter = sent ? &(stats->iFramesSent) : &(stats->iFramesReceived);
+    else if ((msg[2] & 0x03) == 0x01)
+        counter = sent ? &(stats->sFramesSent) : &(stats->sFramesReceived);
+    else
+        counter = sent ? &(stats->uFramesSent) : &(stats->uFramesReceived);
+
+    STATS_ADD(counter, 1);
 }
 
 static int
 writeToSocket(MasterConnection self, uint8_t* buf, int size)
 {
+    int sentBytes;
+
     if (self->slave->rawMessageHandler)
         self->slave->rawMessageHandler(self->slave->rawMessageHandlerParameter,
                 &(self->iMasterConnection), buf, size, true);
 
 #if (CONFIG_CS104_SUPPORT_TLS == 1)
     if (self->tlsSocket)
-        return TLSSocket_write(self->tlsSocket, buf, size);
+        sentBytes = TLSSocket_write(self->tlsSocket, buf, size);
     else
-        return Socket_write(self->socket, buf, size);
+        sentBytes = Socket_write(self->socket, buf, size);
 #else
-    return Socket_write(self->socket, buf, size);
+    sentBytes = Socket_write(self->socket, buf, size);
 #endif
+
+    if (sentBytes > 0) {
+        countFrame(self, buf, true);
+        STATS_ADD(&(self->stats.bytesSent), sentBytes);
+    }
+
+    return sentBytes;
 }
 
 static int
@@ -1762,8 +2126,13 @@ sendIMessage(MasterConnection self, uint8_t* buffer, int msgSize)
     if (writeToSocket(self, buffer, msgSize) > 0) {
         DEBUG_PRINT("CS104 SLAVE: SEND I (size = %i) N(S) = %i N(R) = %i\n", msgSize, self->sendCount, self->receiveCount);
         self->sendCount = (self->sendCount + 1) % 32768;
+
+        if (self->unconfirmedReceivedIMessages > 0)
+            STATS_ADD(&(self->stats.acksPiggybacked), 1);
+
         self->unconfirmedReceivedIMessages = 0;
         self->timeoutT2Triggered = false;
+        self->ackDeadline = UINT64_MAX;
     }
     else
         self->isRunning = false;
@@ -1815,6 +2184,11 @@ sendASDU(MasterConnection self, uint8_t* buffer, int msgSize, uint64_t entryId,
 
     self->newestSentASDU = currentIndex;
 
+    int occupancy = ((self->newestSentASDU - self->oldestSentASDU + self->maxSentASDUs) % self->maxSentASDUs) + 1;
+
+    if (occupancy > self->stats.kWindowHighWaterMark)
+        STATS_STORE(&(self->stats.kWindowHighWaterMark), occupancy);
+
     printSendBuffer(self);
 }
 
@@ -1854,6 +2228,9 @@ sendASDUInternal(MasterConnection self, CS101_ASDU asdu)
             Semaphore_post(self->sentASDUsLock);
 #endif
             asduSent = HighPriorityASDUQueue_enqueue(self->highPrioQueue, asdu);
+
+            if (asduSent == false)
+                STATS_ADD(&(self->stats.highPrioQueueDrops), 1);
         }
 
     }
@@ -2141,6 +2518,27 @@ handleASDU(MasterConnection self, CS101_ASDU asdu)
     return true;
 }
 
+static void
+recordAckRtt(MasterConnection self, uint64_t currentTime, uint64_t sentTime)
+{
+    CS104_ConnectionStatistics* stats = &(self->stats);
+
+    uint64_t rtt = (currentTime > sentTime) ? (currentTime - sentTime) : 0;
+
+    /* bucket 0: < 1 ms, bucket i: [2^(i-1), 2^i) ms */
+    int bucket = 0;
+
+    while ((bucket < CS104_ACK_RTT_HISTOGRAM_BUCKETS - 1) && (rtt >= ((uint64_t) 1 << bucket)))
+        bucket++;
+
+    STATS_ADD(&(stats->ackRttHistogram[bucket]), 1);
+    STATS_ADD(&(stats->ackRttCount), 1);
+    STATS_ADD(&(stats->ackRttSumMs), rtt);
+
+    if (rtt > stats->ackRttMaxMs)
+        STATS_STORE(&(stats->ackRttMaxMs), rtt);
+}
+
 static bool
 checkSequenceNumber(MasterConnection self, int seqNo)
 {
@@ -2187,6 +2585,8 @@ checkSequenceNumber(MasterConnection self, int seqNo)
     if (seqNoIsValid) {
         if (self->oldestSentASDU != -1) {
 
+            uint64_t currentTime = Hal_getTimeInMs();
+
             do {
                 int oldestAsduSeqNo = self->sentASDUs[self->oldestSentASDU].seqNo;
 
@@ -2198,6 +2598,8 @@ checkSequenceNumber(MasterConnection self, int seqNo)
                 if (seqNo == oldestValidSeqNo)
                     break;
 
+                recordAckRtt(self, currentTime, self->sentASDUs[self->oldestSentASDU].sentTime);
+
                 /* remove from server (low-priority) queue if required */
                 if (self->sentASDUs[self->oldestSentASDU].queueEntry != NULL) {
 
@@ -2235,6 +2637,11 @@ checkSequenceNumber(MasterConnection self, int seqNo)
                 }
 
             } while (true);
+
+            if ((self->kWindowStallStart != 0) && (isSentBufferFull(self) == false)) {
+                STATS_ADD(&(self->stats.kWindowStallMs), currentTime - self->kWindowStallStart);
+                self->kWindowStallStart = 0;
+            }
         }
     }
     else
@@ -2366,6 +2773,8 @@ _sendSMessage(MasterConnection self)
     msg[4] = (uint8_t) ((self->receiveCount % 128) * 2);
     msg[5] = (uint8_t) (self->receiveCount / 128);
 
+    self->ackDeadline = UINT64_MAX;
+
     if (writeToSocket(self, msg, 6) < 0)
         self->isRunning = false;
 }
@@ -2610,6 +3019,16 @@ MasterConnection_destroy(MasterConnection self)
     }
 }
 
+/* k-window is full while ASDUs are waiting (sentASDUsLock held) */
+static void
+markWindowStall(MasterConnection self)
+{
+    if (self->kWindowStallStart == 0) {
+        self->kWindowStallStart = Hal_getTimeInMs();
+        STATS_ADD(&(self->stats.kWindowStalls), 1);
+    }
+}
+
 static void
 sendNextLowPriorityASDU(MasterConnection self)
 {
@@ -2619,8 +3038,12 @@ sendNextLowPriorityASDU(MasterConnection self)
 
     uint8_t* asduBuffer;
 
-    if (isSentBufferFull(self))
+    if (isSentBufferFull(self)) {
+        if (MessageQueue_isAsduAvailable(self->lowPrioQueue))
+            markWindowStall(self);
+
         goto exit_function;
+    }
 
     MessageQueue_lock(self->lowPrioQueue);
 
@@ -2660,8 +3083,10 @@ sendNextHighPriorityASDU(MasterConnection self)
     Semaphore_wait(self->sentASDUsLock);
 #endif
 
-    if (isSentBufferFull(self))
+    if (isSentBufferFull(self)) {
+        markWindowStall(self);
         goto exit_function;
+    }
 
     HighPriorityASDUQueue_lock(self->highPrioQueue);
 
@@ -2724,6 +3149,8 @@ handleTimeouts(MasterConnection self)
 
     /* check T3 timeout */
     if (checkT3Timeout(self, currentTime)) {
+        STATS_ADD(&(self->stats.t3Timeouts), 1);
+
         if (writeToSocket(self, TESTFR_ACT_MSG, TESTFR_ACT_MSG_SIZE) < 0) {
 
             DEBUG_PRINT("CS104 SLAVE: Failed to write TESTFR ACT message\n");
@@ -2758,6 +3185,8 @@ handleTimeouts(MasterConnection self)
         if (checkTestFRConTimeout(self, currentTime)) {
             DEBUG_PRINT("CS104 SLAVE: Timeout for TESTFR CON message\n");
 
+            STATS_ADD(&(self->stats.t1Timeouts), 1);
+
             /* close connection */
             timeoutsOk = false;
         }
@@ -2780,6 +3209,14 @@ handleTimeouts(MasterConnection self)
                 _sendSMessage(self);
             }
         }
+
+        /* delayed confirmation was not carried by an I-frame */
+        if ((self->unconfirmedReceivedIMessages > 0) && (currentTime >= self->ackDeadline)) {
+            self->lastConfirmationTime = currentTime;
+            self->unconfirmedReceivedIMessages = 0;
+            self->timeoutT2Triggered = false;
+            _sendSMessage(self);
+        }
     }
 
 #if (CONFIG_USE_SEMAPHORES == 1)
@@ -2805,6 +3242,8 @@ handleTimeouts(MasterConnection self)
             if ((currentTime - self->sentASDUs[self->oldestSentASDU].sentTime) >= (uint64_t) (self->slave->conParameters.t1 * 1000)) {
                 timeoutsOk = false;
 
+                STATS_ADD(&(self->stats.t1Timeouts), 1);
+
                 printSendBuffer(self);
 
                 DEBUG_PRINT("CS104 SLAVE: I message timeout for %i seqNo: %i\n", self->oldestSentASDU,
@@ -2827,24 +3266,103 @@ CS104_Slave_closeAllConnections(CS104_Slave self)
     Semaphore_wait(self->openConnectionsLock);
 #endif
 
-    int i;
+    while (self->openConnections > 0) {
+        MasterConnection con = self->openConnectionList[self->openConnections - 1];
 
-    for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-        if (self->masterConnections[i]) {
-            if (self->masterConnections[i]->isUsed) {
-                self->masterConnections[i]->isUsed = false;
-                MasterConnection_deinit(self->masterConnections[i]);
-            }
-        }
+        MasterConnection_deinit(con);
+        releaseConnection(self, con);
     }
 
-    self->openConnections = 0;
-
 #if (CONFIG_USE_SEMAPHORES)
     Semaphore_post(self->openConnectionsLock);
 #endif
 }
 
+/**
+ * \brief Read available data and handle all complete messages in the receive buffer
+ *
+ * Closes the connection in case of an error.
+ *
+ * \return -1 in case of an error, 0 when the socket has no more data, 1 when the receive
+ * buffer was filled completely (more data can be waiting on the socket)
+ */
+static int
+MasterConnection_handleReceivedData(MasterConnection self)
+{
+    int readCnt = fillReceiveBuffer(self);
+
+    if (readCnt < 0) {
+        DEBUG_PRINT("CS104 SLAVE: Error reading from socket\n");
+        MasterConnection_close(self);
+        return -1;
+    }
+
+    STATS_ADD(&(self->stats.bytesReceived), readCnt);
+
+    bool bufferFull = (self->recvBufFill == CONFIG_CS104_RECEIVE_BUFFER_SIZE);
+
+    uint8_t* msg;
+    int msgSize;
+
+    while ((msgSize = getBufferedMessage(self, &msg)) > 0) {
+
+        DEBUG_PRINT("CS104 SLAVE: Connection: rcvd msg(%i bytes)\n", msgSize);
+
+        countFrame(self, msg, false);
+
+        if (self->slave->rawMessageHandler)
+            self->slave->rawMessageHandler(self->slave->rawMessageHandlerParameter,
+                    &(self->iMasterConnection), msg, msgSize, false);
+
+        if (handleMessage(self, msg, msgSize) == false) {
+            MasterConnection_close(self);
+            return -1;
+        }
+
+        if ((self->unconfirmedReceivedIMessages >= self->slave->conParameters.w) &&
+            (self->slave->ackPolicy == CS104_ACK_POLICY_DELAYED) &&
+            (self->unconfirmedReceivedIMessages < self->slave->conParameters.k))
+        {
+            /* give an outgoing I-frame the chance to carry the confirmation */
+#if (CONFIG_USE_SEMAPHORES == 1)
+            Semaphore_wait(self->stateLock);
+#endif
+            if (self->ackDeadline == UINT64_MAX) {
+                int ackDelay = self->slave->ackDelayMs;
+
+                if (ackDelay > self->slave->conParameters.t2 * 1000)
+                    ackDelay = self->slave->conParameters.t2 * 1000;
+
+                self->ackDeadline = Hal_getTimeInMs() + (uint64_t) ackDelay;
+            }
+#if (CONFIG_USE_SEMAPHORES == 1)
+            Semaphore_post(self->stateLock);
+#endif
+        }
+        else if (self->unconfirmedReceivedIMessages >= self->slave->conParameters.w) {
+
+            self->lastConfirmationTime = Hal_getTimeInMs();
+
+            self->unconfirmedReceivedIMessages = 0;
+
+            self->timeoutT2Triggered = false;
+
+            sendSMessage(self);
+        }
+    }
+
+    if (msgSize < 0) {
+        DEBUG_PRINT("CS104 SLAVE: Invalid message start\n");
+        MasterConnection_close(self);
+        return -1;
+    }
+
+    return bufferFull ? 1 : 0;
+}
+
+/* maximum number of receive buffer fills read before timeouts and sending get their turn */
+#define CONNECTION_RECEIVE_BUDGET 16
+
 static void*
 connectionHandlingThread(void* parameter)
 {
@@ -2854,6 +3372,9 @@ connectionHandlingThread(void* parameter)
 
     bool isAsduWaiting = false;
 
+    /* the last read filled the receive buffer, more data can be waiting */
+    bool inputPending = false;
+
     if (self->slave->connectionEventHandler) {
         self->slave->connectionEventHandler(self->slave->connectionEventHandlerParameter, &(self->iMasterConnection), CS104_CON_EVENT_CONNECTION_OPENED);
     }
@@ -2874,45 +3395,43 @@ connectionHandlingThread(void* parameter)
         else
             socketTimeout = 100;
 
-        if (Handleset_waitReady(self->handleSet, socketTimeout)) {
-
-            int bytesRec = receiveMessage(self);
-
-            if (bytesRec == -1) {
-                DEBUG_PRINT("CS104 SLAVE: Error reading from socket\n");
-                break;
-            }
-
-            if (bytesRec > 0) {
-                DEBUG_PRINT("CS104 SLAVE: Connection: rcvd msg(%i bytes)\n", bytesRec);
-
-                if (self->slave->rawMessageHandler)
-                    self->slave->rawMessageHandler(self->slave->rawMessageHandlerParameter,
-                            &(self->iMasterConnection), self->recvBuffer, bytesRec, false);
-
-                if (handleMessage(self, self->recvBuffer, bytesRec) == false)
-                {
+        /* wake up in time for a delayed confirmation (set and cleared under stateLock) */
 #if (CONFIG_USE_SEMAPHORES == 1)
-                    Semaphore_wait(self->stateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */                  
-                    self->isRunning = false;
-
+        Semaphore_wait(self->stateLock);
+#endif
+        uint64_t ackDeadline = self->ackDeadline;
 #if (CONFIG_USE_SEMAPHORES == 1)
-                    Semaphore_post(self->stateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
-                }
+        Semaphore_post(self->stateLock);
+#endif
+
+        if (ackDeadline != UINT64_MAX) {
+            uint64_t currentTime = Hal_getTimeInMs();
+            int ackTimeout = (ackDeadline > currentTime) ? (int) (ackDeadline - currentTime) : 0;
 
-                if (self->unconfirmedReceivedIMessages >= self->slave->conParameters.w) {
+            if (ackTimeout < socketTimeout)
+                socketTimeout = ackTimeout;
+        }
 
-                    self->lastConfirmationTime = Hal_getTimeInMs();
+        /*
+         * Data left over after a full receive buffer is read without waiting on the socket:
+         * with TLS it can already be decrypted, which does not make the socket readable
+         */
+        if (inputPending || Handleset_waitReady(self->handleSet, socketTimeout)) {
 
-                    self->unconfirmedReceivedIMessages = 0;
+            int result = 0;
+            int i;
 
-                    self->timeoutT2Triggered = false;
+            for (i = 0; i < CONNECTION_RECEIVE_BUDGET; i++) {
+                result = MasterConnection_handleReceivedData(self);
 
-                    sendSMessage(self);
-                }
+                if (result != 1)
+                    break;
             }
+
+            if (result == -1)
+                break;
+
+            inputPending = (result == 1);
         }
 
         if (handleTimeouts(self) == false) {
@@ -3005,6 +3524,15 @@ _IMasterConnection_close(IMasterConnection self)
     MasterConnection con = (MasterConnection) self->object;
 
     MasterConnection_close(con);
+
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+    {
+        CS104_Reactor reactor = __atomic_load_n(&(con->reactor), __ATOMIC_ACQUIRE);
+
+        if (reactor)
+            Reactor_wakeup(reactor);
+    }
+#endif
 }
 
 static int
@@ -3049,6 +3577,8 @@ MasterConnection_create(CS104_Slave slave)
     if (self != NULL) {
         self->isUsed = false;
         self->slave = slave;
+        self->tableIndex = -1;
+        self->openListIndex = -1;
         self->maxSentASDUs = slave->conParameters.k;
         self->sentASDUs = (SentASDUSlave*) GLOBAL_CALLOC(self->maxSentASDUs, sizeof(SentASDUSlave));
 
@@ -3065,6 +3595,12 @@ MasterConnection_create(CS104_Slave slave)
         self->connectionThread = NULL;
 #endif
 
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+        self->reactor = NULL;
+        self->timerFd = -1;
+        self->timerDeadline = 0;
+#endif
+
 #if (CONFIG_USE_SEMAPHORES == 1)
         self->sentASDUsLock = Semaphore_create(1);
         self->stateLock = Semaphore_create(1);
@@ -3097,9 +3633,14 @@ MasterConnection_init(MasterConnection self, Socket skt, MessageQueue lowPrioQue
         self->receiveCount = 0;
         self->sendCount = 0;
         self->recvBufPos = 0;
+        self->recvBufFill = 0;
+
+        memset(&(self->stats), 0, sizeof(self->stats));
 
         self->unconfirmedReceivedIMessages = 0;
         self->lastConfirmationTime = UINT64_MAX;
+        self->ackDeadline = UINT64_MAX;
+        self->kWindowStallStart = 0;
 
         self->timeoutT2Triggered = false;
 
@@ -3176,6 +3717,7 @@ MasterConnection_start(MasterConnection self)
            Thread_create((ThreadExecutionFunction) connectionHandlingThread,
                    (void*) self, false);
 
+    Thread_setClass(self->connectionThread, "connection");
     Thread_start(self->connectionThread);
 }
 #endif /* (CONFIG_USE_THREADS == 1) */
@@ -3236,45 +3778,24 @@ MasterConnection_activate(MasterConnection self)
 }
 
 static void
-MasterConnection_handleTcpConnection(MasterConnection self)
+MasterConnection_executePeriodicTasks(MasterConnection self)
 {
-    int bytesRec = receiveMessage(self);
+    if (self->isActive)
+        sendWaitingASDUs(self);
 
-    if (bytesRec < 0) {
-        DEBUG_PRINT("CS104 SLAVE: Error reading from socket\n");
+    if (handleTimeouts(self) == false)
         self->isRunning = false;
-    }
-
-    if ((bytesRec > 0) && (self->isRunning)) {
-
-        if (self->slave->rawMessageHandler)
-            self->slave->rawMessageHandler(self->slave->rawMessageHandlerParameter,
-                    &(self->iMasterConnection), self->recvBuffer, bytesRec, false);
-
-        if (handleMessage(self, self->recvBuffer, bytesRec) == false)
-            self->isRunning = false;
-
-        if (self->unconfirmedReceivedIMessages >= self->slave->conParameters.w) {
-
-            self->lastConfirmationTime = Hal_getTimeInMs();
-
-            self->unconfirmedReceivedIMessages = 0;
-
-            self->timeoutT2Triggered = false;
-
-            sendSMessage(self);
-        }
-    }
 }
 
+/**
+ * Start listening with a backlog large enough for all masters reconnecting at once
+ */
 static void
-MasterConnection_executePeriodicTasks(MasterConnection self)
+listenServerSocket(CS104_Slave self)
 {
-    if (self->isActive)
-        sendWaitingASDUs(self);
+    ServerSocket_setBacklog(self->serverSocket, self->maxOpenConnections > 2 ? self->maxOpenConnections : 2);
 
-    if (handleTimeouts(self) == false)
-        self->isRunning = false;
+    ServerSocket_listen(self->serverSocket);
 }
 
 static void
@@ -3288,41 +3809,36 @@ handleClientConnections(CS104_Slave self)
 
         bool first = true;
 
-        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
+        /* iterate backwards - closed connections are removed from the list */
+        for (i = self->openConnections - 1; i >= 0; i--) {
 
-            MasterConnection con = self->masterConnections[i];
+            MasterConnection con = self->openConnectionList[i];
 
-            if (con && con->isUsed) {
+            if (con->isRunning) {
 
-                if (con->isRunning) {
+                if (first) {
 
-                    if (first) {
+                    handleset = con->handleSet;
+                    Handleset_reset(handleset);
 
-                        handleset = con->handleSet;
-                        Handleset_reset(handleset);
-
-                        first = false;
-                    }
-
-                    Handleset_addSocket(handleset, con->socket);
+                    first = false;
                 }
-                else {
 
-                    if (self->connectionEventHandler) {
-                       self->connectionEventHandler(self->connectionEventHandlerParameter, &(con->iMasterConnection), CS104_CON_EVENT_CONNECTION_CLOSED);
-                    }
-
-                    DEBUG_PRINT("CS104 SLAVE: Connection closed\n");
+                Handleset_addSocket(handleset, con->socket);
+            }
+            else {
 
-                    self->masterConnections[i]->isUsed = false;
+                if (self->connectionEventHandler) {
+                   self->connectionEventHandler(self->connectionEventHandlerParameter, &(con->iMasterConnection), CS104_CON_EVENT_CONNECTION_CLOSED);
+                }
 
-                    MessageQueue_setWaitingForTransmissionWhenNotConfirmed(self->masterConnections[i]->lowPrioQueue);
+                DEBUG_PRINT("CS104 SLAVE: Connection closed\n");
 
-                    self->openConnections--;
+                MessageQueue_setWaitingForTransmissionWhenNotConfirmed(con->lowPrioQueue);
 
-                    MasterConnection_deinit(con);
-                }
+                MasterConnection_deinit(con);
 
+                releaseConnection(self, con);
             }
 
         }
@@ -3332,40 +3848,34 @@ handleClientConnections(CS104_Slave self)
 
             if (Handleset_waitReady(handleset, 1)) {
 
-                for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-                    MasterConnection con = self->masterConnections[i];
-
-                    if (con != NULL && con->isUsed)
-                        MasterConnection_handleTcpConnection(con);
-                }
+                for (i = 0; i < self->openConnections; i++)
+                    MasterConnection_handleReceivedData(self->openConnectionList[i]);
 
             }
         }
 
         /* handle periodic tasks for running connections */
-        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-            MasterConnection con = self->masterConnections[i];
+        for (i = 0; i < self->openConnections; i++) {
+            MasterConnection con = self->openConnectionList[i];
 
-            if (con != NULL && con->isUsed) {
-                if (con->isRunning) {
-                    MasterConnection_executePeriodicTasks(con);
+            if (con->isRunning) {
+                MasterConnection_executePeriodicTasks(con);
 
-                    /* call plugins */
-                    if (self->plugins) {
+                /* call plugins */
+                if (self->plugins) {
 
-                        LinkedList pluginElem = LinkedList_getNext(self->plugins);
+                    LinkedList pluginElem = LinkedList_getNext(self->plugins);
 
-                        while (pluginElem) {
+                    while (pluginElem) {
 
-                            CS101_SlavePlugin plugin = (CS101_SlavePlugin) LinkedList_getData(pluginElem);
+                        CS101_SlavePlugin plugin = (CS101_SlavePlugin) LinkedList_getData(pluginElem);
 
-                            plugin->runTask(plugin->parameter, &(con->iMasterConnection));
+                        plugin->runTask(plugin->parameter, &(con->iMasterConnection));
 
-                            pluginElem = LinkedList_getNext(pluginElem);
-                        }
+                        pluginElem = LinkedList_getNext(pluginElem);
                     }
-
                 }
+
             }
         }
 
@@ -3505,7 +4015,7 @@ handleConnectionsThreadless(CS104_Slave self)
                                     }
                                 }
                                 else {
-                                    decreaseConnectionCounter(self);
+                                    freeConnection(self, connection);
                                     connection = NULL;
                                 }
                             }
@@ -3537,7 +4047,7 @@ handleConnectionsThreadless(CS104_Slave self)
 
                     if (connection) {
                         if (MasterConnection_init(connection, newSocket, lowPrioQueue, highPrioQueue) == false) {
-                            decreaseConnectionCounter(self);
+                            freeConnection(self, connection);
                             connection = NULL;
                         }
                     }
@@ -3569,6 +4079,116 @@ handleConnectionsThreadless(CS104_Slave self)
 
 #if (CONFIG_USE_THREADS == 1)
 
+/**
+ * Check if a new client is accepted and assign it to a free connection object.
+ *
+ * \return the initialized connection, or NULL when the client is rejected (the socket is destroyed)
+ */
+static MasterConnection
+assignConnection(CS104_Slave self, Socket newSocket)
+{
+    MasterConnection connection = NULL;
+
+    bool acceptConnection = true;
+
+    /* check if maximum number of open connections is reached */
+    if (self->maxOpenConnections > 0) {
+        if (CS104_Slave_getOpenConnections(self) >= self->maxOpenConnections)
+            acceptConnection = false;
+    }
+
+    if (acceptConnection)
+        acceptConnection = callConnectionRequestHandler(self, newSocket);
+
+    if (acceptConnection) {
+
+        MessageQueue lowPrioQueue = NULL;
+        HighPriorityASDUQueue highPrioQueue = NULL;
+
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
+        if (self->serverMode == CS104_MODE_SINGLE_REDUNDANCY_GROUP) {
+            lowPrioQueue = self->asduQueue;
+            highPrioQueue = self->connectionAsduQueue;
+        }
+#endif
+
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_CONNECTION_IS_REDUNDANCY_GROUP == 1)
+        if (self->serverMode == CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP) {
+            lowPrioQueue = NULL;
+            highPrioQueue = NULL;
+        }
+#endif
+
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
+        if (self->serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS) {
+
+            char ipAddress[60];
+
+            char* ipAddrStr = getPeerAddress(newSocket, ipAddress);
+
+            if (ipAddrStr) {
+                CS104_RedundancyGroup matchingGroup = getMatchingRedundancyGroup(self, ipAddrStr);
+
+                if (matchingGroup != NULL) {
+                    connection = getFreeConnection(self);
+
+                    if (connection) {
+                        if (MasterConnection_initEx(connection, newSocket, matchingGroup)) {
+                            if (matchingGroup->name) {
+                                DEBUG_PRINT("CS104 SLAVE: Add connection to group: %s\n", matchingGroup->name);
+                            }
+                        }
+                        else {
+                            freeConnection(self, connection);
+                            connection = NULL;
+                        }
+                    }
+
+                }
+                else {
+                    DEBUG_PRINT("CS104 SLAVE: Found no matching redundancy group -> close connection\n");
+                }
+            }
+            else {
+                DEBUG_PRINT("CS104 SLAVE: cannot determine peer IP address -> close connection\n");
+            }
+
+        }
+        else {
+            connection = getFreeConnection(self);
+
+            if (connection) {
+                if (MasterConnection_init(connection, newSocket, lowPrioQueue, highPrioQueue) == false) {
+                    freeConnection(self, connection);
+                    connection = NULL;
+                }
+            }
+
+        }
+#else
+        connection = getFreeConnection(self);
+
+        if (connection) {
+            if (MasterConnection_init(connection, newSocket, lowPrioQueue, highPrioQueue) == false) {
+                freeConnection(self, connection);
+                connection = NULL;
+            }
+        }
+#endif
+
+        if (connection == NULL) {
+            Socket_destroy(newSocket);
+
+            DEBUG_PRINT("CS104 SLAVE: Connection attempt failed!\n");
+        }
+    }
+    else {
+        Socket_destroy(newSocket);
+    }
+
+    return connection;
+}
+
 static void*
 serverThread (void* parameter)
 {
@@ -3594,7 +4214,7 @@ serverThread (void* parameter)
         goto exit_function;
     }
 
-    ServerSocket_listen(self->serverSocket);
+    listenServerSocket(self);
 
 #if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_wait(self->stateLock);
@@ -3612,199 +4232,785 @@ serverThread (void* parameter)
 
         if (newSocket != NULL) {
 
-            bool acceptConnection = true;
+            MasterConnection connection = assignConnection(self, newSocket);
 
-            /* check if maximum number of open connections is reached */
-            if (self->maxOpenConnections > 0) {
-                if (CS104_Slave_getOpenConnections(self) >= self->maxOpenConnections)
-                    acceptConnection = false;
+            if (connection) {
+                /* now start the connection handling (thread) */
+                MasterConnection_start(connection);
             }
+        }
+        else
+            Thread_sleep(10);
 
-            if (acceptConnection)
-                acceptConnection = callConnectionRequestHandler(self, newSocket);
+        /* check if there are connections to close */
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_wait(self->openConnectionsLock);
+#endif
 
-            if (acceptConnection) {
+        int i;
 
-                MessageQueue lowPrioQueue = NULL;
-                HighPriorityASDUQueue highPrioQueue = NULL;
+        /* iterate backwards - closed connections are removed from the list */
+        for (i = self->openConnections - 1; i >= 0; i--) {
 
-#if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
-                if (self->serverMode == CS104_MODE_SINGLE_REDUNDANCY_GROUP) {
-                    lowPrioQueue = self->asduQueue;
-                    highPrioQueue = self->connectionAsduQueue;
-                }
-#endif
+            MasterConnection connection = self->openConnectionList[i];
 
-#if (CONFIG_CS104_SUPPORT_SERVER_MODE_CONNECTION_IS_REDUNDANCY_GROUP == 1)
-                if (self->serverMode == CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP) {
-                    lowPrioQueue = NULL;
-                    highPrioQueue = NULL;
-                }
-#endif
+            if (MasterConnection_isRunning(connection) == false) {
 
-                MasterConnection connection = NULL;
+                if (connection->connectionThread) {
+                    Thread_destroy(connection->connectionThread);
 
-#if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
-                if (self->serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS) {
+#if (CONFIG_USE_SEMAPHORES == 1)
+                    Semaphore_wait(connection->stateLock);
+#endif /* (CONFIG_USE_SEMAPHORES == 1) */
 
-                    char ipAddress[60];
+                    connection->connectionThread = NULL;
 
-                    char* ipAddrStr = getPeerAddress(newSocket, ipAddress);
+#if (CONFIG_USE_SEMAPHORES == 1)
+                    Semaphore_post(connection->stateLock);
+#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+                }
 
-                    if (ipAddrStr) {
-                        CS104_RedundancyGroup matchingGroup = getMatchingRedundancyGroup(self, ipAddrStr);
+                MasterConnection_deinit(connection);
 
-                        if (matchingGroup != NULL) {
-                            connection = getFreeConnection(self);
+                releaseConnection(self, connection);
+            }
+        }
 
-                            if (connection) {
-                                if (MasterConnection_initEx(connection, newSocket, matchingGroup)) {
-                                    if (matchingGroup->name) {
-                                        DEBUG_PRINT("CS104 SLAVE: Add connection to group: %s\n", matchingGroup->name);
-                                    }
-                                }
-                                else {
-                                    decreaseConnectionCounter(self);
-                                    connection = NULL;
-                                }
-                            }
+#if (CONFIG_USE_SEMAPHORES == 1)
+        Semaphore_post(self->openConnectionsLock);
+#endif
+    }
+
+    if (self->serverSocket)
+        Socket_destroy((Socket) self->serverSocket);
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(self->stateLock);
+#endif
+
+    self->isRunning = false;
+    self->stopRunning = false;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(self->stateLock);
+#endif
+
+exit_function:
+    return NULL;
+}
+
+#endif /* (CONFIG_USE_THREADS == 1) */
+
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+
+/*
+ * Reactor mode
+ *
+ * Each reactor thread owns an epoll instance. Connection sockets are registered
+ * edge-triggered together with a per-connection timerfd that is armed with the
+ * earliest pending t1/t2/t3 deadline. An eventfd wakes the reactor when ASDUs are
+ * enqueued by the application or a connection is closed from another thread.
+ * The listening socket is handled by the first reactor.
+ */
+
+#define REACTOR_MAX_EVENTS 64
+
+/* maximum number of ASDUs sent to one connection before the other connections get their turn */
+#define REACTOR_SEND_BUDGET 64
+
+/* maximum number of receive buffer fills read from one connection before the other connections get their turn */
+#define REACTOR_RECEIVE_BUDGET 16
+
+static bool
+Reactor_isUsed(CS104_Slave self)
+{
+#if (CONFIG_CS104_SUPPORT_TLS == 1)
+    if (self->tlsConfig != NULL)
+        return false;
+#endif
+
+    return (self->numberOfReactors > 0);
+}
+
+static void
+Reactor_wakeupAll(CS104_Slave self)
+{
+    int i;
+
+    for (i = 0; i < self->numberOfReactors; i++)
+        Reactor_wakeup(&(self->reactors[i]));
+}
+
+static void
+Reactor_destroyAll(CS104_Slave self)
+{
+    if (self->reactors) {
+        int i;
+
+        for (i = 0; i < self->numberOfReactors; i++) {
+            CS104_Reactor reactor = &(self->reactors[i]);
+
+            if (reactor->epollFd != -1)
+                close(reactor->epollFd);
+
+            if (reactor->wakeupFd != -1)
+                close(reactor->wakeupFd);
+
+            if (reactor->connectionsLock)
+                Semaphore_destroy(reactor->connectionsLock);
+
+            GLOBAL_FREEMEM(reactor->connections);
+            GLOBAL_FREEMEM(reactor->scratch);
+        }
+
+        GLOBAL_FREEMEM(self->reactors);
+        self->reactors = NULL;
+    }
+
+    self->numberOfReactors = 0;
+}
+
+static uint64_t
+Reactor_getNextDeadline(MasterConnection con, uint64_t currentTime)
+{
+    uint64_t deadline;
+
+    Semaphore_wait(con->stateLock);
+
+    if (con->waitingForTestFRcon)
+        deadline = con->nextTestFRConTimeout;
+    else
+        deadline = con->nextT3Timeout;
+
+    if (con->unconfirmedReceivedIMessages > 0) {
+        uint64_t t2Deadline = currentTime;
+
+        if (con->lastConfirmationTime <= currentTime)
+            t2Deadline = con->lastConfirmationTime + (uint64_t) (con->slave->conParameters.t2 * 1000);
+
+        if (t2Deadline < deadline)
+            deadline = t2Deadline;
+
+        if (con->ackDeadline < deadline)
+            deadline = con->ackDeadline;
+    }
+
+    Semaphore_post(con->stateLock);
+
+    Semaphore_wait(con->sentASDUsLock);
+
+    if (con->oldestSentASDU != -1) {
+        uint64_t t1Deadline = con->sentASDUs[con->oldestSentASDU].sentTime + (uint64_t) (con->slave->conParameters.t1 * 1000);
+
+        if (t1Deadline < deadline)
+            deadline = t1Deadline;
+    }
+
+    Semaphore_post(con->sentASDUsLock);
+
+    return deadline;
+}
+
+/**
+ * Arm the timerfd when a deadline earlier than the armed one is pending.
+ * A timer that fires too early (e.g. T3 was pushed back by received messages)
+ * is simply re-armed after handleTimeouts.
+ */
+static void
+Reactor_armTimer(MasterConnection con)
+{
+    uint64_t currentTime = Hal_getTimeInMs();
+
+    uint64_t deadline = Reactor_getNextDeadline(con, currentTime);
+
+    if ((con->timerDeadline != 0) && (con->timerDeadline <= deadline))
+        return;
+
+    /* handleTimeouts checks for "currentTime > deadline" */
+    uint64_t delay = (deadline >= currentTime) ? (deadline - currentTime + 1) : 1;
+
+    struct itimerspec timerValue;
+
+    memset(&timerValue, 0, sizeof(timerValue));
+    timerValue.it_value.tv_sec = (time_t) (delay / 1000);
+    timerValue.it_value.tv_nsec = (long) ((delay % 1000) * 1000000);
+
+    if (timerfd_settime(con->timerFd, 0, &timerValue, NULL) == 0)
+        con->timerDeadline = currentTime + delay;
+    else
+        DEBUG_PRINT("CS104 SLAVE: failed to arm connection timer (errno=%i)\n", errno);
+}
+
+static void
+Reactor_closeConnection(CS104_Reactor self, MasterConnection con)
+{
+    CS104_Slave slave = self->slave;
+
+    __atomic_store_n(&(con->reactor), NULL, __ATOMIC_RELEASE);
+
+    Semaphore_wait(self->connectionsLock);
+
+    {
+        int last = self->connectionCount - 1;
+
+        self->connections[con->reactorSlot] = self->connections[last];
+        self->connections[con->reactorSlot]->reactorSlot = con->reactorSlot;
+
+        __atomic_store_n(&(self->connectionCount), last, __ATOMIC_RELAXED);
+    }
+
+    Semaphore_post(self->connectionsLock);
+
+    if (con->socket)
+        epoll_ctl(self->epollFd, EPOLL_CTL_DEL, Socket_getFileDescriptor(con->socket), NULL);
+
+    if (con->timerFd != -1) {
+        close(con->timerFd);
+        con->timerFd = -1;
+    }
+
+    MasterConnection_close(con);
+
+    if (slave->connectionEventHandler) {
+        slave->connectionEventHandler(slave->connectionEventHandlerParameter, &(con->iMasterConnection), CS104_CON_EVENT_CONNECTION_CLOSED);
+    }
+
+    MessageQueue_setWaitingForTransmissionWhenNotConfirmed(con->lowPrioQueue);
+
+    Semaphore_wait(slave->openConnectionsLock);
+
+    MasterConnection_deinit(con);
+
+    releaseConnection(slave, con);
+
+    Semaphore_post(slave->openConnectionsLock);
+}
+
+/**
+ * Send waiting ASDUs, then close the connection or re-arm its timer
+ */
+static void
+Reactor_serviceConnection(CS104_Reactor self, MasterConnection con)
+{
+    if (MasterConnection_isRunning(con) && MasterConnection_isActive(con)) {
+
+        int i;
+
+        for (i = 0; i < REACTOR_SEND_BUDGET; i++) {
+            uint16_t sendCount = con->sendCount;
+
+            if (sendWaitingASDUs(con) == false)
+                break;
+
+            /* k-buffer full or remaining queue entries wait for confirmation */
+            if (con->sendCount == sendCount)
+                break;
+
+            if (MasterConnection_isRunning(con) == false)
+                break;
+        }
+
+        /* budget exhausted - continue after the other connections */
+        if (i == REACTOR_SEND_BUDGET)
+            Reactor_wakeup(self);
+    }
+
+    if (MasterConnection_isRunning(con))
+        Reactor_armTimer(con);
+    else
+        Reactor_closeConnection(self, con);
+}
+
+/**
+ * Read until the socket is drained (required for edge-triggered notification)
+ *
+ * A read that does not fill the receive buffer has taken everything the socket had.
+ * A master that sends faster than the reactor reads would keep it here forever, so
+ * after REACTOR_RECEIVE_BUDGET full reads the connection is marked and continued
+ * after the other connections (from the wakeup handler, no new edge will come).
+ */
+static void
+Reactor_handleInput(CS104_Reactor self, MasterConnection con)
+{
+    int i;
+
+    con->inputPending = false;
+
+    for (i = 0; i < REACTOR_RECEIVE_BUDGET; i++) {
+        if (MasterConnection_isRunning(con) == false)
+            return;
+
+        if (MasterConnection_handleReceivedData(con) != 1)
+            return;
+    }
+
+    con->inputPending = true;
+    Reactor_wakeup(self);
+}
+
+static void
+Reactor_handleTimer(MasterConnection con)
+{
+    uint64_t expirations;
+
+    if (read(con->timerFd, &expirations, sizeof(expirations)) < 0) {
+        if (errno == EAGAIN)
+            return;
+    }
+
+    con->timerDeadline = 0;
+
+    if (handleTimeouts(con) == false)
+        MasterConnection_close(con);
+}
+
+/**
+ * Register a new connection with a reactor (called by the reactor that accepted it)
+ */
+static void
+Reactor_addConnection(CS104_Reactor self, MasterConnection con)
+{
+    CS104_Slave slave = self->slave;
+
+    int socketFd = Socket_getFileDescriptor(con->socket);
+
+    con->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    con->timerDeadline = 0;
+
+    con->socketSource.type = REACTOR_SOURCE_SOCKET;
+    con->socketSource.object = con;
+    con->timerSource.type = REACTOR_SOURCE_TIMER;
+    con->timerSource.object = con;
+    con->inputPending = false;
+
+    con->isRunning = true;
+
+    resetT3Timeout(con, Hal_getTimeInMs());
+
+    if (slave->connectionEventHandler) {
+        slave->connectionEventHandler(slave->connectionEventHandlerParameter, &(con->iMasterConnection), CS104_CON_EVENT_CONNECTION_OPENED);
+    }
+
+    __atomic_store_n(&(con->reactor), self, __ATOMIC_RELEASE);
+
+    Semaphore_wait(self->connectionsLock);
+
+    con->reactorSlot = self->connectionCount;
+    self->connections[con->reactorSlot] = con;
+
+    __atomic_store_n(&(self->connectionCount), con->reactorSlot + 1, __ATOMIC_RELAXED);
+
+    Semaphore_post(self->connectionsLock);
+
+    struct epoll_event event;
+
+    bool registered = false;
+
+    if ((con->timerFd != -1) && (socketFd != -1)) {
+        event.events = EPOLLIN | EPOLLET;
+        event.data.ptr = &(con->timerSource);
+
+        if (epoll_ctl(self->epollFd, EPOLL_CTL_ADD, con->timerFd, &event) == 0) {
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+            event.data.ptr = &(con->socketSource);
+
+            if (epoll_ctl(self->epollFd, EPOLL_CTL_ADD, socketFd, &event) == 0)
+                registered = true;
+        }
+    }
+
+    if (registered == false) {
+        DEBUG_PRINT("CS104 SLAVE: failed to register connection with reactor %i\n", self->index);
+        MasterConnection_close(con);
+    }
+
+    /* let the reactor arm the timer (or close the connection) */
+    Reactor_wakeup(self);
+}
+
+/**
+ * Reactor with the fewest connections. Ties go round-robin, so connections are spread
+ * evenly from the start and reactors that lost connections get the new ones.
+ */
+static CS104_Reactor
+Reactor_leastLoaded(CS104_Slave slave)
+{
+    int best = slave->nextReactor;
+    int bestCount = __atomic_load_n(&(slave->reactors[best].connectionCount), __ATOMIC_RELAXED);
+
+    int i;
+
+    for (i = 1; i < slave->numberOfReactors; i++) {
+        int index = (slave->nextReactor + i) % slave->numberOfReactors;
+        int count = __atomic_load_n(&(slave->reactors[index].connectionCount), __ATOMIC_RELAXED);
+
+        if (count < bestCount) {
+            best = index;
+            bestCount = count;
+        }
+    }
+
+    slave->nextReactor = (best + 1) % slave->numberOfReactors;
+
+    return &(slave->reactors[best]);
+}
+
+static void
+Reactor_acceptConnections(CS104_Reactor self)
+{
+    CS104_Slave slave = self->slave;
+
+    Socket newSocket;
+
+    while ((newSocket = ServerSocket_accept(slave->serverSocket)) != NULL) {
+
+        MasterConnection connection = assignConnection(slave, newSocket);
+
+        if (connection) {
+            Reactor_addConnection(Reactor_leastLoaded(slave), connection);
+        }
+    }
+}
+
+/**
+ * Copy the connections of this reactor to self->scratch. Servicing a connection
+ * can close it, and the accepting reactor can add one, while the copy is walked.
+ */
+static int
+Reactor_getConnections(CS104_Reactor self)
+{
+    Semaphore_wait(self->connectionsLock);
+
+    int count = self->connectionCount;
+
+    memcpy(self->scratch, self->connections, count * sizeof(MasterConnection));
+
+    Semaphore_post(self->connectionsLock);
+
+    return count;
+}
+
+static void
+Reactor_handleWakeup(CS104_Reactor self)
+{
+    uint64_t value;
+
+    if (read(self->wakeupFd, &value, sizeof(value)) < 0) {
+        DEBUG_PRINT("CS104 SLAVE: reactor %i: wakeup read failed (errno=%i)\n", self->index, errno);
+    }
+
+    __atomic_store_n(&(self->wakeupPending), 0, __ATOMIC_RELEASE);
+
+    int count = Reactor_getConnections(self);
+
+    int i;
+
+    for (i = 0; i < count; i++) {
+        MasterConnection con = self->scratch[i];
+
+        if (con->inputPending)
+            Reactor_handleInput(self, con);
+
+        Reactor_serviceConnection(self, con);
+    }
+}
+
+static void
+Reactor_pinThread(CS104_Reactor self)
+{
+    long numberOfCpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (numberOfCpus > 0) {
+        cpu_set_t cpuSet;
+
+        CPU_ZERO(&cpuSet);
+        CPU_SET(self->index % numberOfCpus, &cpuSet);
+
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+            DEBUG_PRINT("CS104 SLAVE: failed to pin reactor %i\n", self->index);
+    }
+}
+
+static void*
+reactorThread(void* parameter)
+{
+    CS104_Reactor self = (CS104_Reactor) parameter;
+    CS104_Slave slave = self->slave;
+
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    if (slave->pinReactorThreads)
+        Reactor_pinThread(self);
+
+    while (isStopRunningSet(slave) == false) {
+
+        int eventCount = epoll_wait(self->epollFd, events, REACTOR_MAX_EVENTS, -1);
+
+        if (eventCount < 0) {
+            if (errno == EINTR)
+                continue;
+
+            DEBUG_PRINT("CS104 SLAVE: reactor %i: epoll_wait failed (errno=%i)\n", self->index, errno);
+            break;
+        }
+
+        int i;
 
-                        }
-                        else {
-                            DEBUG_PRINT("CS104 SLAVE: Found no matching redundancy group -> close connection\n");
-                        }
-                    }
-                    else {
-                        DEBUG_PRINT("CS104 SLAVE: cannot determine peer IP address -> close connection\n");
-                    }
+        for (i = 0; i < eventCount; i++) {
+            struct sReactorSource* source = (struct sReactorSource*) events[i].data.ptr;
 
-                }
-                else {
-                    connection = getFreeConnection(self);
+            switch (source->type) {
 
-                    if (connection) {
-                        if (MasterConnection_init(connection, newSocket, lowPrioQueue, highPrioQueue) == false) {
-                            decreaseConnectionCounter(self);
-                            connection = NULL;
-                        }
-                    }
+            case REACTOR_SOURCE_LISTEN:
+                Reactor_acceptConnections(self);
+                break;
 
-                }
-#else
-                connection = getFreeConnection(self);
+            case REACTOR_SOURCE_WAKEUP:
+                Reactor_handleWakeup(self);
+                break;
 
-                if (connection) {
-                    if (MasterConnection_init(connection, newSocket, lowPrioQueue, highPrioQueue) == false) {
-                        decreaseConnectionCounter(self);
-                        connection = NULL;
-                    }
-                }
-#endif
+            case REACTOR_SOURCE_SOCKET:
+            case REACTOR_SOURCE_TIMER:
+                {
+                    MasterConnection con = (MasterConnection) source->object;
 
-                if (connection) {
-                    /* now start the connection handling (thread) */
-                    MasterConnection_start(connection);
-                }
-                else{
-                    Socket_destroy(newSocket);
+                    /* connection was closed while handling an earlier event of this batch */
+                    if (__atomic_load_n(&(con->reactor), __ATOMIC_ACQUIRE) != self)
+                        break;
 
-                    DEBUG_PRINT("CS104 SLAVE: Connection attempt failed!\n");
-                }
+                    if (source->type == REACTOR_SOURCE_SOCKET)
+                        Reactor_handleInput(self, con);
+                    else
+                        Reactor_handleTimer(con);
 
-            }
-            else {
-                Socket_destroy(newSocket);
+                    Reactor_serviceConnection(self, con);
+                }
+                break;
             }
         }
-        else
-            Thread_sleep(10);
+    }
 
-        /* check if there are connections to close */
-#if (CONFIG_USE_SEMAPHORES == 1)
-        Semaphore_wait(self->openConnectionsLock);
-#endif
+    /* close all connections of this reactor */
+    {
+        int count = Reactor_getConnections(self);
 
         int i;
 
-        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
+        for (i = 0; i < count; i++)
+            Reactor_closeConnection(self, self->scratch[i]);
+    }
 
-            if (self->masterConnections[i])
-            {
-                MasterConnection connection = self->masterConnections[i];
-               
-#if (CONFIG_USE_SEMAPHORES == 1)
-                Semaphore_wait(connection->stateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+    return NULL;
+}
 
-                bool isConnectionUsed = connection->isUsed;
+/**
+ * Listening thread in reactor mode. Runs the first reactor and owns the other reactor threads.
+ */
+static void*
+reactorServerThread(void* parameter)
+{
+    CS104_Slave self = (CS104_Slave) parameter;
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-                Semaphore_post(connection->stateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+    CS104_Reactor listener = &(self->reactors[0]);
+
+    if (self->localAddress)
+        self->serverSocket = TcpServerSocket_create(self->localAddress, self->tcpPort);
+    else
+        self->serverSocket = TcpServerSocket_create("0.0.0.0", self->tcpPort);
+
+    if (self->serverSocket == NULL) {
+        DEBUG_PRINT("CS104 SLAVE: Cannot create server socket\n");
 
-                if (isConnectionUsed) {
+        Semaphore_wait(self->stateLock);
+        self->isStarting = false;
+        Semaphore_post(self->stateLock);
 
-                    if (MasterConnection_isRunning(connection) == false) {
+        goto exit_function;
+    }
 
-                        if (connection->connectionThread) {
-                            Thread_destroy(connection->connectionThread);
+    listenServerSocket(self);
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-                            Semaphore_wait(connection->stateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+    {
+        struct epoll_event event;
 
-                            connection->connectionThread = NULL;
+        event.events = EPOLLIN | EPOLLET;
+        event.data.ptr = &(listener->listenSource);
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-                            Semaphore_post(connection->stateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
-                        }
+        if (epoll_ctl(listener->epollFd, EPOLL_CTL_ADD, ServerSocket_getFileDescriptor(self->serverSocket), &event) != 0) {
+            DEBUG_PRINT("CS104 SLAVE: Cannot register server socket (errno=%i)\n", errno);
 
-                        MasterConnection_deinit(connection);
+            ServerSocket_destroy(self->serverSocket);
+            self->serverSocket = NULL;
 
-                        self->openConnections--;
+            Semaphore_wait(self->stateLock);
+            self->isStarting = false;
+            Semaphore_post(self->stateLock);
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-                        Semaphore_wait(connection->stateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+            goto exit_function;
+        }
+    }
 
-                        connection->isUsed = false;
+    self->nextReactor = 0;
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-                        Semaphore_post(connection->stateLock);
-#endif /* (CONFIG_USE_SEMAPHORES == 1) */
+    {
+        int i;
 
-                    }
+        for (i = 0; i < self->numberOfReactors; i++) {
+            CS104_Reactor reactor = &(self->reactors[i]);
 
-                    break;
-                }
+            GLOBAL_FREEMEM(reactor->connections);
+            GLOBAL_FREEMEM(reactor->scratch);
+            reactor->connections = (MasterConnection*) GLOBAL_MALLOC(self->connectionTableSize * sizeof(MasterConnection));
+            reactor->scratch = (MasterConnection*) GLOBAL_MALLOC(self->connectionTableSize * sizeof(MasterConnection));
+            reactor->connectionCount = 0;
+
+            if ((reactor->connections == NULL) || (reactor->scratch == NULL)) {
+                DEBUG_PRINT("CS104 SLAVE: Out of memory\n");
+
+                epoll_ctl(listener->epollFd, EPOLL_CTL_DEL, ServerSocket_getFileDescriptor(self->serverSocket), NULL);
+                ServerSocket_destroy(self->serverSocket);
+                self->serverSocket = NULL;
+
+                Semaphore_wait(self->stateLock);
+                self->isStarting = false;
+                Semaphore_post(self->stateLock);
+
+                goto exit_function;
             }
         }
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-        Semaphore_post(self->openConnectionsLock);
-#endif
+        for (i = 1; i < self->numberOfReactors; i++) {
+            CS104_Reactor reactor = &(self->reactors[i]);
+
+            reactor->thread = Thread_create(reactorThread, (void*) reactor, false);
+            Thread_setClass(reactor->thread, "reactor");
+            Thread_start(reactor->thread);
+        }
     }
 
-    if (self->serverSocket)
-        Socket_destroy((Socket) self->serverSocket);
+    Semaphore_wait(self->stateLock);
+
+    self->isRunning = true;
+    self->isStarting = false;
+
+    Semaphore_post(self->stateLock);
+
+    reactorThread(listener);
+
+    {
+        int i;
+
+        for (i = 1; i < self->numberOfReactors; i++) {
+            CS104_Reactor reactor = &(self->reactors[i]);
+
+            if (reactor->thread) {
+                Thread_destroy(reactor->thread);
+                reactor->thread = NULL;
+            }
+        }
+    }
+
+    epoll_ctl(listener->epollFd, EPOLL_CTL_DEL, ServerSocket_getFileDescriptor(self->serverSocket), NULL);
+
+    ServerSocket_destroy(self->serverSocket);
+    self->serverSocket = NULL;
 
-#if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_wait(self->stateLock);
-#endif
 
     self->isRunning = false;
     self->stopRunning = false;
 
-#if (CONFIG_USE_SEMAPHORES == 1)
     Semaphore_post(self->stateLock);
-#endif
 
 exit_function:
     return NULL;
 }
 
-#endif /* (CONFIG_USE_THREADS == 1) */
+#endif /* (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1) */
+
+void
+CS104_Slave_setAckPolicy(CS104_Slave self, CS104_AckPolicy policy, int ackDelayMs)
+{
+    self->ackPolicy = policy;
+    self->ackDelayMs = (ackDelayMs > 0) ? ackDelayMs : 0;
+}
+
+bool
+CS104_Slave_setReactorThreads(CS104_Slave self, int numberOfThreads, bool pinThreads)
+{
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+    if (isRunning(self))
+        return false;
+
+    Reactor_destroyAll(self);
+
+    if (numberOfThreads <= 0)
+        return true;
+
+    self->reactors = (CS104_Reactor) GLOBAL_CALLOC(numberOfThreads, sizeof(struct sCS104_Reactor));
+
+    if (self->reactors == NULL)
+        return false;
+
+    self->numberOfReactors = numberOfThreads;
+    self->pinReactorThreads = pinThreads;
+
+    int i;
+
+    for (i = 0; i < numberOfThreads; i++) {
+        CS104_Reactor reactor = &(self->reactors[i]);
+
+        reactor->slave = self;
+        reactor->index = i;
+        reactor->epollFd = -1;
+        reactor->wakeupFd = -1;
+        reactor->wakeupPending = 0;
+        reactor->connectionCount = 0;
+        reactor->thread = NULL;
+        reactor->connectionsLock = NULL;
+        reactor->connections = NULL;
+        reactor->scratch = NULL;
+        reactor->wakeupSource.type = REACTOR_SOURCE_WAKEUP;
+        reactor->wakeupSource.object = reactor;
+        reactor->listenSource.type = REACTOR_SOURCE_LISTEN;
+        reactor->listenSource.object = reactor;
+    }
+
+    for (i = 0; i < numberOfThreads; i++) {
+        CS104_Reactor reactor = &(self->reactors[i]);
+
+        reactor->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        reactor->wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        reactor->connectionsLock = Semaphore_create(1);
+
+        if ((reactor->epollFd == -1) || (reactor->wakeupFd == -1) || (reactor->connectionsLock == NULL))
+            goto exit_error;
+
+        struct epoll_event event;
+
+        event.events = EPOLLIN | EPOLLET;
+        event.data.ptr = &(reactor->wakeupSource);
+
+        if (epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->wakeupFd, &event) != 0)
+            goto exit_error;
+    }
+
+    return true;
+
+exit_error:
+    DEBUG_PRINT("CS104 SLAVE: Failed to create reactor (errno=%i)\n", errno);
+
+    Reactor_destroyAll(self);
+
+    return false;
+#else
+    (void) self;
+    (void) numberOfThreads;
+    (void) pinThreads;
+
+    return false;
+#endif /* (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1) */
+}
 
 void
 CS104_Slave_enqueueASDU(CS104_Slave self, CS101_ASDU asdu)
@@ -3849,20 +5055,18 @@ CS104_Slave_enqueueASDU(CS104_Slave self, CS101_ASDU asdu)
 
         int i;
 
-        for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-
-            MasterConnection con = self->masterConnections[i];
-
-            if (con)
-                MessageQueue_enqueueASDU(con->lowPrioQueue, asdu);
-
-        }
+        for (i = 0; i < self->openConnections; i++)
+            MessageQueue_enqueueASDU(self->openConnectionList[i]->lowPrioQueue, asdu);
 
 #if (CONFIG_USE_SEMAPHORES == 1)
         Semaphore_post(self->openConnectionsLock);
 #endif
     }
 #endif /* (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1) */
+
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+    Reactor_wakeupAll(self);
+#endif
 }
 
 void
@@ -3935,8 +5139,14 @@ CS104_Slave_start(CS104_Slave self)
             initializeConnectionSpecificQueues(self);
 #endif
 
-        self->listeningThread = Thread_create(serverThread, (void*) self, false);
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+        if (Reactor_isUsed(self))
+            self->listeningThread = Thread_create(reactorServerThread, (void*) self, false);
+        else
+#endif
+            self->listeningThread = Thread_create(serverThread, (void*) self, false);
 
+        Thread_setClass(self->listeningThread, "listener");
         Thread_start(self->listeningThread);
 
         while (isStarting(self))
@@ -3971,6 +5181,128 @@ CS104_Slave_getNumberOfQueueEntries(CS104_Slave self, CS104_RedundancyGroup redG
     return 0;
 }
 
+int
+CS104_Slave_getQueueHighWaterMark(CS104_Slave self, CS104_RedundancyGroup redGroup, bool reset)
+{
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
+    if (self->serverMode == CS104_MODE_SINGLE_REDUNDANCY_GROUP) {
+        if (self->asduQueue)
+            return MessageQueue_getHighWaterMark(self->asduQueue, reset);
+    }
+#endif
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
+    if (self->serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS) {
+
+        if (redGroup && redGroup->asduQueue) {
+            return MessageQueue_getHighWaterMark(redGroup->asduQueue, reset);
+        }
+
+        DEBUG_PRINT("CS104_SLAVE: redundancy group not found\n");
+    }
+#endif
+
+    /* mode CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP not supported! */
+
+    return 0;
+}
+
+uint64_t
+CS104_Slave_getNumberOfDroppedQueueEntries(CS104_Slave self, CS104_RedundancyGroup redGroup)
+{
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_SINGLE_REDUNDANCY_GROUP == 1)
+    if (self->serverMode == CS104_MODE_SINGLE_REDUNDANCY_GROUP) {
+        if (self->asduQueue)
+            return MessageQueue_getDroppedEntries(self->asduQueue);
+    }
+#endif
+#if (CONFIG_CS104_SUPPORT_SERVER_MODE_MULTIPLE_REDUNDANCY_GROUPS == 1)
+    if (self->serverMode == CS104_MODE_MULTIPLE_REDUNDANCY_GROUPS) {
+
+        if (redGroup && redGroup->asduQueue) {
+            return MessageQueue_getDroppedEntries(redGroup->asduQueue);
+        }
+
+        DEBUG_PRINT("CS104_SLAVE: redundancy group not found\n");
+    }
+#endif
+
+    /* mode CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP not supported! */
+
+    return 0;
+}
+
+void
+CS104_Slave_getConnectionStatistics(CS104_Slave self, IMasterConnection connection, CS104_ConnectionStatistics* stats)
+{
+    (void)self;
+
+    MasterConnection con = (MasterConnection) connection->object;
+    CS104_ConnectionStatistics* src = &(con->stats);
+    int i;
+
+    stats->iFramesSent = STATS_LOAD(&(src->iFramesSent));
+    stats->iFramesReceived = STATS_LOAD(&(src->iFramesReceived));
+    stats->sFramesSent = STATS_LOAD(&(src->sFramesSent));
+    stats->sFramesReceived = STATS_LOAD(&(src->sFramesReceived));
+    stats->uFramesSent = STATS_LOAD(&(src->uFramesSent));
+    stats->uFramesReceived = STATS_LOAD(&(src->uFramesReceived));
+    stats->bytesSent = STATS_LOAD(&(src->bytesSent));
+    stats->bytesReceived = STATS_LOAD(&(src->bytesReceived));
+    stats->t1Timeouts = STATS_LOAD(&(src->t1Timeouts));
+    stats->t3Timeouts = STATS_LOAD(&(src->t3Timeouts));
+    stats->highPrioQueueDrops = STATS_LOAD(&(src->highPrioQueueDrops));
+    stats->acksPiggybacked = STATS_LOAD(&(src->acksPiggybacked));
+    stats->kWindowStalls = STATS_LOAD(&(src->kWindowStalls));
+    stats->kWindowStallMs = STATS_LOAD(&(src->kWindowStallMs));
+    stats->kWindowHighWaterMark = STATS_LOAD(&(src->kWindowHighWaterMark));
+    stats->ackRttCount = STATS_LOAD(&(src->ackRttCount));
+    stats->ackRttSumMs = STATS_LOAD(&(src->ackRttSumMs));
+    stats->ackRttMaxMs = STATS_LOAD(&(src->ackRttMaxMs));
+
+    for (i = 0; i < CS104_ACK_RTT_HISTOGRAM_BUCKETS; i++)
+        stats->ackRttHistogram[i] = STATS_LOAD(&(src->ackRttHistogram[i]));
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_wait(con->sentASDUsLock);
+#endif
+
+    if (con->oldestSentASDU == -1)
+        stats->kWindowOccupancy = 0;
+    else
+        stats->kWindowOccupancy = ((con->newestSentASDU - con->oldestSentASDU + con->maxSentASDUs) % con->maxSentASDUs) + 1;
+
+#if (CONFIG_USE_SEMAPHORES == 1)
+    Semaphore_post(con->sentASDUsLock);
+#endif
+
+    stats->lowPrioQueueHighWaterMark = con->lowPrioQueue ? MessageQueue_getHighWaterMark(con->lowPrioQueue, false) : 0;
+
+    stats->reactor = -1;
+
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+    {
+        CS104_Reactor reactor = __atomic_load_n(&(con->reactor), __ATOMIC_ACQUIRE);
+
+        if (reactor)
+            stats->reactor = reactor->index;
+    }
+#endif
+}
+
+int
+CS104_Slave_getReactorConnections(CS104_Slave self, int reactor)
+{
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+    if ((reactor >= 0) && (reactor < self->numberOfReactors) && self->reactors)
+        return __atomic_load_n(&(self->reactors[reactor].connectionCount), __ATOMIC_RELAXED);
+#else
+    (void)self;
+    (void)reactor;
+#endif
+
+    return -1;
+}
+
 void
 CS104_Slave_startThreadless(CS104_Slave self)
 {
@@ -4016,7 +5348,7 @@ CS104_Slave_startThreadless(CS104_Slave self)
             goto exit_function;
         }
 
-        ServerSocket_listen(self->serverSocket);
+        listenServerSocket(self);
 
 #if (CONFIG_USE_SEMAPHORES == 1)
         Semaphore_wait(self->stateLock);
@@ -4086,6 +5418,10 @@ CS104_Slave_stop(CS104_Slave self)
             Semaphore_post(self->stateLock);
 #endif
 
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+            Reactor_wakeupAll(self);
+#endif
+
             while (isRunning(self))
                 Thread_sleep(1);
         }
@@ -4104,38 +5440,25 @@ CS104_Slave_stop(CS104_Slave self)
         {
             int i;
 
-            for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
-
-                MasterConnection connection = self->masterConnections[i];
-
-                if (connection) {
-
-#if (CONFIG_USE_SEMAPHORES == 1)
-                    Semaphore_wait(connection->stateLock);
-#endif
-
-                    bool isUsed = connection->isUsed;
+            /* signal all connections first, then wait for their threads */
+            for (i = 0; i < self->openConnections; i++)
+                MasterConnection_close(self->openConnectionList[i]);
 
-#if (CONFIG_USE_SEMAPHORES == 1)
-                    Semaphore_post(connection->stateLock);
-#endif
+            while (self->openConnections > 0) {
 
-                    if (isUsed) {
-                        MasterConnection_close(connection);
+                MasterConnection connection = self->openConnectionList[self->openConnections - 1];
 
 #if (CONFIG_USE_THREADS == 1)
-                        if (connection->connectionThread) {
-                            Thread_destroy(connection->connectionThread);
-                            MasterConnection_deinit(connection);
+                if (connection->connectionThread) {
+                    Thread_destroy(connection->connectionThread);
 
-                            connection->connectionThread = NULL;
-                        }
+                    connection->connectionThread = NULL;
+                }
 #endif
 
-                        self->openConnections--;
-                    }
+                MasterConnection_deinit(connection);
 
-                }
+                releaseConnection(self, connection);
             }
         }
 
@@ -4189,19 +5512,27 @@ CS104_Slave_destroy(CS104_Slave self)
         {
             int i;
 
-            for (i = 0; i < CONFIG_CS104_MAX_CLIENT_CONNECTIONS; i++) {
+            for (i = 0; i < self->connectionTableSize; i++) {
 
                 if (self->masterConnections[i]) {
                     MasterConnection_destroy(self->masterConnections[i]);
                     self->masterConnections[i] = NULL;
                 }
             }
+
+            GLOBAL_FREEMEM(self->masterConnections);
+            GLOBAL_FREEMEM(self->freeConnectionSlots);
+            GLOBAL_FREEMEM(self->openConnectionList);
         }
 
         if (self->plugins) {
             LinkedList_destroyStatic(self->plugins);
         }
 
+#if (CONFIG_CS104_SUPPORT_REACTOR_MODE == 1)
+        Reactor_destroyAll(self);
+#endif
+
         GLOBAL_FREEMEM(self);
     }
 }
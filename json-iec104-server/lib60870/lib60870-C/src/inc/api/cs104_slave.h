@@ -105,6 +105,67 @@ typedef void (*CS104_ConnectionEventHandler) (void* parameter, IMasterConnection
  */
 typedef void (*CS104_SlaveRawMessageHandler) (void* parameter, IMasterConnection connection, uint8_t* msg, int msgSize, bool send);
 
+/**
+ * \brief Number of buckets of the acknowledgement round-trip time histogram
+ *
+ * Bucket 0 counts RTTs below 1 ms, bucket i (i > 0) counts RTTs from 2^(i-1) ms up to
+ * 2^i ms (exclusive). The last bucket also counts all longer RTTs.
+ */
+#define CS104_ACK_RTT_HISTOGRAM_BUCKETS 18
+
+/**
+ * \brief Runtime statistics of a client connection
+ *
+ * The counters are reset when a new client uses the connection.
+ */
+typedef struct {
+    uint64_t iFramesSent;
+    uint64_t iFramesReceived;
+    uint64_t sFramesSent;
+    uint64_t sFramesReceived;
+    uint64_t uFramesSent;
+    uint64_t uFramesReceived;
+
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+
+    uint64_t t1Timeouts; /**< I-frame or TESTFR confirmations that were not received within t1 */
+    uint64_t t3Timeouts; /**< TESTFR ACT sent because the connection was idle for t3 */
+
+    uint64_t highPrioQueueDrops; /**< ASDUs not sent because the k-window and the high-priority queue were full */
+
+    uint64_t acksPiggybacked; /**< sent I-frames that also confirmed received I-frames (no S-frame needed) */
+    uint64_t kWindowStalls; /**< number of times ASDUs were waiting while the k-window was full */
+    uint64_t kWindowStallMs; /**< time ASDUs were waiting while the k-window was full */
+
+    int kWindowOccupancy; /**< sent I-frames that are not confirmed yet */
+    int kWindowHighWaterMark; /**< maximum of kWindowOccupancy */
+
+    int lowPrioQueueHighWaterMark; /**< high-water mark of the low-priority queue used by the connection */
+
+    int reactor; /**< index of the reactor thread serving the connection (-1 = own thread) */
+
+    uint64_t ackRttCount; /**< number of confirmed I-frames */
+    uint64_t ackRttSumMs; /**< sum of all acknowledgement RTTs */
+    uint64_t ackRttMaxMs; /**< longest acknowledgement RTT */
+    uint64_t ackRttHistogram[CS104_ACK_RTT_HISTOGRAM_BUCKETS]; /**< acknowledgement RTT distribution */
+} CS104_ConnectionStatistics;
+
+/**
+ * \brief Acknowledgement policy for received I-frames
+ */
+typedef enum {
+    /** send an S-frame as soon as w received I-frames are unconfirmed (default) */
+    CS104_ACK_POLICY_IMMEDIATE = 0,
+
+    /**
+     * when w received I-frames are unconfirmed, wait up to the acknowledgement delay for an
+     * outgoing I-frame that carries the confirmation (N(R)) before sending an S-frame.
+     * With k unconfirmed I-frames the S-frame is sent immediately.
+     */
+    CS104_ACK_POLICY_DELAYED = 1
+} CS104_AckPolicy;
+
 
 /**
  * \brief Create a new instance of a CS104 slave (server)
@@ -162,7 +223,10 @@ CS104_Slave_getOpenConnections(CS104_Slave self);
 /**
  * \brief set the maximum number of open client connections allowed
  *
- * NOTE: the number cannot be larger than the static maximum defined in
+ * The connection table starts with CONFIG_CS104_MAX_CLIENT_CONNECTIONS entries and is
+ * enlarged when a larger number is set before the server is started. Connection objects
+ * are only allocated when a client connects. While the server is running the number
+ * cannot be larger than the current table size.
  *
  * \param self the slave instance
  * \param maxOpenConnections the maximum number of open client connections allowed
@@ -247,6 +311,57 @@ CS104_Slave_getConnectionParameters(CS104_Slave self);
 CS101_AppLayerParameters
 CS104_Slave_getAppLayerParameters(CS104_Slave self);
 
+/**
+ * \brief Handle all connections with a fixed number of epoll reactor threads
+ *
+ * By default (0) every client connection is handled by its own thread that polls the
+ * socket. In reactor mode the listening socket and all connection sockets are registered
+ * edge-triggered with the epoll instance of one of the reactor threads (the one serving the
+ * fewest connections), and the t1/t2/t3 timeouts of each connection are driven by a timerfd.
+ * An idle slave does not wake up. A reactor thread reads and sends a limited amount per
+ * connection before it turns to the next one, so a busy master cannot starve the others.
+ *
+ * Connections are never handed over between reactor threads, so all callbacks of one
+ * connection are called from the same thread.
+ *
+ * NOTE: Has to be called before CS104_Slave_start. Requires CONFIG_CS104_SUPPORT_REACTOR_MODE = 1.
+ * TLS connections always use the thread-per-connection mode.
+ *
+ * \param self CS104_Slave instance
+ * \param numberOfThreads number of reactor threads (0 = thread per connection)
+ * \param pinThreads pin reactor thread i to CPU (i modulo number of CPUs)
+ *
+ * \return true on success, false when reactor mode is not supported
+ */
+bool
+CS104_Slave_setReactorThreads(CS104_Slave self, int numberOfThreads, bool pinThreads);
+
+/**
+ * \brief Get the number of connections served by a reactor thread
+ *
+ * \param self CS104_Slave instance
+ * \param reactor index of the reactor thread (0 to numberOfThreads - 1)
+ *
+ * \return number of connections, -1 when reactor mode is not used or the index is invalid
+ */
+int
+CS104_Slave_getReactorConnections(CS104_Slave self, int reactor);
+
+/**
+ * \brief Set the acknowledgement policy for received I-frames
+ *
+ * With CS104_ACK_POLICY_DELAYED fewer S-frames are sent when the slave answers requests
+ * or sends spontaneous data anyway. The delay is limited to t2.
+ *
+ * NOTE: Has to be called before CS104_Slave_start.
+ *
+ * \param self CS104_Slave instance
+ * \param policy the acknowledgement policy
+ * \param ackDelayMs maximum delay of the S-frame after w unconfirmed I-frames (CS104_ACK_POLICY_DELAYED only)
+ */
+void
+CS104_Slave_setAckPolicy(CS104_Slave self, CS104_AckPolicy policy, int ackDelayMs);
+
 /**
  * \brief Start the CS 104 slave. The slave (server) will listen on the configured TCP/IP port
  *
@@ -319,6 +434,46 @@ CS104_Slave_tick(CS104_Slave self);
 int
 CS104_Slave_getNumberOfQueueEntries(CS104_Slave self, CS104_RedundancyGroup redGroup);
 
+/**
+ * \brief Gets the high-water mark of the low-priority queue
+ *
+ * The high-water mark is the maximum number of ASDUs that were in the queue at the same
+ * time since the server was started or since the last call with reset set to true.
+ *
+ * NOTE: Mode CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP is not supported by this function.
+ *
+ * \param redGroup the redundancy group to use or NULL for single redundancy mode
+ * \param reset when true, restart tracking from the current number of queue entries
+ *
+ * \return the high-water mark of the low-priority queue
+ */
+int
+CS104_Slave_getQueueHighWaterMark(CS104_Slave self, CS104_RedundancyGroup redGroup, bool reset);
+
+/**
+ * \brief Gets the number of ASDUs that were overwritten in the low-priority queue because it was full
+ *
+ * NOTE: Mode CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP is not supported by this function.
+ *
+ * \param redGroup the redundancy group to use or NULL for single redundancy mode
+ *
+ * \return the number of dropped ASDUs since the server was started
+ */
+uint64_t
+CS104_Slave_getNumberOfDroppedQueueEntries(CS104_Slave self, CS104_RedundancyGroup redGroup);
+
+/**
+ * \brief Gets the runtime statistics of a client connection
+ *
+ * Can be called from any thread, e.g. from a periodic monitoring task. The counters are
+ * updated without locks, so the values of different counters can be a few messages apart.
+ *
+ * \param connection the client connection (as passed to the connection event handler)
+ * \param stats the structure to fill
+ */
+void
+CS104_Slave_getConnectionStatistics(CS104_Slave self, IMasterConnection connection, CS104_ConnectionStatistics* stats);
+
 /**
  * \brief Add an ASDU to the low-priority queue of the slave (use for periodic and spontaneous messages)
  *
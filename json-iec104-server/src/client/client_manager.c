@@ -2,6 +2,8 @@
 #include "../utils/logger.h"
 #include "../../cJSON/cJSON.h"
 #include "hal_time.h"
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 
@@ -9,35 +11,107 @@
 typedef struct {
     char ip_address[128];
     IMasterConnection connection;
+    CS104_Slave slave;
     uint64_t connect_time;
-    bool is_active;
 } ConnectedClient;
 
 // Client tracking state
-static ConnectedClient clients[MAX_CLIENTS];
+static ConnectedClient* clients = NULL;     // Dense array, client_count entries
+static int client_capacity = 0;
+static int* client_index = NULL;            // Hash index: connection -> position in clients (-1 = empty)
+static int index_size = 0;                  // Power of two, 2 * client_capacity
 static pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int client_count = 0;
 static bool initialized = false;
 
+static inline int hash_slot(IMasterConnection connection) {
+    uintptr_t h = (uintptr_t)connection;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return (int)(h & (uintptr_t)(index_size - 1));
+}
+
+// Find the hash slot holding the connection, or -1
+static int find_slot(IMasterConnection connection) {
+    if (index_size == 0) return -1;
+
+    for (int slot = hash_slot(connection); client_index[slot] >= 0; slot = (slot + 1) & (index_size - 1)) {
+        if (clients[client_index[slot]].connection == connection) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+static void insert_index(int pos) {
+    int slot = hash_slot(clients[pos].connection);
+    while (client_index[slot] >= 0) {
+        slot = (slot + 1) & (index_size - 1);
+    }
+    client_index[slot] = pos;
+}
+
+// Remove a slot from the linear-probing index, shifting later entries back
+static void remove_slot(int slot) {
+    int mask = index_size - 1;
+    int next = (slot + 1) & mask;
+
+    client_index[slot] = -1;
+
+    while (client_index[next] >= 0) {
+        int pos = client_index[next];
+        int home = hash_slot(clients[pos].connection);
+
+        // Move the entry back if its home lies cyclically outside (slot, next]
+        bool move = (slot <= next) ? (home <= slot || home > next) : (home <= slot && home > next);
+        if (move) {
+            client_index[slot] = pos;
+            client_index[next] = -1;
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+}
+
+static bool grow_table(void) {
+    int new_capacity = client_capacity ? client_capacity * 2 : CLIENT_TABLE_INITIAL_CAPACITY;
+
+    ConnectedClient* new_clients = (ConnectedClient*)realloc(clients, new_capacity * sizeof(ConnectedClient));
+    if (!new_clients) return false;
+    clients = new_clients;
+
+    int new_index_size = new_capacity * 2;
+    int* new_index = (int*)malloc(new_index_size * sizeof(int));
+    if (!new_index) return false;
+
+    free(client_index);
+    client_index = new_index;
+    index_size = new_index_size;
+    client_capacity = new_capacity;
+
+    for (int i = 0; i < index_size; i++) {
+        client_index[i] = -1;
+    }
+    for (int i = 0; i < client_count; i++) {
+        insert_index(i);
+    }
+
+    return true;
+}
+
 void client_manager_init(void) {
     if (initialized) return;
 
     pthread_mutex_lock(&clients_mutex);
 
-    // Initialize all client slots
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        clients[i].is_active = false;
-        clients[i].connection = NULL;
-        clients[i].ip_address[0] = '\0';
-        clients[i].connect_time = 0;
-    }
-
     client_count = 0;
+    grow_table();
     initialized = true;
 
     pthread_mutex_unlock(&clients_mutex);
 
-    LOG_INFO("Client manager initialized (max clients: %d)", MAX_CLIENTS);
+    LOG_INFO("Client manager initialized");
 }
 
 void client_manager_cleanup(void) {
@@ -46,11 +120,12 @@ void client_manager_cleanup(void) {
     pthread_mutex_lock(&clients_mutex);
 
     // Clear all client data
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        clients[i].is_active = false;
-        clients[i].connection = NULL;
-    }
-
+    free(clients);
+    free(client_index);
+    clients = NULL;
+    client_index = NULL;
+    client_capacity = 0;
+    index_size = 0;
     client_count = 0;
     initialized = false;
 
@@ -59,46 +134,54 @@ void client_manager_cleanup(void) {
     LOG_INFO("Client manager cleaned up");
 }
 
-static void add_client(IMasterConnection connection, const char* ip_address) {
+static void add_client(CS104_Slave slave, IMasterConnection connection, const char* ip_address) {
     pthread_mutex_lock(&clients_mutex);
 
     // Check if client already exists
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i].is_active && clients[i].connection == connection) {
-            pthread_mutex_unlock(&clients_mutex);
-            return;
-        }
+    if (find_slot(connection) >= 0) {
+        pthread_mutex_unlock(&clients_mutex);
+        return;
     }
 
-    // Find empty slot
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (!clients[i].is_active) {
-            strncpy(clients[i].ip_address, ip_address, sizeof(clients[i].ip_address) - 1);
-            clients[i].ip_address[sizeof(clients[i].ip_address) - 1] = '\0';
-            clients[i].connection = connection;
-            clients[i].connect_time = Hal_getTimeInMs();
-            clients[i].is_active = true;
-            client_count++;
-            LOG_INFO("Client connected: %s (total: %d)", ip_address, client_count);
-            break;
-        }
+    if (client_count == client_capacity && !grow_table()) {
+        LOG_ERROR("Out of memory tracking client %s", ip_address);
+        pthread_mutex_unlock(&clients_mutex);
+        return;
     }
 
+    ConnectedClient* client = &clients[client_count];
+    strncpy(client->ip_address, ip_address, sizeof(client->ip_address) - 1);
+    client->ip_address[sizeof(client->ip_address) - 1] = '\0';
+    client->connection = connection;
+    client->slave = slave;
+    client->connect_time = Hal_getTimeInMs();
+    insert_index(client_count);
+    client_count++;
+    LOG_INFO("Client connected: %s (total: %d)", ip_address, client_count);
+
     pthread_mutex_unlock(&clients_mutex);
 }
 
 static void remove_client(IMasterConnection connection) {
     pthread_mutex_lock(&clients_mutex);
 
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i].is_active && clients[i].connection == connection) {
-            LOG_INFO("Client disconnected: %s (total: %d)",
-                     clients[i].ip_address, client_count - 1);
-            clients[i].is_active = false;
-            clients[i].connection = NULL;
-            client_count--;
-            break;
+    int slot = find_slot(connection);
+    if (slot >= 0) {
+        int pos = client_index[slot];
+
+        LOG_INFO("Client disconnected: %s (total: %d)",
+                 clients[pos].ip_address, client_count - 1);
+
+        remove_slot(slot);
+
+        // Keep the array dense: move the last client into the freed position
+        int last = client_count - 1;
+        if (pos != last) {
+            int last_slot = find_slot(clients[last].connection);
+            clients[pos] = clients[last];
+            client_index[last_slot] = pos;
         }
+        client_count--;
     }
 
     pthread_mutex_unlock(&clients_mutex);
@@ -106,13 +189,13 @@ static void remove_client(IMasterConnection connection) {
 
 void client_connection_event_handler(void* parameter, IMasterConnection connection,
                                      CS104_PeerConnectionEvent event) {
-    (void)parameter;
+    CS104_Slave slave = (CS104_Slave)parameter;
 
     switch (event) {
         case CS104_CON_EVENT_CONNECTION_OPENED: {
             char peerAddr[128];
             IMasterConnection_getPeerAddress(connection, peerAddr, sizeof(peerAddr));
-            add_client(connection, peerAddr);
+            add_client(slave, connection, peerAddr);
             break;
         }
         case CS104_CON_EVENT_CONNECTION_CLOSED:
@@ -133,19 +216,109 @@ char* client_manager_get_clients_json(void) {
 
     pthread_mutex_lock(&clients_mutex);
 
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i].is_active) {
-            cJSON* client_obj = cJSON_CreateObject();
-            cJSON_AddStringToObject(client_obj, "ip", clients[i].ip_address);
-            cJSON_AddNumberToObject(client_obj, "connect_time", (double)clients[i].connect_time);
-            cJSON_AddItemToArray(clients_array, client_obj);
-        }
+    for (int i = 0; i < client_count; i++) {
+        cJSON* client_obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(client_obj, "ip", clients[i].ip_address);
+        cJSON_AddNumberToObject(client_obj, "connect_time", (double)clients[i].connect_time);
+        cJSON_AddItemToArray(clients_array, client_obj);
     }
 
+    int count = client_count;
+
     pthread_mutex_unlock(&clients_mutex);
 
     cJSON_AddItemToObject(response, "connected_clients", clients_array);
-    cJSON_AddNumberToObject(response, "count", client_count);
+    cJSON_AddNumberToObject(response, "count", count);
+
+    char* json_str = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+
+    return json_str;
+}
+
+// Upper bound (ms) of the histogram bucket that contains the given percentile
+static uint64_t rtt_percentile_ms(const CS104_ConnectionStatistics* stats, double percentile) {
+    if (stats->ackRttCount == 0) return 0;
+
+    uint64_t rank = (uint64_t)(stats->ackRttCount * percentile / 100.0);
+    uint64_t seen = 0;
+
+    for (int i = 0; i < CS104_ACK_RTT_HISTOGRAM_BUCKETS; i++) {
+        seen += stats->ackRttHistogram[i];
+        if (seen > rank) {
+            return (uint64_t)1 << i;
+        }
+    }
+    return stats->ackRttMaxMs;
+}
+
+static cJSON* create_metrics_object(const ConnectedClient* client) {
+    CS104_ConnectionStatistics stats;
+    CS104_Slave_getConnectionStatistics(client->slave, client->connection, &stats);
+
+    cJSON* obj = cJSON_CreateObject();
+    cJSON_AddStringToObject(obj, "ip", client->ip_address);
+    cJSON_AddNumberToObject(obj, "connect_time", (double)client->connect_time);
+    cJSON_AddNumberToObject(obj, "reactor", stats.reactor);
+    cJSON_AddNumberToObject(obj, "i_sent", (double)stats.iFramesSent);
+    cJSON_AddNumberToObject(obj, "i_received", (double)stats.iFramesReceived);
+    cJSON_AddNumberToObject(obj, "s_sent", (double)stats.sFramesSent);
+    cJSON_AddNumberToObject(obj, "s_received", (double)stats.sFramesReceived);
+    cJSON_AddNumberToObject(obj, "u_sent", (double)stats.uFramesSent);
+    cJSON_AddNumberToObject(obj, "u_received", (double)stats.uFramesReceived);
+    cJSON_AddNumberToObject(obj, "bytes_sent", (double)stats.bytesSent);
+    cJSON_AddNumberToObject(obj, "bytes_received", (double)stats.bytesReceived);
+    cJSON_AddNumberToObject(obj, "k_window", stats.kWindowOccupancy);
+    cJSON_AddNumberToObject(obj, "k_window_hwm", stats.kWindowHighWaterMark);
+    cJSON_AddNumberToObject(obj, "t1_timeouts", (double)stats.t1Timeouts);
+    cJSON_AddNumberToObject(obj, "t3_timeouts", (double)stats.t3Timeouts);
+    cJSON_AddNumberToObject(obj, "high_prio_drops", (double)stats.highPrioQueueDrops);
+    cJSON_AddNumberToObject(obj, "low_prio_queue_hwm", stats.lowPrioQueueHighWaterMark);
+    cJSON_AddNumberToObject(obj, "acks_piggybacked", (double)stats.acksPiggybacked);
+    cJSON_AddNumberToObject(obj, "k_window_stalls", (double)stats.kWindowStalls);
+    cJSON_AddNumberToObject(obj, "k_window_stall_ms", (double)stats.kWindowStallMs);
+
+    // Achieved throughput and the share of the connection time spent window-bound
+    uint64_t now = Hal_getTimeInMs();
+    double connected_s = (now > client->connect_time) ? (now - client->connect_time) / 1000.0 : 0.0;
+    cJSON_AddNumberToObject(obj, "i_sent_per_s", connected_s > 0 ? stats.iFramesSent / connected_s : 0.0);
+    cJSON_AddNumberToObject(obj, "window_bound_pct",
+                            connected_s > 0 ? stats.kWindowStallMs / (connected_s * 10.0) : 0.0);
+
+    cJSON* rtt = cJSON_CreateObject();
+    cJSON_AddNumberToObject(rtt, "count", (double)stats.ackRttCount);
+    cJSON_AddNumberToObject(rtt, "avg_ms", stats.ackRttCount ? (double)stats.ackRttSumMs / stats.ackRttCount : 0.0);
+    cJSON_AddNumberToObject(rtt, "max_ms", (double)stats.ackRttMaxMs);
+    cJSON_AddNumberToObject(rtt, "p50_ms", (double)rtt_percentile_ms(&stats, 50.0));
+    cJSON_AddNumberToObject(rtt, "p99_ms", (double)rtt_percentile_ms(&stats, 99.0));
+
+    cJSON* histogram = cJSON_CreateArray();
+    for (int i = 0; i < CS104_ACK_RTT_HISTOGRAM_BUCKETS; i++) {
+        cJSON_AddItemToArray(histogram, cJSON_CreateNumber((double)stats.ackRttHistogram[i]));
+    }
+    cJSON_AddItemToObject(rtt, "histogram", histogram);
+    cJSON_AddItemToObject(obj, "ack_rtt", rtt);
+
+    return obj;
+}
+
+char* client_manager_get_metrics_json(void) {
+    cJSON* response = cJSON_CreateObject();
+    cJSON* connections = cJSON_CreateArray();
+
+    // The connection objects stay valid while the client is in the table
+    pthread_mutex_lock(&clients_mutex);
+
+    for (int i = 0; i < client_count; i++) {
+        cJSON_AddItemToArray(connections, create_metrics_object(&clients[i]));
+    }
+
+    int count = client_count;
+
+    pthread_mutex_unlock(&clients_mutex);
+
+    cJSON_AddItemToObject(response, "connections", connections);
+    cJSON_AddNumberToObject(response, "count", count);
 
     char* json_str = cJSON_PrintUnformatted(response);
     cJSON_Delete(response);
@@ -12,9 +12,15 @@
  * - IP addresses and connection times
  * - Connection/disconnection events
  * - Active client queries
+ * - Per-connection link metrics (frame counters, k-window, ack RTT, timeouts)
+ *
+ * The client table grows on demand, so the number of tracked clients is only
+ * limited by the server's max_connections. Clients are kept in a dense array
+ * with a hash index on the connection, so connect/disconnect events are O(1).
  */
 
-#define MAX_CLIENTS 10
+// Initial size of the client table
+#define CLIENT_TABLE_INITIAL_CAPACITY 16
 
 /**
  * Initialize client manager
@@ -30,7 +36,7 @@ void client_manager_cleanup(void);
  * Connection event handler for CS104_Slave
  * Called automatically by lib60870 when clients connect/disconnect
  *
- * @param parameter User-defined parameter (unused)
+ * @param parameter The CS104_Slave the connection belongs to (used for link metrics)
  * @param connection The client connection
  * @param event Connection event type
  */
@@ -45,4 +51,14 @@ void client_connection_event_handler(void* parameter, IMasterConnection connecti
  */
 char* client_manager_get_clients_json(void);
 
+/**
+ * Get JSON string with the link metrics of all connected clients
+ * Returns allocated string that must be freed by caller
+ *
+ * Ack RTT percentiles are upper bounds of the power-of-two histogram buckets.
+ *
+ * @return JSON string like: {"connections":[{"ip":"127.0.0.1:1234","i_sent":10,...,"ack_rtt":{...}}],"count":1}
+ */
+char* client_manager_get_metrics_json(void);
+
 #endif // CLIENT_MANAGER_H
@@ -0,0 +1,510 @@
+#include "config_image.h"
+#include "config_parser.h"
+#include "../data/data_manager.h"
+#include "../protocol/interrogation.h"
+#include "../protocol/packing_plan.h"
+#include "../threads/periodic_sender.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char IMAGE_MAGIC[8] = { 'I', 'E', 'C', '1', '0', '4', 'I', 'M' };
+
+static void* image_base = NULL;
+static size_t image_length = 0;
+
+static uint64_t fnv1a(const unsigned char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Checksum of the image body: FNV-1a over 64-bit words
+ *
+ * Every step is a bijection of the running hash, so any single damaged word
+ * changes the result. Eight bytes per step keep it cheap next to mapping the
+ * image.
+ */
+uint64_t config_image_body_hash(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+    for (; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+// Map a file read-only, returns NULL if it cannot be opened or is empty
+static void* map_file(const char* filename, size_t* size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    void* data = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            data = NULL;
+        } else {
+            *size = (size_t)st.st_size;
+        }
+    }
+
+    close(fd);
+    return data;
+}
+
+static bool hash_json_file(const char* json_file, uint64_t* hash, uint64_t* size) {
+    size_t length = 0;
+    void* json = map_file(json_file, &length);
+    if (!json) {
+        return false;
+    }
+
+    *hash = fnv1a((const unsigned char*)json, length);
+    *size = length;
+    munmap(json, length);
+    return true;
+}
+
+bool config_image_default_path(const char* json_file, char* image_file, size_t size) {
+    int n = snprintf(image_file, size, "%s.img", json_file);
+    return n > 0 && (size_t)n < size;
+}
+
+// Write `size` bytes at `offset`, zero-padding from the current position
+static bool write_at(FILE* f, uint64_t offset, const void* data, size_t size) {
+    static const char zeros[8] = { 0 };
+
+    long pos = ftell(f);
+    if (pos < 0 || (uint64_t)pos > offset || offset - (uint64_t)pos > sizeof(zeros)) {
+        return false;
+    }
+    if (fwrite(zeros, 1, offset - (uint64_t)pos, f) != offset - (uint64_t)pos) {
+        return false;
+    }
+    return size == 0 || fwrite(data, 1, size, f) == size;
+}
+
+// Hash the body written so far and store it in the header (f must be readable)
+static bool write_body_hash(FILE* f, ConfigImageHeader* header) {
+    if (fflush(f) != 0) {
+        return false;
+    }
+
+    void* image = mmap(NULL, header->image_size, PROT_READ, MAP_SHARED, fileno(f), 0);
+    if (image == MAP_FAILED) {
+        return false;
+    }
+    header->body_hash = config_image_body_hash((const char*)image + sizeof(ConfigImageHeader),
+                                               header->image_size - sizeof(ConfigImageHeader));
+    munmap(image, header->image_size);
+
+    return fseek(f, 0, SEEK_SET) == 0 && fwrite(header, 1, sizeof(*header), f) == sizeof(*header);
+}
+
+// JSON of the configuration without the point lists
+static char* settings_json(const char* content) {
+    cJSON* json = cJSON_Parse(content);
+    if (!json) {
+        return NULL;
+    }
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        char key[64];
+        snprintf(key, sizeof(key), "%s_config", DATA_TYPE_TABLE[i].name);
+        cJSON_DeleteItemFromObjectCaseSensitive(json, key);
+    }
+
+    char* settings = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    return settings;
+}
+
+static bool write_image(FILE* f, uint64_t json_hash, uint64_t json_size,
+                        const char* settings, const PackingPlan* plans) {
+    int type_count = DATA_TYPE_COUNT;
+    uint32_t index_capacity = 0;
+    const IoaIndexEntry* index = get_ioa_index(&index_capacity);
+
+    ConfigImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version = CONFIG_IMAGE_VERSION;
+    header.header_size = sizeof(ConfigImageHeader);
+    header.json_hash = json_hash;
+    header.json_size = json_size;
+    header.ioa_size = sizeof(int);
+    header.chunk_size = sizeof(PackedChunk);
+    header.index_entry_size = sizeof(IoaIndexEntry);
+    header.plan_asdu_size = CONFIG_IMAGE_PLAN_ASDU_SIZE;
+    header.type_count = type_count;
+    header.index_capacity = index_capacity;
+
+    // Lay out the sections
+    ConfigImageType types[type_count];
+    memset(types, 0, sizeof(types));
+
+    uint64_t offset = align8(sizeof(ConfigImageHeader));
+    header.settings_offset = offset;
+    offset = align8(offset + strlen(settings) + 1);
+    header.types_offset = offset;
+    offset = align8(offset + sizeof(types));
+
+    for (int i = 0; i < type_count; i++) {
+        const DataTypeContext* ctx = &g_data_contexts[i];
+        types[i].type_id = ctx->type_id;
+        types[i].count = ctx->config.count;
+        types[i].plan_count = plans[i].count;
+        types[i].ioa_offset = offset;
+        offset = align8(offset + (uint64_t)ctx->config.count * sizeof(int));
+        types[i].plan_offset = offset;
+        offset = align8(offset + (uint64_t)plans[i].count * sizeof(PackedChunk));
+    }
+
+    header.index_offset = offset;
+    header.image_size = offset + (uint64_t)index_capacity * sizeof(IoaIndexEntry);
+
+    // Write them in the same order, then the header again with the body hash
+    if (!write_at(f, 0, &header, sizeof(header)) ||
+        !write_at(f, header.settings_offset, settings, strlen(settings) + 1) ||
+        !write_at(f, header.types_offset, types, sizeof(types))) {
+        return false;
+    }
+
+    for (int i = 0; i < type_count; i++) {
+        const DataTypeContext* ctx = &g_data_contexts[i];
+        if (!write_at(f, types[i].ioa_offset, ctx->config.ioa_list, (size_t)ctx->config.count * sizeof(int)) ||
+            !write_at(f, types[i].plan_offset, plans[i].chunks, (size_t)plans[i].count * sizeof(PackedChunk))) {
+            return false;
+        }
+    }
+
+    return write_at(f, header.index_offset, index, (size_t)index_capacity * sizeof(IoaIndexEntry)) &&
+           write_body_hash(f, &header);
+}
+
+/**
+ * Compile a JSON configuration into a station image
+ *
+ * The image is written to "<image_file>.tmp" and renamed, so a server
+ * starting at the same time never maps a half-written image.
+ */
+bool config_image_compile(const char* json_file, const char* image_file) {
+    size_t length = 0;
+    void* json = map_file(json_file, &length);
+    if (!json) {
+        LOG_ERROR("Failed to open config file: %s", json_file);
+        return false;
+    }
+
+    uint64_t json_hash = fnv1a((const unsigned char*)json, length);
+
+    char* content = (char*)malloc(length + 1);
+    if (!content) {
+        LOG_ERROR("Failed to allocate memory for config file");
+        munmap(json, length);
+        return false;
+    }
+    memcpy(content, json, length);
+    content[length] = '\0';
+    munmap(json, length);
+
+    char* settings = NULL;
+    PackingPlan plans[DATA_TYPE_COUNT];
+    memset(plans, 0, sizeof(plans));
+    bool ok = false;
+
+    if (!parse_config_from_json(content)) {
+        goto done;
+    }
+
+    settings = settings_json(content);
+    if (!settings) {
+        LOG_ERROR("Failed to extract settings from %s", json_file);
+        goto done;
+    }
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        const DataTypeContext* ctx = &g_data_contexts[i];
+        if (ctx->config.count > 0 &&
+            !packing_plan_build(&plans[i], ctx->config.ioa_list, NULL, ctx->config.count,
+                                ctx->type_info->io_size, CONFIG_IMAGE_PLAN_ASDU_SIZE)) {
+            LOG_ERROR("Failed to build packing plan for %s", ctx->type_info->name);
+            goto done;
+        }
+    }
+
+    char tmp_file[4096];
+    if (snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", image_file) >= (int)sizeof(tmp_file)) {
+        LOG_ERROR("Image path too long: %s", image_file);
+        goto done;
+    }
+
+    FILE* f = fopen(tmp_file, "w+b");
+    if (!f) {
+        LOG_ERROR("Failed to create station image: %s", tmp_file);
+        goto done;
+    }
+
+    bool written = write_image(f, json_hash, length, settings, plans);
+    if (fclose(f) != 0) {
+        written = false;
+    }
+
+    if (!written || rename(tmp_file, image_file) != 0) {
+        LOG_ERROR("Failed to write station image: %s", image_file);
+        remove(tmp_file);
+        goto done;
+    }
+
+    LOG_INFO("Compiled %s into station image %s", json_file, image_file);
+    ok = true;
+
+done:
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        packing_plan_free(&plans[i]);
+    }
+    free(settings);
+    free(content);
+    return ok;
+}
+
+static bool section_valid(const ConfigImageHeader* header, uint64_t offset, uint64_t count, uint64_t size) {
+    return offset % 8 == 0 && offset >= sizeof(ConfigImageHeader) && offset <= header->image_size &&
+           count <= (header->image_size - offset) / size;
+}
+
+// Check the header, that every section lies within the image, and the body hash
+static bool image_valid(const ConfigImageHeader* header, size_t length) {
+    if (length < sizeof(ConfigImageHeader) ||
+        memcmp(header->magic, IMAGE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CONFIG_IMAGE_VERSION ||
+        header->header_size != sizeof(ConfigImageHeader) ||
+        header->image_size != length ||
+        header->ioa_size != sizeof(int) ||
+        header->chunk_size != sizeof(PackedChunk) ||
+        header->index_entry_size != sizeof(IoaIndexEntry) ||
+        header->type_count != (uint32_t)DATA_TYPE_COUNT) {
+        return false;
+    }
+
+    const char* base = (const char*)header;
+
+    if (!section_valid(header, header->settings_offset, 1, 1) ||
+        memchr(base + header->settings_offset, '\0', length - header->settings_offset) == NULL) {
+        return false;
+    }
+
+    if (!section_valid(header, header->types_offset, header->type_count, sizeof(ConfigImageType))) {
+        return false;
+    }
+
+    const ConfigImageType* types = (const ConfigImageType*)(base + header->types_offset);
+    for (uint32_t i = 0; i < header->type_count; i++) {
+        if (types[i].type_id != (uint32_t)g_data_contexts[i].type_id ||
+            types[i].count < 0 || types[i].plan_count < 0 ||
+            !section_valid(header, types[i].ioa_offset, (uint64_t)types[i].count, sizeof(int)) ||
+            !section_valid(header, types[i].plan_offset, (uint64_t)types[i].plan_count, sizeof(PackedChunk))) {
+            return false;
+        }
+    }
+
+    uint32_t capacity = header->index_capacity;
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        !section_valid(header, header->index_offset, capacity, sizeof(IoaIndexEntry))) {
+        return false;
+    }
+
+    return config_image_body_hash(base + sizeof(ConfigImageHeader),
+                                  length - sizeof(ConfigImageHeader)) == header->body_hash;
+}
+
+/**
+ * Check the entries of a structurally valid image
+ *
+ * IOA lists must be sorted and unique (find_ioa_index() bisects them), plans
+ * must cover their list exactly, and every used index slot must point at its
+ * own IOA. The index needs a free slot, or a lookup of an unknown IOA would
+ * never end.
+ */
+static bool entries_valid(const ConfigImageHeader* header) {
+    const char* base = (const char*)header;
+    const ConfigImageType* types = (const ConfigImageType*)(base + header->types_offset);
+
+    for (uint32_t i = 0; i < header->type_count; i++) {
+        const int* ioas = (const int*)(base + types[i].ioa_offset);
+        for (int32_t k = 1; k < types[i].count; k++) {
+            if (ioas[k] <= ioas[k - 1]) {
+                return false;
+            }
+        }
+
+        const PackedChunk* chunks = (const PackedChunk*)(base + types[i].plan_offset);
+        int32_t next = 0;
+        for (int32_t c = 0; c < types[i].plan_count; c++) {
+            if (chunks[c].start != next || chunks[c].count <= 0 ||
+                chunks[c].count > types[i].count - next) {
+                return false;
+            }
+            if (chunks[c].sequence &&
+                ioas[next + chunks[c].count - 1] - ioas[next] != chunks[c].count - 1) {
+                return false;
+            }
+            next += chunks[c].count;
+        }
+        if (next != types[i].count) {
+            return false;
+        }
+    }
+
+    const IoaIndexEntry* index = (const IoaIndexEntry*)(base + header->index_offset);
+    uint32_t free_slots = 0;
+    for (uint32_t slot = 0; slot < header->index_capacity; slot++) {
+        const IoaIndexEntry* entry = &index[slot];
+        if (entry->ctx < 0) {
+            free_slots++;
+            continue;
+        }
+        if (entry->ctx >= (int)header->type_count || entry->idx < 0 ||
+            entry->idx >= types[entry->ctx].count ||
+            ((const int*)(base + types[entry->ctx].ioa_offset))[entry->idx] != entry->ioa) {
+            return false;
+        }
+    }
+    return free_slots > 0;
+}
+
+/**
+ * Load the configuration from a station image
+ *
+ * The image (body hash, bounds and entries) is fully checked before anything
+ * is loaded. Only the settings
+ * JSON is parsed; the IOA lists, the index and the packing plans point
+ * into the mapping, which stays until config_image_unload().
+ */
+bool config_image_load(const char* json_file, const char* image_file) {
+    size_t length = 0;
+    void* base = map_file(image_file, &length);
+    if (!base) {
+        LOG_DEBUG("No station image %s", image_file);
+        return false;
+    }
+
+    const ConfigImageHeader* header = (const ConfigImageHeader*)base;
+    if (!image_valid(header, length) || !entries_valid(header)) {
+        LOG_WARN("Station image %s is invalid or from another version, parsing %s", image_file, json_file);
+        munmap(base, length);
+        return false;
+    }
+
+    uint64_t json_hash = 0, json_size = 0;
+    if (!hash_json_file(json_file, &json_hash, &json_size) ||
+        json_hash != header->json_hash || json_size != header->json_size) {
+        LOG_WARN("Station image %s is stale, parsing %s", image_file, json_file);
+        munmap(base, length);
+        return false;
+    }
+
+    cJSON* settings = cJSON_Parse((const char*)base + header->settings_offset);
+    if (!settings || !parse_global_settings(settings)) {
+        LOG_ERROR("Invalid settings in station image %s", image_file);
+        cJSON_Delete(settings);
+        munmap(base, length);
+        return false;
+    }
+
+    // Point directory and values
+    const ConfigImageType* types = (const ConfigImageType*)((const char*)base + header->types_offset);
+    int points = 0;
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        DataTypeContext* ctx = &g_data_contexts[i];
+        if (types[i].count == 0) continue;
+
+        ctx->config.ioa_list = (int*)((char*)base + types[i].ioa_offset);
+        ctx->config.count = types[i].count;
+        ctx->config.mapped = true;
+
+        if (!init_data_storage(ctx)) {
+            goto fail;
+        }
+        points += types[i].count;
+    }
+
+    set_ioa_index((const IoaIndexEntry*)((const char*)base + header->index_offset), header->index_capacity);
+
+    if (!parse_deadband_config(settings, g_data_contexts)) {
+        LOG_ERROR("Failed to parse deadband configuration");
+        goto fail;
+    }
+    if (!parse_offline_config(settings, g_data_contexts)) {
+        LOG_ERROR("Failed to parse offline configuration");
+        goto fail;
+    }
+
+    // Periodic groups resolve their IOAs through the index
+    PeriodicGroupList periodic_groups = { NULL, 0, 0 };
+    if (!parse_periodic_config(settings, g_data_contexts, &periodic_groups)) {
+        LOG_ERROR("Failed to parse periodic configuration");
+        periodic_free_groups(&periodic_groups);
+        goto fail;
+    }
+    periodic_commit_groups(&periodic_groups);
+    periodic_free_groups(&periodic_groups);
+    cJSON_Delete(settings);
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        if (types[i].count > 0) {
+            interrogation_use_plan(&g_data_contexts[i],
+                                   (const PackedChunk*)((const char*)base + types[i].plan_offset),
+                                   types[i].plan_count, (int)header->plan_asdu_size);
+        }
+    }
+
+    image_base = base;
+    image_length = length;
+
+    LOG_INFO("Loaded station image %s (%d points)", image_file, points);
+    return true;
+
+fail:
+    cJSON_Delete(settings);
+    cleanup_data_contexts();
+    init_data_contexts();
+    munmap(base, length);
+    return false;
+}
+
+void config_image_unload(void) {
+    if (image_base) {
+        munmap(image_base, image_length);
+        image_base = NULL;
+        image_length = 0;
+    }
+}
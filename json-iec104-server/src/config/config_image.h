@@ -0,0 +1,118 @@
+#ifndef CONFIG_IMAGE_H
+#define CONFIG_IMAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Station Image Module
+ *
+ * A station image is the JSON configuration compiled into a binary file
+ * (json-iec104-server --compile-config config.json). It holds everything
+ * that is expensive to derive from the JSON:
+ * - The sorted IOA list of every data type (point directory, slot layout)
+ * - The IOA lookup index used by read commands
+ * - The interrogation packing plan of every type
+ * - The remaining settings (global settings, periodic groups) as compact JSON
+ *
+ * At startup the server maps the image and uses the lists, index and plans
+ * in place, so only the small settings JSON is parsed. The image records a
+ * hash of the JSON it was compiled from and a checksum of its own body; if
+ * the JSON has changed since, or the image is missing, damaged or was written
+ * by another version, the server parses the JSON as before.
+ *
+ * The image uses the host's byte order and structure layout and is not
+ * meant to be moved between architectures.
+ */
+
+#define CONFIG_IMAGE_VERSION 2
+
+/**
+ * Image layout
+ *
+ *   ConfigImageHeader
+ *   settings      NUL-terminated JSON without the *_config arrays
+ *   types         ConfigImageType per data context, in g_data_contexts order
+ *   per type      int IOA list, PackedChunk plan
+ *   index         IoaIndexEntry table
+ *
+ * Every section starts at a multiple of 8 bytes. body_hash covers everything
+ * after the header, so a damaged image is rejected before any entry is used.
+ */
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t json_hash;             // FNV-1a of the JSON configuration
+    uint64_t json_size;
+    uint64_t image_size;
+    uint64_t body_hash;             // config_image_body_hash() of the image after the header
+    uint32_t ioa_size;              // Layout checks
+    uint32_t chunk_size;
+    uint32_t index_entry_size;
+    uint32_t plan_asdu_size;        // ASDU size the plans were built for
+    uint32_t type_count;
+    uint32_t index_capacity;
+    uint64_t settings_offset;
+    uint64_t types_offset;
+    uint64_t index_offset;
+} ConfigImageHeader;
+
+typedef struct {
+    uint32_t type_id;
+    int32_t count;                  // Points
+    int32_t plan_count;             // Chunks
+    uint32_t reserved;
+    uint64_t ioa_offset;
+    uint64_t plan_offset;
+} ConfigImageType;
+
+// ASDU size the packing plans are compiled for (lib60870 default)
+#define CONFIG_IMAGE_PLAN_ASDU_SIZE 249
+
+/**
+ * Default image path for a configuration file ("<json_file>.img")
+ *
+ * @return false if the path does not fit into the buffer
+ */
+bool config_image_default_path(const char* json_file, char* image_file, size_t size);
+
+/**
+ * Compile a JSON configuration into a station image
+ *
+ * Parses the configuration like init_config_from_file() (the data contexts
+ * must be initialized) and writes the image atomically. The parsed
+ * configuration stays loaded; release it with periodic_clear_groups() and
+ * cleanup_data_contexts().
+ *
+ * @return true on success, false on error
+ */
+bool config_image_compile(const char* json_file, const char* image_file);
+
+/**
+ * Load the configuration from a station image
+ *
+ * @param json_file The JSON configuration the image must match
+ * @param image_file The station image
+ * @return true on success; false if the image is missing, invalid or stale,
+ *         in which case nothing is loaded and the JSON must be parsed
+ */
+bool config_image_load(const char* json_file, const char* image_file);
+
+/**
+ * Checksum stored in ConfigImageHeader.body_hash
+ *
+ * @param data The image after the header
+ * @param size Its size in bytes
+ */
+uint64_t config_image_body_hash(const void* data, size_t size);
+
+/**
+ * Unmap the loaded station image
+ * Call after interrogation_clear_plans() and cleanup_data_contexts().
+ */
+void config_image_unload(void);
+
+#endif // CONFIG_IMAGE_H
@@ -1,5 +1,7 @@
 #include "config_parser.h"
 #include "../utils/logger.h"
+#include "../threads/thread_policy.h"
+#include "cs104_slave.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +13,125 @@ extern int ASDU;
 extern char command_mode[64];
 extern int tcpPort;
 extern char local_ip[64];
+extern int reactor_threads;
+extern bool reactor_pin_threads;
+extern int max_connections;
+extern char capture_file[256];
+extern int capture_max_mb;
+extern char event_output[256];
+extern struct sCS104_APCIParameters apci_parameters;
+extern CS104_AckPolicy ack_policy;
+extern int ack_delay_ms;
+extern int select_timeout_ms;
+extern int max_selects;
+extern bool async_commands;
+extern int command_timeout_ms;
+extern int max_pending_commands;
+extern char value_snapshot_file[256];
+extern int value_snapshot_sync_ms;
+extern bool value_snapshot_non_topical;
+
+/**
+ * Parse the "apci" object: {"k": 12, "w": 8, "t0": 10, "t1": 15, "t2": 10, "t3": 20}
+ * Missing keys keep their value. Timeouts are in seconds.
+ */
+static bool parse_apci_parameters(cJSON* apci) {
+    struct sCS104_APCIParameters p = apci_parameters;
+
+    const char* names[] = { "k", "w", "t0", "t1", "t2", "t3" };
+    int* fields[] = { &p.k, &p.w, &p.t0, &p.t1, &p.t2, &p.t3 };
+
+    for (int i = 0; i < 6; i++) {
+        cJSON* item = cJSON_GetObjectItemCaseSensitive(apci, names[i]);
+        if (!item) continue;
+
+        if (!cJSON_IsNumber(item) || item->valueint <= 0) {
+            LOG_ERROR("Invalid apci.%s", names[i]);
+            return false;
+        }
+        *fields[i] = item->valueint;
+    }
+
+    if (p.k > 32767 || p.w > p.k) {
+        LOG_ERROR("Invalid apci window k=%d w=%d (w <= k <= 32767)", p.k, p.w);
+        return false;
+    }
+
+    if (p.t2 >= p.t1) {
+        LOG_ERROR("apci.t2 (%d s) must be less than apci.t1 (%d s)", p.t2, p.t1);
+        return false;
+    }
+
+    if (p.w * 3 > p.k * 2) {
+        LOG_WARN("apci.w=%d is more than 2/3 of k=%d", p.w, p.k);
+    }
+
+    apci_parameters = p;
+    LOG_DEBUG("Config: apci k=%d w=%d t0=%d t1=%d t2=%d t3=%d", p.k, p.w, p.t0, p.t1, p.t2, p.t3);
+    return true;
+}
+
+/**
+ * Parse the "threads" object: {"connection": {"cpus": [2, [4, 5]], "priority": 50}, ...}
+ * CPUs are numbers or inclusive [first, last] ranges; priority 0 keeps SCHED_OTHER.
+ */
+static bool parse_thread_policies(cJSON* threads) {
+    cJSON* entry = NULL;
+
+    cJSON_ArrayForEach(entry, threads) {
+        ThreadClass thread_class;
+        if (!thread_class_from_string(entry->string, &thread_class)) {
+            LOG_ERROR("Unknown thread class %s", entry->string ? entry->string : "(null)");
+            return false;
+        }
+        if (!cJSON_IsObject(entry)) {
+            LOG_ERROR("Invalid threads.%s", entry->string);
+            return false;
+        }
+
+        int cpus[THREAD_POLICY_MAX_CPUS];
+        int cpu_count = 0;
+        cJSON* cpu_array = cJSON_GetObjectItemCaseSensitive(entry, "cpus");
+        if (cpu_array) {
+            cJSON* cpu = NULL;
+            if (!cJSON_IsArray(cpu_array) || cJSON_GetArraySize(cpu_array) == 0) {
+                LOG_ERROR("Invalid threads.%s.cpus", entry->string);
+                return false;
+            }
+            cJSON_ArrayForEach(cpu, cpu_array) {
+                int first = -1, last = -1;
+                if (cJSON_IsNumber(cpu)) {
+                    first = last = cpu->valueint;
+                } else if (cJSON_IsArray(cpu) && cJSON_GetArraySize(cpu) == 2 &&
+                           cJSON_IsNumber(cpu->child) && cJSON_IsNumber(cpu->child->next)) {
+                    first = cpu->child->valueint;
+                    last = cpu->child->next->valueint;
+                }
+                if (first < 0 || first > last || last >= THREAD_POLICY_MAX_CPUS) {
+                    LOG_ERROR("Invalid CPU or CPU range in threads.%s.cpus", entry->string);
+                    return false;
+                }
+                for (int c = first; c <= last && cpu_count < THREAD_POLICY_MAX_CPUS; c++) {
+                    cpus[cpu_count++] = c;
+                }
+            }
+        }
+
+        int priority = 0;
+        cJSON* item = cJSON_GetObjectItemCaseSensitive(entry, "priority");
+        if (item) {
+            if (!cJSON_IsNumber(item) || item->valueint < 0 || item->valueint > THREAD_POLICY_MAX_PRIORITY) {
+                LOG_ERROR("Invalid threads.%s.priority (0 to %d)", entry->string, THREAD_POLICY_MAX_PRIORITY);
+                return false;
+            }
+            priority = item->valueint;
+        }
+
+        thread_policy_set(thread_class, cpu_count > 0 ? cpus : NULL, cpu_count, priority);
+        LOG_DEBUG("Config: threads.%s %d CPU(s) priority=%d", entry->string, cpu_count, priority);
+    }
+    return true;
+}
 
 /**
  * Parse global settings from JSON configuration
@@ -67,12 +188,259 @@ bool parse_global_settings(cJSON* json) {
         LOG_DEBUG("Config: local_ip=%s", local_ip);
     }
 
+    // Parse reactor mode (0 = one thread per connection, "auto" = one per CPU)
+    item = cJSON_GetObjectItemCaseSensitive(json, "reactor_threads");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint < 0) {
+            LOG_ERROR("Invalid reactor_threads %d", item->valueint);
+            return false;
+        }
+        reactor_threads = item->valueint;
+        LOG_DEBUG("Config: reactor_threads=%d", reactor_threads);
+    } else if (cJSON_IsString(item) && item->valuestring) {
+        if (strcmp(item->valuestring, "auto") != 0) {
+            LOG_ERROR("Invalid reactor_threads %s", item->valuestring);
+            return false;
+        }
+        reactor_threads = REACTOR_THREADS_AUTO;
+        LOG_DEBUG("Config: reactor_threads=auto");
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(json, "reactor_pin_threads");
+    if (cJSON_IsBool(item)) {
+        reactor_pin_threads = cJSON_IsTrue(item);
+        LOG_DEBUG("Config: reactor_pin_threads=%d", reactor_pin_threads);
+    }
+
+    // Parse connection limit (0 = library default)
+    item = cJSON_GetObjectItemCaseSensitive(json, "max_connections");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint < 0) {
+            LOG_ERROR("Invalid max_connections %d", item->valueint);
+            return false;
+        }
+        max_connections = item->valueint;
+        LOG_DEBUG("Config: max_connections=%d", max_connections);
+    }
+
+    // Parse APDU capture started at boot (empty = off)
+    item = cJSON_GetObjectItemCaseSensitive(json, "capture_file");
+    if (cJSON_IsString(item) && item->valuestring) {
+        strncpy(capture_file, item->valuestring, sizeof(capture_file) - 1);
+        capture_file[sizeof(capture_file) - 1] = '\0';
+        LOG_DEBUG("Config: capture_file=%s", capture_file);
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(json, "capture_max_mb");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint <= 0) {
+            LOG_ERROR("Invalid capture_max_mb %d", item->valueint);
+            return false;
+        }
+        capture_max_mb = item->valueint;
+        LOG_DEBUG("Config: capture_max_mb=%d", capture_max_mb);
+    }
+
+    // Parse event channel for commands and clock syncs (empty = stdout)
+    item = cJSON_GetObjectItemCaseSensitive(json, "event_output");
+    if (cJSON_IsString(item) && item->valuestring) {
+        strncpy(event_output, item->valuestring, sizeof(event_output) - 1);
+        event_output[sizeof(event_output) - 1] = '\0';
+        LOG_DEBUG("Config: event_output=%s", event_output);
+    }
+
+    // Parse select-before-operate limits
+    item = cJSON_GetObjectItemCaseSensitive(json, "select_timeout_ms");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint <= 0) {
+            LOG_ERROR("Invalid select_timeout_ms %d", item->valueint);
+            return false;
+        }
+        select_timeout_ms = item->valueint;
+        LOG_DEBUG("Config: select_timeout_ms=%d", select_timeout_ms);
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(json, "max_selects");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint <= 0) {
+            LOG_ERROR("Invalid max_selects %d", item->valueint);
+            return false;
+        }
+        max_selects = item->valueint;
+        LOG_DEBUG("Config: max_selects=%d", max_selects);
+    }
+
+    // Parse asynchronous command confirmation
+    item = cJSON_GetObjectItemCaseSensitive(json, "async_commands");
+    if (cJSON_IsBool(item)) {
+        async_commands = cJSON_IsTrue(item);
+        LOG_DEBUG("Config: async_commands=%d", async_commands);
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(json, "command_timeout_ms");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint <= 0) {
+            LOG_ERROR("Invalid command_timeout_ms %d", item->valueint);
+            return false;
+        }
+        command_timeout_ms = item->valueint;
+        LOG_DEBUG("Config: command_timeout_ms=%d", command_timeout_ms);
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(json, "max_pending_commands");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint <= 0) {
+            LOG_ERROR("Invalid max_pending_commands %d", item->valueint);
+            return false;
+        }
+        max_pending_commands = item->valueint;
+        LOG_DEBUG("Config: max_pending_commands=%d", max_pending_commands);
+    }
+
+    // Parse last-known-value snapshot
+    item = cJSON_GetObjectItemCaseSensitive(json, "value_snapshot_file");
+    if (cJSON_IsString(item) && item->valuestring) {
+        strncpy(value_snapshot_file, item->valuestring, sizeof(value_snapshot_file) - 1);
+        value_snapshot_file[sizeof(value_snapshot_file) - 1] = '\0';
+        LOG_DEBUG("Config: value_snapshot_file=%s", value_snapshot_file);
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(json, "value_snapshot_sync_ms");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint < 0) {
+            LOG_ERROR("Invalid value_snapshot_sync_ms %d", item->valueint);
+            return false;
+        }
+        value_snapshot_sync_ms = item->valueint;
+        LOG_DEBUG("Config: value_snapshot_sync_ms=%d", value_snapshot_sync_ms);
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(json, "value_snapshot_non_topical");
+    if (cJSON_IsBool(item)) {
+        value_snapshot_non_topical = cJSON_IsTrue(item);
+        LOG_DEBUG("Config: value_snapshot_non_topical=%d", value_snapshot_non_topical);
+    }
+
+    // Parse APCI window and timeouts
+    item = cJSON_GetObjectItemCaseSensitive(json, "apci");
+    if (cJSON_IsObject(item) && !parse_apci_parameters(item)) {
+        return false;
+    }
+
+    // Parse acknowledgement policy ("immediate" or "delayed")
+    item = cJSON_GetObjectItemCaseSensitive(json, "ack_policy");
+    if (cJSON_IsString(item) && item->valuestring) {
+        if (strcmp(item->valuestring, "immediate") == 0) {
+            ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+        } else if (strcmp(item->valuestring, "delayed") == 0) {
+            ack_policy = CS104_ACK_POLICY_DELAYED;
+        } else {
+            LOG_ERROR("Invalid ack_policy %s", item->valuestring);
+            return false;
+        }
+        LOG_DEBUG("Config: ack_policy=%s", item->valuestring);
+    }
+
+    item = cJSON_GetObjectItemCaseSensitive(json, "ack_delay_ms");
+    if (cJSON_IsNumber(item)) {
+        if (item->valueint < 0 || item->valueint >= apci_parameters.t2 * 1000) {
+            LOG_ERROR("Invalid ack_delay_ms %d (0 to t2)", item->valueint);
+            return false;
+        }
+        ack_delay_ms = item->valueint;
+        LOG_DEBUG("Config: ack_delay_ms=%d", ack_delay_ms);
+    }
+
+    // Parse CPU affinity and real-time priority per thread class
+    item = cJSON_GetObjectItemCaseSensitive(json, "threads");
+    if (item) {
+        if (!cJSON_IsObject(item)) {
+            LOG_ERROR("Invalid threads (object expected)");
+            return false;
+        }
+        if (!parse_thread_policies(item)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Largest information object address (3 octets)
+#define MAX_IOA 0xFFFFFF
+
+static int compare_ioa(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Read one IOA, or the bounds of a [first, last] range
+static bool parse_ioa_entry(cJSON* entry, int* first, int* last) {
+    if (cJSON_IsNumber(entry)) {
+        *first = *last = entry->valueint;
+    } else if (cJSON_IsArray(entry) && cJSON_GetArraySize(entry) == 2 &&
+               cJSON_IsNumber(entry->child) && cJSON_IsNumber(entry->child->next)) {
+        *first = entry->child->valueint;
+        *last = entry->child->next->valueint;
+    } else {
+        return false;
+    }
+    return *first >= 0 && *first <= *last && *last <= MAX_IOA;
+}
+
+/**
+ * Expand an IOA array such as [[1, 5000], [6001, 6100], 7000]
+ *
+ * Entries are IOAs or inclusive [first, last] ranges. The array is walked
+ * through its linked list twice (count, then fill), so loading is linear in
+ * the number of entries plus IOAs.
+ */
+static bool expand_ioa_array(cJSON* array, const char* what, int** out, int* out_count) {
+    cJSON* entry = NULL;
+    int first, last;
+    long total = 0;
+    int index = 0;
+
+    cJSON_ArrayForEach(entry, array) {
+        if (!parse_ioa_entry(entry, &first, &last)) {
+            LOG_ERROR("Invalid IOA or IOA range at index %d in %s", index, what);
+            return false;
+        }
+        total += (long)last - first + 1;
+        if (total > MAX_IOA + 1) {
+            LOG_ERROR("Too many IOAs in %s", what);
+            return false;
+        }
+        index++;
+    }
+
+    int* list = (int*)malloc((total > 0 ? total : 1) * sizeof(int));
+    if (!list) {
+        LOG_ERROR("Failed to allocate memory for %s IOA list", what);
+        return false;
+    }
+
+    int count = 0;
+    cJSON_ArrayForEach(entry, array) {
+        parse_ioa_entry(entry, &first, &last);
+        for (int ioa = first; ioa <= last; ioa++) {
+            list[count++] = ioa;
+        }
+    }
+
+    *out = list;
+    *out_count = count;
     return true;
 }
 
 /**
  * Generic parsing for any data type configuration
  * This single function replaces 14 duplicate parsing blocks (~400 lines of code)
+ *
+ * The IOA list is sorted and must not contain duplicates: find_ioa_index()
+ * searches it by bisection and the interrogation packing plan detects SQ=1
+ * runs from neighbouring entries.
  */
 bool parse_data_type_config(cJSON* json, const char* config_key, DataTypeContext* ctx) {
     if (!json || !config_key || !ctx) {
@@ -88,28 +456,33 @@ bool parse_data_type_config(cJSON* json, const char* config_key, DataTypeContext
         return true;
     }
 
-    int count = cJSON_GetArraySize(config_array);
+    int count = 0;
+    if (!expand_ioa_array(config_array, config_key, &ctx->config.ioa_list, &count)) {
+        ctx->config.ioa_list = NULL;
+        return false;
+    }
+
     if (count == 0) {
         LOG_DEBUG("Empty configuration for %s", config_key);
+        free(ctx->config.ioa_list);
+        ctx->config.ioa_list = NULL;
         return true;
     }
 
     LOG_INFO("Parsing %s with %d IOAs", config_key, count);
 
-    // Allocate IOA list
-    ctx->config.ioa_list = (int*)malloc(count * sizeof(int));
-    if (!ctx->config.ioa_list) {
-        LOG_ERROR("Failed to allocate memory for %s IOA list", config_key);
-        return false;
+    // Sort unless the config is already in order (the usual case), then reject duplicates
+    int* ioas = ctx->config.ioa_list;
+    for (int i = 1; i < count; i++) {
+        if (ioas[i] < ioas[i - 1]) {
+            LOG_DEBUG("Sorting IOAs of %s", config_key);
+            qsort(ioas, count, sizeof(int), compare_ioa);
+            break;
+        }
     }
-
-    // Parse IOA addresses
-    for (int i = 0; i < count; i++) {
-        cJSON* item = cJSON_GetArrayItem(config_array, i);
-        if (cJSON_IsNumber(item)) {
-            ctx->config.ioa_list[i] = item->valueint;
-        } else {
-            LOG_ERROR("Invalid IOA at index %d in %s", i, config_key);
+    for (int i = 1; i < count; i++) {
+        if (ioas[i] == ioas[i - 1]) {
+            LOG_ERROR("Duplicate IOA %d in %s", ioas[i], config_key);
             free(ctx->config.ioa_list);
             ctx->config.ioa_list = NULL;
             return false;
@@ -117,60 +490,280 @@ bool parse_data_type_config(cJSON* json, const char* config_key, DataTypeContext
     }
     ctx->config.count = count;
 
-    // Allocate data array
-    ctx->data_array = (DataValue*)calloc(count, sizeof(DataValue));
-    if (!ctx->data_array) {
-        LOG_ERROR("Failed to allocate data array for %s", config_key);
+    // Allocate data array and offline tracking
+    if (!init_data_storage(ctx)) {
         free(ctx->config.ioa_list);
         ctx->config.ioa_list = NULL;
+        ctx->config.count = 0;
         return false;
     }
 
-    // Initialize data values with defaults based on type info
-    for (int i = 0; i < count; i++) {
-        ctx->data_array[i].type = ctx->type_info->value_type;
-        ctx->data_array[i].has_quality = ctx->type_info->has_quality;
-        ctx->data_array[i].has_timestamp = ctx->type_info->has_time_tag;
-
-        // Set default quality to INVALID until first real data arrives
-        if (ctx->type_info->has_quality) {
-            ctx->data_array[i].quality = IEC60870_QUALITY_INVALID;
-        }
-
-        // Initialize values to zero/false
-        switch (ctx->data_array[i].type) {
-            case DATA_VALUE_TYPE_BOOL:
-                ctx->data_array[i].value.bool_val = false;
-                break;
-            case DATA_VALUE_TYPE_DOUBLE_POINT:
-                ctx->data_array[i].value.dp_val = IEC60870_DOUBLE_POINT_INDETERMINATE;
-                break;
-            case DATA_VALUE_TYPE_INT16:
-                ctx->data_array[i].value.int16_val = 0;
-                break;
-            case DATA_VALUE_TYPE_UINT32:
-                ctx->data_array[i].value.uint32_val = 0;
-                break;
-            case DATA_VALUE_TYPE_FLOAT:
-                ctx->data_array[i].value.float_val = 0.0f;
-                break;
-        }
-    }
-
-    // Allocate offline update tracking if has timestamp
-    if (ctx->type_info->has_time_tag) {
-        ctx->last_offline_update = (uint64_t*)calloc(count, sizeof(uint64_t));
-        if (!ctx->last_offline_update) {
-            LOG_ERROR("Failed to allocate offline tracking for %s", config_key);
-            free(ctx->config.ioa_list);
-            free(ctx->data_array);
-            ctx->config.ioa_list = NULL;
-            ctx->data_array = NULL;
+    LOG_INFO("Configured %s with %d IOAs", config_key, count);
+    return true;
+}
+
+/**
+ * Parse deadband configuration
+ *
+ * "deadband" is an array of entries applied in order, so a later entry
+ * overrides an earlier one for the same point:
+ *   {"type": "M_ME_NC_1", "mode": "percent", "value": 1.0, "range": [0, 400],
+ *    "ioas": [[100, 199], 250]}
+ * Without "ioas" the entry covers every point of the type. Modes are
+ * "absolute", "percent" (of "range", or of the last value without one),
+ * "integrating" (units x seconds) and "none". Only float and scaled
+ * measurands take a deadband.
+ *
+ * deadband_M_ME_NC_1_percent is applied first to all M_ME_NC_1 points.
+ * Must run after the data type configs; contexts are g_data_contexts or a
+ * staged copy of them.
+ */
+static DataTypeContext* context_of_type(DataTypeContext* contexts, TypeID type_id) {
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        if (contexts[i].type_id == type_id) {
+            return &contexts[i];
+        }
+    }
+    return NULL;
+}
+
+static bool deadband_bands_for(DataTypeContext* ctx) {
+    if (!ctx->deadband) {
+        ctx->deadband = deadband_create(ctx->config.count);
+        if (!ctx->deadband) {
+            LOG_ERROR("Failed to allocate deadbands for %s", ctx->type_info->name);
             return false;
         }
     }
+    return true;
+}
 
-    LOG_INFO("Configured %s with %d IOAs", config_key, count);
+bool parse_deadband_config(cJSON* json, DataTypeContext* contexts) {
+    cJSON* entries = cJSON_GetObjectItemCaseSensitive(json, "deadband");
+
+    // Global percent deadband of M_ME_NC_1 (relative to the last value)
+    DataTypeContext* nc = context_of_type(contexts, M_ME_NC_1);
+    if (deadband_M_ME_NC_1_percent > 0.0f && nc && nc->config.count > 0) {
+        if (!deadband_bands_for(nc)) return false;
+        for (int i = 0; i < nc->config.count; i++) {
+            if (!deadband_set(nc->deadband, i, DEADBAND_PERCENT, deadband_M_ME_NC_1_percent, NULL)) {
+                LOG_ERROR("Invalid deadband_M_ME_NC_1_percent: %.2f", deadband_M_ME_NC_1_percent);
+                return false;
+            }
+        }
+    }
+
+    cJSON* entry = NULL;
+    int index = 0;
+    cJSON_ArrayForEach(entry, entries) {
+        cJSON* type = cJSON_GetObjectItemCaseSensitive(entry, "type");
+        cJSON* mode_item = cJSON_GetObjectItemCaseSensitive(entry, "mode");
+        cJSON* value = cJSON_GetObjectItemCaseSensitive(entry, "value");
+        cJSON* range_item = cJSON_GetObjectItemCaseSensitive(entry, "range");
+        cJSON* ioas = cJSON_GetObjectItemCaseSensitive(entry, "ioas");
+
+        TypeID type_id = cJSON_IsString(type) ? parse_type_id_from_string(type->valuestring) : 0;
+        DataTypeContext* ctx = type_id ? context_of_type(contexts, type_id) : NULL;
+        DeadbandMode mode = DEADBAND_NONE;
+
+        if (!ctx || !cJSON_IsString(mode_item) ||
+            !deadband_mode_from_string(mode_item->valuestring, &mode) ||
+            (mode != DEADBAND_NONE && !cJSON_IsNumber(value))) {
+            LOG_ERROR("Deadband entry %d requires a valid \"type\", \"mode\" and \"value\"", index);
+            return false;
+        }
+        if (ctx->type_info->value_type != DATA_VALUE_TYPE_FLOAT &&
+            ctx->type_info->value_type != DATA_VALUE_TYPE_INT16) {
+            LOG_ERROR("Deadband entry %d: %s is not a float or scaled measurand", index, ctx->type_info->name);
+            return false;
+        }
+
+        float range[2];
+        const float* range_ptr = NULL;
+        if (range_item) {
+            if (!cJSON_IsArray(range_item) || cJSON_GetArraySize(range_item) != 2 ||
+                !cJSON_IsNumber(range_item->child) || !cJSON_IsNumber(range_item->child->next)) {
+                LOG_ERROR("Deadband entry %d: \"range\" must be [min, max]", index);
+                return false;
+            }
+            range[0] = (float)range_item->child->valuedouble;
+            range[1] = (float)range_item->child->next->valuedouble;
+            range_ptr = range;
+        }
+        float band = cJSON_IsNumber(value) ? (float)value->valuedouble : 0.0f;
+
+        if (ctx->config.count == 0) {
+            LOG_WARN("Deadband entry %d: no %s points configured, skipped", index, ctx->type_info->name);
+            index++;
+            continue;
+        }
+        if (!deadband_bands_for(ctx)) return false;
+
+        // No "ioas" array means the whole type
+        int* ioa_list = NULL;
+        int ioa_count = ctx->config.count;
+        if (cJSON_IsArray(ioas) && !expand_ioa_array(ioas, "deadband", &ioa_list, &ioa_count)) {
+            return false;
+        }
+
+        bool ok = true;
+        for (int i = 0; i < ioa_count && ok; i++) {
+            int idx = i;
+            if (ioa_list) {
+                idx = find_ioa_index(&ctx->config, ioa_list[i]);
+                if (idx < 0) {
+                    LOG_WARN("Deadband entry %d: IOA %d not configured for %s, skipped",
+                             index, ioa_list[i], ctx->type_info->name);
+                    continue;
+                }
+            }
+            ok = deadband_set(ctx->deadband, idx, mode, band, range_ptr);
+        }
+        free(ioa_list);
+
+        if (!ok) {
+            LOG_ERROR("Deadband entry %d: invalid value %.3f or range for mode %s",
+                      index, band, mode_item->valuestring);
+            return false;
+        }
+        index++;
+    }
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        if (contexts[i].deadband) {
+            LOG_INFO("Deadband %s: %d of %d points", contexts[i].type_info->name,
+                     contexts[i].deadband->configured, contexts[i].config.count);
+        }
+    }
+    return true;
+}
+
+/**
+ * Parse offline buffering configuration
+ *
+ * "offline" is an array of entries applied in order. An entry without
+ * "ioas" selects the policy of a type, with its rate limit:
+ *   {"type": "M_ME_NC_1", "policy": "latest"}
+ *   {"type": "M_SP_NA_1", "policy": "rate_limited", "interval_ms": 1000}
+ * An entry with "ioas" overrides the rate limit of some points:
+ *   {"type": "M_SP_NA_1", "ioas": [[1, 10]], "interval_ms": 200}
+ * Policies are "rate_limited" (the default of every type, offline_udt_time
+ * seconds), "latest" and "history". Types without an offline form
+ * (M_ME_ND_1) cannot be configured.
+ *
+ * "offline_queue_mode": "coalesce" changes the defaults before the entries
+ * apply: latest for float and scaled measurands, history for the others.
+ *
+ * Must run after the data type configs; contexts are g_data_contexts or a
+ * staged copy of them.
+ */
+bool parse_offline_config(cJSON* json, DataTypeContext* contexts) {
+    cJSON* entries = cJSON_GetObjectItemCaseSensitive(json, "offline");
+    cJSON* mode_item = cJSON_GetObjectItemCaseSensitive(json, "offline_queue_mode");
+    cJSON* entry = NULL;
+    int index = 0;
+
+    OfflineQueueMode mode = OFFLINE_QUEUE_FIFO;
+    if (mode_item && (!cJSON_IsString(mode_item) ||
+                      !offline_queue_mode_from_string(mode_item->valuestring, &mode))) {
+        LOG_ERROR("Invalid offline_queue_mode (expected \"fifo\" or \"coalesce\")");
+        return false;
+    }
+
+    for (int i = 0; i < DATA_TYPE_COUNT && mode != OFFLINE_QUEUE_FIFO; i++) {
+        DataTypeContext* ctx = &contexts[i];
+        if (!ctx->offline) continue;
+
+        DataValueType value_type = ctx->type_info->value_type;
+        bool analogue = value_type == DATA_VALUE_TYPE_FLOAT || value_type == DATA_VALUE_TYPE_INT16;
+        if (!offline_buffer_set_policy(ctx->offline, offline_queue_mode_policy(mode, analogue),
+                                       offline_udt_time * 1000)) {
+            LOG_ERROR("Failed to allocate offline buffer for %s", ctx->type_info->name);
+            return false;
+        }
+    }
+
+    cJSON_ArrayForEach(entry, entries) {
+        cJSON* type = cJSON_GetObjectItemCaseSensitive(entry, "type");
+        cJSON* policy_item = cJSON_GetObjectItemCaseSensitive(entry, "policy");
+        cJSON* interval = cJSON_GetObjectItemCaseSensitive(entry, "interval_ms");
+        cJSON* ioas = cJSON_GetObjectItemCaseSensitive(entry, "ioas");
+
+        TypeID type_id = cJSON_IsString(type) ? parse_type_id_from_string(type->valuestring) : 0;
+        DataTypeContext* ctx = type_id ? context_of_type(contexts, type_id) : NULL;
+        OfflinePolicy policy = OFFLINE_POLICY_RATE_LIMITED;
+
+        if (!ctx) {
+            LOG_ERROR("Offline entry %d requires a valid \"type\"", index);
+            return false;
+        }
+        if (ctx->type_info->offline_equivalent == 0) {
+            LOG_ERROR("Offline entry %d: %s cannot be sent while offline", index, ctx->type_info->name);
+            return false;
+        }
+        if (interval && (!cJSON_IsNumber(interval) || interval->valuedouble < 0)) {
+            LOG_ERROR("Offline entry %d: \"interval_ms\" must be a number >= 0", index);
+            return false;
+        }
+        if (ioas) {
+            if (!cJSON_IsArray(ioas) || !interval || policy_item) {
+                LOG_ERROR("Offline entry %d: \"ioas\" takes an \"interval_ms\" and no \"policy\"", index);
+                return false;
+            }
+        } else if (!cJSON_IsString(policy_item) ||
+                   !offline_policy_from_string(policy_item->valuestring, &policy)) {
+            LOG_ERROR("Offline entry %d requires a \"policy\": rate_limited, latest or history", index);
+            return false;
+        }
+
+        uint32_t interval_ms = interval ? (uint32_t)interval->valuedouble : offline_udt_time * 1000;
+
+        if (!ctx->offline) {
+            LOG_WARN("Offline entry %d: no %s points configured, skipped", index, ctx->type_info->name);
+            index++;
+            continue;
+        }
+
+        if (!ioas) {
+            if (!offline_buffer_set_policy(ctx->offline, policy, interval_ms)) {
+                LOG_ERROR("Failed to allocate offline buffer for %s", ctx->type_info->name);
+                return false;
+            }
+            index++;
+            continue;
+        }
+
+        int* ioa_list = NULL;
+        int ioa_count = 0;
+        if (!expand_ioa_array(ioas, "offline", &ioa_list, &ioa_count)) {
+            return false;
+        }
+
+        bool ok = true;
+        for (int i = 0; i < ioa_count && ok; i++) {
+            int idx = find_ioa_index(&ctx->config, ioa_list[i]);
+            if (idx < 0) {
+                LOG_WARN("Offline entry %d: IOA %d not configured for %s, skipped",
+                         index, ioa_list[i], ctx->type_info->name);
+                continue;
+            }
+            ok = offline_buffer_set_interval(ctx->offline, idx, interval_ms);
+        }
+        free(ioa_list);
+
+        if (!ok) {
+            LOG_ERROR("Failed to allocate offline rate limits for %s", ctx->type_info->name);
+            return false;
+        }
+        index++;
+    }
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        const OfflineBuffer* buf = contexts[i].offline;
+        if (buf && buf->policy != OFFLINE_POLICY_RATE_LIMITED) {
+            LOG_INFO("Offline %s: %s", contexts[i].type_info->name, offline_policy_to_string(buf->policy));
+        }
+    }
     return true;
 }
 
@@ -178,42 +771,90 @@ bool parse_data_type_config(cJSON* json, const char* config_key, DataTypeContext
 
 /**
  * Parse periodic configuration
+ *
+ * Two forms are supported inside the "periodic" object:
+ * - Per-type entries: "M_ME_NC_1": {"enabled": true, "period_ms": 5000}
+ *   cycles every configured IOA of that type.
+ * - Point groups: "groups": [{"name": "feeders", "type": "M_ME_NC_1",
+ *   "period_ms": 1000, "ioas": [1, 2, 3]}] cycles a subset at its own rate.
+ *   "ioas" accepts [first, last] ranges like the data type configs.
+ *
+ * Both forms accept "spread": true (one tick per ASDU) or "spread_ticks": N
+ * to distribute the ASDUs evenly across the period instead of a burst.
+ *
+ * Must run after the data type configs so group IOAs can be resolved.
  */
-static void parse_periodic_config(cJSON* json) {
+static int parse_periodic_spread(cJSON* cfg) {
+    cJSON* ticks = cJSON_GetObjectItemCaseSensitive(cfg, "spread_ticks");
+    cJSON* spread = cJSON_GetObjectItemCaseSensitive(cfg, "spread");
+
+    if (cJSON_IsNumber(ticks) && ticks->valueint > 0) {
+        return ticks->valueint;
+    }
+    if (cJSON_IsBool(spread) && cJSON_IsTrue(spread)) {
+        return PERIODIC_SPREAD_AUTO;
+    }
+    return PERIODIC_SPREAD_NONE;
+}
+
+bool parse_periodic_config(cJSON* json, const DataTypeContext* contexts, PeriodicGroupList* list) {
     cJSON* periodic = cJSON_GetObjectItemCaseSensitive(json, "periodic");
-    if (!cJSON_IsObject(periodic)) return;
+    if (!cJSON_IsObject(periodic)) return true;
 
-    // Parse M_ME_NC_1 periodic config
-    cJSON* me_nc_1 = cJSON_GetObjectItemCaseSensitive(periodic, "M_ME_NC_1");
-    if (cJSON_IsObject(me_nc_1)) {
-        cJSON* enabled = cJSON_GetObjectItemCaseSensitive(me_nc_1, "enabled");
-        cJSON* period = cJSON_GetObjectItemCaseSensitive(me_nc_1, "period_ms");
-        
-        if (cJSON_IsBool(enabled)) {
-            g_periodic_M_ME_NC_1.enabled = cJSON_IsTrue(enabled);
-        }
-        if (cJSON_IsNumber(period)) {
-            g_periodic_M_ME_NC_1.period_ms = period->valueint;
+    // Per-type entries (any supported data type)
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        const DataTypeInfo* info = &DATA_TYPE_TABLE[i];
+        cJSON* type_cfg = cJSON_GetObjectItemCaseSensitive(periodic, info->name);
+        if (!cJSON_IsObject(type_cfg)) continue;
+
+        cJSON* enabled = cJSON_GetObjectItemCaseSensitive(type_cfg, "enabled");
+        cJSON* period = cJSON_GetObjectItemCaseSensitive(type_cfg, "period_ms");
+
+        bool is_enabled = cJSON_IsBool(enabled) && cJSON_IsTrue(enabled);
+        int period_ms = cJSON_IsNumber(period) ? period->valueint : 5000;
+
+        LOG_INFO("Periodic %s: enabled=%d, period=%d ms", info->name, is_enabled, period_ms);
+
+        if (is_enabled && !periodic_stage_group(list, contexts, info->name, info->type_id, period_ms,
+                                                NULL, 0, parse_periodic_spread(type_cfg))) {
+            return false;
         }
-        LOG_INFO("Periodic M_ME_NC_1: enabled=%d, period=%d ms", 
-                 g_periodic_M_ME_NC_1.enabled, g_periodic_M_ME_NC_1.period_ms);
     }
 
-    // Parse M_SP_TB_1 periodic config
-    cJSON* sp_tb_1 = cJSON_GetObjectItemCaseSensitive(periodic, "M_SP_TB_1");
-    if (cJSON_IsObject(sp_tb_1)) {
-        cJSON* enabled = cJSON_GetObjectItemCaseSensitive(sp_tb_1, "enabled");
-        cJSON* period = cJSON_GetObjectItemCaseSensitive(sp_tb_1, "period_ms");
-        
-        if (cJSON_IsBool(enabled)) {
-            g_periodic_M_SP_TB_1.enabled = cJSON_IsTrue(enabled);
+    // Point groups with individual rates
+    cJSON* group_array = cJSON_GetObjectItemCaseSensitive(periodic, "groups");
+    cJSON* group_cfg = NULL;
+    cJSON_ArrayForEach(group_cfg, group_array) {
+        cJSON* name = cJSON_GetObjectItemCaseSensitive(group_cfg, "name");
+        cJSON* type = cJSON_GetObjectItemCaseSensitive(group_cfg, "type");
+        cJSON* period = cJSON_GetObjectItemCaseSensitive(group_cfg, "period_ms");
+        cJSON* enabled = cJSON_GetObjectItemCaseSensitive(group_cfg, "enabled");
+        cJSON* ioas = cJSON_GetObjectItemCaseSensitive(group_cfg, "ioas");
+
+        if (cJSON_IsBool(enabled) && !cJSON_IsTrue(enabled)) continue;
+
+        TypeID type_id = cJSON_IsString(type) ? parse_type_id_from_string(type->valuestring) : 0;
+        if (type_id == 0 || !cJSON_IsNumber(period)) {
+            LOG_ERROR("Periodic group requires a valid \"type\" and \"period_ms\"");
+            return false;
         }
-        if (cJSON_IsNumber(period)) {
-            g_periodic_M_SP_TB_1.period_ms = period->valueint;
+
+        const char* group_name = cJSON_IsString(name) ? name->valuestring : type->valuestring;
+
+        // No "ioas" array means the whole type
+        int* ioa_list = NULL;
+        int ioa_count = 0;
+        if (cJSON_IsArray(ioas) && !expand_ioa_array(ioas, group_name, &ioa_list, &ioa_count)) {
+            return false;
         }
-        LOG_INFO("Periodic M_SP_TB_1: enabled=%d, period=%d ms", 
-                 g_periodic_M_SP_TB_1.enabled, g_periodic_M_SP_TB_1.period_ms);
+
+        bool ok = periodic_stage_group(list, contexts, group_name, type_id, period->valueint,
+                                       ioa_list, ioa_count, parse_periodic_spread(group_cfg));
+        free(ioa_list);
+        if (!ok) return false;
     }
+
+    return true;
 }
 
 /**
@@ -242,9 +883,6 @@ bool parse_config_from_json(const char* json_string) {
         return false;
     }
 
-    // Parse periodic settings
-    parse_periodic_config(json);
-
     // Parse all data type configurations using generic function
     // This replaces 14 duplicate blocks with a simple loop!
     struct {
@@ -278,24 +916,53 @@ bool parse_config_from_json(const char* json_string) {
         }
     }
 
+    // Per-point deadbands and offline policies (need the configured IOAs)
+    if (!parse_deadband_config(json, g_data_contexts)) {
+        LOG_ERROR("Failed to parse deadband configuration");
+        cJSON_Delete(json);
+        return false;
+    }
+    if (!parse_offline_config(json, g_data_contexts)) {
+        LOG_ERROR("Failed to parse offline configuration");
+        cJSON_Delete(json);
+        return false;
+    }
+
+    // Index all configured IOAs for read commands
+    if (!build_ioa_index()) {
+        cJSON_Delete(json);
+        return false;
+    }
+
+    // Parse periodic settings (needs the configured IOAs)
+    PeriodicGroupList periodic_groups = { NULL, 0, 0 };
+    if (!parse_periodic_config(json, g_data_contexts, &periodic_groups)) {
+        LOG_ERROR("Failed to parse periodic configuration");
+        periodic_free_groups(&periodic_groups);
+        cJSON_Delete(json);
+        return false;
+    }
+    periodic_commit_groups(&periodic_groups);
+    periodic_free_groups(&periodic_groups);
+
     cJSON_Delete(json);
     LOG_INFO("Configuration parsed successfully");
     return true;
 }
 
 /**
- * Parse configuration from file
+ * Read a configuration file into memory
  */
-bool init_config_from_file(const char* filename) {
+char* read_config_file(const char* filename) {
     if (!filename) {
         LOG_ERROR("NULL filename");
-        return false;
+        return NULL;
     }
 
     FILE* file = fopen(filename, "r");
     if (!file) {
         LOG_ERROR("Failed to open config file: %s", filename);
-        return false;
+        return NULL;
     }
 
     // Get file size
@@ -306,7 +973,7 @@ bool init_config_from_file(const char* filename) {
     if (file_size <= 0) {
         LOG_ERROR("Invalid file size for %s", filename);
         fclose(file);
-        return false;
+        return NULL;
     }
 
     // Read file content
@@ -314,7 +981,7 @@ bool init_config_from_file(const char* filename) {
     if (!content) {
         LOG_ERROR("Failed to allocate memory for config file");
         fclose(file);
-        return false;
+        return NULL;
     }
 
     size_t read_size = fread(content, 1, file_size, file);
@@ -322,6 +989,17 @@ bool init_config_from_file(const char* filename) {
     fclose(file);
 
     LOG_DEBUG("Read %zu bytes from %s", read_size, filename);
+    return content;
+}
+
+/**
+ * Parse configuration from file
+ */
+bool init_config_from_file(const char* filename) {
+    char* content = read_config_file(filename);
+    if (!content) {
+        return false;
+    }
 
     // Parse JSON
     bool result = parse_config_from_json(content);
@@ -4,6 +4,10 @@
 #include <stdbool.h>
 #include "../../cJSON/cJSON.h"
 #include "../data/data_manager.h"
+#include "../threads/periodic_sender.h"
+
+// reactor_threads: one reactor per CPU the reactor threads may use ("auto")
+#define REACTOR_THREADS_AUTO -1
 
 /**
  * Parse configuration from JSON string
@@ -19,6 +23,13 @@ bool parse_config_from_json(const char* json_string);
  */
 bool init_config_from_file(const char* filename);
 
+/**
+ * Read a configuration file into memory
+ * @param filename Path to the JSON configuration file
+ * @return NUL-terminated content (free with free()), or NULL on error
+ */
+char* read_config_file(const char* filename);
+
 /**
  * Parse global settings from JSON object
  * @param json The root JSON object
@@ -36,4 +47,33 @@ bool parse_global_settings(cJSON* json);
  */
 bool parse_data_type_config(cJSON* json, const char* config_key, DataTypeContext* ctx);
 
+/**
+ * Parse the "deadband" array into per-point deadbands
+ * Must run after the data type configs; also applies deadband_M_ME_NC_1_percent.
+ * @param json The root JSON object
+ * @param contexts DATA_TYPE_COUNT contexts (g_data_contexts or staged ones)
+ * @return true on success, false on error
+ */
+bool parse_deadband_config(cJSON* json, DataTypeContext* contexts);
+
+/**
+ * Parse the "offline" array into per-type policies and per-point rate limits
+ * Must run after the data type configs.
+ * @param json The root JSON object
+ * @param contexts DATA_TYPE_COUNT contexts (g_data_contexts or staged ones)
+ * @return true on success, false on error
+ */
+bool parse_offline_config(cJSON* json, DataTypeContext* contexts);
+
+/**
+ * Parse the "periodic" object and stage its groups
+ * Must run after the data type configs so group IOAs can be resolved.
+ * Nothing runs until the list is passed to periodic_commit_groups().
+ * @param json The root JSON object
+ * @param contexts DATA_TYPE_COUNT contexts the IOAs are resolved against
+ * @param list Receives the groups (free it with periodic_free_groups())
+ * @return true on success, false on error
+ */
+bool parse_periodic_config(cJSON* json, const DataTypeContext* contexts, PeriodicGroupList* list);
+
 #endif // CONFIG_PARSER_H
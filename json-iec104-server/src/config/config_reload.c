@@ -0,0 +1,403 @@
+#include "config_reload.h"
+#include "config_parser.h"
+#include "../data/data_manager.h"
+#include "../data/value_snapshot.h"
+#include "../protocol/interrogation.h"
+#include "../threads/periodic_sender.h"
+#include "../utils/logger.h"
+#include "../utils/utils.h"
+#include "../../cJSON/cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char config_file[4096] = "";
+static cJSON* last_report = NULL;
+
+/**
+ * IOA ranges of one diff category, grouped by type:
+ * {"M_ME_NC_1": [[100, 199], 300], "M_SP_NA_1": [7]}
+ */
+typedef struct {
+    cJSON* types;
+    cJSON* array;               // Array of the type being walked (created on first entry)
+    const char* type_name;
+    bool pending;
+    int first;
+    int last;
+    int entries;
+    bool truncated;
+} IoaRanges;
+
+static void ranges_flush(IoaRanges* r) {
+    if (!r->pending) return;
+    r->pending = false;
+
+    if (r->entries >= CONFIG_RELOAD_MAX_LISTED) {
+        r->truncated = true;
+        return;
+    }
+
+    if (!r->array) {
+        r->array = cJSON_AddArrayToObject(r->types, r->type_name);
+    }
+
+    cJSON* entry;
+    if (r->first == r->last) {
+        entry = cJSON_CreateNumber(r->first);
+    } else {
+        int bounds[2] = { r->first, r->last };
+        entry = cJSON_CreateIntArray(bounds, 2);
+    }
+    cJSON_AddItemToArray(r->array, entry);
+    r->entries++;
+}
+
+static void ranges_begin_type(IoaRanges* r, const char* type_name) {
+    ranges_flush(r);
+    r->array = NULL;
+    r->type_name = type_name;
+}
+
+static void ranges_add(IoaRanges* r, int ioa) {
+    if (r->pending && ioa == r->last + 1) {
+        r->last = ioa;
+        return;
+    }
+    ranges_flush(r);
+    r->pending = true;
+    r->first = r->last = ioa;
+}
+
+typedef struct {
+    IoaRanges added;
+    IoaRanges removed;
+    cJSON* retyped;
+    ConfigReloadResult* result;
+} ReloadDiff;
+
+/**
+ * What protocol threads may change in a running context during a reload:
+ * values (counter reset, C_RP_NA_1), frozen counters and held marks
+ */
+typedef struct {
+    uint32_t seq;
+    uint64_t frozen_time;
+    int freeze_sequence;
+    int pending;
+} ContextMark;
+
+static void mark_context(const DataTypeContext* ctx, ContextMark* mark) {
+    memset(mark, 0, sizeof(*mark));
+    mark->seq = ctx->seq;
+    mark->frozen_time = ctx->frozen_time;
+    mark->freeze_sequence = ctx->freeze_sequence;
+    mark->pending = ctx->offline ? offline_buffer_pending(ctx->offline) : 0;
+}
+
+// The IOA is configured for another type in the staged configuration
+static bool staged_elsewhere(const DataTypeContext* staged, int type_slot, int ioa) {
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        if (i != type_slot && staged[i].config.count > 0 && find_ioa_index(&staged[i].config, ioa) >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void note_new_ioa(ReloadDiff* diff, const DataTypeContext* next, int ioa) {
+    DataTypeContext* previous;
+    int idx;
+
+    if (lookup_ioa(ioa, &previous, &idx) && previous->type_id != next->type_id) {
+        diff->result->retyped++;
+        if (cJSON_GetArraySize(diff->retyped) < CONFIG_RELOAD_MAX_LISTED) {
+            cJSON* entry = cJSON_CreateObject();
+            cJSON_AddNumberToObject(entry, "ioa", ioa);
+            cJSON_AddStringToObject(entry, "from", previous->type_info->name);
+            cJSON_AddStringToObject(entry, "to", next->type_info->name);
+            cJSON_AddItemToArray(diff->retyped, entry);
+        }
+    } else {
+        diff->result->added++;
+        ranges_add(&diff->added, ioa);
+    }
+}
+
+/**
+ * Carry the values of one type over to its staged context and record the diff
+ *
+ * Both IOA lists are sorted, so one merge walk finds the kept, added and
+ * removed IOAs. The running context is locked only against the protocol
+ * threads that write values (counter freeze and reset); the input thread
+ * runs the reload itself. mark records the state that was copied. With diff
+ * NULL only the values of the kept points are copied again, which the
+ * commit does under the write lock for a type those threads changed while
+ * the reload was being built.
+ */
+static bool carry_over_type(DataTypeContext* ctx, DataTypeContext* next,
+                            const DataTypeContext* staged, int slot, ReloadDiff* diff,
+                            ContextMark* mark) {
+    if (diff) {
+        ranges_begin_type(&diff->added, next->type_info->name);
+        ranges_begin_type(&diff->removed, next->type_info->name);
+    }
+
+    if (ctx->frozen_array && !next->frozen_array && next->config.count > 0) {
+        next->frozen_array = (DataValue*)malloc(next->config.count * sizeof(DataValue));
+        if (!next->frozen_array) {
+            LOG_ERROR("Failed to allocate frozen counters for %s", next->type_info->name);
+            return false;
+        }
+        memcpy(next->frozen_array, next->data_array, next->config.count * sizeof(DataValue));
+    }
+
+    pthread_mutex_lock(&ctx->frozen_mutex);
+    pthread_mutex_lock(&ctx->mutex);
+
+    mark_context(ctx, mark);
+
+    const int* old_ioas = ctx->config.ioa_list;
+    const int* new_ioas = next->config.ioa_list;
+    int a = 0, b = 0;
+
+    while (a < ctx->config.count || b < next->config.count) {
+        if (b == next->config.count || (a < ctx->config.count && old_ioas[a] < new_ioas[b])) {
+            if (diff && !staged_elsewhere(staged, slot, old_ioas[a])) {
+                diff->result->removed++;
+                ranges_add(&diff->removed, old_ioas[a]);
+            }
+            a++;
+        } else if (a == ctx->config.count || old_ioas[a] > new_ioas[b]) {
+            if (diff) {
+                note_new_ioa(diff, next, new_ioas[b]);
+            }
+            b++;
+        } else {
+            next->data_array[b] = ctx->data_array[a];
+            if (ctx->offline && next->offline) {
+                offline_buffer_copy_point(next->offline, b, ctx->offline, a);
+            }
+            if (ctx->frozen_array && next->frozen_array) {
+                next->frozen_array[b] = ctx->frozen_array[a];
+            }
+            if (diff) {
+                diff->result->kept++;
+            }
+            a++;
+            b++;
+        }
+    }
+
+    if (ctx->offline && next->offline) {
+        next->offline->stats = ctx->offline->stats;
+    }
+
+    pthread_mutex_unlock(&ctx->mutex);
+    pthread_mutex_unlock(&ctx->frozen_mutex);
+
+    if (diff) {
+        diff->result->points += next->config.count;
+    }
+    return true;
+}
+
+static void set_failure_report(const char* filename, const char* error) {
+    cJSON_Delete(last_report);
+    last_report = cJSON_CreateObject();
+    cJSON_AddStringToObject(last_report, "reload", "failed");
+    cJSON_AddStringToObject(last_report, "file", filename ? filename : "");
+    cJSON_AddStringToObject(last_report, "error", error);
+}
+
+void config_reload_init(const char* filename) {
+    snprintf(config_file, sizeof(config_file), "%s", filename ? filename : "");
+}
+
+bool config_reload(const char* filename, int max_asdu_size, ConfigReloadResult* result) {
+    ConfigReloadResult r;
+    memset(&r, 0, sizeof(r));
+
+    char file[sizeof(config_file)];
+    snprintf(file, sizeof(file), "%s", filename ? filename : config_file);
+
+    LOG_INFO("Reloading configuration from %s", file);
+    uint64_t start = utils_monotonic_us();
+
+    char* content = read_config_file(file);
+    if (!content) {
+        set_failure_report(file, "cannot read the configuration file");
+        return false;
+    }
+
+    cJSON* json = cJSON_Parse(content);
+    free(content);
+    if (!json) {
+        LOG_ERROR("Failed to parse %s, configuration unchanged", file);
+        set_failure_report(file, "invalid JSON");
+        return false;
+    }
+
+    // Stage the new point lists and values next to the running ones
+    DataTypeContext staged[DATA_TYPE_COUNT];
+    PackingPlan plans[DATA_TYPE_COUNT];
+    memset(staged, 0, sizeof(staged));
+    memset(plans, 0, sizeof(plans));
+
+    IoaIndexEntry* table = NULL;
+    uint32_t capacity = 0;
+    PeriodicGroupList periodic_groups = { NULL, 0, 0 };
+    ContextMark marks[DATA_TYPE_COUNT];
+    const char* error = NULL;
+
+    ReloadDiff diff;
+    memset(&diff, 0, sizeof(diff));
+    diff.added.types = cJSON_CreateObject();
+    diff.removed.types = cJSON_CreateObject();
+    diff.retyped = cJSON_CreateArray();
+    diff.result = &r;
+
+    for (int i = 0; i < DATA_TYPE_COUNT && !error; i++) {
+        char key[64];
+        staged[i].type_id = g_data_contexts[i].type_id;
+        staged[i].type_info = g_data_contexts[i].type_info;
+        snprintf(key, sizeof(key), "%s_config", staged[i].type_info->name);
+
+        if (!parse_data_type_config(json, key, &staged[i])) {
+            error = "invalid point configuration";
+        }
+    }
+
+    // Policies first, so held values are carried over into the right buffers
+    if (!error && !parse_offline_config(json, staged)) {
+        error = "invalid offline configuration";
+    }
+
+    for (int i = 0; i < DATA_TYPE_COUNT && !error; i++) {
+        if (!carry_over_type(&g_data_contexts[i], &staged[i], staged, i, &diff, &marks[i])) {
+            error = "out of memory";
+        }
+    }
+    ranges_flush(&diff.added);
+    ranges_flush(&diff.removed);
+
+    if (!error && !parse_deadband_config(json, staged)) {
+        error = "invalid deadband configuration";
+    }
+
+    if (!error && !(table = build_ioa_table(staged, &capacity))) {
+        error = "out of memory";
+    }
+
+    for (int i = 0; i < DATA_TYPE_COUNT && !error; i++) {
+        if (staged[i].config.count > 0 &&
+            !packing_plan_build(&plans[i], staged[i].config.ioa_list, NULL, staged[i].config.count,
+                                staged[i].type_info->io_size, max_asdu_size)) {
+            error = "out of memory";
+        }
+    }
+
+    // Groups hold indices into the staged lists and go live with them
+    if (!error && !parse_periodic_config(json, staged, &periodic_groups)) {
+        error = "invalid periodic configuration";
+    }
+
+    if (!error && !value_snapshot_prepare_reload(staged)) {
+        error = "cannot write the value snapshot";
+    }
+
+    if (error) {
+        LOG_ERROR("Reload of %s failed (%s), configuration unchanged", file, error);
+        for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+            release_data_storage(&staged[i]);
+            packing_plan_free(&plans[i]);
+        }
+        free(table);
+        periodic_free_groups(&periodic_groups);
+        cJSON_Delete(diff.added.types);
+        cJSON_Delete(diff.removed.types);
+        cJSON_Delete(diff.retyped);
+        cJSON_Delete(json);
+        set_failure_report(file, error);
+        return false;
+    }
+
+    cJSON_Delete(json);
+    r.build_us = utils_monotonic_us() - start;
+
+    data_config_write_lock();
+    uint64_t swap_start = utils_monotonic_us();
+
+    // Counter freezes and resets may have changed values since the first
+    // carry-over; none can run now until the new contexts are in place
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        ContextMark now;
+        mark_context(&g_data_contexts[i], &now);
+        if (memcmp(&now, &marks[i], sizeof(now)) != 0) {
+            carry_over_type(&g_data_contexts[i], &staged[i], staged, i, NULL, &now);
+            r.recopied++;
+        }
+    }
+
+    swap_data_contexts(staged, &table, &capacity);
+    interrogation_swap_plans(plans);
+    periodic_commit_groups(&periodic_groups);
+
+    r.swap_us = utils_monotonic_us() - swap_start;
+    data_config_write_unlock();
+
+    // Nothing refers to the previous configuration any more
+    value_snapshot_finish_reload();
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        release_data_storage(&staged[i]);
+        packing_plan_free(&plans[i]);
+    }
+    free(table);
+    periodic_free_groups(&periodic_groups);
+
+    if (filename) {
+        snprintf(config_file, sizeof(config_file), "%s", filename);
+    }
+
+    LOG_INFO("Configuration reloaded: %d points (%d kept, %d added, %d removed, %d retyped), "
+             "built in %.1f ms, swapped in %llu us (%d types copied again)",
+             r.points, r.kept, r.added, r.removed, r.retyped,
+             r.build_us / 1000.0, (unsigned long long)r.swap_us, r.recopied);
+
+    cJSON_Delete(last_report);
+    last_report = cJSON_CreateObject();
+    cJSON_AddStringToObject(last_report, "reload", "ok");
+    cJSON_AddStringToObject(last_report, "file", file);
+    cJSON_AddNumberToObject(last_report, "points", r.points);
+    cJSON_AddNumberToObject(last_report, "kept", r.kept);
+    cJSON_AddNumberToObject(last_report, "added", r.added);
+    cJSON_AddNumberToObject(last_report, "removed", r.removed);
+    cJSON_AddNumberToObject(last_report, "retyped", r.retyped);
+    cJSON_AddNumberToObject(last_report, "periodic_groups", periodic_get_group_count());
+    cJSON_AddNumberToObject(last_report, "build_ms", r.build_us / 1000.0);
+    cJSON_AddNumberToObject(last_report, "swap_us", (double)r.swap_us);
+
+    cJSON* diff_obj = cJSON_AddObjectToObject(last_report, "diff");
+    cJSON_AddItemToObject(diff_obj, "added", diff.added.types);
+    cJSON_AddItemToObject(diff_obj, "removed", diff.removed.types);
+    cJSON_AddItemToObject(diff_obj, "retyped", diff.retyped);
+    cJSON_AddBoolToObject(diff_obj, "truncated", diff.added.truncated || diff.removed.truncated ||
+                                                 r.retyped > cJSON_GetArraySize(diff.retyped));
+
+    if (result) {
+        *result = r;
+    }
+    return true;
+}
+
+char* config_reload_get_report_json(void) {
+    if (!last_report) {
+        return strdup("{\"reload\":\"none\"}");
+    }
+    return cJSON_PrintUnformatted(last_report);
+}
+
+void config_reload_cleanup(void) {
+    cJSON_Delete(last_report);
+    last_report = NULL;
+}
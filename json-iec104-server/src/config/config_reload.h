@@ -0,0 +1,80 @@
+#ifndef CONFIG_RELOAD_H
+#define CONFIG_RELOAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Configuration Reload Module
+ *
+ * Applies a changed point configuration while the slave keeps running
+ * ({"cmd":"reload_config"} or SIGHUP), so adding an IOA does not drop the
+ * master connections.
+ *
+ * The new IOA lists, their value arrays, the IOA index and the
+ * interrogation packing plans and the periodic groups are built off to the
+ * side from the JSON file. Only a second copy of the carried-over values
+ * and the pointer swap run under the write side of the point configuration
+ * lock; interrogations, reads and periodic cycles wait for that, not for
+ * the parsing. The previous configuration is freed after
+ * the lock is released.
+ *
+ * Values of IOAs that keep their type are carried over (with the value
+ * snapshot, into a new snapshot file). Added IOAs and IOAs that moved to
+ * another type start INVALID. Periodic groups are replaced by those of the
+ * new file; an invalid periodic section fails the reload. Other settings (port, ASDU, APCI parameters, ...) take effect at
+ * the next restart.
+ */
+
+// Entries listed per category in the diff report (the counts are always complete)
+#define CONFIG_RELOAD_MAX_LISTED 100
+
+/**
+ * Outcome of a reload
+ */
+typedef struct {
+    int points;                 // Points configured after the reload
+    int kept;                   // Points whose values were carried over
+    int added;                  // IOAs that were not configured before
+    int removed;                // IOAs that are no longer configured
+    int retyped;                // IOAs configured for another type than before
+    int recopied;               // Types copied again under the write lock (changed during the build)
+    uint64_t build_us;          // Parsing, indexing and planning off to the side
+    uint64_t swap_us;           // Time the write lock was held
+} ConfigReloadResult;
+
+/**
+ * Set the configuration file reloaded by default
+ *
+ * @param config_file File the server was started with
+ */
+void config_reload_init(const char* config_file);
+
+/**
+ * Reload the point configuration
+ *
+ * Must be called from the input thread (the only thread that updates
+ * values without the point configuration lock). On failure nothing changes.
+ * A file given explicitly becomes the default for later reloads.
+ *
+ * @param filename JSON configuration, or NULL for the current one
+ * @param max_asdu_size ASDU size the packing plans are built for
+ * @param result Output (may be NULL)
+ * @return true if the new configuration is in use
+ */
+bool config_reload(const char* filename, int max_asdu_size, ConfigReloadResult* result);
+
+/**
+ * Get the report of the last reload
+ * Returns allocated string that must be freed by caller
+ *
+ * @return JSON string like: {"reload":"ok","points":10001,"added":1,...,"diff":{"added":{"M_ME_NC_1":[300]},...}}
+ */
+char* config_reload_get_report_json(void);
+
+/**
+ * Release the last report
+ */
+void config_reload_cleanup(void);
+
+#endif // CONFIG_RELOAD_H
@@ -1,5 +1,10 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP */
+#endif
+
 #include "data_manager.h"
 #include "../utils/logger.h"
+#include "../utils/utils.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -12,12 +17,30 @@
  */
 DataTypeContext g_data_contexts[10];
 
+static IoaIndexEntry* ioa_index = NULL;
+static uint32_t ioa_index_mask = 0;
+static bool ioa_index_mapped = false;   // Table belongs to the station image
+
+/**
+ * Point configuration lock
+ *
+ * Writer preferring, so a reload is not starved by back-to-back
+ * interrogations; readers must not take it recursively.
+ */
+#ifdef PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP
+static pthread_rwlock_t config_lock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+#else
+static pthread_rwlock_t config_lock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
+
+// Orders held-value marks against their flush on activation
+static pthread_mutex_t offline_mark_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  * External global variables from the main program
  * These will be refactored into a ServerConfig struct in a later phase
  */
 extern uint32_t offline_udt_time;
-extern float deadband_M_ME_NC_1_percent;
 
 /**
  * Initialize all data contexts
@@ -31,12 +54,55 @@ void init_data_contexts(void) {
         g_data_contexts[i].type_info = &DATA_TYPE_TABLE[i];
         g_data_contexts[i].config.ioa_list = NULL;
         g_data_contexts[i].config.count = 0;
+        g_data_contexts[i].config.mapped = false;
         g_data_contexts[i].data_array = NULL;
-        g_data_contexts[i].last_offline_update = NULL;
+        g_data_contexts[i].data_mapped = false;
+        g_data_contexts[i].offline = NULL;
+        g_data_contexts[i].deadband = NULL;
         pthread_mutex_init(&g_data_contexts[i].mutex, NULL);
+        g_data_contexts[i].seq = 0;
+        g_data_contexts[i].frozen_array = NULL;
+        g_data_contexts[i].frozen_time = 0;
+        g_data_contexts[i].freeze_sequence = 0;
+        pthread_mutex_init(&g_data_contexts[i].frozen_mutex, NULL);
     }
 }
 
+/**
+ * Release the point list and value arrays of a context
+ *
+ * Memory that belongs to the station image or the value snapshot is not freed.
+ */
+void release_data_storage(DataTypeContext* ctx) {
+    if (ctx->config.ioa_list) {
+        if (!ctx->config.mapped) {
+            free(ctx->config.ioa_list);
+        }
+        ctx->config.ioa_list = NULL;
+        ctx->config.mapped = false;
+    }
+    ctx->config.count = 0;
+
+    if (ctx->data_array) {
+        if (!ctx->data_mapped) {
+            free(ctx->data_array);
+        }
+        ctx->data_array = NULL;
+        ctx->data_mapped = false;
+    }
+
+    offline_buffer_free(ctx->offline);
+    ctx->offline = NULL;
+
+    if (ctx->frozen_array) {
+        free(ctx->frozen_array);
+        ctx->frozen_array = NULL;
+    }
+
+    deadband_free(ctx->deadband);
+    ctx->deadband = NULL;
+}
+
 /**
  * Cleanup all data contexts
  *
@@ -48,36 +114,313 @@ void cleanup_data_contexts(void) {
         DataTypeContext* ctx = &g_data_contexts[i];
 
         // Free allocated memory
-        if (ctx->config.ioa_list) {
-            free(ctx->config.ioa_list);
-            ctx->config.ioa_list = NULL;
+        release_data_storage(ctx);
+        ctx->frozen_time = 0;
+
+        // Destroy mutexes
+        pthread_mutex_destroy(&ctx->mutex);
+        pthread_mutex_destroy(&ctx->frozen_mutex);
+    }
+
+    if (!ioa_index_mapped) {
+        free(ioa_index);
+    }
+    ioa_index = NULL;
+    ioa_index_mask = 0;
+    ioa_index_mapped = false;
+}
+
+/**
+ * Allocate the values of a configured context
+ */
+bool init_data_storage(DataTypeContext* ctx) {
+    int count = ctx->config.count;
+
+    // Allocate data array
+    ctx->data_array = (DataValue*)calloc(count, sizeof(DataValue));
+    if (!ctx->data_array) {
+        LOG_ERROR("Failed to allocate data array for %s", ctx->type_info->name);
+        return false;
+    }
+
+    // Initialize data values with defaults based on type info
+    for (int i = 0; i < count; i++) {
+        ctx->data_array[i].type = ctx->type_info->value_type;
+        ctx->data_array[i].has_quality = ctx->type_info->has_quality;
+        ctx->data_array[i].has_timestamp = ctx->type_info->has_time_tag;
+
+        // Set default quality to INVALID until first real data arrives
+        if (ctx->type_info->has_quality) {
+            ctx->data_array[i].quality = IEC60870_QUALITY_INVALID;
         }
 
-        if (ctx->data_array) {
+        // Initialize values to zero/false
+        switch (ctx->data_array[i].type) {
+            case DATA_VALUE_TYPE_BOOL:
+                ctx->data_array[i].value.bool_val = false;
+                break;
+            case DATA_VALUE_TYPE_DOUBLE_POINT:
+                ctx->data_array[i].value.dp_val = IEC60870_DOUBLE_POINT_INDETERMINATE;
+                break;
+            case DATA_VALUE_TYPE_INT16:
+                ctx->data_array[i].value.int16_val = 0;
+                break;
+            case DATA_VALUE_TYPE_UINT32:
+                ctx->data_array[i].value.uint32_val = 0;
+                break;
+            case DATA_VALUE_TYPE_FLOAT:
+                ctx->data_array[i].value.float_val = 0.0f;
+                break;
+        }
+    }
+
+    // Offline buffer if the type can be sent while offline (it has a time
+    // tag or an equivalent with one); the policy is set by the offline config
+    if (ctx->type_info->offline_equivalent != 0 && count > 0) {
+        ctx->offline = offline_buffer_create(count, ctx->type_info->offline_equivalent,
+                                             offline_udt_time * 1000);
+        if (!ctx->offline) {
+            LOG_ERROR("Failed to allocate offline buffer for %s", ctx->type_info->name);
             free(ctx->data_array);
             ctx->data_array = NULL;
+            return false;
         }
+    }
 
-        if (ctx->last_offline_update) {
-            free(ctx->last_offline_update);
-            ctx->last_offline_update = NULL;
+    return true;
+}
+
+/**
+ * Sequence lock around changes of data_array (caller holds ctx->mutex)
+ */
+static inline void data_write_begin(DataTypeContext* ctx) {
+    __atomic_store_n(&ctx->seq, ctx->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void data_write_end(DataTypeContext* ctx) {
+    __atomic_store_n(&ctx->seq, ctx->seq + 1, __ATOMIC_RELEASE);
+}
+
+void read_data_value(DataTypeContext* ctx, int idx, DataValue* out) {
+    uint32_t begin, end;
+
+    do {
+        begin = __atomic_load_n(&ctx->seq, __ATOMIC_ACQUIRE);
+        if (begin & 1) {
+            continue;
         }
+        memcpy(out, &ctx->data_array[idx], sizeof(DataValue));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        end = __atomic_load_n(&ctx->seq, __ATOMIC_RELAXED);
+    } while ((begin & 1) || begin != end);
+}
 
-        // Destroy mutex
-        pthread_mutex_destroy(&ctx->mutex);
+static inline uint32_t ioa_hash(int ioa) {
+    return (uint32_t)ioa * 2654435761u;
+}
+
+/**
+ * Build an IOA index table for a set of contexts
+ *
+ * Capacity is the next power of two above twice the point count, so the
+ * table is at most half full and linear probing stays short.
+ */
+IoaIndexEntry* build_ioa_table(const DataTypeContext* contexts, uint32_t* capacity_out) {
+    int total = 0;
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        total += contexts[i].config.count;
+    }
+
+    uint32_t capacity = 16;
+    while (capacity < (uint32_t)total * 2) {
+        capacity <<= 1;
+    }
+
+    IoaIndexEntry* table = (IoaIndexEntry*)malloc(capacity * sizeof(IoaIndexEntry));
+    if (!table) {
+        LOG_ERROR("Failed to allocate IOA index (%u entries)", capacity);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < capacity; i++) {
+        table[i].ioa = 0;
+        table[i].ctx = -1;
+        table[i].idx = 0;
+    }
+
+    uint32_t mask = capacity - 1;
+
+    for (int c = 0; c < DATA_TYPE_COUNT; c++) {
+        const DataTypeContext* ctx = &contexts[c];
+
+        for (int k = 0; k < ctx->config.count; k++) {
+            int ioa = ctx->config.ioa_list[k];
+            uint32_t slot = ioa_hash(ioa) & mask;
+
+            while (table[slot].ctx >= 0 && table[slot].ioa != ioa) {
+                slot = (slot + 1) & mask;
+            }
+
+            if (table[slot].ctx >= 0) {
+                LOG_WARN("IOA %d configured for %s and %s, reads return %s",
+                         ioa, contexts[table[slot].ctx].type_info->name,
+                         ctx->type_info->name, contexts[table[slot].ctx].type_info->name);
+                continue;
+            }
+
+            table[slot].ioa = ioa;
+            table[slot].ctx = c;
+            table[slot].idx = k;
+        }
+    }
+
+    LOG_DEBUG("IOA index: %d points, %u slots", total, capacity);
+    *capacity_out = capacity;
+    return table;
+}
+
+bool build_ioa_index(void) {
+    uint32_t capacity;
+    IoaIndexEntry* table = build_ioa_table(g_data_contexts, &capacity);
+    if (!table) {
+        return false;
+    }
+
+    if (!ioa_index_mapped) {
+        free(ioa_index);
+    }
+    ioa_index = table;
+    ioa_index_mask = capacity - 1;
+    ioa_index_mapped = false;
+    return true;
+}
+
+const IoaIndexEntry* get_ioa_index(uint32_t* capacity) {
+    *capacity = ioa_index ? ioa_index_mask + 1 : 0;
+    return ioa_index;
+}
+
+void set_ioa_index(const IoaIndexEntry* table, uint32_t capacity) {
+    if (!ioa_index_mapped) {
+        free(ioa_index);
     }
+    ioa_index = (IoaIndexEntry*)table;
+    ioa_index_mask = capacity - 1;
+    ioa_index_mapped = true;
+}
+
+void data_config_read_lock(void) {
+    pthread_rwlock_rdlock(&config_lock);
+}
+
+void data_config_read_unlock(void) {
+    pthread_rwlock_unlock(&config_lock);
+}
+
+void data_config_write_lock(void) {
+    pthread_rwlock_wrlock(&config_lock);
+}
+
+void data_config_write_unlock(void) {
+    pthread_rwlock_unlock(&config_lock);
+}
+
+void offline_mark_lock(void) {
+    pthread_mutex_lock(&offline_mark_mutex);
+}
+
+void offline_mark_unlock(void) {
+    pthread_mutex_unlock(&offline_mark_mutex);
+}
+
+/**
+ * Swap the point configuration of all contexts (configuration reload)
+ *
+ * Only pointers and counts change hands, so the write lock is held for a
+ * few dozen stores regardless of the number of points. Mutexes, sequence
+ * counters and freeze state stay with the global contexts.
+ */
+void swap_data_contexts(DataTypeContext* staged, IoaIndexEntry** table, uint32_t* capacity) {
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        DataTypeContext* ctx = &g_data_contexts[i];
+        DataTypeContext* next = &staged[i];
+
+        DynamicIOAConfig config = ctx->config;
+        DataValue* data_array = ctx->data_array;
+        bool data_mapped = ctx->data_mapped;
+        OfflineBuffer* offline = ctx->offline;
+        DataValue* frozen_array = ctx->frozen_array;
+        DeadbandBands* deadband = ctx->deadband;
+
+        pthread_mutex_lock(&ctx->mutex);
+        data_write_begin(ctx);
+        ctx->config = next->config;
+        ctx->data_array = next->data_array;
+        ctx->data_mapped = next->data_mapped;
+        ctx->offline = next->offline;
+        ctx->frozen_array = next->frozen_array;
+        ctx->deadband = next->deadband;
+        data_write_end(ctx);
+        pthread_mutex_unlock(&ctx->mutex);
+
+        next->config = config;
+        next->data_array = data_array;
+        next->data_mapped = data_mapped;
+        next->offline = offline;
+        next->frozen_array = frozen_array;
+        next->deadband = deadband;
+    }
+
+    IoaIndexEntry* old_table = ioa_index_mapped ? NULL : ioa_index;
+    uint32_t old_capacity = ioa_index ? ioa_index_mask + 1 : 0;
+
+    ioa_index = *table;
+    ioa_index_mask = *capacity - 1;
+    ioa_index_mapped = false;
+
+    *table = old_table;
+    *capacity = old_capacity;
+}
+
+bool lookup_ioa(int ioa, DataTypeContext** ctx, int* idx) {
+    if (!ioa_index) {
+        return false;
+    }
+
+    uint32_t slot = ioa_hash(ioa) & ioa_index_mask;
+
+    while (ioa_index[slot].ctx >= 0) {
+        if (ioa_index[slot].ioa == ioa) {
+            *ctx = &g_data_contexts[ioa_index[slot].ctx];
+            *idx = ioa_index[slot].idx;
+            return true;
+        }
+        slot = (slot + 1) & ioa_index_mask;
+    }
+
+    return false;
 }
 
 /**
  * Find IOA index in configuration
  *
- * Linear search through the IOA list.
- * This is efficient for small lists (typically < 100 IOAs per type).
+ * Binary search; the config parser keeps every IOA list sorted and unique.
  */
 int find_ioa_index(const DynamicIOAConfig* config, int ioa) {
-    for (int i = 0; i < config->count; i++) {
-        if (config->ioa_list[i] == ioa) {
-            return i;
+    int low = 0;
+    int high = config->count - 1;
+
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        int value = config->ioa_list[mid];
+
+        if (value == ioa) {
+            return mid;
+        }
+        if (value < ioa) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
         }
     }
     return -1;
@@ -113,18 +456,24 @@ bool is_client_connected(CS104_Slave slave) {
 /**
  * Compare two data values
  *
- * Returns true if values are equal (within tolerance for floats).
+ * Returns true if values are equal, or within the point's deadband.
  * Handles all 5 value types: bool, double point, int16, uint32, float.
  *
- * For float types, applies deadband if configured.
+ * Float and scaled (int16) values go through the deadband engine when the
+ * context has deadbands; otherwise any change counts. A new quality (e.g.
+ * INVALID or NT cleared) always counts as a change.
  */
 static bool values_equal(const DataValue* v1, const DataValue* v2,
-                        const DataTypeInfo* type_info) {
+                        const DataTypeInfo* type_info, DeadbandBands* deadband, int idx) {
     // Type must match
     if (v1->type != v2->type) {
         return false;
     }
 
+    if (type_info->has_quality && v2->has_quality && v1->quality != v2->quality) {
+        return false;
+    }
+
     switch (v1->type) {
         case DATA_VALUE_TYPE_BOOL:
             return v1->value.bool_val == v2->value.bool_val;
@@ -133,55 +482,27 @@ static bool values_equal(const DataValue* v1, const DataValue* v2,
             return v1->value.dp_val == v2->value.dp_val;
 
         case DATA_VALUE_TYPE_INT16:
+            if (deadband) {
+                return !deadband_check(deadband, idx, v1->value.int16_val, v2->value.int16_val,
+                                       (uint32_t)utils_monotonic_ms());
+            }
             return v1->value.int16_val == v2->value.int16_val;
 
         case DATA_VALUE_TYPE_UINT32:
             return v1->value.uint32_val == v2->value.uint32_val;
 
-        case DATA_VALUE_TYPE_FLOAT: {
-            // Calculate difference
-            float diff = fabsf(v1->value.float_val - v2->value.float_val);
-
-            // Apply deadband for M_ME_NC_1 if configured
-            if (type_info->type_id == M_ME_NC_1 && deadband_M_ME_NC_1_percent > 0.0f) {
-                float threshold = fabsf(v1->value.float_val) * (deadband_M_ME_NC_1_percent / 100.0f);
-                return diff <= threshold;
+        case DATA_VALUE_TYPE_FLOAT:
+            if (deadband) {
+                return !deadband_check(deadband, idx, v1->value.float_val, v2->value.float_val,
+                                       (uint32_t)utils_monotonic_ms());
             }
-
-            // For other float types, use small epsilon
-            return diff < 0.0001f;
-        }
+            return v1->value.float_val == v2->value.float_val;
 
         default:
             return false;
     }
 }
 
-/**
- * Check if offline update is allowed
- *
- * Returns true if enough time has passed since last offline update.
- * This prevents flooding the queue with updates when no client is connected.
- * 
- * IMPORTANT: This function UPDATES the timestamp if enough time has passed.
- * This matches the reference implementation behavior.
- */
-static bool allow_offline_update(uint64_t* last_update_time_ptr) {
-    if (last_update_time_ptr == NULL) {
-        return true;
-    }
-    
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    uint64_t current = (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
-
-    if ((current - *last_update_time_ptr) >= (offline_udt_time * 1000)) {
-        *last_update_time_ptr = current;  // Update timestamp
-        return true;
-    }
-    return false;
-}
-
 /**
  * Generic update function - THE HEART OF PHASE 2
  *
@@ -204,8 +525,69 @@ static bool allow_offline_update(uint64_t* last_update_time_ptr) {
  */
 bool update_data(DataTypeContext* ctx, CS104_Slave slave,
                  int ioa, const DataValue* new_value) {
-    bool rc = false;
+    return update_data_send_type(ctx, slave, ioa, new_value) != 0;
+}
+
+static bool store_value(DataTypeContext* ctx, int ioa, const DataValue* new_value,
+                        int* idx_out, bool* quality_changed);
+
+/**
+ * Store an update and decide as which type to send it (step 6 of update_data())
+ *
+ * Connected: every change is sent as the point's type, and a value still
+ * held for the latest policy is superseded by it. Offline: the type's
+ * offline buffer decides, and what it queues is sent as the offline type.
+ */
+TypeID update_data_send_type(DataTypeContext* ctx, CS104_Slave slave,
+                             int ioa, const DataValue* new_value) {
+    int idx = -1;
+    bool quality_changed = false;
+
+    if (!store_value(ctx, ioa, new_value, &idx, &quality_changed)) {
+        return 0;
+    }
+
+    // Only marks of the latest policy can miss the flush on activation
+    bool marks = ctx->offline && ctx->offline->pending;
+    if (marks) {
+        offline_mark_lock();
+    }
+
+    TypeID send_type = 0;
+
+    if (is_client_connected(slave)) {
+        if (marks) {
+            offline_buffer_clear(ctx->offline, idx);
+        }
+        send_type = ctx->type_id;
+    } else {
+        // A quality that turns bad (invalid, not topical, ...) is significant:
+        // the latest policy queues it at once instead of holding it
+        bool significant = quality_changed && new_value->quality != IEC60870_QUALITY_GOOD;
+
+        if (ctx->offline && offline_buffer_admit(ctx->offline, idx, utils_monotonic_ms(), significant)) {
+            send_type = ctx->offline->send_type;
+        }
+    }
+
+    if (marks) {
+        offline_mark_unlock();
+    }
+    return send_type;
+}
+
+/**
+ * Store a value unless it equals the current one (steps 1-5 of update_data())
+ */
+bool store_data_value(DataTypeContext* ctx, int ioa, const DataValue* new_value, int* idx_out) {
+    return store_value(ctx, ioa, new_value, idx_out, NULL);
+}
 
+/**
+ * store_data_value(), also telling whether the stored value has a new quality
+ */
+static bool store_value(DataTypeContext* ctx, int ioa, const DataValue* new_value,
+                        int* idx_out, bool* quality_changed) {
     // Validate input
     if (ctx == NULL || new_value == NULL) {
         LOG_ERROR("Invalid parameters to update_data: ctx=%p, new_value=%p", 
@@ -219,14 +601,30 @@ bool update_data(DataTypeContext* ctx, CS104_Slave slave,
         LOG_ERROR("IOA %d not configured for type %s", ioa, ctx->type_info->name);
         return false;
     }
+    if (idx_out) {
+        *idx_out = idx;
+    }
 
     // Lock mutex for thread safety
     pthread_mutex_lock(&ctx->mutex);
 
     // Compare old and new values
-    bool changed = !values_equal(&ctx->data_array[idx], new_value, ctx->type_info);
+    bool changed = !values_equal(&ctx->data_array[idx], new_value, ctx->type_info,
+                                 ctx->deadband, idx);
 
     if (changed) {
+        // Stored for a quality change: the integral starts again from here too
+        if (ctx->deadband) {
+            deadband_reset(ctx->deadband, idx, (uint32_t)utils_monotonic_ms());
+        }
+
+        if (quality_changed) {
+            *quality_changed = ctx->type_info->has_quality && new_value->has_quality &&
+                               ctx->data_array[idx].quality != new_value->quality;
+        }
+
+        data_write_begin(ctx);
+
         // Update data
         ctx->data_array[idx] = *new_value;
 
@@ -239,26 +637,93 @@ bool update_data(DataTypeContext* ctx, CS104_Slave slave,
         if (ctx->type_info->has_quality && new_value->has_quality) {
             ctx->data_array[idx].quality = new_value->quality;
         }
+
+        data_write_end(ctx);
     }
 
     // Unlock mutex
     pthread_mutex_unlock(&ctx->mutex);
 
-    // Determine if update should be sent
-    // Logic matches reference: send if (client_connected OR offline_update_allowed)
-    if (changed) {
-        // Check if client is connected first
-        bool should_send = is_client_connected(slave);
-        
-        // If not connected, check offline update timing (if tracking is enabled)
-        if (!should_send && ctx->last_offline_update != NULL) {
-            should_send = allow_offline_update(&ctx->last_offline_update[idx]);
+    return changed;
+}
+
+bool is_counter_context(const DataTypeContext* ctx) {
+    return ctx && ctx->type_info->value_type == DATA_VALUE_TYPE_UINT32;
+}
+
+static uint64_t wall_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Freeze counters
+ *
+ * The frozen buffer is only touched under frozen_mutex, which the caller
+ * holds. The live array is only locked for one memcpy (plus the reset pass),
+ * so update_data() is never blocked while a frozen snapshot is encoded.
+ * The freeze time becomes the time tag of every frozen value.
+ */
+bool freeze_counters(DataTypeContext* ctx, bool reset) {
+    if (!is_counter_context(ctx)) {
+        return false;
+    }
+
+    if (ctx->config.count == 0) {
+        return true;
+    }
+
+    if (!ctx->frozen_array) {
+        ctx->frozen_array = (DataValue*)calloc(ctx->config.count, sizeof(DataValue));
+        if (!ctx->frozen_array) {
+            LOG_ERROR("Failed to allocate frozen counters for %s", ctx->type_info->name);
+            return false;
         }
-        
-        rc = should_send;
     }
 
-    return rc;
+    uint64_t now = wall_clock_ms();
+
+    pthread_mutex_lock(&ctx->mutex);
+
+    memcpy(ctx->frozen_array, ctx->data_array, ctx->config.count * sizeof(DataValue));
+
+    if (reset) {
+        data_write_begin(ctx);
+        for (int i = 0; i < ctx->config.count; i++) {
+            ctx->data_array[i].value.uint32_val = 0;
+        }
+        data_write_end(ctx);
+    }
+
+    pthread_mutex_unlock(&ctx->mutex);
+
+    for (int i = 0; i < ctx->config.count; i++) {
+        CP56Time2a_createFromMsTimestamp(&ctx->frozen_array[i].timestamp, now);
+    }
+
+    ctx->frozen_time = now;
+    ctx->freeze_sequence = (ctx->freeze_sequence + 1) & 0x1f;
+
+    LOG_DEBUG("Froze %d counters of %s (reset=%d, seq=%d)",
+              ctx->config.count, ctx->type_info->name, reset, ctx->freeze_sequence);
+    return true;
+}
+
+void reset_counters(DataTypeContext* ctx) {
+    if (!is_counter_context(ctx)) {
+        return;
+    }
+
+    pthread_mutex_lock(&ctx->mutex);
+    data_write_begin(ctx);
+
+    for (int i = 0; i < ctx->config.count; i++) {
+        ctx->data_array[i].value.uint32_val = 0;
+    }
+
+    data_write_end(ctx);
+    pthread_mutex_unlock(&ctx->mutex);
 }
 
 /**
@@ -274,6 +739,8 @@ void reset_all_data(void) {
         pthread_mutex_lock(&ctx->mutex);
         
         if (ctx->data_array && ctx->config.count > 0) {
+            data_write_begin(ctx);
+
             // Reset data array based on type
             // Since DataValue is a union and we want to zero it out, 
             // memset is the safest and most efficient way.
@@ -286,6 +753,8 @@ void reset_all_data(void) {
             // so we should probably do the same to match it exactly.
             // However, our DataValue structure might be different.
             // Let's just zero out the whole array of DataValues.
+
+            data_write_end(ctx);
         }
         
         pthread_mutex_unlock(&ctx->mutex);
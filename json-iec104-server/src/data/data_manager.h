@@ -2,6 +2,8 @@
 #define DATA_MANAGER_H
 
 #include "data_types.h"
+#include "deadband.h"
+#include "offline_buffer.h"
 #include "../../lib60870/lib60870-C/src/inc/api/cs104_slave.h"
 #include <pthread.h>
 
@@ -12,15 +14,26 @@
 typedef struct {
     int *ioa_list;      // Array of IOA addresses
     int count;          // Number of IOAs
+    bool mapped;        // ioa_list points into the station image (not freed)
 } DynamicIOAConfig;
 
+/**
+ * IOA index entry (ctx = -1 marks an empty slot)
+ * Stored as is in the station image.
+ */
+typedef struct {
+    int ioa;
+    int ctx;            // Index in g_data_contexts
+    int idx;            // Index in the context's data_array
+} IoaIndexEntry;
+
 /**
  * Data type context - encapsulates all data for one type
  *
  * This structure consolidates everything related to a single IEC104 data type:
  * - Configuration (which IOAs are configured)
  * - Runtime data (current values)
- * - Offline update tracking
+ * - Offline buffering state
  * - Thread safety (mutex)
  * - Type metadata
  *
@@ -35,8 +48,17 @@ typedef struct {
     const DataTypeInfo* type_info;      // Pointer to type metadata
     DynamicIOAConfig config;            // IOA configuration
     DataValue* data_array;              // Current data values
-    uint64_t* last_offline_update;      // Timestamps for offline updates
+    bool data_mapped;                   // data_array lives in the value snapshot (not freed)
+    OfflineBuffer* offline;             // Offline policy and state (NULL = not sent while offline)
+    DeadbandBands* deadband;            // Per-point deadbands (NULL = report every change)
     pthread_mutex_t mutex;              // Thread safety
+    uint32_t seq;                       // Sequence lock for readers without the mutex (odd while data_array changes)
+
+    // Counter freeze buffer (integrated totals only, allocated on first freeze)
+    DataValue* frozen_array;            // Values captured by the last freeze
+    uint64_t frozen_time;               // Time of the last freeze (ms, 0 = never frozen)
+    int freeze_sequence;                // Sequence number of the last freeze (0..31)
+    pthread_mutex_t frozen_mutex;       // Protects frozen_array while it is read or refreshed
 } DataTypeContext;
 
 /**
@@ -57,6 +79,29 @@ void init_data_contexts(void);
  */
 void cleanup_data_contexts(void);
 
+/**
+ * Allocate the values of a configured context
+ *
+ * Allocates data_array for config.count points, with INVALID quality until
+ * the first real data, and the offline buffer of types that can be sent
+ * while offline (rate_limited, offline_udt_time seconds).
+ *
+ * @param ctx Context with config.ioa_list and config.count set
+ * @return true on success, false on allocation failure
+ */
+bool init_data_storage(DataTypeContext* ctx);
+
+/**
+ * Release the point list and values of a context
+ *
+ * Frees ioa_list, data_array, the offline buffer, frozen_array and the
+ * deadbands unless they are mapped, and sets count to 0. Mutexes are left
+ * alone.
+ *
+ * @param ctx Context to release (a global or a staged one)
+ */
+void release_data_storage(DataTypeContext* ctx);
+
 /**
  * Generic update function - REPLACES 9 FUNCTIONS!
  *
@@ -81,15 +126,156 @@ void cleanup_data_contexts(void);
 bool update_data(DataTypeContext* ctx, CS104_Slave slave,
                  int ioa, const DataValue* new_value);
 
+/**
+ * Store an update and decide as which type to send it
+ *
+ * Same as update_data(), but tells the caller which type to encode: the
+ * point's own type while a master is connected, otherwise the offline
+ * type (ctx->offline->send_type) when the type's offline policy queues the
+ * change now.
+ *
+ * @param ctx The data type context to update
+ * @param slave The CS104 slave instance
+ * @param ioa The IOA address to update
+ * @param new_value The new value to set
+ * @return Type to send the value as, or 0 if nothing is to be sent now
+ */
+TypeID update_data_send_type(DataTypeContext* ctx, CS104_Slave slave,
+                             int ioa, const DataValue* new_value);
+
+/**
+ * Store a value unless it equals the current one or stays within the
+ * point's deadband
+ *
+ * The comparison and storage part of update_data(), without the decision
+ * whether to send.
+ *
+ * @param ctx The data type context to update
+ * @param ioa The IOA address to update
+ * @param new_value The new value to set
+ * @param idx_out Output: index of the IOA in data_array (may be NULL)
+ * @return true if the value was stored
+ */
+bool store_data_value(DataTypeContext* ctx, int ioa, const DataValue* new_value, int* idx_out);
+
 /**
  * Find IOA index in configuration
  *
- * @param config The IOA configuration to search
+ * @param config The IOA configuration to search (ioa_list sorted ascending)
  * @param ioa The IOA address to find
  * @return Index in ioa_list array, or -1 if not found
  */
 int find_ioa_index(const DynamicIOAConfig* config, int ioa);
 
+/**
+ * Build the IOA index over all configured data types
+ *
+ * Maps every configured IOA to its context and array index in an
+ * open-addressing hash table, so a lookup costs O(1) regardless of
+ * the number of points. An IOA configured for two types is indexed
+ * for the first one only (logged as a warning).
+ * Call after the data type configurations have been parsed.
+ *
+ * @return true on success, false on allocation failure
+ */
+bool build_ioa_index(void);
+
+/**
+ * Build an IOA index table for any set of contexts
+ *
+ * Same table as build_ioa_index() without installing it; ctx entries are
+ * indices into the given array.
+ *
+ * @param contexts DATA_TYPE_COUNT contexts in g_data_contexts order
+ * @param capacity Output: number of slots (a power of two)
+ * @return The table (free with free()), or NULL on allocation failure
+ */
+IoaIndexEntry* build_ioa_table(const DataTypeContext* contexts, uint32_t* capacity);
+
+/**
+ * Get the IOA index table
+ *
+ * @param capacity Output: number of slots (a power of two)
+ * @return The table, or NULL before build_ioa_index()
+ */
+const IoaIndexEntry* get_ioa_index(uint32_t* capacity);
+
+/**
+ * Use a prebuilt IOA index, e.g. mapped from the station image
+ *
+ * The table is not copied or freed; it must stay valid until
+ * cleanup_data_contexts().
+ *
+ * @param table Index built by build_ioa_index() for the current contexts
+ * @param capacity Number of slots (a power of two)
+ */
+void set_ioa_index(const IoaIndexEntry* table, uint32_t capacity);
+
+/**
+ * Point configuration lock
+ *
+ * A configuration reload replaces ioa_list, count, data_array and the IOA
+ * index under the write side. Threads other than the input thread hold the
+ * read side while they use them (interrogations, reads, the periodic
+ * sender). The input thread applies updates and reloads, so it does not
+ * need the lock to update values. Do not take the read side recursively.
+ */
+void data_config_read_lock(void);
+void data_config_read_unlock(void);
+void data_config_write_lock(void);
+void data_config_write_unlock(void);
+
+/**
+ * Offline mark lock
+ *
+ * Held by update_data_send_type() from the connection check to the mark of
+ * a held value, and by offline_send_pending() while it flushes the marks on
+ * activation. A mark is then either set before the flush and sent by it, or
+ * the update sees the connection and is sent directly.
+ */
+void offline_mark_lock(void);
+void offline_mark_unlock(void);
+
+/**
+ * Swap a staged point configuration into the global contexts
+ *
+ * Exchanges config, data_array, last_offline_update, frozen_array and
+ * deadband of every context with the staged ones, and the IOA index with
+ * table.
+ * Afterwards staged holds the previous configuration and table the previous
+ * index (NULL if it was mapped), both to be released by the caller.
+ * Caller holds the write lock.
+ *
+ * @param staged DATA_TYPE_COUNT contexts in g_data_contexts order
+ * @param table In: new index, out: previous index
+ * @param capacity In: slots of the new index, out: slots of the previous one
+ */
+void swap_data_contexts(DataTypeContext* staged, IoaIndexEntry** table, uint32_t* capacity);
+
+/**
+ * Look up an IOA in the index
+ *
+ * @param ioa The IOA address to find
+ * @param ctx Output: context of the data type holding the IOA
+ * @param idx Output: index in the context's data_array
+ * @return true if the IOA is configured, false otherwise
+ */
+bool lookup_ioa(int ioa, DataTypeContext** ctx, int* idx);
+
+/**
+ * Read one data value without taking the context mutex
+ *
+ * Writers hold ctx->mutex and bump ctx->seq around every change of
+ * data_array; the reader copies the value and retries if a writer was
+ * active in between. Safe to call from the protocol threads while
+ * updates are being applied.
+ *
+ * @param ctx The data type context
+ * @param idx Index in data_array
+ * @param out Output: copy of the value
+ */
+void read_data_value(DataTypeContext* ctx, int idx, DataValue* out);
+
 /**
  * Get context by type ID
  *
@@ -106,6 +292,33 @@ DataTypeContext* get_data_context(TypeID type_id);
  */
 bool is_client_connected(CS104_Slave slave);
 
+/**
+ * Check if a data type holds counters (integrated totals)
+ */
+bool is_counter_context(const DataTypeContext* ctx);
+
+/**
+ * Freeze the counters of a context
+ *
+ * Copies the live values into the frozen buffer. The context mutex is only
+ * held for that copy, so readers of the frozen buffer (counter interrogation)
+ * never block counter updates. With reset the live counters restart at 0.
+ *
+ * Caller must hold ctx->frozen_mutex.
+ *
+ * @param ctx Counter context
+ * @param reset true for freeze with reset
+ * @return true on success, false if ctx is not a counter type or on allocation failure
+ */
+bool freeze_counters(DataTypeContext* ctx, bool reset);
+
+/**
+ * Reset the live counters of a context to 0 without freezing
+ *
+ * @param ctx Counter context
+ */
+void reset_counters(DataTypeContext* ctx);
+
 /**
  * Reset all process data
  * 
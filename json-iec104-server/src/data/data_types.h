@@ -33,7 +33,7 @@ typedef struct {
     } value;
     QualityDescriptor quality;
     bool has_quality;
-    CP56Time2a timestamp;
+    struct sCP56Time2a timestamp;
     bool has_timestamp;
 } DataValue;
 
@@ -0,0 +1,162 @@
+#include "deadband.h"
+#include "../utils/utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+/**
+ * One deadband step
+ *
+ * The deviation of the previous sample held until now, so the integral
+ * grows by that deviation times the time since the previous sample; the
+ * new sample only counts from now on. A change of exactly the band is
+ * reported; a value equal to the reported one never is and clears the
+ * integral.
+ */
+static inline int deadband_step(float absolute, float relative, float integral,
+                                float* accumulated, float* previous, uint32_t* sample_ms,
+                                float reported, float value, uint32_t now_ms) {
+    int32_t elapsed_ms = (int32_t)(now_ms - *sample_ms);
+    elapsed_ms = elapsed_ms > 0 ? elapsed_ms : 0;
+
+    float area = *accumulated + *previous * ((float)elapsed_ms * 0.001f);
+    float deviation = fabsf(value - reported);
+
+    int report = (deviation > 0.0f) &
+                 ((deviation >= absolute + relative * fabsf(reported)) |
+                  ((integral > 0.0f) & (area >= integral)));
+
+    int restart = report | (integral <= 0.0f) | (deviation <= 0.0f);
+    *accumulated = restart ? 0.0f : area;
+    *previous = report ? 0.0f : deviation;
+    *sample_ms = now_ms;
+    return report;
+}
+
+static bool has_band(const DeadbandBands* bands, int idx) {
+    return bands->absolute[idx] > 0.0f || bands->relative[idx] > 0.0f || bands->integral[idx] > 0.0f;
+}
+
+DeadbandBands* deadband_create(int count) {
+    if (count <= 0) {
+        return NULL;
+    }
+
+    DeadbandBands* bands = (DeadbandBands*)calloc(1, sizeof(DeadbandBands));
+    if (!bands) {
+        return NULL;
+    }
+
+    bands->count = count;
+    bands->absolute = (float*)calloc(count, sizeof(float));
+    bands->relative = (float*)calloc(count, sizeof(float));
+    bands->integral = (float*)calloc(count, sizeof(float));
+    bands->accumulated = (float*)calloc(count, sizeof(float));
+    bands->previous = (float*)calloc(count, sizeof(float));
+    bands->sample_ms = (uint32_t*)malloc(count * sizeof(uint32_t));
+
+    if (!bands->absolute || !bands->relative || !bands->integral ||
+        !bands->accumulated || !bands->previous || !bands->sample_ms) {
+        deadband_free(bands);
+        return NULL;
+    }
+
+    uint32_t now = (uint32_t)utils_monotonic_ms();
+    for (int i = 0; i < count; i++) {
+        bands->sample_ms[i] = now;
+    }
+    return bands;
+}
+
+void deadband_free(DeadbandBands* bands) {
+    if (!bands) {
+        return;
+    }
+    free(bands->absolute);
+    free(bands->relative);
+    free(bands->integral);
+    free(bands->accumulated);
+    free(bands->previous);
+    free(bands->sample_ms);
+    free(bands);
+}
+
+bool deadband_set(DeadbandBands* bands, int idx, DeadbandMode mode, float value, const float* range) {
+    if (!bands || idx < 0 || idx >= bands->count || !(value >= 0.0f)) {
+        return false;
+    }
+
+    float absolute = 0.0f, relative = 0.0f, integral = 0.0f;
+
+    switch (mode) {
+        case DEADBAND_NONE:
+            break;
+        case DEADBAND_ABSOLUTE:
+            absolute = value;
+            break;
+        case DEADBAND_PERCENT:
+            if (range) {
+                if (!(range[1] > range[0])) {
+                    return false;
+                }
+                absolute = value / 100.0f * (range[1] - range[0]);
+            } else {
+                relative = value / 100.0f;
+            }
+            break;
+        case DEADBAND_INTEGRATING:
+            if (value <= 0.0f) {
+                return false;
+            }
+            absolute = FLT_MAX;     // Only the integral reports
+            integral = value;
+            break;
+        default:
+            return false;
+    }
+
+    bands->configured -= has_band(bands, idx);
+    bands->absolute[idx] = absolute;
+    bands->relative[idx] = relative;
+    bands->integral[idx] = integral;
+    bands->accumulated[idx] = 0.0f;
+    bands->previous[idx] = 0.0f;
+    bands->configured += has_band(bands, idx);
+    return true;
+}
+
+bool deadband_check(DeadbandBands* bands, int idx, float reported, float value, uint32_t now_ms) {
+    return deadband_step(bands->absolute[idx], bands->relative[idx], bands->integral[idx],
+                         &bands->accumulated[idx], &bands->previous[idx], &bands->sample_ms[idx],
+                         reported, value, now_ms);
+}
+
+void deadband_reset(DeadbandBands* bands, int idx, uint32_t now_ms) {
+    bands->accumulated[idx] = 0.0f;
+    bands->previous[idx] = 0.0f;
+    bands->sample_ms[idx] = now_ms;
+}
+
+bool deadband_mode_from_string(const char* name, DeadbandMode* mode) {
+    static const struct {
+        const char* name;
+        DeadbandMode mode;
+    } modes[] = {
+        {"none", DEADBAND_NONE},
+        {"absolute", DEADBAND_ABSOLUTE},
+        {"percent", DEADBAND_PERCENT},
+        {"integrating", DEADBAND_INTEGRATING}
+    };
+
+    if (!name) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (strcmp(name, modes[i].name) == 0) {
+            *mode = modes[i].mode;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,103 @@
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Deadband Module
+ *
+ * Decides whether a new analogue value (float or scaled) differs enough
+ * from the last reported one to be stored and sent as an event. Each point
+ * of a type with a deadband has three bands:
+ *
+ *   report if |v - r| >= absolute + relative * |r| (and v != r)
+ *          or the integral of |v - r| over time reaches integral (v != r)
+ *
+ * where r is the last reported value. The configured modes map onto them:
+ * - absolute:    absolute = value (engineering units)
+ * - percent:     absolute = value % of "range" [min, max]; without a range,
+ *                relative = value % of the last reported value (the rule of
+ *                deadband_M_ME_NC_1_percent)
+ * - integrating: integral = value (units x seconds); a small deviation is
+ *                reported once it has lasted long enough, a large one sooner
+ *
+ * A point without a deadband reports every change. The bands are kept as
+ * one array each (structure of arrays) and deadband_check() decides an
+ * update without branches.
+ */
+
+typedef enum {
+    DEADBAND_NONE = 0,
+    DEADBAND_ABSOLUTE,
+    DEADBAND_PERCENT,
+    DEADBAND_INTEGRATING
+} DeadbandMode;
+
+/**
+ * Bands and integrating state of one context's points (indexed like data_array)
+ */
+typedef struct {
+    int count;
+    float* absolute;        // Absolute band (units)
+    float* relative;        // Band relative to |r| (fraction, not percent)
+    float* integral;        // Integrating limit (units x s, 0 = not integrating)
+    float* accumulated;     // Integral since the last report
+    float* previous;        // |v - r| of the previous sample, held until the next
+    uint32_t* sample_ms;    // Time of the previous sample (utils_monotonic_ms(), wraps after 49 days)
+    int configured;         // Points with a band
+} DeadbandBands;
+
+/**
+ * Allocate bands for count points, all without a deadband
+ *
+ * @return Bands, or NULL on allocation failure
+ */
+DeadbandBands* deadband_create(int count);
+
+/**
+ * Free bands (NULL is ignored)
+ */
+void deadband_free(DeadbandBands* bands);
+
+/**
+ * Set the deadband of one point
+ *
+ * @param bands Bands of the point's context
+ * @param idx Index in data_array
+ * @param mode Deadband mode (DEADBAND_NONE removes the band)
+ * @param value Absolute band, percent, or integrating limit (>= 0, > 0 when integrating)
+ * @param range [min, max] for DEADBAND_PERCENT, or NULL for percent of the last value
+ * @return false if idx or the parameters are invalid
+ */
+bool deadband_set(DeadbandBands* bands, int idx, DeadbandMode mode, float value, const float* range);
+
+/**
+ * Check one update against its deadband
+ *
+ * Advances the integrating state; when the update is reported the state
+ * starts again from it.
+ *
+ * @param bands Bands of the point's context
+ * @param idx Index in data_array
+ * @param reported Last reported (stored) value
+ * @param value New value
+ * @param now_ms utils_monotonic_ms() truncated to 32 bits
+ * @return true if the update reaches the deadband
+ */
+bool deadband_check(DeadbandBands* bands, int idx, float reported, float value, uint32_t now_ms);
+
+/**
+ * Restart the integrating state of a point that was stored for another
+ * reason (e.g. a quality change)
+ */
+void deadband_reset(DeadbandBands* bands, int idx, uint32_t now_ms);
+
+/**
+ * Parse a mode name: "absolute", "percent", "integrating" or "none"
+ *
+ * @return true if the name is known
+ */
+bool deadband_mode_from_string(const char* name, DeadbandMode* mode);
+
+#endif // DEADBAND_H
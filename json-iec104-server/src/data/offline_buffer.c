@@ -0,0 +1,175 @@
+#include "offline_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+OfflineBuffer* offline_buffer_create(int count, TypeID send_type, uint32_t interval_ms) {
+    if (count <= 0) {
+        return NULL;
+    }
+
+    OfflineBuffer* buf = (OfflineBuffer*)calloc(1, sizeof(OfflineBuffer));
+    if (!buf) {
+        return NULL;
+    }
+
+    buf->count = count;
+    buf->send_type = send_type;
+    buf->policy = OFFLINE_POLICY_RATE_LIMITED;
+    buf->interval_ms = interval_ms;
+    buf->last_ms = (uint64_t*)calloc(count, sizeof(uint64_t));
+    if (!buf->last_ms) {
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+void offline_buffer_free(OfflineBuffer* buf) {
+    if (!buf) {
+        return;
+    }
+    free(buf->point_interval_ms);
+    free(buf->last_ms);
+    free(buf->pending);
+    free(buf);
+}
+
+bool offline_buffer_set_policy(OfflineBuffer* buf, OfflinePolicy policy, uint32_t interval_ms) {
+    if (policy == OFFLINE_POLICY_LATEST && !buf->pending) {
+        buf->pending = (uint8_t*)calloc(buf->count, sizeof(uint8_t));
+        if (!buf->pending) {
+            return false;
+        }
+    }
+
+    free(buf->point_interval_ms);
+    buf->point_interval_ms = NULL;
+    buf->policy = policy;
+    buf->interval_ms = interval_ms;
+    return true;
+}
+
+bool offline_buffer_set_interval(OfflineBuffer* buf, int idx, uint32_t interval_ms) {
+    if (!buf || idx < 0 || idx >= buf->count) {
+        return false;
+    }
+
+    if (!buf->point_interval_ms) {
+        buf->point_interval_ms = (uint32_t*)malloc(buf->count * sizeof(uint32_t));
+        if (!buf->point_interval_ms) {
+            return false;
+        }
+        for (int i = 0; i < buf->count; i++) {
+            buf->point_interval_ms[i] = buf->interval_ms;
+        }
+    }
+    buf->point_interval_ms[idx] = interval_ms;
+    return true;
+}
+
+bool offline_buffer_admit(OfflineBuffer* buf, int idx, uint64_t now_ms, bool significant) {
+    switch (buf->policy) {
+        case OFFLINE_POLICY_HISTORY:
+            __atomic_fetch_add(&buf->stats.queued, 1, __ATOMIC_RELAXED);
+            return true;
+
+        case OFFLINE_POLICY_LATEST:
+            if (significant) {
+                // Sent now with the current value, nothing left to hold
+                offline_buffer_take(buf, idx);
+                __atomic_fetch_add(&buf->stats.queued, 1, __ATOMIC_RELAXED);
+                return true;
+            }
+            if (!__atomic_exchange_n(&buf->pending[idx], 1, __ATOMIC_ACQ_REL)) {
+                __atomic_fetch_add(&buf->pending_count, 1, __ATOMIC_RELEASE);
+            }
+            __atomic_fetch_add(&buf->stats.held, 1, __ATOMIC_RELAXED);
+            return false;
+
+        case OFFLINE_POLICY_RATE_LIMITED:
+        default: {
+            uint32_t interval = buf->point_interval_ms ? buf->point_interval_ms[idx] : buf->interval_ms;
+            uint64_t last = buf->last_ms[idx];
+
+            if (last == 0 || now_ms - last >= interval) {
+                buf->last_ms[idx] = now_ms;
+                __atomic_fetch_add(&buf->stats.queued, 1, __ATOMIC_RELAXED);
+                return true;
+            }
+            __atomic_fetch_add(&buf->stats.dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    }
+}
+
+void offline_buffer_clear(OfflineBuffer* buf, int idx) {
+    offline_buffer_take(buf, idx);
+}
+
+bool offline_buffer_take(OfflineBuffer* buf, int idx) {
+    if (!buf->pending || !__atomic_load_n(&buf->pending[idx], __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    if (!__atomic_exchange_n(&buf->pending[idx], 0, __ATOMIC_ACQ_REL)) {
+        return false;
+    }
+    __atomic_fetch_sub(&buf->pending_count, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+int offline_buffer_pending(const OfflineBuffer* buf) {
+    return buf ? __atomic_load_n(&buf->pending_count, __ATOMIC_ACQUIRE) : 0;
+}
+
+void offline_buffer_copy_point(OfflineBuffer* to, int to_idx, const OfflineBuffer* from, int from_idx) {
+    to->last_ms[to_idx] = from->last_ms[from_idx];
+
+    if (to->pending) {
+        uint8_t pending = from->pending && from->pending[from_idx];
+        to->pending_count += pending - to->pending[to_idx];
+        to->pending[to_idx] = pending;
+    }
+}
+
+bool offline_policy_from_string(const char* name, OfflinePolicy* policy) {
+    if (!name) {
+        return false;
+    }
+    for (int p = OFFLINE_POLICY_RATE_LIMITED; p <= OFFLINE_POLICY_HISTORY; p++) {
+        if (strcmp(name, offline_policy_to_string((OfflinePolicy)p)) == 0) {
+            *policy = (OfflinePolicy)p;
+            return true;
+        }
+    }
+    return false;
+}
+
+OfflinePolicy offline_queue_mode_policy(OfflineQueueMode mode, bool analogue) {
+    if (mode == OFFLINE_QUEUE_COALESCE) {
+        return analogue ? OFFLINE_POLICY_LATEST : OFFLINE_POLICY_HISTORY;
+    }
+    return OFFLINE_POLICY_RATE_LIMITED;
+}
+
+bool offline_queue_mode_from_string(const char* name, OfflineQueueMode* mode) {
+    if (!name) {
+        return false;
+    }
+    if (strcmp(name, "fifo") == 0) {
+        *mode = OFFLINE_QUEUE_FIFO;
+    } else if (strcmp(name, "coalesce") == 0) {
+        *mode = OFFLINE_QUEUE_COALESCE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* offline_policy_to_string(OfflinePolicy policy) {
+    switch (policy) {
+        case OFFLINE_POLICY_RATE_LIMITED: return "rate_limited";
+        case OFFLINE_POLICY_LATEST:       return "latest";
+        case OFFLINE_POLICY_HISTORY:      return "history";
+        default:                          return "unknown";
+    }
+}
@@ -0,0 +1,163 @@
+#ifndef OFFLINE_BUFFER_H
+#define OFFLINE_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../../lib60870/lib60870-C/src/inc/api/iec60870_common.h"
+
+/**
+ * Offline Buffer Module
+ *
+ * Decides what happens to a changed value while no master is connected.
+ * Each type that can be sent offline (it has a time tag, or an
+ * offline_equivalent with one) has a buffer sized for its points when the
+ * configuration is loaded, with one of three policies:
+ *
+ * - rate_limited: queue a change as the offline type at most once per
+ *                 interval per point; changes in between are dropped
+ *                 (the default, interval offline_udt_time seconds)
+ * - latest:       queue nothing while offline, keep the point marked;
+ *                 the latest value of every marked point is sent once
+ *                 when a master activates the connection. Significant
+ *                 changes (a quality turning bad) are queued at once.
+ * - history:      queue every change (bounded by the slave's queue)
+ *
+ * The coalescing queue mode selects latest for analogues (float and scaled
+ * measurands) and history for everything else, so an outage costs one
+ * held value per analogue point while digital events keep their sequence.
+ *
+ * The input thread is the only writer of the rate-limit state, so no lock
+ * is taken per update. Marks of the latest policy are also cleared by the
+ * connection thread that flushes them, so they are changed atomically; the
+ * statistics are atomic counters for the stats command.
+ */
+
+typedef enum {
+    OFFLINE_POLICY_RATE_LIMITED = 0,
+    OFFLINE_POLICY_LATEST,
+    OFFLINE_POLICY_HISTORY
+} OfflinePolicy;
+
+typedef enum {
+    OFFLINE_QUEUE_FIFO = 0,         // Every type rate_limited unless configured
+    OFFLINE_QUEUE_COALESCE          // Analogues latest, other types history
+} OfflineQueueMode;
+
+typedef struct {
+    uint64_t queued;        // Changes queued while offline
+    uint64_t dropped;       // Changes dropped by the rate limit
+    uint64_t held;          // Changes kept as the latest value of a point
+    uint64_t flushed;       // Latest values sent on activation
+} OfflineStats;
+
+/**
+ * Offline state of one context's points (indexed like data_array)
+ */
+typedef struct {
+    int count;
+    TypeID send_type;               // Type sent while offline (offline_equivalent)
+    OfflinePolicy policy;
+    uint32_t interval_ms;           // Rate limit of the type
+    uint32_t* point_interval_ms;    // Per-point rate limits (NULL = interval_ms for all)
+    uint64_t* last_ms;              // Time each point was last queued (0 = never)
+    uint8_t* pending;               // Latest value not sent yet (latest policy only)
+    int pending_count;              // Number of marked points
+    OfflineStats stats;
+} OfflineBuffer;
+
+/**
+ * Allocate the offline state for count points (rate_limited policy)
+ *
+ * @param count Number of points
+ * @param send_type Type to send while offline
+ * @param interval_ms Rate limit of the type
+ * @return Buffer, or NULL on allocation failure or count <= 0
+ */
+OfflineBuffer* offline_buffer_create(int count, TypeID send_type, uint32_t interval_ms);
+
+/**
+ * Free a buffer (NULL is ignored)
+ */
+void offline_buffer_free(OfflineBuffer* buf);
+
+/**
+ * Select the policy and rate limit of the type
+ *
+ * Allocates the marks when switching to the latest policy and resets the
+ * per-point rate limits. Call while the configuration is loaded.
+ *
+ * @return false on allocation failure
+ */
+bool offline_buffer_set_policy(OfflineBuffer* buf, OfflinePolicy policy, uint32_t interval_ms);
+
+/**
+ * Set the rate limit of one point
+ *
+ * @return false if idx is invalid or on allocation failure
+ */
+bool offline_buffer_set_interval(OfflineBuffer* buf, int idx, uint32_t interval_ms);
+
+/**
+ * Decide what to do with a change of a point while offline
+ *
+ * Updates the rate limit and the marks.
+ *
+ * @param buf Buffer of the point's context
+ * @param idx Index in data_array
+ * @param now_ms utils_monotonic_ms()
+ * @param significant The change must not be coalesced (latest policy)
+ * @return true to queue the value now as buf->send_type
+ */
+bool offline_buffer_admit(OfflineBuffer* buf, int idx, uint64_t now_ms, bool significant);
+
+/**
+ * Clear the mark of a point whose newer value was sent online
+ */
+void offline_buffer_clear(OfflineBuffer* buf, int idx);
+
+/**
+ * Take the mark of a point (connection thread, when flushing)
+ *
+ * @return true if the point was marked; its current value is to be sent
+ */
+bool offline_buffer_take(OfflineBuffer* buf, int idx);
+
+/**
+ * Number of marked points (0 when nothing is to be flushed)
+ */
+int offline_buffer_pending(const OfflineBuffer* buf);
+
+/**
+ * Carry the state of a point over to a reloaded buffer
+ * Copying the same point again replaces its earlier copy.
+ */
+void offline_buffer_copy_point(OfflineBuffer* to, int to_idx, const OfflineBuffer* from, int from_idx);
+
+/**
+ * Parse a policy name: "rate_limited", "latest" or "history"
+ *
+ * @return true if the name is known
+ */
+bool offline_policy_from_string(const char* name, OfflinePolicy* policy);
+
+/**
+ * Policy of a type in a queue mode
+ *
+ * @param mode Queue mode
+ * @param analogue The type is a float or scaled measurand
+ */
+OfflinePolicy offline_queue_mode_policy(OfflineQueueMode mode, bool analogue);
+
+/**
+ * Parse a queue mode name: "fifo" or "coalesce"
+ *
+ * @return true if the name is known
+ */
+bool offline_queue_mode_from_string(const char* name, OfflineQueueMode* mode);
+
+/**
+ * Name of a policy
+ */
+const char* offline_policy_to_string(OfflinePolicy policy);
+
+#endif // OFFLINE_BUFFER_H
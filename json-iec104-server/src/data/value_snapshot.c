@@ -0,0 +1,498 @@
+#include "value_snapshot.h"
+#include "data_manager.h"
+#include "../utils/logger.h"
+#include "../utils/utils.h"
+#include "../threads/thread_policy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * File layout
+ *
+ *   SnapshotHeader
+ *   SnapshotType per data context, in g_data_contexts order
+ *   per type      int IOA list, DataValue array (mapped as data_array)
+ *
+ * Sections start at multiples of 64 bytes so value arrays are cache line
+ * aligned like heap allocations.
+ */
+static const char SNAPSHOT_MAGIC[8] = { 'I', 'E', 'C', '1', '0', '4', 'L', 'V' };
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t value_size;            // sizeof(DataValue), layout check
+    uint32_t type_count;
+    uint64_t file_size;
+} SnapshotHeader;
+
+typedef struct {
+    uint32_t type_id;
+    int32_t count;
+    uint64_t ioa_offset;
+    uint64_t value_offset;
+} SnapshotType;
+
+static char snapshot_file[4096];
+static int snapshot_fd = -1;
+static void* snapshot_base = NULL;
+static size_t snapshot_length = 0;
+
+// File written for a configuration reload, mapped until the swap is finished
+static int staged_fd = -1;
+static void* staged_base = NULL;
+static size_t staged_length = 0;
+static int staged_points = 0;
+
+static ValueSnapshotStats stats;
+static pthread_mutex_t snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t flush_mutex = PTHREAD_MUTEX_INITIALIZER;     // Mapping must not change during msync()
+static pthread_cond_t sync_cond;
+static pthread_t sync_thread;
+static bool sync_running = false;
+
+static uint64_t align64(uint64_t offset) {
+    return (offset + 63) & ~(uint64_t)63;
+}
+
+// Layout for the point lists of the contexts, returns the file size
+static size_t build_layout(const DataTypeContext* contexts, SnapshotType* types) {
+    uint64_t offset = align64(sizeof(SnapshotHeader) + DATA_TYPE_COUNT * sizeof(SnapshotType));
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        const DataTypeContext* ctx = &contexts[i];
+        types[i].type_id = ctx->type_id;
+        types[i].count = ctx->config.count;
+        types[i].ioa_offset = offset;
+        offset = align64(offset + (uint64_t)ctx->config.count * sizeof(int));
+        types[i].value_offset = offset;
+        offset = align64(offset + (uint64_t)ctx->config.count * sizeof(DataValue));
+    }
+
+    return (size_t)offset;
+}
+
+static const SnapshotType* file_types(const void* base) {
+    return (const SnapshotType*)((const char*)base + sizeof(SnapshotHeader));
+}
+
+static bool section_valid(uint64_t offset, int32_t count, size_t size, size_t length) {
+    return offset % 8 == 0 && offset <= length && (uint64_t)count <= (length - offset) / size;
+}
+
+// Check the header and that every section lies within the file
+static bool snapshot_valid(const void* base, size_t length) {
+    const SnapshotHeader* header = (const SnapshotHeader*)base;
+
+    if (length < sizeof(SnapshotHeader) + DATA_TYPE_COUNT * sizeof(SnapshotType) ||
+        memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != VALUE_SNAPSHOT_VERSION ||
+        header->header_size != sizeof(SnapshotHeader) ||
+        header->value_size != sizeof(DataValue) ||
+        header->type_count != (uint32_t)DATA_TYPE_COUNT ||
+        header->file_size != length) {
+        return false;
+    }
+
+    const SnapshotType* types = file_types(base);
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        if (types[i].count < 0 ||
+            !section_valid(types[i].ioa_offset, types[i].count, sizeof(int), length) ||
+            !section_valid(types[i].value_offset, types[i].count, sizeof(DataValue), length)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The file was written for exactly the configured point lists
+static bool layout_matches(const void* base, const SnapshotType* types) {
+    const SnapshotType* old = file_types(base);
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        if (old[i].type_id != types[i].type_id || old[i].count != types[i].count ||
+            old[i].ioa_offset != types[i].ioa_offset || old[i].value_offset != types[i].value_offset) {
+            return false;
+        }
+        if (types[i].count > 0 &&
+            memcmp((const char*)base + old[i].ioa_offset, g_data_contexts[i].config.ioa_list,
+                   (size_t)types[i].count * sizeof(int)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Take over a value from the previous run
+static void restore_value(DataValue* dst, const DataValue* src, const DataTypeInfo* info, bool mark_non_topical) {
+    *dst = *src;
+    dst->type = info->value_type;
+    dst->has_quality = info->has_quality;
+    dst->has_timestamp = info->has_time_tag;
+
+    if (mark_non_topical && info->has_quality && !(dst->quality & IEC60870_QUALITY_INVALID)) {
+        dst->quality |= IEC60870_QUALITY_NON_TOPICAL;
+    }
+}
+
+// Copy the values of IOAs that are still configured (both lists are sorted)
+static int carry_over(const void* old_base, void* base, const SnapshotType* types, bool mark_non_topical) {
+    const SnapshotType* old = file_types(old_base);
+    int restored = 0;
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        if (old[i].type_id != types[i].type_id) continue;
+
+        const int* old_ioas = (const int*)((const char*)old_base + old[i].ioa_offset);
+        const DataValue* old_values = (const DataValue*)((const char*)old_base + old[i].value_offset);
+        const int* ioas = g_data_contexts[i].config.ioa_list;
+        DataValue* values = (DataValue*)((char*)base + types[i].value_offset);
+
+        int a = 0, b = 0;
+        while (a < old[i].count && b < types[i].count) {
+            if (old_ioas[a] < ioas[b]) {
+                a++;
+            } else if (old_ioas[a] > ioas[b]) {
+                b++;
+            } else {
+                restore_value(&values[b], &old_values[a], g_data_contexts[i].type_info, mark_non_topical);
+                restored++;
+                a++;
+                b++;
+            }
+        }
+    }
+    return restored;
+}
+
+// Write a snapshot for the point lists of the contexts with their current values
+static void init_snapshot(void* base, size_t length, const SnapshotType* types,
+                          const DataTypeContext* contexts) {
+    SnapshotHeader* header = (SnapshotHeader*)base;
+    memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+    header->version = VALUE_SNAPSHOT_VERSION;
+    header->header_size = sizeof(SnapshotHeader);
+    header->value_size = sizeof(DataValue);
+    header->type_count = DATA_TYPE_COUNT;
+    header->file_size = length;
+
+    memcpy((char*)base + sizeof(SnapshotHeader), types, DATA_TYPE_COUNT * sizeof(SnapshotType));
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        const DataTypeContext* ctx = &contexts[i];
+        size_t count = (size_t)types[i].count;
+        if (count == 0) continue;
+
+        memcpy((char*)base + types[i].ioa_offset, ctx->config.ioa_list, count * sizeof(int));
+        memcpy((char*)base + types[i].value_offset, ctx->data_array, count * sizeof(DataValue));
+    }
+}
+
+// Map a new file with the current layout in place of the old one
+static void* create_snapshot(const char* filename, int* fd, size_t length, const SnapshotType* types,
+                             const DataTypeContext* contexts) {
+    char tmp_file[4096];
+    if (snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", filename) >= (int)sizeof(tmp_file)) {
+        LOG_ERROR("Snapshot path too long: %s", filename);
+        return NULL;
+    }
+
+    int tmp_fd = open(tmp_file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (tmp_fd < 0) {
+        LOG_ERROR("Failed to create value snapshot %s: %s", tmp_file, strerror(errno));
+        return NULL;
+    }
+
+    void* base = MAP_FAILED;
+    if (flock(tmp_fd, LOCK_EX | LOCK_NB) == 0 && ftruncate(tmp_fd, (off_t)length) == 0) {
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, tmp_fd, 0);
+    }
+    if (base == MAP_FAILED) {
+        LOG_ERROR("Failed to map value snapshot %s: %s", tmp_file, strerror(errno));
+        close(tmp_fd);
+        remove(tmp_file);
+        return NULL;
+    }
+
+    init_snapshot(base, length, types, contexts);
+
+    if (rename(tmp_file, filename) != 0) {
+        LOG_ERROR("Failed to replace value snapshot %s: %s", filename, strerror(errno));
+        munmap(base, length);
+        close(tmp_fd);
+        remove(tmp_file);
+        return NULL;
+    }
+
+    *fd = tmp_fd;
+    return base;
+}
+
+static void flush_snapshot(void) {
+    pthread_mutex_lock(&flush_mutex);
+    uint64_t start = utils_monotonic_us();
+    msync(snapshot_base, snapshot_length, MS_SYNC);
+    uint64_t elapsed = utils_monotonic_us() - start;
+    pthread_mutex_unlock(&flush_mutex);
+
+    pthread_mutex_lock(&snapshot_mutex);
+    stats.syncs++;
+    stats.last_sync_us = elapsed;
+    pthread_mutex_unlock(&snapshot_mutex);
+}
+
+static void* snapshot_sync_thread(void* arg) {
+    (void)arg;
+    thread_policy_apply(THREAD_CLASS_BACKGROUND);
+
+    pthread_mutex_lock(&snapshot_mutex);
+
+    while (sync_running) {
+        struct timespec until;
+        clock_gettime(CLOCK_MONOTONIC, &until);
+        until.tv_sec += stats.sync_ms / 1000;
+        until.tv_nsec += (long)(stats.sync_ms % 1000) * 1000000;
+        if (until.tv_nsec >= 1000000000) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000;
+        }
+
+        pthread_cond_timedwait(&sync_cond, &snapshot_mutex, &until);
+        if (!sync_running) break;
+
+        pthread_mutex_unlock(&snapshot_mutex);
+        flush_snapshot();
+        pthread_mutex_lock(&snapshot_mutex);
+    }
+
+    pthread_mutex_unlock(&snapshot_mutex);
+    return NULL;
+}
+
+/**
+ * Map the snapshot file and restore the last known values
+ *
+ * Unchanged point lists map the file as is and restore every value in one
+ * pass. Otherwise a new file is written and the old values are merged in
+ * by IOA, so points that were added start INVALID and removed points are
+ * dropped.
+ */
+bool value_snapshot_open(const char* filename, int sync_ms, bool mark_non_topical) {
+    value_snapshot_close();
+
+    uint64_t start = utils_monotonic_us();
+
+    SnapshotType types[DATA_TYPE_COUNT];
+    size_t length = build_layout(g_data_contexts, types);
+
+    int fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open value snapshot %s: %s", filename, strerror(errno));
+        return false;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        LOG_ERROR("Value snapshot %s is used by another process", filename);
+        close(fd);
+        return false;
+    }
+
+    struct stat st;
+    size_t old_length = (fstat(fd, &st) == 0 && st.st_size > 0) ? (size_t)st.st_size : 0;
+    void* old = NULL;
+
+    if (old_length > 0) {
+        old = mmap(NULL, old_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (old == MAP_FAILED || !snapshot_valid(old, old_length)) {
+            LOG_WARN("Value snapshot %s is invalid or from another version, values start INVALID", filename);
+            if (old != MAP_FAILED) munmap(old, old_length);
+            old = NULL;
+        }
+    }
+
+    void* base;
+    int restored = 0;
+    int points = 0;
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        points += types[i].count;
+    }
+
+    if (old && old_length == length && layout_matches(old, types)) {
+        // Same point lists: the file already holds the values in place
+        base = old;
+        for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+            DataValue* values = (DataValue*)((char*)base + types[i].value_offset);
+            for (int k = 0; k < types[i].count; k++) {
+                restore_value(&values[k], &values[k], g_data_contexts[i].type_info, mark_non_topical);
+            }
+        }
+        restored = points;
+    } else {
+        int new_fd = -1;
+        base = create_snapshot(filename, &new_fd, length, types, g_data_contexts);
+        if (base && old) {
+            restored = carry_over(old, base, types, mark_non_topical);
+            LOG_INFO("Point lists changed, %d of %d values carried over", restored, points);
+        }
+        if (old) munmap(old, old_length);
+        close(fd);
+        fd = new_fd;
+        if (!base) {
+            return false;
+        }
+    }
+
+    // The contexts keep their values in the mapping from now on
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        DataTypeContext* ctx = &g_data_contexts[i];
+        if (types[i].count == 0) continue;
+
+        free(ctx->data_array);
+        ctx->data_array = (DataValue*)((char*)base + types[i].value_offset);
+        ctx->data_mapped = true;
+    }
+
+    snprintf(snapshot_file, sizeof(snapshot_file), "%s", filename);
+    snapshot_fd = fd;
+    snapshot_base = base;
+    snapshot_length = length;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.points = points;
+    stats.restored = restored;
+    stats.sync_ms = sync_ms > 0 ? sync_ms : 0;
+
+    if (stats.sync_ms > 0) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&sync_cond, &attr);
+        pthread_condattr_destroy(&attr);
+
+        sync_running = true;
+        if (pthread_create(&sync_thread, NULL, snapshot_sync_thread, NULL) != 0) {
+            sync_running = false;
+            pthread_cond_destroy(&sync_cond);
+            stats.sync_ms = 0;
+            LOG_WARN("Failed to create snapshot sync thread, flushing is left to the kernel");
+        }
+    }
+
+    LOG_INFO("Value snapshot %s: %d of %d values restored in %.1f ms", filename, restored, points,
+             (utils_monotonic_us() - start) / 1000.0);
+    return true;
+}
+
+void value_snapshot_close(void) {
+    if (!snapshot_base) {
+        return;
+    }
+
+    if (sync_running) {
+        pthread_mutex_lock(&snapshot_mutex);
+        sync_running = false;
+        pthread_cond_signal(&sync_cond);
+        pthread_mutex_unlock(&snapshot_mutex);
+
+        pthread_join(sync_thread, NULL);
+        pthread_cond_destroy(&sync_cond);
+    }
+
+    flush_snapshot();
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        DataTypeContext* ctx = &g_data_contexts[i];
+        if (ctx->data_mapped) {
+            ctx->data_array = NULL;
+            ctx->data_mapped = false;
+        }
+    }
+
+    munmap(snapshot_base, snapshot_length);
+    close(snapshot_fd);         // Releases the lock
+    snapshot_base = NULL;
+    snapshot_length = 0;
+    snapshot_fd = -1;
+}
+
+/**
+ * Write the snapshot for a reloaded configuration
+ *
+ * The staged contexts already hold the carried-over values; they are copied
+ * into a new file that replaces the old one, and the staged data_array
+ * pointers move into its mapping. The old mapping stays valid for the
+ * running configuration until value_snapshot_finish_reload().
+ */
+bool value_snapshot_prepare_reload(DataTypeContext* contexts) {
+    if (!snapshot_base) {
+        return true;
+    }
+
+    SnapshotType types[DATA_TYPE_COUNT];
+    size_t length = build_layout(contexts, types);
+
+    int fd = -1;
+    void* base = create_snapshot(snapshot_file, &fd, length, types, contexts);
+    if (!base) {
+        return false;
+    }
+
+    int points = 0;
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        DataTypeContext* ctx = &contexts[i];
+        points += types[i].count;
+        if (types[i].count == 0) continue;
+
+        if (!ctx->data_mapped) {
+            free(ctx->data_array);
+        }
+        ctx->data_array = (DataValue*)((char*)base + types[i].value_offset);
+        ctx->data_mapped = true;
+    }
+
+    staged_fd = fd;
+    staged_base = base;
+    staged_length = length;
+    staged_points = points;
+    return true;
+}
+
+void value_snapshot_finish_reload(void) {
+    if (!staged_base) {
+        return;
+    }
+
+    pthread_mutex_lock(&flush_mutex);
+
+    munmap(snapshot_base, snapshot_length);
+    close(snapshot_fd);
+    snapshot_fd = staged_fd;
+    snapshot_base = staged_base;
+    snapshot_length = staged_length;
+
+    pthread_mutex_unlock(&flush_mutex);
+
+    pthread_mutex_lock(&snapshot_mutex);
+    stats.points = staged_points;
+    pthread_mutex_unlock(&snapshot_mutex);
+
+    staged_fd = -1;
+    staged_base = NULL;
+    staged_length = 0;
+    staged_points = 0;
+}
+
+void value_snapshot_get_stats(ValueSnapshotStats* out) {
+    pthread_mutex_lock(&snapshot_mutex);
+    *out = stats;
+    pthread_mutex_unlock(&snapshot_mutex);
+}
@@ -0,0 +1,82 @@
+#ifndef VALUE_SNAPSHOT_H
+#define VALUE_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "data_manager.h"
+
+/**
+ * Last-Known-Value Snapshot
+ *
+ * With "value_snapshot_file" set, the data_array of every configured type
+ * lives in a shared file mapping instead of heap memory. Every update is
+ * thus written through to the page cache and survives a restart or crash
+ * of the server; with "value_snapshot_sync_ms" the mapping is also flushed
+ * to disk periodically, which covers power loss.
+ *
+ * At startup the previous values and qualities are restored in place: if
+ * the point lists are unchanged the file is mapped as is, otherwise values
+ * are carried over by IOA into a file with the new layout. Restored values
+ * can be flagged non-topical (NT) until the producer sends them again.
+ *
+ * The file uses the host's byte order and structure layout.
+ */
+
+#define VALUE_SNAPSHOT_VERSION 1
+
+/**
+ * Snapshot statistics
+ */
+typedef struct {
+    int points;                 // Points held in the snapshot
+    int restored;               // Points restored at startup
+    int sync_ms;                // Flush interval (0 = left to the kernel)
+    uint64_t syncs;             // Flushes to disk
+    uint64_t last_sync_us;      // Duration of the last flush
+} ValueSnapshotStats;
+
+/**
+ * Map the snapshot file and restore the last known values
+ *
+ * Call after the configuration is loaded and before the slave starts.
+ * The file is locked, so two servers cannot share it.
+ *
+ * @param filename Snapshot file (created if missing)
+ * @param sync_ms Flush interval in ms (0 = left to the kernel)
+ * @param mark_non_topical Set the NT quality bit on restored values
+ * @return true on success; false leaves the values in heap memory
+ */
+bool value_snapshot_open(const char* filename, int sync_ms, bool mark_non_topical);
+
+/**
+ * Flush and unmap the snapshot
+ *
+ * The contexts' data_array pointers become NULL; call at shutdown after
+ * the slave and all senders are stopped, before cleanup_data_contexts().
+ */
+void value_snapshot_close(void);
+
+/**
+ * Move the snapshot to a reloaded configuration (first half)
+ *
+ * Writes a new file for the staged contexts with their current values and
+ * maps their data_array into it. No-op if no snapshot is open.
+ *
+ * @param contexts DATA_TYPE_COUNT staged contexts in g_data_contexts order
+ * @return true on success; false leaves the running snapshot untouched
+ */
+bool value_snapshot_prepare_reload(DataTypeContext* contexts);
+
+/**
+ * Move the snapshot to a reloaded configuration (second half)
+ *
+ * Call after swap_data_contexts(); unmaps the previous file.
+ */
+void value_snapshot_finish_reload(void);
+
+/**
+ * Get snapshot statistics
+ */
+void value_snapshot_get_stats(ValueSnapshotStats* stats);
+
+#endif // VALUE_SNAPSHOT_H
@@ -1,15 +1,21 @@
 #include "input_handler.h"
 #include "../client/client_manager.h"
+#include "../threads/periodic_sender.h"
 #include "../data/data_manager.h"
 #include "../data/data_types.h"
 #include "../protocol/interrogation.h"
+#include "../protocol/asdu_pool.h"
+#include "../protocol/command_pipeline.h"
+#include "../protocol/offline_sender.h"
+#include "../config/config_reload.h"
 #include "../utils/logger.h"
+#include "../utils/apdu_capture.h"
+#include "../utils/event_output.h"
 #include "../../cJSON/cJSON.h"
 #include "hal_time.h"
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
-#include <time.h>
 
 // External globals
 extern int ASDU;
@@ -24,7 +30,7 @@ static void convert_input_to_value(TypeID type, double input_val, int qualifier,
     out_val->has_quality = get_data_type_info(type)->has_quality;
     out_val->has_timestamp = get_data_type_info(type)->has_time_tag;
     out_val->quality = qualifier;
-    CP56Time2a_createFromMsTimestamp(out_val->timestamp, Hal_getTimeInMs());
+    CP56Time2a_createFromMsTimestamp(&out_val->timestamp, Hal_getTimeInMs());
 
     switch (out_val->type) {
         case DATA_VALUE_TYPE_BOOL:
@@ -87,16 +93,127 @@ bool input_handler_process_line(const char* line) {
             cJSON_Delete(json);
             return true;
         }
+        else if (strcmp(cmd_item->valuestring, "get_connection_metrics") == 0) {
+            char* json_str = client_manager_get_metrics_json();
+            if (json_str) {
+                printf("%s\n", json_str);
+                fflush(stdout);
+                free(json_str);
+            }
+            cJSON_Delete(json);
+            return true;
+        }
         else if (strcmp(cmd_item->valuestring, "get_queue_count") == 0) {
             int queue_count = 0;
+            int queue_hwm = 0;
+            unsigned long long queue_dropped = 0;
             if (slave && CS104_Slave_isRunning(slave)) {
                 queue_count = CS104_Slave_getNumberOfQueueEntries(slave, NULL);
+                queue_hwm = CS104_Slave_getQueueHighWaterMark(slave, NULL, false);
+                queue_dropped = CS104_Slave_getNumberOfDroppedQueueEntries(slave, NULL);
             }
-            printf("{\"queue_count\":%d}\n", queue_count);
+            printf("{\"queue_count\":%d,\"queue_high_water_mark\":%d,\"queue_dropped\":%llu}\n",
+                   queue_count, queue_hwm, queue_dropped);
             fflush(stdout);
             cJSON_Delete(json);
             return true;
         }
+        else if (strcmp(cmd_item->valuestring, "capture_start") == 0 ||
+                 strcmp(cmd_item->valuestring, "capture_stop") == 0 ||
+                 strcmp(cmd_item->valuestring, "get_capture_stats") == 0) {
+            // {"cmd":"capture_start","file":"/tmp/rtu.pcap","max_mb":16}
+            if (strcmp(cmd_item->valuestring, "capture_start") == 0) {
+                cJSON* file_item = cJSON_GetObjectItem(json, "file");
+                cJSON* max_item = cJSON_GetObjectItem(json, "max_mb");
+                uint64_t max_bytes = 0;
+                if (cJSON_IsNumber(max_item) && max_item->valueint > 0) {
+                    max_bytes = (uint64_t)max_item->valueint * 1024 * 1024;
+                }
+                apdu_capture_start(cJSON_IsString(file_item) ? file_item->valuestring : NULL, max_bytes);
+            }
+            else if (strcmp(cmd_item->valuestring, "capture_stop") == 0) {
+                apdu_capture_stop();
+            }
+
+            char* json_str = apdu_capture_get_stats_json();
+            if (json_str) {
+                printf("%s\n", json_str);
+                fflush(stdout);
+                free(json_str);
+            }
+            cJSON_Delete(json);
+            return true;
+        }
+        else if (strcmp(cmd_item->valuestring, "command_result") == 0) {
+            // {"cmd":"command_result","id":17,"success":true}
+            cJSON* id_item = cJSON_GetObjectItem(json, "id");
+            cJSON* success_item = cJSON_GetObjectItem(json, "success");
+
+            if (!cJSON_IsNumber(id_item) || !cJSON_IsBool(success_item)) {
+                LOG_ERROR("command_result requires id and success");
+            }
+            else if (!command_pipeline_complete((uint32_t)id_item->valuedouble, cJSON_IsTrue(success_item))) {
+                event_output_emit("\"error\":\"unknown command id\",\"id\":%u", (uint32_t)id_item->valuedouble);
+            }
+            cJSON_Delete(json);
+            return true;
+        }
+        else if (strcmp(cmd_item->valuestring, "get_command_stats") == 0) {
+            char* json_str = command_pipeline_get_stats_json();
+            if (json_str) {
+                printf("%s\n", json_str);
+                fflush(stdout);
+                free(json_str);
+            }
+            cJSON_Delete(json);
+            return true;
+        }
+        else if (strcmp(cmd_item->valuestring, "get_event_output_stats") == 0) {
+            char* json_str = event_output_get_stats_json();
+            if (json_str) {
+                printf("%s\n", json_str);
+                fflush(stdout);
+                free(json_str);
+            }
+            cJSON_Delete(json);
+            return true;
+        }
+        else if (strcmp(cmd_item->valuestring, "reload_config") == 0) {
+            // {"cmd":"reload_config"} or {"cmd":"reload_config","file":"/etc/iec104/station.json"}
+            cJSON* file_item = cJSON_GetObjectItem(json, "file");
+            CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+            config_reload(cJSON_IsString(file_item) ? file_item->valuestring : NULL,
+                          alParams->maxSizeOfASDU, NULL);
+
+            char* json_str = config_reload_get_report_json();
+            if (json_str) {
+                printf("%s\n", json_str);
+                fflush(stdout);
+                free(json_str);
+            }
+            cJSON_Delete(json);
+            return true;
+        }
+        else if (strcmp(cmd_item->valuestring, "get_offline_stats") == 0) {
+            char* json_str = offline_get_stats_json();
+            if (json_str) {
+                printf("%s\n", json_str);
+                fflush(stdout);
+                free(json_str);
+            }
+            cJSON_Delete(json);
+            return true;
+        }
+        else if (strcmp(cmd_item->valuestring, "get_periodic_stats") == 0) {
+            char* json_str = periodic_get_stats_json();
+            if (json_str) {
+                printf("%s\n", json_str);
+                fflush(stdout);
+                free(json_str);
+            }
+            cJSON_Delete(json);
+            return true;
+        }
     }
 
     // Parse data update: {"type":"M_SP_TB_1", "address":100, "value":1, "qualifier":0}
@@ -136,121 +253,22 @@ bool input_handler_process_line(const char* line) {
                 DataValue val;
                 convert_input_to_value(type_id, value_item->valuedouble, qual, &val);
 
-                // Get type info for offline handling
-                const DataTypeInfo* type_info = get_data_type_info(type_id);
-                
-                // Generic offline handling for ALL non-timestamped types
-                bool offline_enqueue = false;
-                
-                if (type_info && !type_info->has_time_tag && !is_client_connected(slave) && 
-                    type_info->offline_equivalent != 0) {
-                    // This type supports offline queueing
-                    int idx = find_ioa_index(&ctx->config, ioa);
-                    if (idx >= 0) {
-                        // Global offline tracking for all non-timestamped types
-                        // Each type gets its own tracking array
-                        static struct {
-                            TypeID type_id;
-                            uint64_t* timestamps;
-                            int count;
-                        } offline_tracking[10] = {{0}};  // Support up to 10 types
-                        
-                        // Find or create tracking for this type
-                        int tracking_idx = -1;
-                        for (int i = 0; i < 10; i++) {
-                            if (offline_tracking[i].type_id == type_id) {
-                                tracking_idx = i;
-                                break;
-                            }
-                            if (offline_tracking[i].type_id == 0) {
-                                // Initialize new tracking
-                                offline_tracking[i].type_id = type_id;
-                                offline_tracking[i].count = ctx->config.count;
-                                offline_tracking[i].timestamps = (uint64_t*)calloc(ctx->config.count, sizeof(uint64_t));
-                                tracking_idx = i;
-                                break;
-                            }
-                        }
-                        
-                        if (tracking_idx >= 0) {
-                            pthread_mutex_lock(&ctx->mutex);
-                            
-                            // Get old value based on type
-                            bool deadband_passed = false;
-                            switch (type_info->value_type) {
-                                case DATA_VALUE_TYPE_FLOAT: {
-                                    float old_val = ctx->data_array[idx].value.float_val;
-                                    float new_val = val.value.float_val;
-                                    float diff = fabsf(old_val - new_val);
-                                    
-                                    // Apply deadband (use M_ME_NC_1 deadband for all float types for now)
-                                    extern float deadband_M_ME_NC_1_percent;
-                                    float percent = 0.0f;
-                                    if (fabsf(old_val) > 0.0001f) {
-                                        percent = (diff / fabsf(old_val)) * 100.0f;
-                                    } else {
-                                        percent = (diff > 0.0001f) ? 100.0f : 0.0f;
-                                    }
-                                    deadband_passed = (percent >= deadband_M_ME_NC_1_percent && diff > 0.0001f);
-                                    break;
-                                }
-                                case DATA_VALUE_TYPE_BOOL:
-                                case DATA_VALUE_TYPE_DOUBLE_POINT:
-                                case DATA_VALUE_TYPE_INT16:
-                                case DATA_VALUE_TYPE_UINT32:
-                                    // For non-float types, any change passes deadband
-                                    deadband_passed = true;
-                                    break;
-                            }
-                            
-                            if (deadband_passed) {
-                                // Check offline timing
-                                extern uint32_t offline_udt_time;
-                                struct timespec ts;
-                                clock_gettime(CLOCK_REALTIME, &ts);
-                                uint64_t current = (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
-                                
-                                if ((current - offline_tracking[tracking_idx].timestamps[idx]) >= (offline_udt_time * 1000)) {
-                                    offline_tracking[tracking_idx].timestamps[idx] = current;
-                                    offline_enqueue = true;
-                                }
-                            }
-                            
-                            pthread_mutex_unlock(&ctx->mutex);
-                        }
-                    }
-                }
+                // Own type while connected, offline type when the type's
+                // offline policy queues the change now, 0 otherwise
+                TypeID send_type = update_data_send_type(ctx, slave, ioa, &val);
 
-                // Update the data
-                bool should_send_immediately = update_data(ctx, slave, ioa, &val);
-                
-                // Determine if we should enqueue
-                bool should_enqueue = should_send_immediately || offline_enqueue;
-
-                if (should_enqueue) {
+                if (send_type != 0) {
                     CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
-                    CS101_ASDU newAsdu = CS101_ASDU_create(
-                        alParams, false, CS101_COT_SPONTANEOUS,
-                        0, ASDU, false, false  // OA=0, CA=ASDU
+                    CS101_ASDU newAsdu = asdu_pool_acquire(
+                        alParams, false, CS101_COT_SPONTANEOUS, ASDU
                     );
 
-                    if (newAsdu) {
-                        InformationObject io = NULL;
-                        
-                        // Use generic offline IO creator for non-timestamped types when offline
-                        if (offline_enqueue) {
-                            io = create_offline_io_for_type(type_id, ioa, &val);
-                        } else {
-                            // Normal case: use the original type
-                            io = create_io_for_type(type_id, ioa, &val);
-                        }
-                        
-                        if (io) {
-                            CS101_ASDU_addInformationObject(newAsdu, io);
-                            InformationObject_destroy(io);
-                            CS104_Slave_enqueueASDU(slave, newAsdu);
-                        }
-                        CS101_ASDU_destroy(newAsdu);
+                    InformationObject io = create_io_for_type(send_type, ioa, &val);
+
+                    if (io) {
+                        CS101_ASDU_addInformationObject(newAsdu, io);
+                        InformationObject_destroy(io);
+                        CS104_Slave_enqueueASDU(slave, newAsdu);
                     }
                 }
             } else {
@@ -10,7 +10,9 @@
  * Processes JSON commands from stdin:
  * - {"cmd":"stop"} - Shutdown server
  * - {"cmd":"get_connected_clients"} - Query connected clients
- * - {"cmd":"get_queue_count"} - Get number of queued ASDUs
+ * - {"cmd":"get_queue_count"} - Get number of queued ASDUs, queue high-water mark and dropped entries
+ * - {"cmd":"get_periodic_stats"} - Cycle/missed-deadline counters per periodic group
+ * - {"cmd":"reload_config"} - Reload the point configuration, prints the diff
  * - {"type":"M_SP_TB_1","address":100,"value":1,"qualifier":0} - Data update
  */
 
@@ -3,19 +3,33 @@
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/signalfd.h>
 
 #include "cs104_slave.h"
 #include "hal_thread.h"
 
 #include "config/config_parser.h"
+#include "config/config_image.h"
+#include "config/config_reload.h"
 #include "data/data_manager.h"
+#include "data/value_snapshot.h"
 #include "protocol/interrogation.h"
+#include "protocol/counter_interrogation.h"
 #include "protocol/command_handler.h"
 #include "protocol/clock_sync.h"
+#include "protocol/read_command.h"
+#include "protocol/select_table.h"
+#include "protocol/command_pipeline.h"
+#include "protocol/offline_sender.h"
 #include "threads/periodic_sender.h"
+#include "threads/thread_policy.h"
 #include "client/client_manager.h"
 #include "input/input_handler.h"
 #include "utils/logger.h"
+#include "utils/apdu_capture.h"
+#include "utils/event_output.h"
 
 // Global variables
 static CS104_Slave slave = NULL;
@@ -28,17 +42,69 @@ int ASDU = 1;
 char command_mode[64] = "direct";
 int tcpPort = 2404;
 char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = SELECT_TABLE_DEFAULT_TIMEOUT_MS;
+int max_selects = SELECT_TABLE_DEFAULT_CAPACITY;
+bool async_commands = false;
+int command_timeout_ms = COMMAND_PIPELINE_DEFAULT_TIMEOUT_MS;
+int max_pending_commands = COMMAND_PIPELINE_DEFAULT_CAPACITY;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
 CS101_AppLayerParameters alParameters = NULL;
 
+// Connection events go to the client list, the APDU capture and the command state
+static void connection_event_handler(void* parameter, IMasterConnection connection,
+                                     CS104_PeerConnectionEvent event) {
+    client_connection_event_handler(parameter, connection, event);
+    apdu_capture_connection_event(connection, event);
+
+    if (event == CS104_CON_EVENT_CONNECTION_CLOSED) {
+        select_table_connection_closed(connection);
+        command_pipeline_connection_closed(connection);
+    }
+
+    // Values held by the latest offline policy go out once data transfer starts
+    if (event == CS104_CON_EVENT_ACTIVATED) {
+        offline_send_pending((CS104_Slave)parameter);
+    }
+}
+
 // Signal handler
 void sigint_handler(int signalId) {
     (void)signalId;
     running = false;
 }
 
+// Process one line read from stdin; returns false when shutdown is requested
+static bool process_input_line(const char* line) {
+    if (line[0] == '\0') {
+        return true;
+    }
+    return input_handler_process_line(line);
+}
+
 int main(int argc, char** argv) {
     // Setup signal handler
     signal(SIGINT, sigint_handler);
+    // A consumer closing the event channel must not terminate the server
+    signal(SIGPIPE, SIG_IGN);
+
+    // SIGHUP is read from a signalfd in the main loop. Block it before any
+    // thread is created, so every thread inherits the mask and none takes it.
+    sigset_t hup_mask;
+    sigemptyset(&hup_mask);
+    sigaddset(&hup_mask, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &hup_mask, NULL);
+    int hup_fd = -1;
 
     // Initialize logger
     logger_init(LOG_LEVEL_INFO);
@@ -47,15 +113,51 @@ int main(int argc, char** argv) {
     init_data_contexts();
     client_manager_init();
 
+    // Compile the configuration into a station image and exit
+    if (argc > 1 && strcmp(argv[1], "--compile-config") == 0) {
+        char image_file[4096];
+
+        if (argc < 3 || argc > 4) {
+            fprintf(stderr, "Usage: %s --compile-config <config.json> [image]\n", argv[0]);
+            return 1;
+        }
+        if (argc == 4) {
+            snprintf(image_file, sizeof(image_file), "%s", argv[3]);
+        } else if (!config_image_default_path(argv[2], image_file, sizeof(image_file))) {
+            LOG_ERROR("Config path too long: %s", argv[2]);
+            return 1;
+        }
+
+        bool compiled = config_image_compile(argv[2], image_file);
+        periodic_clear_groups();
+        cleanup_data_contexts();
+        client_manager_cleanup();
+        return compiled ? 0 : 1;
+    }
+
     // Load configuration
     const char* config_file = "iec104_config.json";
     if (argc > 1) {
         config_file = argv[1];
     }
 
-    if (!init_config_from_file(config_file)) {
-        LOG_ERROR("Failed to load configuration");
-        return 1;
+    // Prefer the station image next to the config, parse the JSON if it is missing or stale
+    char image_file[4096];
+    if (!config_image_default_path(config_file, image_file, sizeof(image_file)) ||
+        !config_image_load(config_file, image_file)) {
+        if (!init_config_from_file(config_file)) {
+            LOG_ERROR("Failed to load configuration");
+            return 1;
+        }
+    }
+
+    // CPU affinity and priority per thread class, applied by each thread as it starts
+    thread_policy_init();
+
+    // Restore the last known values and keep writing them to the snapshot
+    if (value_snapshot_file[0] != '\0' &&
+        !value_snapshot_open(value_snapshot_file, value_snapshot_sync_ms, value_snapshot_non_topical)) {
+        LOG_WARN("Value snapshot disabled, values start INVALID");
     }
 
     // Create slave
@@ -68,16 +170,71 @@ int main(int argc, char** argv) {
     // Get AppLayerParameters for global usage
     alParameters = CS104_Slave_getAppLayerParameters(slave);
 
+    // Interrogations reuse one packing plan per type (rebuilt if the image's ASDU size differs)
+    if (!interrogation_prepare_plans(alParameters->maxSizeOfASDU)) {
+        LOG_WARN("Packing plans are built per interrogation");
+    }
+
     // Configure slave
     CS104_Slave_setLocalPort(slave, tcpPort);
     CS104_Slave_setLocalAddress(slave, local_ip);
     CS104_Slave_setServerMode(slave, CS104_MODE_SINGLE_REDUNDANCY_GROUP);
 
+    // APCI window/timeouts and acknowledgement policy
+    *CS104_Slave_getConnectionParameters(slave) = apci_parameters;
+    CS104_Slave_setAckPolicy(slave, ack_policy, ack_delay_ms);
+    LOG_INFO("APCI: k=%d w=%d t1=%d t2=%d t3=%d, %s acknowledgement",
+             apci_parameters.k, apci_parameters.w, apci_parameters.t1, apci_parameters.t2, apci_parameters.t3,
+             ack_policy == CS104_ACK_POLICY_DELAYED ? "delayed" : "immediate");
+
     // Set callbacks
     CS104_Slave_setInterrogationHandler(slave, interrogationHandler, NULL);
+    CS104_Slave_setCounterInterrogationHandler(slave, counterInterrogationHandler, NULL);
     CS104_Slave_setASDUHandler(slave, asduHandler, NULL);
     CS104_Slave_setClockSyncHandler(slave, clockSyncHandler, NULL);
-    CS104_Slave_setConnectionEventHandler(slave, client_connection_event_handler, NULL);
+    CS104_Slave_setReadHandler(slave, readHandler, NULL);
+    CS104_Slave_setConnectionEventHandler(slave, connection_event_handler, slave);
+    CS104_Slave_setRawMessageHandler(slave, apdu_capture_raw_message_handler, NULL);
+
+    // APDU capture (also switchable at runtime with capture_start/capture_stop)
+    apdu_capture_init(local_ip, tcpPort);
+    if (capture_file[0] != '\0') {
+        apdu_capture_start(capture_file, (uint64_t)capture_max_mb * 1024 * 1024);
+    }
+
+    // Commands and clock syncs on their own channel instead of stdout
+    if (event_output[0] != '\0' && !event_output_open(event_output)) {
+        LOG_WARN("Event output unavailable, events are printed on stdout");
+    }
+
+    // Pending selects of select-before-operate commands
+    if (!select_table_init(max_selects, select_timeout_ms)) {
+        LOG_ERROR("Failed to allocate select table");
+        goto cleanup;
+    }
+
+    // Executes wait for {"cmd":"command_result"} instead of being confirmed at once
+    if (async_commands && !command_pipeline_init(max_pending_commands, command_timeout_ms)) {
+        goto cleanup;
+    }
+
+    // Size the connection table (0 = library default)
+    if (max_connections > 0) {
+        CS104_Slave_setMaxOpenConnections(slave, max_connections);
+        LOG_INFO("Max connections: %d", max_connections);
+    }
+
+    // Serve all connections from a fixed pool of epoll reactor threads instead of one thread per connection
+    if (reactor_threads == REACTOR_THREADS_AUTO) {
+        reactor_threads = thread_policy_cpu_count(THREAD_CLASS_REACTOR);
+    }
+    if (reactor_threads > 0) {
+        if (CS104_Slave_setReactorThreads(slave, reactor_threads, reactor_pin_threads)) {
+            LOG_INFO("Reactor mode: %d thread(s)%s", reactor_threads, reactor_pin_threads ? ", pinned" : "");
+        } else {
+            LOG_WARN("Reactor mode not available, using one thread per connection");
+        }
+    }
 
     // Start server
     CS104_Slave_start(slave);
@@ -94,21 +251,67 @@ int main(int argc, char** argv) {
     // Initialize input handler
     input_handler_init(slave);
 
-    // Main loop - read stdin and process commands
+    // Reload on SIGHUP
+    config_reload_init(config_file);
+    hup_fd = signalfd(-1, &hup_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (hup_fd < 0) {
+        LOG_WARN("SIGHUP reload unavailable: %s", strerror(errno));
+    }
+
+    // The stdin loop runs on this thread; set last so no other thread inherits it
+    thread_policy_apply(THREAD_CLASS_INPUT);
+
+    // Main loop - wait for stdin commands and SIGHUP together
+    struct pollfd fds[2] = {
+        { .fd = STDIN_FILENO, .events = POLLIN },
+        { .fd = hup_fd, .events = POLLIN }
+    };
     char buffer[1024];
+    size_t used = 0;
     while (running) {
-        if (fgets(buffer, sizeof(buffer), stdin)) {
-            // Remove newline
-            buffer[strcspn(buffer, "\n")] = 0;
-            if (strlen(buffer) > 0) {
-                if (!input_handler_process_line(buffer)) {
-                    // Shutdown requested
-                    running = false;
-                }
+        if (poll(fds, 2, -1) < 0) {
+            if (errno != EINTR) {
+                LOG_ERROR("Main loop poll failed: %s", strerror(errno));
+                break;
             }
-        } else {
-            // EOF or error
-            Thread_sleep(100);
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            // Several SIGHUPs before this read give one reload
+            struct signalfd_siginfo info;
+            while (read(hup_fd, &info, sizeof(info)) == sizeof(info)) {
+            }
+            input_handler_process_line("{\"cmd\":\"reload_config\"}");
+        }
+
+        if (fds[0].revents == 0) {
+            continue;
+        }
+
+        ssize_t n = read(STDIN_FILENO, buffer + used, sizeof(buffer) - 1 - used);
+        if (n <= 0) {
+            // EOF or error: keep serving (and reloading on SIGHUP) without stdin
+            fds[0].fd = -1;
+            continue;
+        }
+        used += (size_t)n;
+
+        char* line = buffer;
+        char* end;
+        while (running && (end = memchr(line, '\n', used - (size_t)(line - buffer))) != NULL) {
+            *end = '\0';
+            running = process_input_line(line);
+            line = end + 1;
+        }
+        used -= (size_t)(line - buffer);
+        memmove(buffer, line, used);
+
+        // A line longer than the buffer is processed in pieces, as fgets() did
+        if (running && used == sizeof(buffer) - 1) {
+            buffer[used] = '\0';
+            running = process_input_line(buffer);
+            used = 0;
         }
     }
 
@@ -118,13 +321,26 @@ cleanup:
 
     input_handler_cleanup();
     stop_periodic_sender();
+    periodic_clear_groups();
 
     if (slave) {
         CS104_Slave_stop(slave);
         CS104_Slave_destroy(slave);
     }
 
+    apdu_capture_cleanup();
+    select_table_cleanup();
+    command_pipeline_cleanup();
+    event_output_close();
+
+    interrogation_clear_plans();
+    value_snapshot_close();
     cleanup_data_contexts();
+    config_image_unload();
+    config_reload_cleanup();
+    if (hup_fd >= 0) {
+        close(hup_fd);
+    }
     client_manager_cleanup();
 
     LOG_INFO("Server stopped");
@@ -0,0 +1,23 @@
+#include "asdu_pool.h"
+
+/**
+ * One ASDU buffer per thread
+ *
+ * GI runs in the lib60870 connection threads, periodic data in the
+ * periodic sender thread and spontaneous data in the stdin loop.
+ * Thread-local storage gives each of them a private buffer without
+ * any locking.
+ */
+static __thread sCS101_StaticASDU thread_asdu;
+
+/**
+ * Acquire the thread-local ASDU
+ *
+ * CS101_ASDU_initializeStatic() rewrites the header and clears the
+ * payload, which is all that is needed to reuse the buffer.
+ */
+CS101_ASDU asdu_pool_acquire(CS101_AppLayerParameters parameters, bool isSequence,
+                             CS101_CauseOfTransmission cot, int ca) {
+    return CS101_ASDU_initializeStatic(&thread_asdu, parameters, isSequence,
+                                       cot, 0, ca, false, false);
+}
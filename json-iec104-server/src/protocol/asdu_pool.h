@@ -0,0 +1,35 @@
+#ifndef ASDU_POOL_H
+#define ASDU_POOL_H
+
+#include <stdbool.h>
+#include "../../lib60870/lib60870-C/src/inc/api/iec60870_common.h"
+
+/**
+ * ASDU Pool Module
+ *
+ * Provides reusable ASDU objects for the send paths (GI, periodic,
+ * spontaneous). Each thread owns one statically allocated ASDU buffer
+ * that is re-initialized in place with CS101_ASDU_initializeStatic(),
+ * so building a message no longer costs a malloc/free pair.
+ *
+ * The lib60870 send functions (IMasterConnection_sendASDU,
+ * CS104_Slave_enqueueASDU) copy the encoded ASDU, so the buffer can be
+ * reused as soon as the call returns.
+ */
+
+/**
+ * Acquire the calling thread's ASDU buffer, initialized with new header values
+ *
+ * The returned ASDU stays valid until the next call to asdu_pool_acquire()
+ * on the same thread. It must NOT be passed to CS101_ASDU_destroy().
+ *
+ * @param parameters Application layer parameters used to encode the ASDU
+ * @param isSequence true for SQ=1 (consecutive IOAs), false for SQ=0
+ * @param cot Cause of transmission
+ * @param ca Common address of the ASDU
+ * @return The thread-local ASDU instance (never NULL)
+ */
+CS101_ASDU asdu_pool_acquire(CS101_AppLayerParameters parameters, bool isSequence,
+                             CS101_CauseOfTransmission cot, int ca);
+
+#endif // ASDU_POOL_H
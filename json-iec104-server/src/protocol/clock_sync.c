@@ -1,5 +1,6 @@
 #include "clock_sync.h"
 #include "../utils/logger.h"
+#include "../utils/event_output.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -25,9 +26,8 @@ bool clockSyncHandler(void* parameter, IMasterConnection connection, CS101_ASDU
     char buffer[100];
     strftime(buffer, sizeof(buffer), "%FT%X%z", &tmTime);
     
-    // Log JSON for external handler
-    printf("{\"type\":\"C_CS_NA_1\",\"value\":\"%s\"}\n", buffer);
-    fflush(stdout);
+    // Report to the external handler
+    bool accepted = event_output_emit("\"type\":\"C_CS_NA_1\",\"value\":\"%s\"", buffer);
     
     LOG_INFO("Clock sync received: %s", buffer);
 
@@ -38,16 +38,21 @@ bool clockSyncHandler(void* parameter, IMasterConnection connection, CS101_ASDU
     
     if (system(cmd_buf) != 0) {
         LOG_WARN("Failed to set system time");
-        printf("{\"warn\":\"set system time failed\"}\n");
+        event_output_emit("\"warn\":\"set system time failed\"");
     } else {
         LOG_INFO("System time updated successfully");
-        printf("{\"info\":\"set system time success\"}\n");
+        event_output_emit("\"info\":\"set system time success\"");
+        accepted = true;
     }
-    fflush(stdout);
 #endif /* CLOCKSYNC_FROM_IEC */
 
-    // Send activation confirmation
+    if (!accepted) {
+        LOG_WARN("Event output full, clock sync rejected");
+    }
+
+    // Send activation confirmation, negative if nobody applied the time
     CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
+    CS101_ASDU_setNegative(asdu, !accepted);
     IMasterConnection_sendASDU(connection, asdu);
 
     return true;
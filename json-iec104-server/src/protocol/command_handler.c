@@ -1,89 +1,77 @@
 #include "command_handler.h"
+#include "select_table.h"
+#include "command_pipeline.h"
 #include "../data/data_manager.h"
 #include "../utils/logger.h"
+#include "../utils/event_output.h"
 #include "hal_time.h"
 #include <stdio.h>
 #include <string.h>
-#include <pthread.h>
 
 // External configuration
 extern char command_mode[64];
+extern bool async_commands;
 
-// SBO State Management
-#define MAX_SELECT_ENTRIES 100
-#define SELECT_TIMEOUT_MS 5000
-
-typedef struct {
-    int ioa;
-    IMasterConnection connection; 
-    uint64_t timestamp;
-    bool isSelected;
-} SelectEntry;
+// Store the select and confirm it, or reject it when the select table is full
+static bool confirm_select(IMasterConnection connection, CS101_ASDU asdu, TypeID type, int ioa)
+{
+    bool stored = select_table_store(connection, type, ioa);
 
-static SelectEntry selectTable[MAX_SELECT_ENTRIES];
-static pthread_mutex_t selectTableMutex = PTHREAD_MUTEX_INITIALIZER;
+    CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
+    CS101_ASDU_setNegative(asdu, !stored);
+    IMasterConnection_sendASDU(connection, asdu);
 
-static void storeSelectState(int ioa, IMasterConnection connection) {
-    pthread_mutex_lock(&selectTableMutex);
-    
-    int freeIndex = -1;
-    for(int i = 0; i < MAX_SELECT_ENTRIES; i++) {
-        if(!selectTable[i].isSelected) {
-            freeIndex = i;
-            break;
-        }
-        if(selectTable[i].ioa == ioa) {
-            freeIndex = i;
-            break; 
-        }
+    if (!stored) {
+        LOG_WARN("Select table full, select of IOA %d rejected", ioa);
+        event_output_emit("\"error\":\"select table full\",\"address\":%d", ioa);
     }
-    
-    if(freeIndex >= 0) {
-        selectTable[freeIndex].ioa = ioa;
-        selectTable[freeIndex].connection = connection;
-        selectTable[freeIndex].timestamp = Hal_getTimeInMs();
-        selectTable[freeIndex].isSelected = true;
-    }
-    
-    pthread_mutex_unlock(&selectTableMutex);
+
+    return stored;
 }
 
-static bool isPreviouslySelected(int ioa, IMasterConnection connection) {
-    bool result = false;
-    uint64_t currentTime = Hal_getTimeInMs();
-    
-    pthread_mutex_lock(&selectTableMutex);
-    
-    for(int i = 0; i < MAX_SELECT_ENTRIES; i++) {
-        if(selectTable[i].isSelected && 
-           selectTable[i].ioa == ioa &&
-           selectTable[i].connection == connection) {
-            if((currentTime - selectTable[i].timestamp) < SELECT_TIMEOUT_MS) {
-                result = true;
-            } else {
-                selectTable[i].isSelected = false;
-            }
-            break;
+/**
+ * Emit an execute and confirm it
+ *
+ * fields is the JSON object body without braces. With async commands the
+ * ASDU is held by the command pipeline and confirmed once the external
+ * process reports the result; the emitted command carries the ID to answer.
+ * A command the event channel drops never reaches the external process and
+ * is confirmed negatively, as when the pipeline is full.
+ */
+static void execute_command(IMasterConnection connection, CS101_ASDU asdu, const char* fields)
+{
+    if (!async_commands) {
+        bool emitted = event_output_emit("%s", fields);
+
+        CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
+        CS101_ASDU_setNegative(asdu, !emitted);
+        IMasterConnection_sendASDU(connection, asdu);
+
+        if (!emitted) {
+            LOG_WARN("Event output full, command rejected");
+            return;
         }
+
+        CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_TERMINATION);
+        IMasterConnection_sendASDU(connection, asdu);
+        return;
     }
-    
-    pthread_mutex_unlock(&selectTableMutex);
-    return result;
-}
 
-static void clearSelectState(int ioa, IMasterConnection connection) {
-    pthread_mutex_lock(&selectTableMutex);
-    
-    for(int i = 0; i < MAX_SELECT_ENTRIES; i++) {
-        if(selectTable[i].isSelected && 
-           selectTable[i].ioa == ioa &&
-           selectTable[i].connection == connection) {
-            selectTable[i].isSelected = false;
-            break;
-        }
+    uint32_t id;
+    if (!command_pipeline_submit(connection, asdu, &id)) {
+        CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
+        CS101_ASDU_setNegative(asdu, true);
+        IMasterConnection_sendASDU(connection, asdu);
+
+        LOG_WARN("Command pipeline full, command rejected");
+        event_output_emit("\"error\":\"command pipeline full\"");
+        return;
+    }
+
+    if (!event_output_emit("%s,\"id\":%u", fields, id)) {
+        LOG_WARN("Event output full, command %u rejected", id);
+        command_pipeline_complete(id, false);
     }
-    
-    pthread_mutex_unlock(&selectTableMutex);
 }
 
 bool handle_single_command(IMasterConnection connection, CS101_ASDU asdu)
@@ -105,47 +93,40 @@ bool handle_single_command(IMasterConnection connection, CS101_ASDU asdu)
     if (isDirectMode) {
         // Direct mode: Execute immediately if not select
         if (!select) {
-            printf("{\"type\":\"C_SC_NA_1\",\"action\":\"execute\",\"mode\":\"direct\",\"address\":%d,\"value\":\"%s\"}\n", 
-                   ioa, value ? "on" : "off");
-            
-            CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
-            IMasterConnection_sendASDU(connection, asdu);
-            
-            CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_TERMINATION);
-            IMasterConnection_sendASDU(connection, asdu);
+            char fields[160];
+            snprintf(fields, sizeof(fields), "\"type\":\"C_SC_NA_1\",\"action\":\"execute\",\"mode\":\"direct\",\"address\":%d,\"value\":\"%s\"",
+                     ioa, value ? "on" : "off");
+            execute_command(connection, asdu, fields);
         } else {
             // Select in direct mode: Just confirm
-            storeSelectState(ioa, connection);
-            CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
-            IMasterConnection_sendASDU(connection, asdu);
+            if (!confirm_select(connection, asdu, C_SC_NA_1, ioa)) {
+                InformationObject_destroy(io);
+                return true;
+            }
             
-            printf("{\"type\":\"C_SC_NA_1\",\"action\":\"select\",\"mode\":\"direct\",\"address\":%d}\n", ioa);
+            event_output_emit("\"type\":\"C_SC_NA_1\",\"action\":\"select\",\"mode\":\"direct\",\"address\":%d", ioa);
         }
     } else {
         // SBO mode
         if (select) {
-            storeSelectState(ioa, connection);
-            CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
-            IMasterConnection_sendASDU(connection, asdu);
+            if (!confirm_select(connection, asdu, C_SC_NA_1, ioa)) {
+                InformationObject_destroy(io);
+                return true;
+            }
             
-            printf("{\"type\":\"C_SC_NA_1\",\"action\":\"select\",\"mode\":\"sbo\",\"address\":%d}\n", ioa);
+            event_output_emit("\"type\":\"C_SC_NA_1\",\"action\":\"select\",\"mode\":\"sbo\",\"address\":%d", ioa);
         } else {
-            if (isPreviouslySelected(ioa, connection)) {
-                clearSelectState(ioa, connection);
-                printf("{\"type\":\"C_SC_NA_1\",\"action\":\"execute\",\"mode\":\"sbo\",\"address\":%d,\"value\":\"%s\"}\n", 
-                       ioa, value ? "on" : "off");
-                
-                CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
-                IMasterConnection_sendASDU(connection, asdu);
-                
-                CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_TERMINATION);
-                IMasterConnection_sendASDU(connection, asdu);
+            if (select_table_take(connection, C_SC_NA_1, ioa)) {
+                char fields[160];
+                snprintf(fields, sizeof(fields), "\"type\":\"C_SC_NA_1\",\"action\":\"execute\",\"mode\":\"sbo\",\"address\":%d,\"value\":\"%s\"",
+                         ioa, value ? "on" : "off");
+                execute_command(connection, asdu, fields);
             } else {
                 CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_TERMINATION);
                 CS101_ASDU_setNegative(asdu, true);
                 IMasterConnection_sendASDU(connection, asdu);
                 
-                printf("{\"error\":\"command not previously selected\"}\n");
+                event_output_emit("\"error\":\"command not previously selected\"");
             }
         }
     }
@@ -172,45 +153,38 @@ bool handle_set_point_command(IMasterConnection connection, CS101_ASDU asdu)
 
     if (isDirectMode) {
         if (!select) {
-            printf("{\"type\":\"C_SE_NC_1\",\"action\":\"execute\",\"mode\":\"direct\",\"address\":%d,\"value\":%.2f,\"qualifier\":%d}\n", 
-                   ioa, value, ql);
-            
-            CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
-            IMasterConnection_sendASDU(connection, asdu);
-            
-            CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_TERMINATION);
-            IMasterConnection_sendASDU(connection, asdu);
+            char fields[160];
+            snprintf(fields, sizeof(fields), "\"type\":\"C_SE_NC_1\",\"action\":\"execute\",\"mode\":\"direct\",\"address\":%d,\"value\":%.2f,\"qualifier\":%d",
+                     ioa, value, ql);
+            execute_command(connection, asdu, fields);
         } else {
-            storeSelectState(ioa, connection);
-            CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
-            IMasterConnection_sendASDU(connection, asdu);
+            if (!confirm_select(connection, asdu, C_SE_NC_1, ioa)) {
+                InformationObject_destroy(io);
+                return true;
+            }
             
-            printf("{\"type\":\"C_SE_NC_1\",\"action\":\"select\",\"mode\":\"direct\",\"address\":%d}\n", ioa);
+            event_output_emit("\"type\":\"C_SE_NC_1\",\"action\":\"select\",\"mode\":\"direct\",\"address\":%d", ioa);
         }
     } else {
         if (select) {
-            storeSelectState(ioa, connection);
-            CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
-            IMasterConnection_sendASDU(connection, asdu);
+            if (!confirm_select(connection, asdu, C_SE_NC_1, ioa)) {
+                InformationObject_destroy(io);
+                return true;
+            }
             
-            printf("{\"type\":\"C_SE_NC_1\",\"action\":\"select\",\"mode\":\"sbo\",\"address\":%d}\n", ioa);
+            event_output_emit("\"type\":\"C_SE_NC_1\",\"action\":\"select\",\"mode\":\"sbo\",\"address\":%d", ioa);
         } else {
-            if (isPreviouslySelected(ioa, connection)) {
-                clearSelectState(ioa, connection);
-                printf("{\"type\":\"C_SE_NC_1\",\"action\":\"execute\",\"mode\":\"sbo\",\"address\":%d,\"value\":%.2f,\"qualifier\":%d}\n", 
-                       ioa, value, ql);
-                
-                CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
-                IMasterConnection_sendASDU(connection, asdu);
-                
-                CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_TERMINATION);
-                IMasterConnection_sendASDU(connection, asdu);
+            if (select_table_take(connection, C_SE_NC_1, ioa)) {
+                char fields[160];
+                snprintf(fields, sizeof(fields), "\"type\":\"C_SE_NC_1\",\"action\":\"execute\",\"mode\":\"sbo\",\"address\":%d,\"value\":%.2f,\"qualifier\":%d",
+                         ioa, value, ql);
+                execute_command(connection, asdu, fields);
             } else {
                 CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_TERMINATION);
                 CS101_ASDU_setNegative(asdu, true);
                 IMasterConnection_sendASDU(connection, asdu);
                 
-                printf("{\"warn\":\"execute without select: %d\"}\n", ioa);
+                event_output_emit("\"warn\":\"execute without select: %d\"", ioa);
             }
         }
     }
@@ -229,18 +203,27 @@ bool handle_reset_process_command(IMasterConnection connection, CS101_ASDU asdu)
 
     LOG_INFO("Received C_RP_NA_1 (Reset Process): IOA=%d, QRP=%d", ioa, qrp);
 
-    // Send ACT_CON (Activation Confirmation)
+    // Output JSON for external handler to perform actual reset
+    bool emitted = event_output_emit("\"type\":\"C_RP_NA_1\",\"action\":\"reset\",\"address\":%d,\"qrp\":%d",
+                                     ioa, qrp);
+
+    // Send ACT_CON (Activation Confirmation), negative if the external
+    // handler will never see the reset
     CS101_ASDU_setCOT(asdu, CS101_COT_ACTIVATION_CON);
+    CS101_ASDU_setNegative(asdu, !emitted);
     IMasterConnection_sendASDU(connection, asdu);
 
-    // Output JSON for external handler to perform actual reset
-    printf("{\"type\":\"C_RP_NA_1\",\"action\":\"reset\",\"address\":%d,\"qrp\":%d}\n",
-           ioa, qrp);
-    fflush(stdout);
+    if (!emitted) {
+        LOG_WARN("Event output full, reset process rejected");
+        InformationObject_destroy(io);
+        return true;
+    }
 
     // Execute reset if QRP is 1 (General Reset)
     if (qrp == 1) {
+        data_config_read_lock();
         reset_all_data();
+        data_config_read_unlock();
     }
 
     // Send ACT_TERM (Activation Termination) indicating completion
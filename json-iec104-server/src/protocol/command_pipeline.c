@@ -0,0 +1,287 @@
+#include "command_pipeline.h"
+#include "../utils/logger.h"
+#include "../utils/utils.h"
+#include "../utils/event_output.h"
+#include "../threads/thread_policy.h"
+#include "../../cJSON/cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+typedef struct {
+    bool active;
+    uint32_t id;
+    IMasterConnection connection;
+    uint64_t deadline;                  // Monotonic ms
+    CS101_ASDU asdu;                    // Clone in storage
+    sCS101_StaticASDU storage;
+} PendingCommand;
+
+static PendingCommand* ring = NULL;
+static uint32_t ring_mask = 0;
+static uint32_t head_id = 0;            // Oldest ID that may still be pending
+static uint32_t next_id = 1;
+
+static CommandPipelineStats stats;
+static pthread_mutex_t pipeline_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pipeline_cond;
+static pthread_t timeout_thread;
+static bool thread_running = false;
+
+// Send the confirmation of a pending command (called with the mutex held)
+static void confirm(PendingCommand* cmd, bool success) {
+    CS101_ASDU_setCOT(cmd->asdu, CS101_COT_ACTIVATION_CON);
+    CS101_ASDU_setNegative(cmd->asdu, !success);
+    IMasterConnection_sendASDU(cmd->connection, cmd->asdu);
+
+    if (success) {
+        CS101_ASDU_setCOT(cmd->asdu, CS101_COT_ACTIVATION_TERMINATION);
+        IMasterConnection_sendASDU(cmd->connection, cmd->asdu);
+    }
+}
+
+// Free a slot and move the head past completed commands
+static void release(PendingCommand* cmd) {
+    cmd->active = false;
+    cmd->connection = NULL;
+    stats.pending--;
+
+    while (head_id != next_id && !ring[head_id & ring_mask].active) {
+        head_id++;
+    }
+}
+
+/**
+ * Timeout thread
+ *
+ * The command at the head has the earliest deadline, so the thread sleeps
+ * until that deadline or until a command is submitted to an empty ring.
+ */
+static void* command_timeout_thread(void* arg) {
+    (void)arg;
+    thread_policy_apply(THREAD_CLASS_BACKGROUND);
+
+    pthread_mutex_lock(&pipeline_mutex);
+
+    while (thread_running) {
+        if (stats.pending == 0) {
+            pthread_cond_wait(&pipeline_cond, &pipeline_mutex);
+            continue;
+        }
+
+        PendingCommand* cmd = &ring[head_id & ring_mask];
+        uint64_t now = utils_monotonic_ms();
+
+        if (cmd->deadline <= now) {
+            LOG_WARN("Command %u timed out without result", cmd->id);
+            event_output_emit("\"error\":\"command timeout\",\"id\":%u", cmd->id);
+
+            confirm(cmd, false);
+            stats.timed_out++;
+            release(cmd);
+            continue;
+        }
+
+        struct timespec until = {
+            .tv_sec = (time_t)(cmd->deadline / 1000),
+            .tv_nsec = (long)(cmd->deadline % 1000) * 1000000
+        };
+        pthread_cond_timedwait(&pipeline_cond, &pipeline_mutex, &until);
+    }
+
+    pthread_mutex_unlock(&pipeline_mutex);
+    return NULL;
+}
+
+bool command_pipeline_init(int capacity, int timeout_ms) {
+    if (capacity <= 0) {
+        capacity = COMMAND_PIPELINE_DEFAULT_CAPACITY;
+    }
+    if (timeout_ms <= 0) {
+        timeout_ms = COMMAND_PIPELINE_DEFAULT_TIMEOUT_MS;
+    }
+
+    command_pipeline_cleanup();
+
+    // Twice the capacity, so completed commands behind a slow one do not fill the ring
+    uint32_t size = utils_next_pow2((uint32_t)capacity * 2);
+
+    pthread_mutex_lock(&pipeline_mutex);
+
+    ring = calloc(size, sizeof(PendingCommand));
+    if (!ring) {
+        pthread_mutex_unlock(&pipeline_mutex);
+        LOG_ERROR("Failed to allocate command pipeline");
+        return false;
+    }
+
+    ring_mask = size - 1;
+    head_id = next_id;
+    memset(&stats, 0, sizeof(stats));
+    stats.capacity = capacity;
+    stats.timeout_ms = timeout_ms;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&pipeline_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    thread_running = true;
+    if (pthread_create(&timeout_thread, NULL, command_timeout_thread, NULL) != 0) {
+        thread_running = false;
+        pthread_cond_destroy(&pipeline_cond);
+        free(ring);
+        ring = NULL;
+        pthread_mutex_unlock(&pipeline_mutex);
+        LOG_ERROR("Failed to create command timeout thread");
+        return false;
+    }
+
+    pthread_mutex_unlock(&pipeline_mutex);
+
+    LOG_INFO("Async commands: %d pending, timeout %d ms", capacity, timeout_ms);
+    return true;
+}
+
+void command_pipeline_cleanup(void) {
+    pthread_mutex_lock(&pipeline_mutex);
+
+    if (!ring) {
+        pthread_mutex_unlock(&pipeline_mutex);
+        return;
+    }
+
+    thread_running = false;
+    pthread_cond_signal(&pipeline_cond);
+    pthread_mutex_unlock(&pipeline_mutex);
+
+    pthread_join(timeout_thread, NULL);
+
+    pthread_mutex_lock(&pipeline_mutex);
+    pthread_cond_destroy(&pipeline_cond);
+    free(ring);
+    ring = NULL;
+    stats.pending = 0;
+    pthread_mutex_unlock(&pipeline_mutex);
+}
+
+bool command_pipeline_submit(IMasterConnection connection, CS101_ASDU asdu, uint32_t* id) {
+    bool submitted = false;
+    uint64_t now = utils_monotonic_ms();
+
+    pthread_mutex_lock(&pipeline_mutex);
+
+    if (ring) {
+        if (stats.pending < stats.capacity && next_id - head_id <= ring_mask) {
+            PendingCommand* cmd = &ring[next_id & ring_mask];
+
+            cmd->active = true;
+            cmd->id = next_id;
+            cmd->connection = connection;
+            cmd->deadline = now + stats.timeout_ms;
+            cmd->asdu = CS101_ASDU_clone(asdu, &cmd->storage);
+
+            *id = next_id++;
+            stats.submitted++;
+
+            // The timeout thread sleeps while nothing is pending
+            if (stats.pending++ == 0) {
+                pthread_cond_signal(&pipeline_cond);
+            }
+            submitted = true;
+        } else {
+            stats.rejected++;
+        }
+    }
+
+    pthread_mutex_unlock(&pipeline_mutex);
+    return submitted;
+}
+
+bool command_pipeline_complete(uint32_t id, bool success) {
+    bool completed = false;
+
+    pthread_mutex_lock(&pipeline_mutex);
+
+    if (ring) {
+        PendingCommand* cmd = &ring[id & ring_mask];
+
+        if (cmd->active && cmd->id == id) {
+            confirm(cmd, success);
+            if (success) {
+                stats.succeeded++;
+            } else {
+                stats.failed++;
+            }
+            release(cmd);
+            completed = true;
+        } else {
+            stats.unknown_results++;
+        }
+    }
+
+    pthread_mutex_unlock(&pipeline_mutex);
+    return completed;
+}
+
+/**
+ * Drop the commands of a closed connection without confirmation
+ *
+ * Commands are indexed by ID, not by connection, so every ring slot is
+ * checked. Holding the mutex here also keeps the timeout thread and result
+ * handling from sending on the connection while the slave releases it.
+ */
+void command_pipeline_connection_closed(IMasterConnection connection) {
+    if (connection == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pipeline_mutex);
+
+    if (ring) {
+        int dropped = 0;
+
+        for (uint32_t i = 0; i <= ring_mask; i++) {
+            if (ring[i].active && ring[i].connection == connection) {
+                release(&ring[i]);
+                dropped++;
+            }
+        }
+
+        if (dropped > 0) {
+            LOG_DEBUG("Dropped %d pending command(s) of a closed connection", dropped);
+        }
+    }
+
+    pthread_mutex_unlock(&pipeline_mutex);
+}
+
+void command_pipeline_get_stats(CommandPipelineStats* out) {
+    pthread_mutex_lock(&pipeline_mutex);
+    *out = stats;
+    pthread_mutex_unlock(&pipeline_mutex);
+}
+
+char* command_pipeline_get_stats_json(void) {
+    CommandPipelineStats s;
+    command_pipeline_get_stats(&s);
+
+    cJSON* response = cJSON_CreateObject();
+    cJSON_AddNumberToObject(response, "pending", s.pending);
+    cJSON_AddNumberToObject(response, "capacity", s.capacity);
+    cJSON_AddNumberToObject(response, "timeout_ms", s.timeout_ms);
+    cJSON_AddNumberToObject(response, "submitted", (double)s.submitted);
+    cJSON_AddNumberToObject(response, "succeeded", (double)s.succeeded);
+    cJSON_AddNumberToObject(response, "failed", (double)s.failed);
+    cJSON_AddNumberToObject(response, "timed_out", (double)s.timed_out);
+    cJSON_AddNumberToObject(response, "rejected", (double)s.rejected);
+    cJSON_AddNumberToObject(response, "unknown_results", (double)s.unknown_results);
+
+    char* json_str = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+
+    return json_str;
+}
@@ -0,0 +1,88 @@
+#ifndef COMMAND_PIPELINE_H
+#define COMMAND_PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cs104_slave.h"
+
+/**
+ * Asynchronous Command Pipeline
+ *
+ * With "async_commands" enabled an execute is not confirmed when it is
+ * printed. The command handler submits a copy of the ASDU here and prints
+ * the command with its correlation ID; ACT_CON and ACT_TERM are sent when
+ * the external process answers with {"cmd":"command_result","id":N,...},
+ * a negative ACT_CON when it reports a failure or the timeout expires.
+ *
+ * IDs are consecutive and every command has the same timeout, so pending
+ * commands sit in a ring indexed by ID in deadline order: submit, result
+ * and expiry cost O(1) and one thread only waits for the oldest command.
+ * Connection threads never wait for the external process.
+ */
+
+#define COMMAND_PIPELINE_DEFAULT_CAPACITY 1024
+#define COMMAND_PIPELINE_DEFAULT_TIMEOUT_MS 10000
+
+/**
+ * Command pipeline statistics
+ */
+typedef struct {
+    int pending;                // Commands waiting for a result
+    int capacity;               // Maximum pending commands
+    int timeout_ms;             // Time allowed for a result
+    uint64_t submitted;         // Commands handed to the external process
+    uint64_t succeeded;         // Results with success (ACT_CON + ACT_TERM sent)
+    uint64_t failed;            // Results with failure (negative ACT_CON sent)
+    uint64_t timed_out;         // Commands without result in time (negative ACT_CON sent)
+    uint64_t rejected;          // Commands rejected because the pipeline was full
+    uint64_t unknown_results;   // Results for unknown, expired or closed commands
+} CommandPipelineStats;
+
+/**
+ * Initialize the pipeline and start the timeout thread
+ *
+ * @param capacity Maximum number of pending commands (0 = default)
+ * @param timeout_ms Time allowed for a result (0 = default)
+ * @return true on success
+ */
+bool command_pipeline_init(int capacity, int timeout_ms);
+
+/**
+ * Stop the timeout thread and release the pipeline
+ */
+void command_pipeline_cleanup(void);
+
+/**
+ * Hold a command until its result arrives
+ *
+ * The ASDU is copied, the caller keeps ownership of asdu.
+ *
+ * @param id Receives the correlation ID
+ * @return false if the pipeline is full or not initialized
+ */
+bool command_pipeline_submit(IMasterConnection connection, CS101_ASDU asdu, uint32_t* id);
+
+/**
+ * Complete a pending command with the result of the external process
+ *
+ * @return false if the ID is not pending (unknown, timed out or connection closed)
+ */
+bool command_pipeline_complete(uint32_t id, bool success);
+
+/**
+ * Drop all commands of a connection, call on CS104_CON_EVENT_CONNECTION_CLOSED
+ */
+void command_pipeline_connection_closed(IMasterConnection connection);
+
+/**
+ * Get pipeline statistics
+ */
+void command_pipeline_get_stats(CommandPipelineStats* stats);
+
+/**
+ * Get pipeline statistics as JSON string
+ * @return JSON string (caller must free)
+ */
+char* command_pipeline_get_stats_json(void);
+
+#endif // COMMAND_PIPELINE_H
@@ -0,0 +1,165 @@
+#include "counter_interrogation.h"
+#include "interrogation.h" // For create_io_for_type
+#include "asdu_pool.h"
+#include "packing_plan.h"
+#include "../data/data_types.h"
+#include "../utils/logger.h"
+#include <stdio.h>
+#include <string.h>
+
+// External globals
+extern CS101_AppLayerParameters alParameters;
+extern int ASDU;
+
+/**
+ * Create a counter reading carrying the freeze sequence number
+ */
+static InformationObject create_counter_io(TypeID type_id, int ioa, const DataValue* data, int sequence) {
+    if (type_id != M_IT_TB_1) {
+        return create_io_for_type(type_id, ioa, data);
+    }
+
+    struct sBinaryCounterReading bcr;
+    BinaryCounterReading_create(&bcr, (int32_t)data->value.uint32_val, sequence, false, false, false);
+
+    return (InformationObject)IntegratedTotalsWithCP56Time2a_create(
+        NULL, ioa, &bcr, (CP56Time2a)&data->timestamp);
+}
+
+bool counter_freeze_all(bool reset) {
+    bool result = true;
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        DataTypeContext* ctx = &g_data_contexts[i];
+        if (!is_counter_context(ctx)) continue;
+
+        pthread_mutex_lock(&ctx->frozen_mutex);
+        if (!freeze_counters(ctx, reset)) {
+            result = false;
+        }
+        pthread_mutex_unlock(&ctx->frozen_mutex);
+    }
+
+    return result;
+}
+
+/**
+ * Send frozen counters of one type
+ *
+ * Only frozen_mutex is held while encoding, so update_data() on the live
+ * counters proceeds in parallel.
+ */
+bool send_counter_interrogation_for_type(IMasterConnection connection,
+                                         DataTypeContext* ctx,
+                                         CS101_CauseOfTransmission cot) {
+    if (!connection || !is_counter_context(ctx)) {
+        LOG_ERROR("Invalid parameters to send_counter_interrogation_for_type");
+        return false;
+    }
+
+    if (ctx->config.count == 0) {
+        return true;
+    }
+
+    bool result = true;
+
+    pthread_mutex_lock(&ctx->frozen_mutex);
+
+    // A read before any freeze reports the current values
+    if (ctx->frozen_time == 0 && !freeze_counters(ctx, false)) {
+        pthread_mutex_unlock(&ctx->frozen_mutex);
+        return false;
+    }
+
+    PackingPlan scratch;
+    const PackingPlan* plan = interrogation_get_plan(ctx, alParameters->maxSizeOfASDU, &scratch);
+
+    if (plan) {
+        for (int c = 0; c < plan->count; c++) {
+            const PackedChunk* chunk = &plan->chunks[c];
+
+            CS101_ASDU newAsdu = asdu_pool_acquire(alParameters, chunk->sequence, cot, ASDU);
+
+            for (int k = chunk->start; k < chunk->start + chunk->count; k++) {
+                InformationObject io = create_counter_io(ctx->type_id,
+                    ctx->config.ioa_list[k], &ctx->frozen_array[k], ctx->freeze_sequence);
+
+                if (io) {
+                    CS101_ASDU_addInformationObject(newAsdu, io);
+                    InformationObject_destroy(io);
+                }
+            }
+
+            IMasterConnection_sendASDU(connection, newAsdu);
+        }
+
+        LOG_DEBUG("Sent %d frozen %s counters in %d ASDUs",
+                  ctx->config.count, ctx->type_info->name, plan->count);
+        if (plan == &scratch) {
+            packing_plan_free(&scratch);
+        }
+    } else {
+        LOG_ERROR("Failed to build packing plan for %s", ctx->type_info->name);
+        result = false;
+    }
+
+    pthread_mutex_unlock(&ctx->frozen_mutex);
+    return result;
+}
+
+/**
+ * Main counter interrogation handler
+ */
+bool counterInterrogationHandler(void* parameter, IMasterConnection connection,
+                                 CS101_ASDU asdu, QualifierOfCIC qcc) {
+    (void)parameter; // Unused in this implementation
+
+    int rqt = qcc & 0x3f;
+    int frz = qcc & 0xc0;
+
+    LOG_INFO("Counter interrogation received: RQT=%d, FRZ=%d", rqt, frz >> 6);
+
+    if (rqt != IEC60870_QCC_RQT_GENERAL) {
+        LOG_WARN("Unsupported counter group RQT=%d, sending negative ACT-CON", rqt);
+        IMasterConnection_sendACT_CON(connection, asdu, true);
+        return false;
+    }
+
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+
+    data_config_read_lock();
+
+    switch (frz) {
+        case IEC60870_QCC_FRZ_READ:
+            for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+                DataTypeContext* ctx = &g_data_contexts[i];
+                if (!is_counter_context(ctx)) continue;
+
+                if (!send_counter_interrogation_for_type(connection, ctx,
+                                                         CS101_COT_REQUESTED_BY_GENERAL_COUNTER)) {
+                    LOG_WARN("Failed to send counter interrogation for type %s", ctx->type_info->name);
+                }
+            }
+            break;
+
+        case IEC60870_QCC_FRZ_FREEZE_WITHOUT_RESET:
+        case IEC60870_QCC_FRZ_FREEZE_WITH_RESET:
+            if (!counter_freeze_all(frz == IEC60870_QCC_FRZ_FREEZE_WITH_RESET)) {
+                LOG_WARN("Counter freeze failed");
+            }
+            break;
+
+        case IEC60870_QCC_FRZ_COUNTER_RESET:
+            for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+                reset_counters(&g_data_contexts[i]);
+            }
+            break;
+    }
+
+    data_config_read_unlock();
+
+    IMasterConnection_sendACT_TERM(connection, asdu);
+
+    LOG_INFO("Counter interrogation completed");
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef COUNTER_INTERROGATION_H
+#define COUNTER_INTERROGATION_H
+
+#include <stdbool.h>
+#include "../../lib60870/lib60870-C/src/inc/api/iec60870_slave.h"
+#include "../../lib60870/lib60870-C/src/inc/api/cs104_slave.h"
+#include "../data/data_manager.h"
+
+/**
+ * Counter Interrogation Module (C_CI_NA_1)
+ *
+ * Integrated totals are double-buffered: stdin updates always go to the live
+ * array, a freeze copies it into the frozen array, and counter interrogation
+ * reads only the frozen array. Streaming thousands of counters therefore
+ * never blocks counter updates.
+ *
+ * QCC handling (FRZ bits):
+ * - READ: send the frozen values (COT=REQUESTED_BY_GENERAL_COUNTER);
+ *   freezes first if nothing has been frozen yet
+ * - FREEZE_WITHOUT_RESET / FREEZE_WITH_RESET: freeze, no data
+ * - COUNTER_RESET: reset the live counters to 0
+ *
+ * Only the general request (RQT=5) is supported; counter groups 1-4 are
+ * rejected with a negative ACT-CON.
+ */
+
+/**
+ * Counter interrogation handler for CS104_Slave_setCounterInterrogationHandler
+ *
+ * @param parameter User-defined parameter (unused)
+ * @param connection The master connection requesting counter interrogation
+ * @param asdu The ASDU containing the counter interrogation command
+ * @param qcc Qualifier of counter interrogation (RQT + FRZ)
+ * @return true if the command was handled
+ */
+bool counterInterrogationHandler(void* parameter, IMasterConnection connection,
+                                 CS101_ASDU asdu, QualifierOfCIC qcc);
+
+/**
+ * Freeze the counters of all counter types
+ *
+ * @param reset true for freeze with reset
+ * @return true on success
+ */
+bool counter_freeze_all(bool reset);
+
+/**
+ * Send the frozen counters of one data type
+ * Uses the same packing plan as station interrogation
+ *
+ * @param connection The master connection
+ * @param ctx Counter context
+ * @param cot Cause of transmission for the data ASDUs
+ * @return true on success
+ */
+bool send_counter_interrogation_for_type(IMasterConnection connection,
+                                         DataTypeContext* ctx,
+                                         CS101_CauseOfTransmission cot);
+
+#endif // COUNTER_INTERROGATION_H
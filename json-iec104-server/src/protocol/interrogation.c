@@ -1,47 +1,17 @@
 #include "interrogation.h"
+#include "asdu_pool.h"
+#include "packing_plan.h"
 #include "../data/data_manager.h"
 #include "../data/data_types.h"
 #include "../utils/logger.h"
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 
 // External globals (will be refactored later)
 extern CS101_AppLayerParameters alParameters;
 extern int ASDU;
 
-/**
- * Calculate maximum number of Information Objects per ASDU for SQ=0 (individual)
- */
-static int calcMaxIOAs_SQ0(int maxASDUSize, int ioSize) {
-    // ASDU overhead: 6 bytes
-    // Each IO includes: IOA (3 bytes) + data
-    return (maxASDUSize - 6) / ioSize;
-}
-
-/**
- * Calculate maximum number of Information Objects per ASDU for SQ=1 (sequence)
- * For consecutive IOAs, only first IO has IOA, rest are just data
- */
-static int calcMaxIOAs_SQ1(int maxASDUSize, int ioSizeWithIOA, int ioSizeNoIOA) {
-    // ASDU overhead: 6 bytes
-    // First IO: ioSizeWithIOA (includes IOA)
-    // Remaining IOs: ioSizeNoIOA (no IOA, saves 3 bytes each)
-    // Formula: 6 + ioSizeWithIOA + (n-1) * ioSizeNoIOA <= maxASDUSize
-    // Solving: n <= (maxASDUSize - 6 - ioSizeWithIOA) / ioSizeNoIOA + 1
-    if (maxASDUSize <= 6 + ioSizeWithIOA) {
-        return 1;
-    }
-    return ((maxASDUSize - 6 - ioSizeWithIOA) / ioSizeNoIOA) + 1;
-}
-
-/**
- * Get IO size without IOA (for SQ=1 sequence mode)
- */
-static int getIOSizeNoIOA(int ioSizeWithIOA) {
-    // Remove IOA size (3 bytes) from total IO size
-    return ioSizeWithIOA - 3;
-}
-
 /**
  * Create InformationObject based on data type
  * This is the key function that handles all 10 data types generically
@@ -126,9 +96,121 @@ InformationObject create_offline_io_for_type(TypeID original_type, int ioa, cons
     return create_io_for_type(info->offline_equivalent, ioa, data);
 }
 
+/**
+ * Packing plans of the full point list of every type
+ *
+ * The point lists do not change while the slave runs, so the plans are
+ * prepared once at startup (or taken from the station image) instead of
+ * being rebuilt for every interrogation. A plan is only used while it still
+ * matches the context's point list and the ASDU size.
+ */
+#define PLAN_CACHE_SIZE (sizeof(g_data_contexts) / sizeof(g_data_contexts[0]))
+
+static PackingPlan plan_cache[PLAN_CACHE_SIZE];
+static const int* plan_ioa_list[PLAN_CACHE_SIZE];  // Point list the plan was built from
+static bool plan_borrowed[PLAN_CACHE_SIZE];        // Chunks belong to the station image
+
+static int plan_slot(const DataTypeContext* ctx) {
+    ptrdiff_t slot = ctx - g_data_contexts;
+    return (slot >= 0 && slot < (ptrdiff_t)PLAN_CACHE_SIZE) ? (int)slot : -1;
+}
+
+static bool plan_valid(int slot, const DataTypeContext* ctx, int max_asdu_size) {
+    const PackingPlan* plan = &plan_cache[slot];
+    return plan->chunks != NULL &&
+           plan_ioa_list[slot] == ctx->config.ioa_list &&
+           plan->points == ctx->config.count &&
+           plan->max_asdu_size == max_asdu_size;
+}
+
+static void release_plan(int slot) {
+    if (plan_borrowed[slot]) {
+        memset(&plan_cache[slot], 0, sizeof(PackingPlan));
+    } else {
+        packing_plan_free(&plan_cache[slot]);
+    }
+    plan_ioa_list[slot] = NULL;
+    plan_borrowed[slot] = false;
+}
+
+bool interrogation_prepare_plans(int max_asdu_size) {
+    int prepared = 0;
+
+    for (int slot = 0; slot < (int)PLAN_CACHE_SIZE; slot++) {
+        const DataTypeContext* ctx = &g_data_contexts[slot];
+
+        if (ctx->config.count == 0 || plan_valid(slot, ctx, max_asdu_size)) {
+            continue;
+        }
+
+        release_plan(slot);
+        if (!packing_plan_build(&plan_cache[slot], ctx->config.ioa_list, NULL, ctx->config.count,
+                                ctx->type_info->io_size, max_asdu_size)) {
+            LOG_ERROR("Failed to build packing plan for %s", ctx->type_info->name);
+            return false;
+        }
+        plan_ioa_list[slot] = ctx->config.ioa_list;
+        prepared++;
+    }
+
+    LOG_DEBUG("Prepared %d interrogation packing plan(s)", prepared);
+    return true;
+}
+
+void interrogation_use_plan(const DataTypeContext* ctx, const PackedChunk* chunks,
+                            int count, int max_asdu_size) {
+    int slot = plan_slot(ctx);
+    if (slot < 0) return;
+
+    release_plan(slot);
+    plan_cache[slot].chunks = (PackedChunk*)chunks;
+    plan_cache[slot].count = count;
+    plan_cache[slot].points = ctx->config.count;
+    plan_cache[slot].max_asdu_size = max_asdu_size;
+    plan_ioa_list[slot] = ctx->config.ioa_list;
+    plan_borrowed[slot] = true;
+}
+
+const PackingPlan* interrogation_get_plan(const DataTypeContext* ctx, int max_asdu_size,
+                                          PackingPlan* scratch) {
+    int slot = plan_slot(ctx);
+    if (slot >= 0 && plan_valid(slot, ctx, max_asdu_size)) {
+        return &plan_cache[slot];
+    }
+
+    memset(scratch, 0, sizeof(*scratch));
+    if (!packing_plan_build(scratch, ctx->config.ioa_list, NULL, ctx->config.count,
+                            ctx->type_info->io_size, max_asdu_size)) {
+        return NULL;
+    }
+    return scratch;
+}
+
+void interrogation_swap_plans(PackingPlan* plans) {
+    for (int slot = 0; slot < (int)PLAN_CACHE_SIZE; slot++) {
+        PackingPlan previous = plan_cache[slot];
+        if (plan_borrowed[slot]) {
+            memset(&previous, 0, sizeof(previous));
+        }
+
+        plan_cache[slot] = plans[slot];
+        plan_ioa_list[slot] = plans[slot].chunks ? g_data_contexts[slot].config.ioa_list : NULL;
+        plan_borrowed[slot] = false;
+
+        plans[slot] = previous;
+    }
+}
+
+void interrogation_clear_plans(void) {
+    for (int slot = 0; slot < (int)PLAN_CACHE_SIZE; slot++) {
+        release_plan(slot);
+    }
+}
+
 /**
  * Send interrogation data for one data type with SQ=1 optimization
- * Detects consecutive IOA sequences and uses sequence mode for efficiency
+ * The packing plan puts runs of consecutive IOAs into SQ=1 ASDUs and packs
+ * all remaining points together into SQ=0 ASDUs
  */
 bool send_interrogation_for_type(IMasterConnection connection,
                                  DataTypeContext* ctx,
@@ -140,109 +222,55 @@ bool send_interrogation_for_type(IMasterConnection connection,
         return false;
     }
 
+    bool result = true;
+
     pthread_mutex_lock(&ctx->mutex);
 
     if (ctx->config.count > 0) {
-        int maxASDUSize = alParameters->maxSizeOfASDU;
-        int ioSizeWithIOA = ctx->type_info->io_size;
-        int ioSizeNoIOA = getIOSizeNoIOA(ioSizeWithIOA);
-
         LOG_DEBUG("Sending %s: count=%d", ctx->type_info->name, ctx->config.count);
 
-        // Process IOAs in blocks (consecutive sequences use SQ=1, others use SQ=0)
-        int i = 0;
-        while (i < ctx->config.count) {
-            // Find length of consecutive sequence starting at i
-            int seq_len = 1;
-            while (i + seq_len < ctx->config.count &&
-                   ctx->config.ioa_list[i + seq_len] == ctx->config.ioa_list[i + seq_len - 1] + 1) {
-                seq_len++;
-            }
-
-            // Decide: use SQ=1 for sequences of 3+ consecutive IOAs, else SQ=0
-            bool useSequence = (seq_len >= 3);
-
-            if (useSequence) {
-                // SQ=1: Sequence mode for consecutive IOAs
-                int maxIOAs = calcMaxIOAs_SQ1(maxASDUSize, ioSizeWithIOA, ioSizeNoIOA);
+        PackingPlan scratch;
+        const PackingPlan* plan = interrogation_get_plan(ctx, alParameters->maxSizeOfASDU, &scratch);
 
-                // Send consecutive IOAs in chunks using SQ=1
-                for (int j = 0; j < seq_len; j += maxIOAs) {
-                    int chunk_len = (j + maxIOAs < seq_len) ? maxIOAs : (seq_len - j);
+        if (plan) {
+            for (int c = 0; c < plan->count; c++) {
+                const PackedChunk* chunk = &plan->chunks[c];
 
-                    CS101_ASDU newAsdu = CS101_ASDU_create(
-                        alParameters, true,  // SQ=1 (sequence mode)
-                        CS101_COT_INTERROGATED_BY_STATION,
-                        0, ASDU, false, false
-                    );
-
-                    if (!newAsdu) {
-                        LOG_ERROR("Failed to create ASDU for %s", ctx->type_info->name);
-                        pthread_mutex_unlock(&ctx->mutex);
-                        return false;
-                    }
+                CS101_ASDU newAsdu = asdu_pool_acquire(
+                    alParameters, chunk->sequence,  // SQ=1 for runs, SQ=0 otherwise
+                    CS101_COT_INTERROGATED_BY_STATION, ASDU
+                );
 
-                    // Add consecutive IOs to ASDU
-                    for (int k = 0; k < chunk_len; k++) {
-                        InformationObject io = create_io_for_type(ctx->type_id,
-                            ctx->config.ioa_list[i + j + k], &ctx->data_array[i + j + k]);
+                for (int k = chunk->start; k < chunk->start + chunk->count; k++) {
+                    InformationObject io = create_io_for_type(ctx->type_id,
+                        ctx->config.ioa_list[k], &ctx->data_array[k]);
 
-                        if (io) {
-                            CS101_ASDU_addInformationObject(newAsdu, io);
-                            InformationObject_destroy(io);
-                        }
+                    if (io) {
+                        CS101_ASDU_addInformationObject(newAsdu, io);
+                        InformationObject_destroy(io);
                     }
-
-                    IMasterConnection_sendASDU(connection, newAsdu);
-                    CS101_ASDU_destroy(newAsdu);
-
-                    LOG_DEBUG("Sent %s SQ=1: IOAs %d-%d (%d values)",
-                             ctx->type_info->name,
-                             ctx->config.ioa_list[i + j],
-                             ctx->config.ioa_list[i + j + chunk_len - 1],
-                             chunk_len);
                 }
-            } else {
-                // SQ=0: Individual mode for non-consecutive or short sequences
-                int maxIOAs = calcMaxIOAs_SQ0(maxASDUSize, ioSizeWithIOA);
-
-                // Send individual IOAs
-                for (int j = 0; j < seq_len; j += maxIOAs) {
-                    int chunk_len = (j + maxIOAs < seq_len) ? maxIOAs : (seq_len - j);
-
-                    CS101_ASDU newAsdu = CS101_ASDU_create(
-                        alParameters, false,  // SQ=0 (individual mode)
-                        CS101_COT_INTERROGATED_BY_STATION,
-                        0, ASDU, false, false
-                    );
-
-                    if (!newAsdu) {
-                        LOG_ERROR("Failed to create ASDU for %s", ctx->type_info->name);
-                        pthread_mutex_unlock(&ctx->mutex);
-                        return false;
-                    }
-
-                    for (int k = 0; k < chunk_len; k++) {
-                        InformationObject io = create_io_for_type(ctx->type_id,
-                            ctx->config.ioa_list[i + j + k], &ctx->data_array[i + j + k]);
 
-                        if (io) {
-                            CS101_ASDU_addInformationObject(newAsdu, io);
-                            InformationObject_destroy(io);
-                        }
-                    }
+                IMasterConnection_sendASDU(connection, newAsdu);
 
-                    IMasterConnection_sendASDU(connection, newAsdu);
-                    CS101_ASDU_destroy(newAsdu);
-                }
+                LOG_DEBUG("Sent %s SQ=%d: IOAs %d-%d (%d values)",
+                         ctx->type_info->name, chunk->sequence,
+                         ctx->config.ioa_list[chunk->start],
+                         ctx->config.ioa_list[chunk->start + chunk->count - 1],
+                         chunk->count);
             }
 
-            i += seq_len;
+            if (plan == &scratch) {
+                packing_plan_free(&scratch);
+            }
+        } else {
+            LOG_ERROR("Failed to build packing plan for %s", ctx->type_info->name);
+            result = false;
         }
     }
 
     pthread_mutex_unlock(&ctx->mutex);
-    return true;
+    return result;
 }
 
 /**
@@ -264,6 +292,8 @@ bool interrogationHandler(void* parameter, IMasterConnection connection,
 
         // Iterate through all data types and send their data
         // This single loop replaces 9 duplicate blocks!
+        // A reload waits until the whole interrogation has been sent
+        data_config_read_lock();
         for (int i = 0; i < DATA_TYPE_COUNT; i++) {
             if (!send_interrogation_for_type(connection, &g_data_contexts[i], asdu_addr)) {
                 LOG_WARN("Failed to send interrogation for type %s",
@@ -271,6 +301,7 @@ bool interrogationHandler(void* parameter, IMasterConnection connection,
                 // Continue with other types even if one fails
             }
         }
+        data_config_read_unlock();
 
         // Send ACT-TERM (activation termination)
         IMasterConnection_sendACT_TERM(connection, asdu);
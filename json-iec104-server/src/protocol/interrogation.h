@@ -5,6 +5,7 @@
 #include "../../lib60870/lib60870-C/src/inc/api/iec60870_slave.h"
 #include "../../lib60870/lib60870-C/src/inc/api/cs104_slave.h"
 #include "../data/data_manager.h"
+#include "packing_plan.h"
 
 /**
  * Generic interrogation handler for IEC 60870-5-104
@@ -53,4 +54,56 @@ InformationObject create_io_for_type(TypeID type_id, int ioa, const DataValue* v
  */
 InformationObject create_offline_io_for_type(TypeID original_type, int ioa, const DataValue* data);
 
+/**
+ * Build the packing plans of all configured types once
+ *
+ * Call after the configuration is loaded and before the slave starts;
+ * interrogations then reuse the plans instead of building one per request.
+ * Types that already have a matching plan (e.g. from the station image)
+ * are skipped.
+ *
+ * @param max_asdu_size Maximum ASDU size from the application layer parameters
+ * @return true on success, false on allocation failure
+ */
+bool interrogation_prepare_plans(int max_asdu_size);
+
+/**
+ * Use a prebuilt packing plan for the full point list of a type
+ *
+ * The chunks are not copied or freed (e.g. mapped from the station image)
+ * and must stay valid until interrogation_clear_plans().
+ */
+void interrogation_use_plan(const DataTypeContext* ctx, const PackedChunk* chunks,
+                            int count, int max_asdu_size);
+
+/**
+ * Get the packing plan for the full point list of a type
+ *
+ * Returns the prepared plan if it matches the context and ASDU size,
+ * otherwise builds one into scratch; free it with packing_plan_free()
+ * when the returned pointer is scratch.
+ *
+ * @return The plan, or NULL on allocation failure
+ */
+const PackingPlan* interrogation_get_plan(const DataTypeContext* ctx, int max_asdu_size,
+                                          PackingPlan* scratch);
+
+/**
+ * Exchange the prepared plans with plans built for a reloaded configuration
+ *
+ * plans[i] must have been built for the point list that g_data_contexts[i]
+ * holds after swap_data_contexts(); a plan without chunks leaves the type to
+ * per-request plans. On return plans[] holds the previous plans (borrowed
+ * ones zeroed), to be freed with packing_plan_free() after the write lock
+ * is released. Caller holds the write lock.
+ *
+ * @param plans DATA_TYPE_COUNT plans in g_data_contexts order
+ */
+void interrogation_swap_plans(PackingPlan* plans);
+
+/**
+ * Release all prepared packing plans
+ */
+void interrogation_clear_plans(void);
+
 #endif // INTERROGATION_H
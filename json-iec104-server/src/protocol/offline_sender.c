@@ -0,0 +1,112 @@
+#include "offline_sender.h"
+#include "asdu_pool.h"
+#include "interrogation.h"
+#include "../data/data_manager.h"
+#include "../utils/logger.h"
+#include "../../cJSON/cJSON.h"
+
+// External globals
+extern int ASDU;
+
+/**
+ * Queue the held values of one type
+ */
+static int send_pending_for_type(CS104_Slave slave, CS101_AppLayerParameters alParams,
+                                 DataTypeContext* ctx) {
+    OfflineBuffer* buf = ctx->offline;
+    CS101_ASDU asdu = NULL;
+    int sent = 0;
+
+    for (int idx = 0; idx < buf->count && offline_buffer_pending(buf) > 0; idx++) {
+        if (!offline_buffer_take(buf, idx)) {
+            continue;
+        }
+
+        DataValue value;
+        read_data_value(ctx, idx, &value);
+
+        InformationObject io = create_offline_io_for_type(ctx->type_id, ctx->config.ioa_list[idx], &value);
+        if (!io) {
+            continue;
+        }
+
+        if (!asdu) {
+            asdu = asdu_pool_acquire(alParams, false, CS101_COT_SPONTANEOUS, ASDU);
+        }
+        if (!CS101_ASDU_addInformationObject(asdu, io)) {
+            // ASDU full: send it and start the next one with this point
+            CS104_Slave_enqueueASDU(slave, asdu);
+            asdu = asdu_pool_acquire(alParams, false, CS101_COT_SPONTANEOUS, ASDU);
+            CS101_ASDU_addInformationObject(asdu, io);
+        }
+        InformationObject_destroy(io);
+        sent++;
+    }
+
+    if (asdu) {
+        CS104_Slave_enqueueASDU(slave, asdu);
+    }
+
+    __atomic_fetch_add(&buf->stats.flushed, (uint64_t)sent, __ATOMIC_RELAXED);
+    return sent;
+}
+
+int offline_send_pending(CS104_Slave slave) {
+    if (slave == NULL) {
+        return 0;
+    }
+
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave);
+    int sent = 0;
+
+    data_config_read_lock();
+    offline_mark_lock();
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        DataTypeContext* ctx = &g_data_contexts[i];
+        if (ctx->offline && offline_buffer_pending(ctx->offline) > 0) {
+            sent += send_pending_for_type(slave, alParams, ctx);
+        }
+    }
+
+    offline_mark_unlock();
+    data_config_read_unlock();
+
+    if (sent > 0) {
+        LOG_INFO("Sent %d values held while offline", sent);
+    }
+    return sent;
+}
+
+char* offline_get_stats_json(void) {
+    cJSON* response = cJSON_CreateObject();
+    cJSON* types_array = cJSON_CreateArray();
+
+    data_config_read_lock();
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        const OfflineBuffer* buf = g_data_contexts[i].offline;
+        if (!buf) continue;
+
+        cJSON* obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(obj, "type", g_data_contexts[i].type_info->name);
+        cJSON_AddStringToObject(obj, "policy", offline_policy_to_string(buf->policy));
+        cJSON_AddNumberToObject(obj, "interval_ms", buf->interval_ms);
+        cJSON_AddNumberToObject(obj, "points", buf->count);
+        cJSON_AddNumberToObject(obj, "queued", (double)__atomic_load_n(&buf->stats.queued, __ATOMIC_RELAXED));
+        cJSON_AddNumberToObject(obj, "dropped", (double)__atomic_load_n(&buf->stats.dropped, __ATOMIC_RELAXED));
+        cJSON_AddNumberToObject(obj, "held", (double)__atomic_load_n(&buf->stats.held, __ATOMIC_RELAXED));
+        cJSON_AddNumberToObject(obj, "flushed", (double)__atomic_load_n(&buf->stats.flushed, __ATOMIC_RELAXED));
+        cJSON_AddNumberToObject(obj, "pending", offline_buffer_pending(buf));
+        cJSON_AddItemToArray(types_array, obj);
+    }
+
+    data_config_read_unlock();
+
+    cJSON_AddItemToObject(response, "offline", types_array);
+
+    char* json_str = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+
+    return json_str;
+}
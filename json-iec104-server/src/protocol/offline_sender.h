@@ -0,0 +1,34 @@
+#ifndef OFFLINE_SENDER_H
+#define OFFLINE_SENDER_H
+
+#include "cs104_slave.h"
+
+/**
+ * Offline Sender
+ *
+ * Sends the values held by the latest offline policy (see offline_buffer.h)
+ * when a master activates a connection: one spontaneous event per marked
+ * point, with its current value encoded as the offline type, packed into
+ * as few ASDUs as fit. Runs on the thread that reports the activation and
+ * holds the configuration read lock while it walks the points.
+ */
+
+/**
+ * Queue the held values of all types
+ *
+ * @param slave The CS104 slave instance
+ * @return Number of values queued
+ */
+int offline_send_pending(CS104_Slave slave);
+
+/**
+ * Get the offline buffering statistics as JSON
+ *
+ * Format: {"offline":[{"type":"M_ME_NC_1","policy":"latest","interval_ms":5000,
+ *          "points":100,"queued":0,"dropped":0,"held":12,"flushed":40,"pending":3}]}
+ *
+ * @return JSON string (caller must free), or NULL on error
+ */
+char* offline_get_stats_json(void);
+
+#endif // OFFLINE_SENDER_H
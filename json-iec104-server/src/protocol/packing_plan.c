@@ -0,0 +1,133 @@
+#include "packing_plan.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ASDU header overhead (type ID, VSQ, COT, CA) and IOA size
+#define ASDU_HEADER_SIZE 6
+#define IOA_SIZE 3
+
+// The VSQ field holds at most 127 information objects
+#define MAX_OBJECTS_PER_ASDU 127
+
+// Minimum run length worth sending as SQ=1
+#define MIN_SEQUENCE_LENGTH 3
+
+/**
+ * Calculate maximum number of Information Objects per ASDU for SQ=0 (individual)
+ */
+static int calcMaxIOAs_SQ0(int maxASDUSize, int ioSize) {
+    int n = (maxASDUSize - ASDU_HEADER_SIZE) / ioSize;
+    if (n < 1) n = 1;
+    return n > MAX_OBJECTS_PER_ASDU ? MAX_OBJECTS_PER_ASDU : n;
+}
+
+/**
+ * Calculate maximum number of Information Objects per ASDU for SQ=1 (sequence)
+ * Only the first object carries the IOA
+ */
+static int calcMaxIOAs_SQ1(int maxASDUSize, int ioSizeWithIOA) {
+    int ioSizeNoIOA = ioSizeWithIOA - IOA_SIZE;
+    if (maxASDUSize <= ASDU_HEADER_SIZE + ioSizeWithIOA || ioSizeNoIOA <= 0) {
+        return 1;
+    }
+    int n = ((maxASDUSize - ASDU_HEADER_SIZE - ioSizeWithIOA) / ioSizeNoIOA) + 1;
+    return n > MAX_OBJECTS_PER_ASDU ? MAX_OBJECTS_PER_ASDU : n;
+}
+
+static inline int ioa_at(const int* ioa_list, const int* indices, int pos) {
+    return ioa_list[indices ? indices[pos] : pos];
+}
+
+static bool append_chunk(PackingPlan* plan, int* capacity, int start, int count, bool sequence) {
+    if (plan->count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        PackedChunk* chunks = (PackedChunk*)realloc(plan->chunks, new_capacity * sizeof(PackedChunk));
+        if (!chunks) {
+            return false;
+        }
+        plan->chunks = chunks;
+        *capacity = new_capacity;
+    }
+
+    plan->chunks[plan->count].start = start;
+    plan->chunks[plan->count].count = count;
+    plan->chunks[plan->count].sequence = sequence;
+    plan->count++;
+    return true;
+}
+
+/**
+ * Build the plan in a single pass over the point list
+ *
+ * Short runs are accumulated into an open SQ=0 chunk. When a run of
+ * MIN_SEQUENCE_LENGTH or more consecutive IOAs starts, the open SQ=0
+ * chunk is closed and the run is emitted as one or more SQ=1 chunks.
+ */
+bool packing_plan_build(PackingPlan* plan, const int* ioa_list, const int* indices,
+                        int count, int io_size, int max_asdu_size) {
+    packing_plan_free(plan);
+
+    plan->points = count;
+    plan->max_asdu_size = max_asdu_size;
+
+    if (count <= 0 || !ioa_list) {
+        return true;
+    }
+
+    int maxSQ0 = calcMaxIOAs_SQ0(max_asdu_size, io_size);
+    int maxSQ1 = calcMaxIOAs_SQ1(max_asdu_size, io_size);
+    int capacity = 0;
+
+    int open_start = -1;    // Start of the pending SQ=0 chunk (-1 = none)
+    int i = 0;
+
+    while (i < count) {
+        int seq_len = 1;
+        while (i + seq_len < count &&
+               ioa_at(ioa_list, indices, i + seq_len) == ioa_at(ioa_list, indices, i + seq_len - 1) + 1) {
+            seq_len++;
+        }
+
+        if (seq_len >= MIN_SEQUENCE_LENGTH) {
+            if (open_start >= 0) {
+                if (!append_chunk(plan, &capacity, open_start, i - open_start, false)) goto fail;
+                open_start = -1;
+            }
+
+            for (int j = 0; j < seq_len; j += maxSQ1) {
+                int chunk_len = (j + maxSQ1 < seq_len) ? maxSQ1 : (seq_len - j);
+                if (!append_chunk(plan, &capacity, i + j, chunk_len, true)) goto fail;
+            }
+        } else {
+            for (int j = 0; j < seq_len; j++) {
+                if (open_start < 0) {
+                    open_start = i + j;
+                } else if (i + j - open_start == maxSQ0) {
+                    if (!append_chunk(plan, &capacity, open_start, maxSQ0, false)) goto fail;
+                    open_start = i + j;
+                }
+            }
+        }
+
+        i += seq_len;
+    }
+
+    if (open_start >= 0) {
+        if (!append_chunk(plan, &capacity, open_start, count - open_start, false)) goto fail;
+    }
+
+    return true;
+
+fail:
+    packing_plan_free(plan);
+    return false;
+}
+
+void packing_plan_free(PackingPlan* plan) {
+    if (!plan) return;
+
+    free(plan->chunks);
+    plan->chunks = NULL;
+    plan->count = 0;
+    plan->points = 0;
+}
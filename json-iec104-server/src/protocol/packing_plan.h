@@ -0,0 +1,58 @@
+#ifndef PACKING_PLAN_H
+#define PACKING_PLAN_H
+
+#include <stdbool.h>
+
+/**
+ * Packing Plan Module
+ *
+ * Precomputes how a list of points is split into ASDUs:
+ * - Runs of 3+ consecutive IOAs are packed with SQ=1 (IOA sent once)
+ * - All other points are packed together with SQ=0 (IOA per object)
+ * - Every chunk respects the ASDU size and the 127-object VSQ limit
+ *
+ * The plan only depends on the IOA layout, so it is built once and then
+ * reused for every cycle. Senders can also send a sub-range of chunks,
+ * which is what spreads a periodic group across its period.
+ */
+
+/**
+ * One ASDU worth of points
+ * Positions refer to the point list the plan was built from.
+ */
+typedef struct {
+    int start;          // First position in the point list
+    int count;          // Number of consecutive positions in this ASDU
+    bool sequence;      // true = SQ=1, false = SQ=0
+} PackedChunk;
+
+/**
+ * Complete plan for a point list
+ */
+typedef struct {
+    PackedChunk* chunks;
+    int count;          // Number of chunks (= ASDUs per full transmission)
+    int points;         // Number of points the plan covers
+    int max_asdu_size;  // ASDU size the plan was built for
+} PackingPlan;
+
+/**
+ * Build a packing plan
+ *
+ * @param plan The plan to fill (previous content is freed)
+ * @param ioa_list IOA of every configured point of the type
+ * @param indices Point list as indices into ioa_list, or NULL for all points
+ * @param count Number of points in the list
+ * @param io_size Size of one information object including its IOA
+ * @param max_asdu_size Maximum ASDU size from the application layer parameters
+ * @return true on success, false on allocation failure
+ */
+bool packing_plan_build(PackingPlan* plan, const int* ioa_list, const int* indices,
+                        int count, int io_size, int max_asdu_size);
+
+/**
+ * Free the chunks of a plan and reset it to empty
+ */
+void packing_plan_free(PackingPlan* plan);
+
+#endif // PACKING_PLAN_H
@@ -0,0 +1,46 @@
+#include "read_command.h"
+#include "asdu_pool.h"
+#include "interrogation.h"
+#include "../data/data_manager.h"
+#include "../utils/logger.h"
+
+// External globals
+extern CS101_AppLayerParameters alParameters;
+extern int ASDU;
+
+bool readHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, int ioa)
+{
+    (void)parameter;  // Unused
+
+    DataTypeContext* ctx;
+    int idx;
+    DataValue value;
+
+    data_config_read_lock();
+
+    if (!lookup_ioa(ioa, &ctx, &idx)) {
+        data_config_read_unlock();
+        LOG_WARN("Read of unknown IOA %d", ioa);
+
+        CS101_ASDU_setCOT(asdu, CS101_COT_UNKNOWN_IOA);
+        CS101_ASDU_setNegative(asdu, true);
+        IMasterConnection_sendASDU(connection, asdu);
+        return true;
+    }
+
+    read_data_value(ctx, idx, &value);
+    data_config_read_unlock();
+
+    CS101_ASDU response = asdu_pool_acquire(alParameters, false, CS101_COT_REQUEST, ASDU);
+
+    InformationObject io = create_io_for_type(ctx->type_id, ioa, &value);
+    if (io) {
+        CS101_ASDU_addInformationObject(response, io);
+        InformationObject_destroy(io);
+    }
+
+    IMasterConnection_sendASDU(connection, response);
+
+    LOG_DEBUG("Read %s IOA %d", ctx->type_info->name, ioa);
+    return true;
+}
@@ -0,0 +1,19 @@
+#ifndef READ_COMMAND_H
+#define READ_COMMAND_H
+
+#include "cs104_slave.h"
+
+/**
+ * Read command handler (C_RD_NA_1)
+ *
+ * Answers a read of a single IOA with the current value of the point,
+ * COT=REQUEST. The IOA is found through the IOA index and the value is
+ * read without the type's mutex, so polling single points costs far less
+ * than a general interrogation and never blocks updates.
+ * An IOA that is not configured is answered with COT=UNKNOWN_IOA (negative).
+ *
+ * Register with CS104_Slave_setReadHandler().
+ */
+bool readHandler(void* parameter, IMasterConnection connection, CS101_ASDU asdu, int ioa);
+
+#endif // READ_COMMAND_H
@@ -0,0 +1,287 @@
+#include "select_table.h"
+#include "../utils/logger.h"
+#include "../utils/utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Timer wheel resolution
+#define SELECT_TICK_MS 50
+
+typedef struct SelectEntry {
+    IMasterConnection connection;
+    TypeID type;
+    int ioa;
+    uint64_t deadline;
+    struct SelectEntry* hash_next;      // Bucket chain
+    struct SelectEntry* wheel_prev;     // Timer wheel slot list
+    struct SelectEntry* wheel_next;
+} SelectEntry;
+
+static SelectEntry* entries = NULL;     // Preallocated pool
+static SelectEntry* free_list = NULL;   // Unused entries (chained through hash_next)
+static SelectEntry** buckets = NULL;
+static uint32_t bucket_mask = 0;
+static SelectEntry** wheel = NULL;
+static uint32_t wheel_mask = 0;
+static uint64_t wheel_tick = 0;         // Last tick processed
+
+static SelectTableStats stats;
+static pthread_mutex_t table_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline uint32_t key_hash(IMasterConnection connection, TypeID type, int ioa) {
+    uint64_t h = (uint64_t)(uintptr_t)connection * 0x9E3779B97F4A7C15ULL;
+    h ^= ((uint64_t)type << 24 | (uint32_t)ioa) * 0xC2B2AE3D27D4EB4FULL;
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static SelectEntry** find_link(IMasterConnection connection, TypeID type, int ioa) {
+    SelectEntry** link = &buckets[key_hash(connection, type, ioa) & bucket_mask];
+
+    while (*link) {
+        SelectEntry* e = *link;
+        if (e->ioa == ioa && e->type == type && e->connection == connection) {
+            break;
+        }
+        link = &e->hash_next;
+    }
+    return link;
+}
+
+static void wheel_insert(SelectEntry* e) {
+    SelectEntry** slot = &wheel[(e->deadline / SELECT_TICK_MS) & wheel_mask];
+
+    e->wheel_prev = NULL;
+    e->wheel_next = *slot;
+    if (*slot) {
+        (*slot)->wheel_prev = e;
+    }
+    *slot = e;
+}
+
+static void wheel_remove(SelectEntry* e) {
+    if (e->wheel_prev) {
+        e->wheel_prev->wheel_next = e->wheel_next;
+    } else {
+        wheel[(e->deadline / SELECT_TICK_MS) & wheel_mask] = e->wheel_next;
+    }
+    if (e->wheel_next) {
+        e->wheel_next->wheel_prev = e->wheel_prev;
+    }
+}
+
+// Unlink from the hash chain at *link and the wheel, return to the pool
+static void release(SelectEntry** link) {
+    SelectEntry* e = *link;
+
+    *link = e->hash_next;
+    wheel_remove(e);
+
+    e->connection = NULL;
+    e->hash_next = free_list;
+    free_list = e;
+    stats.active--;
+}
+
+/**
+ * Expire the slots between the last processed tick and now
+ *
+ * The wheel spans more than the timeout, so every entry in a passed slot
+ * belongs to the current round; entries of the current tick are checked
+ * against their exact deadline.
+ */
+static void advance_wheel(uint64_t now) {
+    uint64_t now_tick = now / SELECT_TICK_MS;
+
+    if (now_tick - wheel_tick > wheel_mask + 1) {
+        wheel_tick = now_tick - (wheel_mask + 1);
+    }
+
+    for (; wheel_tick <= now_tick; wheel_tick++) {
+        SelectEntry* e = wheel[wheel_tick & wheel_mask];
+
+        while (e) {
+            SelectEntry* next = e->wheel_next;
+
+            if (e->deadline <= now) {
+                LOG_DEBUG("Select of IOA %d expired", e->ioa);
+                release(find_link(e->connection, e->type, e->ioa));
+                stats.expired++;
+            }
+            e = next;
+        }
+    }
+    wheel_tick = now_tick;
+}
+
+bool select_table_init(int capacity, int timeout_ms) {
+    if (capacity <= 0) {
+        capacity = SELECT_TABLE_DEFAULT_CAPACITY;
+    }
+    if (timeout_ms <= 0) {
+        timeout_ms = SELECT_TABLE_DEFAULT_TIMEOUT_MS;
+    }
+
+    select_table_cleanup();
+
+    uint32_t bucket_count = utils_next_pow2((uint32_t)capacity * 2);
+    uint32_t wheel_slots = utils_next_pow2((uint32_t)(timeout_ms / SELECT_TICK_MS) + 2);
+
+    entries = (SelectEntry*)calloc(capacity, sizeof(SelectEntry));
+    buckets = (SelectEntry**)calloc(bucket_count, sizeof(SelectEntry*));
+    wheel = (SelectEntry**)calloc(wheel_slots, sizeof(SelectEntry*));
+
+    if (!entries || !buckets || !wheel) {
+        LOG_ERROR("Failed to allocate select table (%d entries)", capacity);
+        select_table_cleanup();
+        return false;
+    }
+
+    pthread_mutex_lock(&table_mutex);
+
+    for (int i = capacity - 1; i >= 0; i--) {
+        entries[i].hash_next = free_list;
+        free_list = &entries[i];
+    }
+
+    bucket_mask = bucket_count - 1;
+    wheel_mask = wheel_slots - 1;
+    wheel_tick = utils_monotonic_ms() / SELECT_TICK_MS;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.capacity = capacity;
+    stats.timeout_ms = timeout_ms;
+
+    pthread_mutex_unlock(&table_mutex);
+
+    LOG_DEBUG("Select table: %d entries, timeout %d ms", capacity, timeout_ms);
+    return true;
+}
+
+void select_table_cleanup(void) {
+    pthread_mutex_lock(&table_mutex);
+
+    free(entries);
+    free(buckets);
+    free(wheel);
+    entries = NULL;
+    buckets = NULL;
+    wheel = NULL;
+    free_list = NULL;
+    stats.active = 0;
+
+    pthread_mutex_unlock(&table_mutex);
+}
+
+bool select_table_store(IMasterConnection connection, TypeID type, int ioa) {
+    bool stored = false;
+    uint64_t now = utils_monotonic_ms();
+
+    pthread_mutex_lock(&table_mutex);
+
+    if (buckets) {
+        advance_wheel(now);
+
+        SelectEntry** link = find_link(connection, type, ioa);
+        SelectEntry* e = *link;
+
+        if (e) {
+            // Select again: restart the timeout
+            wheel_remove(e);
+        } else if (free_list) {
+            e = free_list;
+            free_list = e->hash_next;
+
+            e->connection = connection;
+            e->type = type;
+            e->ioa = ioa;
+            e->hash_next = NULL;
+            *link = e;
+            stats.active++;
+        }
+
+        if (e) {
+            e->deadline = now + stats.timeout_ms;
+            wheel_insert(e);
+            stats.selects++;
+            stored = true;
+        } else {
+            stats.rejected++;
+        }
+    }
+
+    pthread_mutex_unlock(&table_mutex);
+    return stored;
+}
+
+bool select_table_take(IMasterConnection connection, TypeID type, int ioa) {
+    bool selected = false;
+
+    pthread_mutex_lock(&table_mutex);
+
+    if (buckets) {
+        advance_wheel(utils_monotonic_ms());
+
+        SelectEntry** link = find_link(connection, type, ioa);
+        if (*link) {
+            release(link);
+            stats.executes++;
+            selected = true;
+        }
+    }
+
+    pthread_mutex_unlock(&table_mutex);
+    return selected;
+}
+
+void select_table_clear(IMasterConnection connection, TypeID type, int ioa) {
+    pthread_mutex_lock(&table_mutex);
+
+    if (buckets) {
+        SelectEntry** link = find_link(connection, type, ioa);
+        if (*link) {
+            release(link);
+        }
+    }
+
+    pthread_mutex_unlock(&table_mutex);
+}
+
+/**
+ * Release all selects of a connection
+ *
+ * Selects are hashed by connection, type and IOA together, so a connection's
+ * entries are found by scanning the entry pool; free entries have no connection.
+ */
+void select_table_connection_closed(IMasterConnection connection) {
+    if (connection == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&table_mutex);
+
+    if (entries) {
+        int released = 0;
+
+        for (int i = 0; i < stats.capacity; i++) {
+            SelectEntry* e = &entries[i];
+
+            if (e->connection == connection) {
+                release(find_link(e->connection, e->type, e->ioa));
+                released++;
+            }
+        }
+
+        if (released > 0) {
+            LOG_DEBUG("Released %d select(s) of a closed connection", released);
+        }
+    }
+
+    pthread_mutex_unlock(&table_mutex);
+}
+
+void select_table_get_stats(SelectTableStats* out) {
+    pthread_mutex_lock(&table_mutex);
+    *out = stats;
+    pthread_mutex_unlock(&table_mutex);
+}
@@ -0,0 +1,81 @@
+#ifndef SELECT_TABLE_H
+#define SELECT_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cs104_slave.h"
+
+/**
+ * Select-Before-Operate Table
+ *
+ * Holds the pending selects of SBO commands, keyed by (connection, TypeID,
+ * IOA). Lookups go through a chained hash table and every entry sits in a
+ * timer wheel slot for its deadline, so select, execute and expiry all cost
+ * O(1) independent of the number of controllable points. The wheel advances
+ * on every operation; an expired select is never executed even if its slot
+ * has not been reached yet.
+ *
+ * All entries of a connection are released when the connection closes.
+ * The table is protected by one mutex, held only for the O(1) operations.
+ */
+
+#define SELECT_TABLE_DEFAULT_CAPACITY 1024
+#define SELECT_TABLE_DEFAULT_TIMEOUT_MS 5000
+
+/**
+ * Select table statistics
+ */
+typedef struct {
+    int active;                 // Pending selects
+    int capacity;               // Maximum pending selects
+    int timeout_ms;             // Select timeout
+    uint64_t selects;           // Selects stored
+    uint64_t executes;          // Executes that found their select
+    uint64_t expired;           // Selects removed by the timeout
+    uint64_t rejected;          // Selects rejected because the table was full
+} SelectTableStats;
+
+/**
+ * Initialize the table
+ *
+ * @param capacity Maximum number of pending selects (0 = default)
+ * @param timeout_ms Time between select and execute (0 = default)
+ * @return true on success, false on allocation failure
+ */
+bool select_table_init(int capacity, int timeout_ms);
+
+/**
+ * Release the table
+ */
+void select_table_cleanup(void);
+
+/**
+ * Store a select, or restart its timeout if it is already pending
+ *
+ * @return false if the table is full
+ */
+bool select_table_store(IMasterConnection connection, TypeID type, int ioa);
+
+/**
+ * Consume a pending select for an execute
+ *
+ * @return true if the select was pending and not expired (it is removed)
+ */
+bool select_table_take(IMasterConnection connection, TypeID type, int ioa);
+
+/**
+ * Remove a pending select (deactivation)
+ */
+void select_table_clear(IMasterConnection connection, TypeID type, int ioa);
+
+/**
+ * Remove all selects of a connection, call on CS104_CON_EVENT_CONNECTION_CLOSED
+ */
+void select_table_connection_closed(IMasterConnection connection);
+
+/**
+ * Get table statistics
+ */
+void select_table_get_stats(SelectTableStats* stats);
+
+#endif // SELECT_TABLE_H
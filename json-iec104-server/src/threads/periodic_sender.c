@@ -1,151 +1,493 @@
 #include "periodic_sender.h"
+#include "thread_policy.h"
 #include "../data/data_manager.h"
 #include "../protocol/interrogation.h" // For create_io_for_type
+#include "../protocol/asdu_pool.h"
 #include "../utils/logger.h"
-#include "hal_time.h"
-#include "hal_thread.h"
+#include "../utils/utils.h"
+#include "../../cJSON/cJSON.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <poll.h>
+#include <time.h>
 #include <pthread.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
 
 // External globals
 extern int ASDU;
 
-// Global periodic configs
-PeriodicConfig g_periodic_M_ME_NC_1 = {false, 5000, 0};
-PeriodicConfig g_periodic_M_SP_TB_1 = {false, 5000, 0};
+// Group registry (grown on demand, any number of groups)
+static PeriodicGroupList registry = { NULL, 0, 0 };
+static pthread_mutex_t groups_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static pthread_t periodic_thread;
 static bool running = false;
 static CS104_Slave slave_instance = NULL;
+static int timer_fd = -1;
+static int wake_fd = -1;
 
-// Helper to calculate max IOAs for SQ=0
-static int calcMaxIOAs_SQ0(int maxASDUSize, int ioSize) {
-    return (maxASDUSize - 6) / ioSize;
+// Map a position within the group to an index in the type's arrays
+static inline int group_index(const PeriodicGroup* group, int pos) {
+    return group->indices ? group->indices[pos] : pos;
 }
 
-// Helper to calculate max IOAs for SQ=1
-static int calcMaxIOAs_SQ1(int maxASDUSize, int ioSizeWithIOA, int ioSizeNoIOA) {
-    if (maxASDUSize <= 6 + ioSizeWithIOA) {
-        return 1;
+static int group_size(const PeriodicGroup* group, const DataTypeContext* ctx) {
+    return group->indices ? group->count : ctx->config.count;
+}
+
+static int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Context of type_id among DATA_TYPE_COUNT contexts
+static const DataTypeContext* find_context(const DataTypeContext* contexts, TypeID type_id) {
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        if (contexts[i].type_info && contexts[i].type_id == type_id) {
+            return &contexts[i];
+        }
+    }
+    return NULL;
+}
+
+// Resolve a group against ctx and append it to list
+static bool group_list_add(PeriodicGroupList* list, const DataTypeContext* ctx, const char* name,
+                           TypeID type_id, int period_ms, const int* ioas, int ioa_count, int spread_ticks) {
+    if (!name || !ctx || period_ms <= 0 || spread_ticks < PERIODIC_SPREAD_AUTO) {
+        LOG_ERROR("Invalid periodic group parameters (name=%s, type=%d, period=%d, spread=%d)",
+                  name ? name : "NULL", type_id, period_ms, spread_ticks);
+        return false;
+    }
+
+    int* indices = NULL;
+    int count = 0;
+
+    if (ioas) {
+        indices = (int*)malloc((ioa_count > 0 ? ioa_count : 1) * sizeof(int));
+        if (!indices) {
+            LOG_ERROR("Failed to allocate periodic group %s", name);
+            return false;
+        }
+
+        for (int i = 0; i < ioa_count; i++) {
+            int idx = find_ioa_index(&ctx->config, ioas[i]);
+            if (idx < 0) {
+                LOG_WARN("Periodic group %s: IOA %d not configured for %s, skipped",
+                         name, ioas[i], ctx->type_info->name);
+                continue;
+            }
+            indices[count++] = idx;
+        }
+
+        // Config (IOA) order, so consecutive IOAs pack into SQ=1 runs; an
+        // IOA listed twice is sent once
+        qsort(indices, count, sizeof(int), compare_int);
+        int unique = 0;
+        for (int i = 0; i < count; i++) {
+            if (unique == 0 || indices[i] != indices[unique - 1]) {
+                indices[unique++] = indices[i];
+            }
+        }
+        count = unique;
+    }
+
+    if (list->count == list->capacity) {
+        int new_capacity = list->capacity ? list->capacity * 2 : 8;
+        PeriodicGroup* new_groups = (PeriodicGroup*)realloc(list->groups, new_capacity * sizeof(PeriodicGroup));
+        if (!new_groups) {
+            free(indices);
+            LOG_ERROR("Failed to grow periodic group table");
+            return false;
+        }
+        list->groups = new_groups;
+        list->capacity = new_capacity;
+    }
+
+    PeriodicGroup* group = &list->groups[list->count++];
+    memset(group, 0, sizeof(*group));
+    strncpy(group->name, name, sizeof(group->name) - 1);
+    group->type_id = type_id;
+    group->indices = indices;
+    group->count = count;
+    group->period_ms = period_ms;
+    group->spread_ticks = spread_ticks;
+    group->ticks = 1;
+    group->cycle_start = utils_monotonic_ms() + period_ms;
+    group->next_deadline = group->cycle_start;
+
+    LOG_INFO("Periodic group %s: type=%s, points=%d, period=%d ms, spread=%d",
+             name, ctx->type_info->name, ioas ? count : ctx->config.count, period_ms, spread_ticks);
+    return true;
+}
+
+// Re-arm the scheduler if it is already running
+static void wake_sender(void) {
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) {
+            LOG_WARN("Failed to wake periodic sender");
+        }
+    }
+}
+
+bool periodic_add_group(const char* name, TypeID type_id, int period_ms,
+                        const int* ioas, int ioa_count, int spread_ticks) {
+    // Lock order: point configuration before the group registry
+    data_config_read_lock();
+    pthread_mutex_lock(&groups_mutex);
+    bool ok = group_list_add(&registry, get_data_context(type_id), name, type_id,
+                             period_ms, ioas, ioa_count, spread_ticks);
+    pthread_mutex_unlock(&groups_mutex);
+    data_config_read_unlock();
+
+    if (ok) {
+        wake_sender();
     }
-    return ((maxASDUSize - 6 - ioSizeWithIOA) / ioSizeNoIOA) + 1;
+    return ok;
+}
+
+bool periodic_stage_group(PeriodicGroupList* list, const DataTypeContext* contexts,
+                          const char* name, TypeID type_id, int period_ms,
+                          const int* ioas, int ioa_count, int spread_ticks) {
+    return group_list_add(list, find_context(contexts, type_id), name, type_id,
+                          period_ms, ioas, ioa_count, spread_ticks);
 }
 
-// Get IO size without IOA (for SQ=1)
-static int getIOSizeNoIOA(int ioSizeWithIOA) {
-    return ioSizeWithIOA - 3;
+void periodic_commit_groups(PeriodicGroupList* list) {
+    pthread_mutex_lock(&groups_mutex);
+    PeriodicGroupList previous = registry;
+    registry = *list;
+    *list = previous;
+    pthread_mutex_unlock(&groups_mutex);
+
+    wake_sender();
 }
 
-static void send_periodic_data_for_type(DataTypeContext* ctx, PeriodicConfig* config) {
-    if (!config->enabled || ctx->config.count == 0) return;
+void periodic_free_groups(PeriodicGroupList* list) {
+    for (int i = 0; i < list->count; i++) {
+        free(list->groups[i].indices);
+        packing_plan_free(&list->groups[i].plan);
+        free(list->groups[i].snapshot);
+    }
+    free(list->groups);
+    memset(list, 0, sizeof(*list));
+}
 
-    uint64_t now = Hal_getTimeInMs();
-    if (now - config->last_sent < config->period_ms) return;
+void periodic_clear_groups(void) {
+    pthread_mutex_lock(&groups_mutex);
+    periodic_free_groups(&registry);
+    pthread_mutex_unlock(&groups_mutex);
+}
 
-    LOG_DEBUG("Sending periodic data for %s", ctx->type_info->name);
+int periodic_get_group_count(void) {
+    pthread_mutex_lock(&groups_mutex);
+    int count = registry.count;
+    pthread_mutex_unlock(&groups_mutex);
+    return count;
+}
 
+char* periodic_get_stats_json(void) {
+    cJSON* response = cJSON_CreateObject();
+    cJSON* groups_array = cJSON_CreateArray();
+
+    pthread_mutex_lock(&groups_mutex);
+
+    for (int i = 0; i < registry.count; i++) {
+        const PeriodicGroup* group = &registry.groups[i];
+        cJSON* obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(obj, "name", group->name);
+        cJSON_AddStringToObject(obj, "type", type_id_to_string(group->type_id));
+        cJSON_AddNumberToObject(obj, "period_ms", group->period_ms);
+        cJSON_AddNumberToObject(obj, "spread_ticks", group->ticks);
+        cJSON_AddNumberToObject(obj, "asdus_per_cycle", group->plan.count);
+        cJSON_AddNumberToObject(obj, "cycles", (double)group->stats.cycles);
+        cJSON_AddNumberToObject(obj, "missed_deadlines", (double)group->stats.missed_deadlines);
+        cJSON_AddNumberToObject(obj, "last_cycle_us", (double)group->stats.last_cycle_us);
+        cJSON_AddNumberToObject(obj, "max_cycle_us", (double)group->stats.max_cycle_us);
+        cJSON_AddNumberToObject(obj, "avg_cycle_us", group->stats.cycles ?
+            (double)group->stats.total_cycle_us / (double)group->stats.cycles : 0.0);
+        cJSON_AddNumberToObject(obj, "max_lock_us", (double)group->stats.max_lock_us);
+        cJSON_AddNumberToObject(obj, "queue_hwm", group->stats.queue_high_water_mark);
+        cJSON_AddItemToArray(groups_array, obj);
+    }
+
+    int count = registry.count;
+
+    pthread_mutex_unlock(&groups_mutex);
+
+    cJSON_AddItemToObject(response, "periodic_groups", groups_array);
+    cJSON_AddNumberToObject(response, "count", count);
+
+    char* json_str = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+
+    return json_str;
+}
+
+/**
+ * (Re)build the packing plan of a group and derive its effective tick count
+ *
+ * The plan only changes when the ASDU size or the point count changes, so
+ * this is a no-op on every cycle after the first one.
+ */
+static void prepare_group(PeriodicGroup* group, const DataTypeContext* ctx) {
+    CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave_instance);
+    int n = group_size(group, ctx);
+
+    if (group->plan.max_asdu_size != alParams->maxSizeOfASDU || group->plan.points != n) {
+        DataValue* snapshot = (DataValue*)realloc(group->snapshot, (n > 0 ? n : 1) * sizeof(DataValue));
+        if (!snapshot ||
+            !packing_plan_build(&group->plan, ctx->config.ioa_list, group->indices, n,
+                                ctx->type_info->io_size, alParams->maxSizeOfASDU)) {
+            LOG_ERROR("Failed to build packing plan for periodic group %s", group->name);
+            packing_plan_free(&group->plan);
+        }
+        if (snapshot) {
+            group->snapshot = snapshot;
+        }
+    }
+
+    int ticks = 1;
+    if (group->spread_ticks == PERIODIC_SPREAD_AUTO) {
+        ticks = group->plan.count;
+    } else if (group->spread_ticks > 0) {
+        ticks = group->spread_ticks;
+    }
+
+    // More ticks than ASDUs would only produce empty ticks
+    if (ticks > group->plan.count) ticks = group->plan.count;
+    if (ticks > group->period_ms / PERIODIC_MIN_TICK_MS) ticks = group->period_ms / PERIODIC_MIN_TICK_MS;
+    if (ticks < 1) ticks = 1;
+
+    group->ticks = ticks;
+}
+
+/**
+ * Copy the values of the positions [first_pos, last_pos) into the snapshot
+ *
+ * This is the only part of a tick that holds the data context mutex.
+ * Whole-type groups are a single memcpy.
+ */
+static void snapshot_values(PeriodicGroup* group, DataTypeContext* ctx, int first_pos, int last_pos) {
     pthread_mutex_lock(&ctx->mutex);
+    uint64_t start = utils_monotonic_us();
+
+    if (!group->indices) {
+        memcpy(&group->snapshot[first_pos], &ctx->data_array[first_pos],
+               (last_pos - first_pos) * sizeof(DataValue));
+    } else {
+        for (int pos = first_pos; pos < last_pos; pos++) {
+            group->snapshot[pos] = ctx->data_array[group->indices[pos]];
+        }
+    }
+
+    uint64_t held = utils_monotonic_us() - start;
+    pthread_mutex_unlock(&ctx->mutex);
+
+    if (held > group->stats.max_lock_us) {
+        group->stats.max_lock_us = held;
+    }
+}
+
+/**
+ * Send the chunks [first, last) of the group's packing plan
+ *
+ * Chunks cover consecutive positions, so the values for the whole range are
+ * snapshotted at once and then encoded without holding the context mutex.
+ */
+static void send_periodic_chunks(PeriodicGroup* group, DataTypeContext* ctx, int first, int last) {
+    if (first >= last) return;
+
+    LOG_DEBUG("Sending periodic data for group %s (ASDUs %d..%d of %d)",
+              group->name, first, last - 1, group->plan.count);
+
+    const PackedChunk* last_chunk = &group->plan.chunks[last - 1];
+    snapshot_values(group, ctx, group->plan.chunks[first].start, last_chunk->start + last_chunk->count);
 
     CS101_AppLayerParameters alParams = CS104_Slave_getAppLayerParameters(slave_instance);
-    int maxASDUSize = alParams->maxSizeOfASDU;
-    int ioSizeWithIOA = ctx->type_info->io_size;
-    int ioSizeNoIOA = getIOSizeNoIOA(ioSizeWithIOA);
-
-    // Process IOAs with SQ=1 optimization
-    int i = 0;
-    while (i < ctx->config.count) {
-        // Find consecutive sequence length
-        int seq_len = 1;
-        while (i + seq_len < ctx->config.count &&
-               ctx->config.ioa_list[i + seq_len] == ctx->config.ioa_list[i + seq_len - 1] + 1) {
-            seq_len++;
-        }
-
-        bool useSequence = (seq_len >= 3);
-
-        if (useSequence) {
-            // SQ=1 mode for consecutive IOAs
-            int maxIOAs = calcMaxIOAs_SQ1(maxASDUSize, ioSizeWithIOA, ioSizeNoIOA);
-
-            for (int j = 0; j < seq_len; j += maxIOAs) {
-                int chunk_len = (j + maxIOAs < seq_len) ? maxIOAs : (seq_len - j);
-
-                CS101_ASDU newAsdu = CS101_ASDU_create(
-                    alParams, true,  // SQ=1
-                    CS101_COT_PERIODIC,
-                    0, ASDU, false, false
-                );
-
-                if (newAsdu) {
-                    for (int k = 0; k < chunk_len; k++) {
-                        InformationObject io = create_io_for_type(
-                            ctx->type_id,
-                            ctx->config.ioa_list[i + j + k],
-                            &ctx->data_array[i + j + k]
-                        );
-
-                        if (io) {
-                            CS101_ASDU_addInformationObject(newAsdu, io);
-                            InformationObject_destroy(io);
-                        }
-                    }
-
-                    CS104_Slave_enqueueASDU(slave_instance, newAsdu);
-                    CS101_ASDU_destroy(newAsdu);
-                }
+
+    for (int c = first; c < last; c++) {
+        const PackedChunk* chunk = &group->plan.chunks[c];
+
+        CS101_ASDU newAsdu = asdu_pool_acquire(
+            alParams, chunk->sequence,  // SQ=1 for runs, SQ=0 otherwise
+            CS101_COT_PERIODIC, ASDU
+        );
+
+        for (int k = 0; k < chunk->count; k++) {
+            int pos = chunk->start + k;
+            InformationObject io = create_io_for_type(
+                ctx->type_id,
+                ctx->config.ioa_list[group_index(group, pos)],
+                &group->snapshot[pos]
+            );
+
+            if (io) {
+                CS101_ASDU_addInformationObject(newAsdu, io);
+                InformationObject_destroy(io);
+            }
+        }
+
+        CS104_Slave_enqueueASDU(slave_instance, newAsdu);
+    }
+}
+
+// Deadline of the group's next tick within the current cycle
+static uint64_t tick_deadline(const PeriodicGroup* group) {
+    return group->cycle_start + (uint64_t)group->tick * group->period_ms / group->ticks;
+}
+
+/**
+ * Run one tick of a group: 1/ticks of its ASDUs
+ *
+ * A cycle is complete after its last tick; its duration is the sum of the
+ * tick durations, so burst and spread groups report comparable numbers.
+ */
+static void run_group_tick(PeriodicGroup* group) {
+    DataTypeContext* ctx = get_data_context(group->type_id);
+    if (!ctx || ctx->config.count == 0) {
+        group->tick = 0;
+        group->cycle_start += group->period_ms;
+        return;
+    }
+
+    if (group->tick == 0) {
+        prepare_group(group, ctx);
+        group->cycle_us = 0;
+    }
+
+    int first = (int)((int64_t)group->tick * group->plan.count / group->ticks);
+    int last = (int)((int64_t)(group->tick + 1) * group->plan.count / group->ticks);
+
+    uint64_t start = utils_monotonic_us();
+    send_periodic_chunks(group, ctx, first, last);
+    group->cycle_us += utils_monotonic_us() - start;
+
+    int queued = CS104_Slave_getNumberOfQueueEntries(slave_instance, NULL);
+    if (queued > group->stats.queue_high_water_mark) {
+        group->stats.queue_high_water_mark = queued;
+    }
+
+    if (++group->tick < group->ticks) return;
+
+    group->tick = 0;
+    group->cycle_start += group->period_ms;
+
+    uint64_t duration = group->cycle_us;
+    group->stats.cycles++;
+    group->stats.last_cycle_us = duration;
+    group->stats.total_cycle_us += duration;
+    if (duration > group->stats.max_cycle_us) {
+        group->stats.max_cycle_us = duration;
+    }
+}
+
+/**
+ * Fire every group whose deadline has passed
+ *
+ * Cycles advance by whole periods from the previous cycle start, not from
+ * "now", so they stay phase-locked. If more than one period elapsed before
+ * a cycle started, the skipped cycles are counted as missed deadlines
+ * instead of being replayed. A spread cycle interrupted by a disconnect is
+ * abandoned and restarts at the next period.
+ */
+static void run_due_groups(void) {
+    bool connected = is_client_connected(slave_instance);
+
+    // Lock order: point configuration before the group registry
+    data_config_read_lock();
+    pthread_mutex_lock(&groups_mutex);
+
+    for (int i = 0; i < registry.count; i++) {
+        PeriodicGroup* group = &registry.groups[i];
+        uint64_t now = utils_monotonic_ms();
+
+        if (now < group->next_deadline) continue;
+
+        if (group->tick == 0) {
+            uint64_t late_periods = (now - group->cycle_start) / group->period_ms;
+            group->cycle_start += late_periods * group->period_ms;
+            if (connected) {
+                group->stats.missed_deadlines += late_periods;
             }
+        }
+
+        if (connected) {
+            run_group_tick(group);
         } else {
-            // SQ=0 mode for non-consecutive
-            int maxIOAs = calcMaxIOAs_SQ0(maxASDUSize, ioSizeWithIOA);
-
-            for (int j = 0; j < seq_len; j += maxIOAs) {
-                int chunk_len = (j + maxIOAs < seq_len) ? maxIOAs : (seq_len - j);
-
-                CS101_ASDU newAsdu = CS101_ASDU_create(
-                    alParams, false,  // SQ=0
-                    CS101_COT_PERIODIC,
-                    0, ASDU, false, false
-                );
-
-                if (newAsdu) {
-                    for (int k = 0; k < chunk_len; k++) {
-                        InformationObject io = create_io_for_type(
-                            ctx->type_id,
-                            ctx->config.ioa_list[i + j + k],
-                            &ctx->data_array[i + j + k]
-                        );
-
-                        if (io) {
-                            CS101_ASDU_addInformationObject(newAsdu, io);
-                            InformationObject_destroy(io);
-                        }
-                    }
-
-                    CS104_Slave_enqueueASDU(slave_instance, newAsdu);
-                    CS101_ASDU_destroy(newAsdu);
-                }
+            group->tick = 0;
+            group->cycle_start += group->period_ms;
+        }
+
+        group->next_deadline = tick_deadline(group);
+    }
+
+    pthread_mutex_unlock(&groups_mutex);
+    data_config_read_unlock();
+}
+
+// Arm the timerfd for the earliest deadline, or disarm it if there are no groups
+static void arm_timer(void) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+
+    pthread_mutex_lock(&groups_mutex);
+
+    if (registry.count > 0) {
+        uint64_t earliest = registry.groups[0].next_deadline;
+        for (int i = 1; i < registry.count; i++) {
+            if (registry.groups[i].next_deadline < earliest) {
+                earliest = registry.groups[i].next_deadline;
             }
         }
 
-        i += seq_len;
+        // A zero it_value disarms the timer, so never arm for time 0
+        if (earliest == 0) earliest = 1;
+        spec.it_value.tv_sec = earliest / 1000;
+        spec.it_value.tv_nsec = (earliest % 1000) * 1000000;
     }
 
-    pthread_mutex_unlock(&ctx->mutex);
-    config->last_sent = now;
+    pthread_mutex_unlock(&groups_mutex);
+
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
 }
 
 void* periodic_sender_thread(void* arg) {
     (void)arg;
-    LOG_INFO("Periodic sender thread started");
+    thread_policy_apply(THREAD_CLASS_PERIODIC);
+    LOG_INFO("Periodic sender thread started (%d groups)", periodic_get_group_count());
+
+    struct pollfd fds[2];
+    fds[0].fd = timer_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_fd;
+    fds[1].events = POLLIN;
 
     while (running) {
-        if (is_client_connected(slave_instance)) {
-            send_periodic_data_for_type(get_data_context(M_ME_NC_1), &g_periodic_M_ME_NC_1);
-            send_periodic_data_for_type(get_data_context(M_SP_TB_1), &g_periodic_M_SP_TB_1);
+        arm_timer();
+
+        if (poll(fds, 2, -1) < 0) {
+            continue; // EINTR
+        }
+
+        uint64_t value;
+
+        if (fds[1].revents & POLLIN) {
+            // Stop request or new group added
+            if (read(wake_fd, &value, sizeof(value)) < 0) {
+                LOG_WARN("Failed to read periodic sender wake event");
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            if (read(timer_fd, &value, sizeof(value)) > 0) {
+                run_due_groups();
+            }
         }
-        
-        Thread_sleep(100); // Check every 100ms
     }
 
     LOG_INFO("Periodic sender thread stopped");
@@ -156,11 +498,25 @@ void start_periodic_sender(CS104_Slave slave) {
     if (running) return;
 
     slave_instance = slave;
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (timer_fd < 0 || wake_fd < 0) {
+        LOG_ERROR("Failed to create periodic sender timer");
+        if (timer_fd >= 0) close(timer_fd);
+        if (wake_fd >= 0) close(wake_fd);
+        timer_fd = wake_fd = -1;
+        return;
+    }
+
     running = true;
-    
+
     if (pthread_create(&periodic_thread, NULL, periodic_sender_thread, NULL) != 0) {
         LOG_ERROR("Failed to create periodic sender thread");
         running = false;
+        close(timer_fd);
+        close(wake_fd);
+        timer_fd = wake_fd = -1;
     }
 }
 
@@ -168,5 +524,15 @@ void stop_periodic_sender(void) {
     if (!running) return;
 
     running = false;
+
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        LOG_WARN("Failed to wake periodic sender");
+    }
+
     pthread_join(periodic_thread, NULL);
+
+    close(timer_fd);
+    close(wake_fd);
+    timer_fd = wake_fd = -1;
 }
@@ -3,16 +3,145 @@
 
 #include "cs104_slave.h"
 #include <stdbool.h>
+#include <stdint.h>
+#include "../protocol/packing_plan.h"
+#include "../data/data_manager.h"
 
+/**
+ * Periodic Sender Module
+ *
+ * Sends cyclic data (COT=PERIODIC) for any number of point groups.
+ * A group is either a whole data type or an explicit subset of its IOAs,
+ * each with its own period (e.g. 1 s feeder currents, 60 s temperatures).
+ *
+ * The sender thread sleeps on a timerfd armed with the absolute time of
+ * the earliest group deadline, so there is no fixed polling tick.
+ * Deadlines advance by exactly one period per cycle to avoid drift.
+ *
+ * Values are copied into a per-group snapshot while holding the data
+ * context mutex; encoding and enqueueing run on the snapshot after the
+ * mutex is released, so update_data() never waits for a whole cycle.
+ *
+ * In spread mode a group is sliced into N ticks evenly spaced across its
+ * period, and each tick enqueues 1/N of the group's ASDUs. This keeps the
+ * low-priority queue occupancy flat instead of bursting a whole type into
+ * it at once.
+ */
+
+#define PERIODIC_GROUP_NAME_LEN 32
+
+// Spread ticks: send the whole group at once
+#define PERIODIC_SPREAD_NONE 0
+// Spread ticks: one tick per ASDU (limited by PERIODIC_MIN_TICK_MS)
+#define PERIODIC_SPREAD_AUTO -1
+// Smallest spacing between two spread ticks
+#define PERIODIC_MIN_TICK_MS 10
+
+/**
+ * Runtime statistics for one cyclic group
+ */
+typedef struct {
+    uint64_t cycles;            // Completed cycles
+    uint64_t missed_deadlines;  // Periods skipped because the sender fell behind
+    uint64_t last_cycle_us;     // Duration of the last cycle (encode + enqueue)
+    uint64_t max_cycle_us;      // Longest cycle seen
+    uint64_t total_cycle_us;    // Sum of all cycle durations (for the average)
+    uint64_t max_lock_us;       // Longest time one tick held the data context mutex
+    int queue_high_water_mark;  // Max low-priority queue entries seen after this group's ticks
+} PeriodicGroupStats;
+
+/**
+ * One cyclic group
+ */
+typedef struct {
+    char name[PERIODIC_GROUP_NAME_LEN];
+    TypeID type_id;             // Data type of the points in this group
+    int* indices;               // Sorted indices into the type's ioa_list (NULL = whole type)
+    int count;                  // Number of indices (ignored when indices == NULL)
+    int period_ms;              // Cycle period
+    int spread_ticks;           // Configured ticks per period (PERIODIC_SPREAD_*, or N)
+    int ticks;                  // Effective ticks per period (1 = burst)
+    int tick;                   // Next tick within the current cycle
+    uint64_t cycle_start;       // Start of the current cycle (monotonic ms)
+    uint64_t next_deadline;     // Next firing time (monotonic ms)
+    uint64_t cycle_us;          // Encode time accumulated in the current cycle
+    PackingPlan plan;           // ASDU layout of the group
+    DataValue* snapshot;        // Values copied out of the data context (plan.points entries)
+    PeriodicGroupStats stats;
+} PeriodicGroup;
+
+/**
+ * List of cyclic groups
+ */
 typedef struct {
-    bool enabled;
-    int period_ms;
-    uint64_t last_sent;
-} PeriodicConfig;
-
-// Global periodic configs (exposed for config parser)
-extern PeriodicConfig g_periodic_M_ME_NC_1;
-extern PeriodicConfig g_periodic_M_SP_TB_1;
+    PeriodicGroup* groups;
+    int count;
+    int capacity;
+} PeriodicGroupList;
+
+/**
+ * Add a cyclic group
+ *
+ * Must be called after the data type has been configured, so the IOAs can be
+ * resolved to indices. Unknown IOAs are skipped with a warning, duplicates
+ * are kept once.
+ *
+ * @param name Group name used in logs and statistics
+ * @param type_id Data type of the group
+ * @param period_ms Cycle period in milliseconds (> 0)
+ * @param ioas IOAs belonging to the group, or NULL for the whole type
+ * @param ioa_count Number of entries in ioas
+ * @param spread_ticks PERIODIC_SPREAD_NONE, PERIODIC_SPREAD_AUTO or number of ticks per period
+ * @return true on success, false on invalid parameters or allocation failure
+ */
+bool periodic_add_group(const char* name, TypeID type_id, int period_ms,
+                        const int* ioas, int ioa_count, int spread_ticks);
+
+/**
+ * Add a cyclic group to a list that is not running yet
+ *
+ * Same as periodic_add_group(), but the IOAs are resolved against contexts,
+ * so the groups of a reload can be built from its staged configuration.
+ *
+ * @param list List to append to (zero-initialized when empty)
+ * @param contexts DATA_TYPE_COUNT contexts (g_data_contexts or staged ones)
+ * @return true on success, false on invalid parameters or allocation failure
+ */
+bool periodic_stage_group(PeriodicGroupList* list, const DataTypeContext* contexts,
+                          const char* name, TypeID type_id, int period_ms,
+                          const int* ioas, int ioa_count, int spread_ticks);
+
+/**
+ * Replace the running groups with the staged ones
+ *
+ * Call with the configuration write lock held when contexts are swapped as
+ * well, so the groups always match the point lists. On return list holds
+ * the previous groups; release them with periodic_free_groups().
+ */
+void periodic_commit_groups(PeriodicGroupList* list);
+
+/**
+ * Free the groups of a list that is not running
+ */
+void periodic_free_groups(PeriodicGroupList* list);
+
+/**
+ * Remove all cyclic groups and free their resources
+ */
+void periodic_clear_groups(void);
+
+/**
+ * Get the number of configured cyclic groups
+ */
+int periodic_get_group_count(void);
+
+/**
+ * Get JSON string with the statistics of all groups
+ * Returns allocated string that must be freed by caller
+ *
+ * @return JSON string like: {"periodic_groups":[{"name":"M_ME_NC_1","period_ms":5000,"cycles":3,...}],"count":1}
+ */
+char* periodic_get_stats_json(void);
 
 void start_periodic_sender(CS104_Slave slave);
 void stop_periodic_sender(void);
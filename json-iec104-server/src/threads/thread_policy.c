@@ -0,0 +1,183 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* cpu_set_t, pthread_setaffinity_np */
+#endif
+
+#include "thread_policy.h"
+#include "../utils/logger.h"
+#include "hal_thread.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+typedef struct {
+    bool has_cpus;
+    cpu_set_t cpus;
+    int priority;                   // 0 = SCHED_OTHER
+    int affinity_warned;            // Warning logged (atomic)
+    int priority_warned;
+    ThreadClassStats stats;         // Updated atomically by starting threads
+} ThreadPolicy;
+
+static const char* class_names[THREAD_CLASS_COUNT] = {
+    "input", "connection", "listener", "reactor", "periodic", "background", "worker", "output"
+};
+
+// Written while the configuration is loaded, before any classed thread starts
+static ThreadPolicy policies[THREAD_CLASS_COUNT];
+
+// Affinity of the process at startup, restored in classes without CPUs
+static cpu_set_t process_cpus;
+static bool process_cpus_valid = false;
+static bool any_priority = false;
+
+bool thread_policy_set(ThreadClass thread_class, const int* cpus, int cpu_count, int priority) {
+    if ((int)thread_class < 0 || thread_class >= THREAD_CLASS_COUNT) {
+        return false;
+    }
+    if (priority < 0 || priority > THREAD_POLICY_MAX_PRIORITY) {
+        return false;
+    }
+
+    ThreadPolicy* policy = &policies[thread_class];
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    for (int i = 0; cpus && i < cpu_count; i++) {
+        if (cpus[i] < 0 || cpus[i] >= THREAD_POLICY_MAX_CPUS) {
+            return false;
+        }
+        CPU_SET(cpus[i], &set);
+    }
+
+    policy->has_cpus = cpus && cpu_count > 0;
+    policy->cpus = set;
+    policy->priority = priority;
+    if (priority > 0) {
+        any_priority = true;
+    }
+    return true;
+}
+
+void thread_policy_reset(void) {
+    memset(policies, 0, sizeof(policies));
+    any_priority = false;
+}
+
+bool thread_policy_configured(void) {
+    for (int c = 0; c < THREAD_CLASS_COUNT; c++) {
+        if (policies[c].has_cpus || policies[c].priority > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool thread_policy_apply(ThreadClass thread_class) {
+    if ((int)thread_class < 0 || thread_class >= THREAD_CLASS_COUNT) {
+        return false;
+    }
+
+    ThreadPolicy* policy = &policies[thread_class];
+    const char* name = class_names[thread_class];
+    bool ok = true;
+
+    __atomic_fetch_add(&policy->stats.started, 1, __ATOMIC_RELAXED);
+
+    if (!thread_policy_configured()) {
+        return true;
+    }
+
+    // A thread inherits the settings of its creator, so a class without CPUs
+    // or priority returns to the process defaults
+    const cpu_set_t* cpus = policy->has_cpus ? &policy->cpus : (process_cpus_valid ? &process_cpus : NULL);
+    if (cpus) {
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(*cpus), cpus);
+        if (rc != 0) {
+            __atomic_fetch_add(&policy->stats.affinity_failed, 1, __ATOMIC_RELAXED);
+            if (!__atomic_exchange_n(&policy->affinity_warned, 1, __ATOMIC_RELAXED)) {
+                LOG_WARN("Failed to set CPU affinity of %s threads: %s", name, strerror(rc));
+            }
+            ok = false;
+        }
+    }
+
+    if (policy->priority > 0 || any_priority) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = policy->priority;
+
+        int rc = pthread_setschedparam(pthread_self(), policy->priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+        if (rc != 0) {
+            __atomic_fetch_add(&policy->stats.priority_failed, 1, __ATOMIC_RELAXED);
+            if (!__atomic_exchange_n(&policy->priority_warned, 1, __ATOMIC_RELAXED)) {
+                LOG_WARN("Failed to set SCHED_FIFO priority %d of %s threads: %s%s", policy->priority, name,
+                         strerror(rc), rc == EPERM ? " (needs CAP_SYS_NICE)" : "");
+            }
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+// Called by lib60870 in each new thread before its start function
+static void hal_thread_started(void* parameter, const char* thread_class) {
+    (void)parameter;
+    ThreadClass c;
+
+    if (thread_class_from_string(thread_class, &c)) {
+        thread_policy_apply(c);
+    }
+}
+
+void thread_policy_init(void) {
+    process_cpus_valid = sched_getaffinity(0, sizeof(process_cpus), &process_cpus) == 0;
+    Thread_setStartHandler(hal_thread_started, NULL);
+}
+
+bool thread_class_from_string(const char* name, ThreadClass* thread_class) {
+    if (!name) {
+        return false;
+    }
+    for (int c = 0; c < THREAD_CLASS_COUNT; c++) {
+        if (strcmp(name, class_names[c]) == 0) {
+            *thread_class = (ThreadClass)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* thread_class_to_string(ThreadClass thread_class) {
+    if ((int)thread_class < 0 || thread_class >= THREAD_CLASS_COUNT) {
+        return "unknown";
+    }
+    return class_names[thread_class];
+}
+
+int thread_policy_cpu_count(ThreadClass thread_class) {
+    int count = 0;
+
+    if ((int)thread_class >= 0 && thread_class < THREAD_CLASS_COUNT && policies[thread_class].has_cpus) {
+        count = CPU_COUNT(&policies[thread_class].cpus);
+    } else {
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            count = CPU_COUNT(&set);
+        }
+    }
+    return count > 0 ? count : 1;
+}
+
+void thread_policy_get_stats(ThreadClass thread_class, ThreadClassStats* stats) {
+    if ((int)thread_class < 0 || thread_class >= THREAD_CLASS_COUNT) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    ThreadClassStats* s = &policies[thread_class].stats;
+    stats->started = __atomic_load_n(&s->started, __ATOMIC_RELAXED);
+    stats->affinity_failed = __atomic_load_n(&s->affinity_failed, __ATOMIC_RELAXED);
+    stats->priority_failed = __atomic_load_n(&s->priority_failed, __ATOMIC_RELAXED);
+}
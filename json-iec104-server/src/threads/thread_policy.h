@@ -0,0 +1,120 @@
+#ifndef THREAD_POLICY_H
+#define THREAD_POLICY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Thread Policy Module
+ *
+ * CPU affinity and real-time priority per class of server thread, e.g.
+ * connection threads on cores 2-3 with SCHED_FIFO 50, the input loop on
+ * core 1 and background writers anywhere else:
+ *
+ *   "threads": {
+ *     "connection": {"cpus": [[2, 3]], "priority": 50},
+ *     "input":      {"cpus": [1]}
+ *   }
+ *
+ * Every thread applies the policy of its class to itself when it starts.
+ * Threads created by lib60870 (connection, listener and reactor threads)
+ * are covered through the hal_thread start handler, which the library calls
+ * in each new thread with the class the slave gave it. Threads of the
+ * server call thread_policy_apply() at the top of their start function.
+ *
+ * Once any class is configured, a thread of a class without CPUs or
+ * priority returns to the affinity of the process and SCHED_OTHER, so it
+ * does not inherit the settings of the thread that created it.
+ * Priorities need CAP_SYS_NICE (or an RLIMIT_RTPRIO); when the kernel
+ * refuses, the thread keeps running with the default policy and a warning
+ * is logged once per class.
+ */
+
+typedef enum {
+    THREAD_CLASS_INPUT = 0,         // stdin loop (main thread)
+    THREAD_CLASS_CONNECTION,        // lib60870 thread per master connection
+    THREAD_CLASS_LISTENER,          // lib60870 accept loop (reactor 0 in reactor mode)
+    THREAD_CLASS_REACTOR,           // lib60870 reactor threads 1..N-1
+    THREAD_CLASS_PERIODIC,          // Cyclic data sender
+    THREAD_CLASS_BACKGROUND,        // Snapshot sync, capture writer, command timeouts
+    THREAD_CLASS_WORKER,            // Worker pool threads
+    THREAD_CLASS_OUTPUT,            // Event output writer
+    THREAD_CLASS_COUNT
+} ThreadClass;
+
+// Highest SCHED_FIFO priority accepted in the configuration
+#define THREAD_POLICY_MAX_PRIORITY 99
+// CPU numbers must be below this (glibc CPU_SETSIZE)
+#define THREAD_POLICY_MAX_CPUS 1024
+
+/**
+ * Statistics of one class
+ */
+typedef struct {
+    uint64_t started;           // Threads that applied the policy
+    uint64_t affinity_failed;   // Threads whose affinity could not be set
+    uint64_t priority_failed;   // Threads whose priority could not be set
+} ThreadClassStats;
+
+/**
+ * Set the policy of a class
+ *
+ * @param thread_class Class to configure
+ * @param cpus CPU numbers, or NULL to keep the inherited affinity
+ * @param cpu_count Number of CPU numbers
+ * @param priority SCHED_FIFO priority 1..THREAD_POLICY_MAX_PRIORITY, 0 = SCHED_OTHER
+ * @return false if the class, a CPU number or the priority is invalid
+ */
+bool thread_policy_set(ThreadClass thread_class, const int* cpus, int cpu_count, int priority);
+
+/**
+ * Remove all policies and statistics (before loading a configuration)
+ */
+void thread_policy_reset(void);
+
+/**
+ * Whether any class has a policy
+ */
+bool thread_policy_configured(void);
+
+/**
+ * Apply the policy of a class to the calling thread
+ *
+ * @return false if a configured affinity or priority could not be set
+ */
+bool thread_policy_apply(ThreadClass thread_class);
+
+/**
+ * Remember the process affinity and install the hal_thread start handler,
+ * so lib60870 threads apply the policy of their class
+ *
+ * Must be called after the configuration is loaded and before any thread
+ * is started.
+ */
+void thread_policy_init(void);
+
+/**
+ * Parse a class name ("input", "connection", "listener", "reactor",
+ * "periodic", "background", "worker" or "output")
+ *
+ * @return true if the name is known
+ */
+bool thread_class_from_string(const char* name, ThreadClass* thread_class);
+
+/**
+ * Name of a class
+ */
+const char* thread_class_to_string(ThreadClass thread_class);
+
+/**
+ * Number of CPUs threads of a class may run on (its CPU set, or the CPUs of
+ * the process when the class has none); at least 1
+ */
+int thread_policy_cpu_count(ThreadClass thread_class);
+
+/**
+ * Copy the statistics of a class
+ */
+void thread_policy_get_stats(ThreadClass thread_class, ThreadClassStats* stats);
+
+#endif // THREAD_POLICY_H
@@ -0,0 +1,655 @@
+#include "apdu_capture.h"
+#include "logger.h"
+#include "../threads/thread_policy.h"
+#include "../../cJSON/cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#define RING_MASK (APDU_CAPTURE_RING_SLOTS - 1)
+// Writer sleep when the ring is empty
+#define CAPTURE_POLL_US 10000
+
+#define PCAP_MAGIC 0xa1b2c3d4
+#define PCAP_LINKTYPE_RAW 101   // Packets start with the IPv4 header
+#define PCAP_RECORD_HEADER_SIZE 16
+#define PCAP_FILE_HEADER_SIZE 24
+#define IP_TCP_HEADER_SIZE 40
+
+#define TCP_FIN 0x01
+#define TCP_SYN 0x02
+#define TCP_PSH 0x08
+#define TCP_ACK 0x10
+
+typedef enum {
+    RECORD_RX,
+    RECORD_TX,
+    RECORD_OPEN,
+    RECORD_CLOSE
+} RecordKind;
+
+/**
+ * Ring slot
+ *
+ * sequence is the slot state of the bounded MPMC queue by D. Vyukov:
+ * pos = free for the producer at pos, pos + 1 = filled.
+ */
+typedef struct {
+    uint64_t sequence;
+    uint64_t timestamp_us;
+    IMasterConnection connection;
+    uint32_t peer_ip;           // RECORD_OPEN: network byte order
+    uint16_t peer_port;         // RECORD_OPEN
+    uint16_t length;            // Captured bytes
+    uint16_t orig_length;       // APDU size
+    uint8_t kind;
+    uint8_t data[APDU_CAPTURE_SNAPLEN];
+} CaptureRecord;
+
+// Connection known from the connection events
+typedef struct {
+    IMasterConnection connection;
+    uint32_t peer_ip;
+    uint16_t peer_port;
+} OpenConnection;
+
+// TCP stream written to the file (writer thread only)
+typedef struct {
+    IMasterConnection connection;
+    uint32_t client_ip;
+    uint16_t client_port;
+    uint32_t client_seq;
+    uint32_t server_seq;
+} TcpStream;
+
+// Ring (producers: protocol threads, consumer: writer thread)
+static CaptureRecord* ring = NULL;
+static uint64_t ring_tail = 0;
+static uint64_t ring_head = 0;
+static bool capture_enabled = false;
+static uint64_t dropped = 0;
+
+// Open connections, start/stop and file name are protected by capture_mutex
+static pthread_mutex_t capture_mutex = PTHREAD_MUTEX_INITIALIZER;
+static OpenConnection* open_connections = NULL;
+static int open_count = 0;
+static int open_capacity = 0;
+static char file_name[256] = "";
+
+// Writer state
+static pthread_t writer_thread;
+static bool writer_started = false;
+static bool writer_running = false;
+static FILE* out = NULL;
+static uint64_t file_bytes = 0;
+static uint64_t max_bytes = 0;
+static uint64_t packets = 0;
+static bool limit_reached = false;
+static TcpStream* streams = NULL;
+static int stream_count = 0;
+static int stream_capacity = 0;
+static int stream_total = 0;
+
+static uint32_t server_ip = 0;
+static uint16_t server_port = 2404;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Add a record to the ring, never blocks
+ * @return false if the ring is full (record dropped)
+ */
+static bool ring_push(RecordKind kind, IMasterConnection connection, const uint8_t* data, int length,
+                      uint32_t peer_ip, uint16_t peer_port) {
+    uint64_t pos = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+    CaptureRecord* rec;
+
+    for (;;) {
+        rec = &ring[pos & RING_MASK];
+        uint64_t seq = __atomic_load_n(&rec->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(seq - pos);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring_tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    int captured = length < APDU_CAPTURE_SNAPLEN ? length : APDU_CAPTURE_SNAPLEN;
+
+    rec->timestamp_us = now_us();
+    rec->connection = connection;
+    rec->peer_ip = peer_ip;
+    rec->peer_port = peer_port;
+    rec->length = (uint16_t)captured;
+    rec->orig_length = (uint16_t)length;
+    rec->kind = (uint8_t)kind;
+    if (captured > 0) {
+        memcpy(rec->data, data, captured);
+    }
+
+    __atomic_store_n(&rec->sequence, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Next filled record or NULL (single consumer)
+static CaptureRecord* ring_peek(void) {
+    CaptureRecord* rec = &ring[ring_head & RING_MASK];
+    if (__atomic_load_n(&rec->sequence, __ATOMIC_ACQUIRE) != ring_head + 1) {
+        return NULL;
+    }
+    return rec;
+}
+
+static void ring_release(CaptureRecord* rec) {
+    __atomic_store_n(&rec->sequence, ring_head + APDU_CAPTURE_RING_SLOTS, __ATOMIC_RELEASE);
+    ring_head++;
+}
+
+static void parse_peer_address(IMasterConnection connection, uint32_t* ip, uint16_t* port) {
+    char addr[128];
+    *ip = 0;
+    *port = 0;
+
+    if (IMasterConnection_getPeerAddress(connection, addr, sizeof(addr)) <= 0) return;
+
+    char* colon = strrchr(addr, ':');
+    if (!colon) return;
+
+    *port = (uint16_t)atoi(colon + 1);
+    *colon = '\0';
+
+    // IPv6 peers keep their port and show up as 0.0.0.0
+    struct in_addr in;
+    if (inet_pton(AF_INET, addr, &in) == 1) {
+        *ip = in.s_addr;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// pcap writer
+// ---------------------------------------------------------------------------
+
+static uint32_t checksum_add(uint32_t sum, const uint8_t* data, int length) {
+    for (int i = 0; i + 1 < length; i += 2) {
+        sum += (uint32_t)(data[i] << 8 | data[i + 1]);
+    }
+    if (length & 1) {
+        sum += (uint32_t)(data[length - 1] << 8);
+    }
+    return sum;
+}
+
+static uint16_t checksum_fold(uint32_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * Write one IPv4/TCP packet
+ * Addresses are in network byte order, ports and sequence numbers in host order.
+ * @return false if the packet does not fit into the size limit
+ */
+static bool write_packet(uint64_t timestamp_us, uint32_t src_ip, uint16_t src_port,
+                         uint32_t dst_ip, uint16_t dst_port, uint32_t seq, uint32_t ack,
+                         uint8_t flags, const uint8_t* payload, int length, int orig_length) {
+    uint8_t pkt[PCAP_RECORD_HEADER_SIZE + IP_TCP_HEADER_SIZE + APDU_CAPTURE_SNAPLEN];
+    int size = PCAP_RECORD_HEADER_SIZE + IP_TCP_HEADER_SIZE + length;
+
+    if (file_bytes + size > max_bytes) {
+        return false;
+    }
+
+    // pcap record header (host byte order, like the file header)
+    uint32_t rec[4] = {
+        (uint32_t)(timestamp_us / 1000000),
+        (uint32_t)(timestamp_us % 1000000),
+        (uint32_t)(IP_TCP_HEADER_SIZE + length),
+        (uint32_t)(IP_TCP_HEADER_SIZE + orig_length)
+    };
+    memcpy(pkt, rec, sizeof(rec));
+
+    uint8_t* ip = pkt + PCAP_RECORD_HEADER_SIZE;
+    memset(ip, 0, IP_TCP_HEADER_SIZE);
+    ip[0] = 0x45;
+    put16(ip + 2, (uint16_t)(IP_TCP_HEADER_SIZE + orig_length));
+    put16(ip + 6, 0x4000);      // Don't fragment
+    ip[8] = 64;                 // TTL
+    ip[9] = 6;                  // TCP
+    memcpy(ip + 12, &src_ip, 4);
+    memcpy(ip + 16, &dst_ip, 4);
+    put16(ip + 10, checksum_fold(checksum_add(0, ip, 20)));
+
+    uint8_t* tcp = ip + 20;
+    put16(tcp, src_port);
+    put16(tcp + 2, dst_port);
+    put32(tcp + 4, seq);
+    put32(tcp + 8, ack);
+    tcp[12] = 5 << 4;           // Header length
+    tcp[13] = flags;
+    put16(tcp + 14, 65535);     // Window
+    if (length > 0) {
+        memcpy(tcp + 20, payload, length);
+    }
+
+    // Pseudo header + TCP header + payload
+    uint8_t pseudo[12];
+    memcpy(pseudo, &src_ip, 4);
+    memcpy(pseudo + 4, &dst_ip, 4);
+    pseudo[8] = 0;
+    pseudo[9] = 6;
+    put16(pseudo + 10, (uint16_t)(20 + length));
+    put16(tcp + 16, checksum_fold(checksum_add(checksum_add(0, pseudo, 12), tcp, 20 + length)));
+
+    if (fwrite(pkt, 1, size, out) != (size_t)size) {
+        LOG_ERROR("Failed to write APDU capture file");
+        return false;
+    }
+
+    __atomic_store_n(&file_bytes, file_bytes + size, __ATOMIC_RELAXED);
+    return true;
+}
+
+static bool write_from_client(TcpStream* s, uint64_t timestamp_us, uint8_t flags,
+                              const uint8_t* payload, int length, int orig_length) {
+    return write_packet(timestamp_us, s->client_ip, s->client_port, server_ip, server_port,
+                        s->client_seq, s->server_seq, flags, payload, length, orig_length);
+}
+
+static bool write_from_server(TcpStream* s, uint64_t timestamp_us, uint8_t flags,
+                              const uint8_t* payload, int length, int orig_length) {
+    return write_packet(timestamp_us, server_ip, server_port, s->client_ip, s->client_port,
+                        s->server_seq, s->client_seq, flags, payload, length, orig_length);
+}
+
+static TcpStream* find_stream(IMasterConnection connection) {
+    for (int i = stream_count - 1; i >= 0; i--) {
+        if (streams[i].connection == connection) {
+            return &streams[i];
+        }
+    }
+    return NULL;
+}
+
+// Start a TCP stream with a three-way handshake
+static TcpStream* open_stream(IMasterConnection connection, uint32_t ip, uint16_t port,
+                              uint64_t timestamp_us, bool* ok) {
+    if (stream_count == stream_capacity) {
+        int new_capacity = stream_capacity ? stream_capacity * 2 : 16;
+        TcpStream* new_streams = (TcpStream*)realloc(streams, new_capacity * sizeof(TcpStream));
+        if (!new_streams) {
+            LOG_ERROR("Failed to allocate capture stream");
+            return NULL;
+        }
+        streams = new_streams;
+        stream_capacity = new_capacity;
+    }
+
+    TcpStream* s = &streams[stream_count++];
+    s->connection = connection;
+    s->client_ip = ip;
+    s->client_port = port;
+    s->client_seq = 0;
+    s->server_seq = 0;
+
+    __atomic_store_n(&stream_total, stream_total + 1, __ATOMIC_RELAXED);
+
+    *ok = write_from_client(s, timestamp_us, TCP_SYN, NULL, 0, 0);
+    s->client_seq = 1;
+    *ok = *ok && write_from_server(s, timestamp_us, TCP_SYN | TCP_ACK, NULL, 0, 0);
+    s->server_seq = 1;
+    *ok = *ok && write_from_client(s, timestamp_us, TCP_ACK, NULL, 0, 0);
+
+    return s;
+}
+
+static bool close_stream(TcpStream* s, uint64_t timestamp_us) {
+    bool ok = write_from_server(s, timestamp_us, TCP_FIN | TCP_ACK, NULL, 0, 0);
+    *s = streams[--stream_count];
+    return ok;
+}
+
+/**
+ * Write one ring record
+ * @return false when the size limit is reached
+ */
+static bool write_record(const CaptureRecord* rec) {
+    TcpStream* s = find_stream(rec->connection);
+    bool ok = true;
+
+    switch (rec->kind) {
+        case RECORD_OPEN:
+            // Address reused by a new connection while the close was lost
+            if (s && !close_stream(s, rec->timestamp_us)) return false;
+            open_stream(rec->connection, rec->peer_ip, rec->peer_port, rec->timestamp_us, &ok);
+            return ok;
+
+        case RECORD_CLOSE:
+            return s ? close_stream(s, rec->timestamp_us) : true;
+
+        case RECORD_RX:
+        case RECORD_TX:
+            // Open record lost in a full ring: the peer address is unknown
+            if (!s) {
+                s = open_stream(rec->connection, 0, 0, rec->timestamp_us, &ok);
+                if (!s) return true;
+                if (!ok) return false;
+            }
+
+            if (rec->kind == RECORD_RX) {
+                ok = write_from_client(s, rec->timestamp_us, TCP_PSH | TCP_ACK,
+                                       rec->data, rec->length, rec->orig_length);
+                s->client_seq += rec->orig_length;
+            } else {
+                ok = write_from_server(s, rec->timestamp_us, TCP_PSH | TCP_ACK,
+                                       rec->data, rec->length, rec->orig_length);
+                s->server_seq += rec->orig_length;
+            }
+
+            if (ok) {
+                __atomic_store_n(&packets, packets + 1, __ATOMIC_RELAXED);
+            }
+            return ok;
+    }
+
+    return true;
+}
+
+/**
+ * Write all filled records
+ * @return number of records, -1 when the size limit is reached
+ */
+static int drain_ring(void) {
+    int count = 0;
+    CaptureRecord* rec;
+
+    while ((rec = ring_peek()) != NULL) {
+        bool ok = write_record(rec);
+        ring_release(rec);
+        if (!ok) return -1;
+        count++;
+    }
+
+    return count;
+}
+
+static void* capture_writer_thread(void* arg) {
+    (void)arg;
+    thread_policy_apply(THREAD_CLASS_BACKGROUND);
+
+    for (;;) {
+        bool stopping = !__atomic_load_n(&writer_running, __ATOMIC_ACQUIRE);
+
+        int count = drain_ring();
+
+        if (count < 0) {
+            __atomic_store_n(&capture_enabled, false, __ATOMIC_RELEASE);
+            __atomic_store_n(&limit_reached, true, __ATOMIC_RELAXED);
+            LOG_WARN("APDU capture stopped: %s reached %llu bytes",
+                     file_name, (unsigned long long)max_bytes);
+            break;
+        }
+
+        if (count == 0) {
+            if (stopping) break;
+            fflush(out);
+            usleep(CAPTURE_POLL_US);
+        }
+    }
+
+    fclose(out);
+    out = NULL;
+    return NULL;
+}
+
+// Wait for the writer of the last capture (capture_mutex held)
+static void join_writer(void) {
+    if (!writer_started) return;
+
+    __atomic_store_n(&writer_running, false, __ATOMIC_RELEASE);
+    pthread_join(writer_thread, NULL);
+    writer_started = false;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void apdu_capture_init(const char* ip, int port) {
+    struct in_addr in;
+    server_ip = (ip && inet_pton(AF_INET, ip, &in) == 1) ? in.s_addr : 0;
+    server_port = (uint16_t)port;
+}
+
+void apdu_capture_cleanup(void) {
+    apdu_capture_stop();
+
+    pthread_mutex_lock(&capture_mutex);
+    free(ring);
+    ring = NULL;
+    free(open_connections);
+    open_connections = NULL;
+    open_count = open_capacity = 0;
+    free(streams);
+    streams = NULL;
+    stream_count = stream_capacity = 0;
+    pthread_mutex_unlock(&capture_mutex);
+}
+
+bool apdu_capture_start(const char* file, uint64_t limit) {
+    if (!file || file[0] == '\0') {
+        LOG_ERROR("No APDU capture file given");
+        return false;
+    }
+
+    pthread_mutex_lock(&capture_mutex);
+
+    if (__atomic_load_n(&capture_enabled, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_unlock(&capture_mutex);
+        LOG_WARN("APDU capture already running (%s)", file_name);
+        return false;
+    }
+
+    // The previous capture may have stopped at its size limit
+    join_writer();
+
+    if (!ring) {
+        ring = (CaptureRecord*)malloc(APDU_CAPTURE_RING_SLOTS * sizeof(CaptureRecord));
+        if (!ring) {
+            pthread_mutex_unlock(&capture_mutex);
+            LOG_ERROR("Failed to allocate APDU capture ring");
+            return false;
+        }
+        for (uint64_t i = 0; i < APDU_CAPTURE_RING_SLOTS; i++) {
+            ring[i].sequence = i;
+        }
+        ring_tail = ring_head = 0;
+    }
+
+    // Discard records that raced with the last stop
+    CaptureRecord* rec;
+    while ((rec = ring_peek()) != NULL) {
+        ring_release(rec);
+    }
+
+    out = fopen(file, "wb");
+    if (!out) {
+        pthread_mutex_unlock(&capture_mutex);
+        LOG_ERROR("Failed to open APDU capture file %s", file);
+        return false;
+    }
+
+    uint32_t header[6] = { PCAP_MAGIC, 2 | (4 << 16), 0, 0,
+                           IP_TCP_HEADER_SIZE + APDU_CAPTURE_SNAPLEN, PCAP_LINKTYPE_RAW };
+    fwrite(header, 1, sizeof(header), out);
+
+    strncpy(file_name, file, sizeof(file_name) - 1);
+    file_name[sizeof(file_name) - 1] = '\0';
+    file_bytes = PCAP_FILE_HEADER_SIZE;
+    max_bytes = limit ? limit : APDU_CAPTURE_DEFAULT_MAX_BYTES;
+    packets = 0;
+    dropped = 0;
+    limit_reached = false;
+    stream_count = 0;
+    stream_total = 0;
+
+    // Connections that are already open get their stream before any APDU
+    for (int i = 0; i < open_count; i++) {
+        ring_push(RECORD_OPEN, open_connections[i].connection, NULL, 0,
+                  open_connections[i].peer_ip, open_connections[i].peer_port);
+    }
+
+    writer_running = true;
+    if (pthread_create(&writer_thread, NULL, capture_writer_thread, NULL) != 0) {
+        writer_running = false;
+        fclose(out);
+        out = NULL;
+        pthread_mutex_unlock(&capture_mutex);
+        LOG_ERROR("Failed to create APDU capture thread");
+        return false;
+    }
+    writer_started = true;
+
+    __atomic_store_n(&capture_enabled, true, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&capture_mutex);
+
+    LOG_INFO("APDU capture started: %s (limit %llu bytes)", file, (unsigned long long)max_bytes);
+    return true;
+}
+
+void apdu_capture_stop(void) {
+    pthread_mutex_lock(&capture_mutex);
+
+    bool was_enabled = __atomic_exchange_n(&capture_enabled, false, __ATOMIC_ACQ_REL);
+    join_writer();
+
+    pthread_mutex_unlock(&capture_mutex);
+
+    if (was_enabled) {
+        LOG_INFO("APDU capture stopped: %s, %llu APDUs, %llu dropped, %llu bytes", file_name,
+                 (unsigned long long)packets, (unsigned long long)dropped,
+                 (unsigned long long)file_bytes);
+    }
+}
+
+void apdu_capture_get_stats(ApduCaptureStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    pthread_mutex_lock(&capture_mutex);
+
+    stats->active = __atomic_load_n(&capture_enabled, __ATOMIC_ACQUIRE);
+    stats->limit_reached = __atomic_load_n(&limit_reached, __ATOMIC_RELAXED);
+    stats->packets = __atomic_load_n(&packets, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&file_bytes, __ATOMIC_RELAXED);
+    stats->max_bytes = max_bytes;
+    stats->connections = __atomic_load_n(&stream_total, __ATOMIC_RELAXED);
+    strncpy(stats->file, file_name, sizeof(stats->file) - 1);
+
+    pthread_mutex_unlock(&capture_mutex);
+}
+
+char* apdu_capture_get_stats_json(void) {
+    ApduCaptureStats stats;
+    apdu_capture_get_stats(&stats);
+
+    cJSON* response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "active", stats.active);
+    cJSON_AddStringToObject(response, "file", stats.file);
+    cJSON_AddNumberToObject(response, "packets", (double)stats.packets);
+    cJSON_AddNumberToObject(response, "dropped", (double)stats.dropped);
+    cJSON_AddNumberToObject(response, "bytes", (double)stats.bytes);
+    cJSON_AddNumberToObject(response, "max_bytes", (double)stats.max_bytes);
+    cJSON_AddNumberToObject(response, "connections", stats.connections);
+    cJSON_AddBoolToObject(response, "limit_reached", stats.limit_reached);
+
+    char* json_str = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+
+    return json_str;
+}
+
+void apdu_capture_raw_message_handler(void* parameter, IMasterConnection connection,
+                                      uint8_t* msg, int msgSize, bool sent) {
+    (void)parameter;
+
+    if (!__atomic_load_n(&capture_enabled, __ATOMIC_ACQUIRE)) return;
+
+    ring_push(sent ? RECORD_TX : RECORD_RX, connection, msg, msgSize, 0, 0);
+}
+
+void apdu_capture_connection_event(IMasterConnection connection, CS104_PeerConnectionEvent event) {
+    uint32_t ip = 0;
+    uint16_t port = 0;
+
+    if (event == CS104_CON_EVENT_CONNECTION_OPENED) {
+        parse_peer_address(connection, &ip, &port);
+    } else if (event != CS104_CON_EVENT_CONNECTION_CLOSED) {
+        return;
+    }
+
+    pthread_mutex_lock(&capture_mutex);
+
+    if (event == CS104_CON_EVENT_CONNECTION_OPENED) {
+        if (open_count == open_capacity) {
+            int new_capacity = open_capacity ? open_capacity * 2 : 16;
+            OpenConnection* new_open = (OpenConnection*)realloc(open_connections,
+                                                                new_capacity * sizeof(OpenConnection));
+            if (new_open) {
+                open_connections = new_open;
+                open_capacity = new_capacity;
+            }
+        }
+        if (open_count < open_capacity) {
+            open_connections[open_count].connection = connection;
+            open_connections[open_count].peer_ip = ip;
+            open_connections[open_count].peer_port = port;
+            open_count++;
+        }
+    } else {
+        for (int i = 0; i < open_count; i++) {
+            if (open_connections[i].connection == connection) {
+                open_connections[i] = open_connections[--open_count];
+                break;
+            }
+        }
+    }
+
+    // Under the mutex so a starting capture sees every connection exactly once
+    if (__atomic_load_n(&capture_enabled, __ATOMIC_ACQUIRE)) {
+        ring_push(event == CS104_CON_EVENT_CONNECTION_OPENED ? RECORD_OPEN : RECORD_CLOSE,
+                  connection, NULL, 0, ip, port);
+    }
+
+    pthread_mutex_unlock(&capture_mutex);
+}
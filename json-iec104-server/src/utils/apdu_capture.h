@@ -0,0 +1,106 @@
+#ifndef APDU_CAPTURE_H
+#define APDU_CAPTURE_H
+
+#include "cs104_slave.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * APDU Capture Module
+ *
+ * Records the raw APDUs of all master connections into a pcap file that
+ * Wireshark decodes with its IEC 104 dissector, for sites where tcpdump is
+ * not available.
+ *
+ * The raw message handler only copies the APDU with a timestamp and the
+ * connection into a bounded lock-free ring (multi-producer, single
+ * consumer). A writer thread drains the ring and wraps every APDU in
+ * synthetic IPv4/TCP headers; each connection becomes its own TCP stream
+ * with the real peer address and port, starting with a handshake and
+ * ending with a FIN. When the ring is full APDUs are dropped and counted,
+ * the protocol threads are never blocked.
+ *
+ * Capture is switched on and off at runtime and stops by itself when the
+ * file reaches its size limit.
+ */
+
+// Ring capacity in APDUs (power of two)
+#define APDU_CAPTURE_RING_SLOTS 8192
+// Bytes kept per APDU (the largest APDU is 255 bytes)
+#define APDU_CAPTURE_SNAPLEN 256
+// Default file size limit
+#define APDU_CAPTURE_DEFAULT_MAX_BYTES (64ULL * 1024 * 1024)
+
+/**
+ * Capture statistics
+ */
+typedef struct {
+    bool active;                // Capture running
+    bool limit_reached;         // Last capture stopped at its size limit
+    uint64_t packets;           // APDUs written to the file
+    uint64_t dropped;           // APDUs lost because the ring was full
+    uint64_t bytes;             // Current file size
+    uint64_t max_bytes;         // File size limit
+    int connections;            // TCP streams in the file
+    char file[256];
+} ApduCaptureStats;
+
+/**
+ * Initialize the capture module
+ *
+ * @param server_ip Local address used as the server side of the TCP streams
+ * @param server_port Local port used as the server side of the TCP streams
+ */
+void apdu_capture_init(const char* server_ip, int server_port);
+
+/**
+ * Stop a running capture and release the ring
+ * Must be called after the slave has been stopped.
+ */
+void apdu_capture_cleanup(void);
+
+/**
+ * Start capturing into a new pcap file (truncated if it exists)
+ *
+ * @param file Output file
+ * @param max_bytes File size limit (0 = APDU_CAPTURE_DEFAULT_MAX_BYTES)
+ * @return true if the capture was started, false if already running or on error
+ */
+bool apdu_capture_start(const char* file, uint64_t max_bytes);
+
+/**
+ * Stop the capture, write the remaining APDUs and close the file
+ */
+void apdu_capture_stop(void);
+
+/**
+ * Get capture statistics
+ *
+ * @param stats Output statistics
+ */
+void apdu_capture_get_stats(ApduCaptureStats* stats);
+
+/**
+ * Get JSON string with capture statistics
+ * Returns allocated string that must be freed by caller
+ *
+ * @return JSON string like: {"active":true,"file":"x.pcap","packets":10,...}
+ */
+char* apdu_capture_get_stats_json(void);
+
+/**
+ * Raw message handler for CS104_Slave_setRawMessageHandler
+ * Costs one atomic load while no capture is running.
+ */
+void apdu_capture_raw_message_handler(void* parameter, IMasterConnection connection,
+                                      uint8_t* msg, int msgSize, bool sent);
+
+/**
+ * Track connection open/close, must be called from the connection event handler
+ *
+ * @param connection The client connection
+ * @param event Connection event type
+ */
+void apdu_capture_connection_event(IMasterConnection connection, CS104_PeerConnectionEvent event);
+
+#endif // APDU_CAPTURE_H
@@ -0,0 +1,352 @@
+#include "event_output.h"
+#include "logger.h"
+#include "utils.h"
+#include "../threads/thread_policy.h"
+#include "../../cJSON/cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Wait of the writer for a full pipe between checks of the abort flag
+#define WRITER_POLL_MS 100
+
+// Ring of event lines, byte positions only grow (protected by ring_mutex)
+static pthread_mutex_t ring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ring_cond = PTHREAD_COND_INITIALIZER;
+static char* ring = NULL;
+static uint64_t ring_head = 0;
+static uint64_t ring_tail = 0;
+static uint64_t next_seq = 0;
+static uint64_t events = 0;
+static uint64_t dropped = 0;
+static bool writer_running = false;
+static bool writer_exited = false;
+static bool writer_abort = false;
+
+// Read without the lock by emitters to choose stdout
+static bool channel_open = false;
+
+// Writer state
+static pthread_t writer_thread;
+static int out_fd = -1;
+static bool own_fd = false;
+static char target_name[256] = "";
+static uint64_t writes = 0;
+static uint64_t bytes = 0;
+static uint64_t write_errors = 0;
+static char batch[EVENT_OUTPUT_BATCH_BYTES];
+
+/**
+ * Write a batch, retrying partial writes
+ *
+ * The descriptor is non-blocking: while the consumer does not read, the
+ * writer waits in short polls so that event_output_close() can abort it.
+ */
+static bool write_batch(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(out_fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (__atomic_load_n(&writer_abort, __ATOMIC_ACQUIRE)) {
+                    errno = ETIMEDOUT;
+                    return false;
+                }
+                struct pollfd pfd = { out_fd, POLLOUT, 0 };
+                poll(&pfd, 1, WRITER_POLL_MS);
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Writer thread
+ *
+ * Takes everything queued since its last write (up to one batch) and writes
+ * it with a single call. While it writes, new events collect in the ring
+ * and go out together with the next call.
+ */
+static void* event_writer_thread(void* arg) {
+    (void)arg;
+    thread_policy_apply(THREAD_CLASS_OUTPUT);
+
+    bool warned = false;
+
+    pthread_mutex_lock(&ring_mutex);
+
+    for (;;) {
+        while (ring_head == ring_tail && writer_running) {
+            pthread_cond_wait(&ring_cond, &ring_mutex);
+        }
+        if (ring_head == ring_tail) break;  // Stopping and drained
+        if (__atomic_load_n(&writer_abort, __ATOMIC_ACQUIRE)) {
+            LOG_WARN("Event output %s not read, %llu bytes discarded", target_name,
+                     (unsigned long long)(ring_head - ring_tail));
+            ring_tail = ring_head;
+            break;
+        }
+
+        size_t len = (size_t)(ring_head - ring_tail);
+        if (len > EVENT_OUTPUT_BATCH_BYTES) len = EVENT_OUTPUT_BATCH_BYTES;
+
+        size_t pos = (size_t)(ring_tail % EVENT_OUTPUT_RING_BYTES);
+        size_t first = EVENT_OUTPUT_RING_BYTES - pos;
+        if (first > len) first = len;
+        memcpy(batch, ring + pos, first);
+        memcpy(batch + first, ring, len - first);
+        ring_tail += len;
+
+        pthread_mutex_unlock(&ring_mutex);
+
+        if (write_batch(batch, len)) {
+            __atomic_fetch_add(&writes, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&bytes, len, __ATOMIC_RELAXED);
+        } else {
+            __atomic_fetch_add(&write_errors, 1, __ATOMIC_RELAXED);
+            if (!warned) {
+                LOG_WARN("Failed to write events to %s: %s", target_name, strerror(errno));
+                warned = true;
+            }
+        }
+
+        pthread_mutex_lock(&ring_mutex);
+    }
+
+    pthread_mutex_unlock(&ring_mutex);
+    __atomic_store_n(&writer_exited, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// "fd:N", or a FIFO or file path, opened non-blocking
+static int open_target(const char* target, bool* owned) {
+    if (strncmp(target, "fd:", 3) == 0) {
+        char* end = NULL;
+        long fd = strtol(target + 3, &end, 10);
+        int flags = -1;
+        if (end != target + 3 && *end == '\0' && fd >= 0 && fd <= 65535) {
+            flags = fcntl((int)fd, F_GETFL);
+        }
+        if (flags < 0 || fcntl((int)fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            LOG_ERROR("Invalid event output descriptor %s", target);
+            return -1;
+        }
+        *owned = false;
+        return (int)fd;
+    }
+
+    // Holding the read side of a FIFO keeps open() and write() from failing
+    // while no consumer is attached; events wait in the pipe until one is
+    struct stat st;
+    bool fifo = stat(target, &st) == 0 && S_ISFIFO(st.st_mode);
+    int fd = fifo ? open(target, O_RDWR | O_NONBLOCK | O_CLOEXEC)
+                  : open(target, O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open event output %s: %s", target, strerror(errno));
+        return -1;
+    }
+    *owned = true;
+    return fd;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+bool event_output_open(const char* target) {
+    if (!target || target[0] == '\0') {
+        LOG_ERROR("Event output target missing");
+        return false;
+    }
+
+    pthread_mutex_lock(&ring_mutex);
+    bool busy = ring != NULL;
+    pthread_mutex_unlock(&ring_mutex);
+    if (busy) {
+        LOG_WARN("Event output already open: %s", target_name);
+        return false;
+    }
+
+    bool owned = false;
+    int fd = open_target(target, &owned);
+    if (fd < 0) {
+        return false;
+    }
+
+    char* buffer = (char*)malloc(EVENT_OUTPUT_RING_BYTES);
+    if (!buffer) {
+        LOG_ERROR("Failed to allocate event output ring");
+        if (owned) close(fd);
+        return false;
+    }
+
+    pthread_mutex_lock(&ring_mutex);
+    ring = buffer;
+    ring_head = ring_tail = 0;
+    next_seq = 0;
+    events = dropped = 0;
+    writes = bytes = write_errors = 0;
+    out_fd = fd;
+    own_fd = owned;
+    strncpy(target_name, target, sizeof(target_name) - 1);
+    target_name[sizeof(target_name) - 1] = '\0';
+    writer_running = true;
+    writer_exited = false;
+    writer_abort = false;
+
+    if (pthread_create(&writer_thread, NULL, event_writer_thread, NULL) != 0) {
+        writer_running = false;
+        ring = NULL;
+        out_fd = -1;
+        pthread_mutex_unlock(&ring_mutex);
+        free(buffer);
+        if (owned) close(fd);
+        LOG_ERROR("Failed to create event output thread");
+        return false;
+    }
+
+    __atomic_store_n(&channel_open, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&ring_mutex);
+
+    LOG_INFO("Event output: %s", target);
+    return true;
+}
+
+void event_output_close(void) {
+    pthread_mutex_lock(&ring_mutex);
+    if (!ring) {
+        pthread_mutex_unlock(&ring_mutex);
+        return;
+    }
+    __atomic_store_n(&channel_open, false, __ATOMIC_RELEASE);
+    writer_running = false;
+    pthread_cond_signal(&ring_cond);
+    pthread_mutex_unlock(&ring_mutex);
+
+    // The writer drains the ring before it exits; what a stalled consumer
+    // has not taken by the deadline is discarded
+    uint64_t deadline = utils_monotonic_ms() + EVENT_OUTPUT_CLOSE_MS;
+    while (!__atomic_load_n(&writer_exited, __ATOMIC_ACQUIRE) && utils_monotonic_ms() < deadline) {
+        usleep(1000);
+    }
+    __atomic_store_n(&writer_abort, true, __ATOMIC_RELEASE);
+    pthread_join(writer_thread, NULL);
+
+    pthread_mutex_lock(&ring_mutex);
+    free(ring);
+    ring = NULL;
+    if (own_fd) close(out_fd);
+    out_fd = -1;
+    pthread_mutex_unlock(&ring_mutex);
+
+    LOG_INFO("Event output closed: %s, %llu events, %llu dropped, %llu writes",
+             target_name, (unsigned long long)events, (unsigned long long)dropped,
+             (unsigned long long)writes);
+}
+
+bool event_output_emit(const char* format, ...) {
+    char fields[EVENT_OUTPUT_MAX_EVENT];
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(fields, sizeof(fields), format, args);
+    va_end(args);
+
+    if (len < 0) {
+        return false;
+    }
+
+    if (!__atomic_load_n(&channel_open, __ATOMIC_ACQUIRE)) {
+        printf("{%s}\n", fields);
+        return fflush(stdout) == 0;
+    }
+
+    char line[EVENT_OUTPUT_MAX_EVENT + 32];
+
+    pthread_mutex_lock(&ring_mutex);
+
+    if (!ring || !writer_running) {
+        // Closed since the check above
+        pthread_mutex_unlock(&ring_mutex);
+        printf("{%s}\n", fields);
+        return fflush(stdout) == 0;
+    }
+
+    // Numbered in ring order, so the consumer reads them ascending
+    uint64_t seq = ++next_seq;
+    int n = (len < (int)sizeof(fields))
+            ? snprintf(line, sizeof(line), "{\"seq\":%llu,%s}\n", (unsigned long long)seq, fields)
+            : -1;
+
+    if (n < 0 || n >= (int)sizeof(line) || ring_head - ring_tail + (uint64_t)n > EVENT_OUTPUT_RING_BYTES) {
+        dropped++;
+        pthread_mutex_unlock(&ring_mutex);
+        return false;
+    }
+
+    bool was_empty = ring_head == ring_tail;
+
+    size_t pos = (size_t)(ring_head % EVENT_OUTPUT_RING_BYTES);
+    size_t first = EVENT_OUTPUT_RING_BYTES - pos;
+    if (first > (size_t)n) first = (size_t)n;
+    memcpy(ring + pos, line, first);
+    memcpy(ring, line + first, (size_t)n - first);
+    ring_head += (uint64_t)n;
+    events++;
+
+    // The writer only waits on an empty ring
+    if (was_empty) {
+        pthread_cond_signal(&ring_cond);
+    }
+
+    pthread_mutex_unlock(&ring_mutex);
+    return true;
+}
+
+void event_output_get_stats(EventOutputStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    pthread_mutex_lock(&ring_mutex);
+
+    stats->active = ring != NULL;
+    stats->events = events;
+    stats->dropped = dropped;
+    stats->last_seq = next_seq;
+    stats->writes = __atomic_load_n(&writes, __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&bytes, __ATOMIC_RELAXED);
+    stats->write_errors = __atomic_load_n(&write_errors, __ATOMIC_RELAXED);
+    strncpy(stats->target, target_name, sizeof(stats->target) - 1);
+
+    pthread_mutex_unlock(&ring_mutex);
+}
+
+char* event_output_get_stats_json(void) {
+    EventOutputStats stats;
+    event_output_get_stats(&stats);
+
+    cJSON* response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "active", stats.active);
+    cJSON_AddStringToObject(response, "target", stats.target);
+    cJSON_AddNumberToObject(response, "events", (double)stats.events);
+    cJSON_AddNumberToObject(response, "dropped", (double)stats.dropped);
+    cJSON_AddNumberToObject(response, "writes", (double)stats.writes);
+    cJSON_AddNumberToObject(response, "bytes", (double)stats.bytes);
+    cJSON_AddNumberToObject(response, "write_errors", (double)stats.write_errors);
+    cJSON_AddNumberToObject(response, "last_seq", (double)stats.last_seq);
+
+    char* json_str = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+
+    return json_str;
+}
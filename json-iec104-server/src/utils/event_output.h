@@ -0,0 +1,95 @@
+#ifndef EVENT_OUTPUT_H
+#define EVENT_OUTPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Event Output Module
+ *
+ * Channel for the events the external process acts on: commands (C_SC_NA_1,
+ * C_SE_NC_1, C_RP_NA_1), their errors and timeouts, and clock syncs.
+ *
+ * Without a channel the events are printed on stdout as before, mixed with
+ * the JSON log. With "event_output" set they go to a separate file
+ * descriptor ("fd:3"), a FIFO or a file, one JSON object per line with a
+ * sequence number:
+ *
+ *   {"seq":17,"type":"C_SC_NA_1","action":"execute",...}
+ *
+ * Protocol threads only copy the line into a bounded ring; a writer thread
+ * drains everything that accumulated with one write, so a command burst
+ * costs a few system calls instead of a flush per line. When the ring is
+ * full the event is dropped and counted; its sequence number is skipped, so
+ * the consumer sees the gap. The protocol threads never block on a slow
+ * consumer.
+ */
+
+// Ring capacity in bytes
+#define EVENT_OUTPUT_RING_BYTES (1024 * 1024)
+// Longest event line
+#define EVENT_OUTPUT_MAX_EVENT 512
+// Most bytes written with one system call
+#define EVENT_OUTPUT_BATCH_BYTES (64 * 1024)
+// Time event_output_close() gives the consumer to take the queued events
+#define EVENT_OUTPUT_CLOSE_MS 1000
+
+/**
+ * Channel statistics
+ */
+typedef struct {
+    bool active;                // Channel open
+    uint64_t events;            // Events queued for the channel
+    uint64_t dropped;           // Events lost because the ring was full or too long
+    uint64_t writes;            // System calls that wrote events
+    uint64_t bytes;             // Bytes written
+    uint64_t write_errors;      // Failed writes (their events are lost)
+    uint64_t last_seq;          // Sequence number of the last event
+    char target[256];
+} EventOutputStats;
+
+/**
+ * Open the event channel and start its writer thread
+ *
+ * @param target "fd:N" for an inherited descriptor (switched to
+ *               non-blocking), or the path of a FIFO (opened read-write, so
+ *               the server does not wait for the consumer) or of a file
+ *               (appended)
+ * @return true if the channel was opened, false if already open or on error
+ */
+bool event_output_open(const char* target);
+
+/**
+ * Write the queued events, stop the writer and close the channel
+ * Events the consumer has not read within EVENT_OUTPUT_CLOSE_MS are
+ * discarded, so a stalled consumer cannot hold up shutdown. Later events
+ * are printed on stdout again.
+ */
+void event_output_close(void);
+
+/**
+ * Emit one event
+ *
+ * @param format printf format of the members of the JSON object, without
+ *               braces, e.g. "\"type\":\"C_RP_NA_1\",\"qrp\":%d"
+ * @return false if the event was dropped (ring full, too long) and will
+ *         never reach the consumer
+ */
+bool event_output_emit(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * Get channel statistics
+ *
+ * @param stats Output statistics
+ */
+void event_output_get_stats(EventOutputStats* stats);
+
+/**
+ * Get JSON string with channel statistics
+ * Returns allocated string that must be freed by caller
+ *
+ * @return JSON string like: {"active":true,"target":"fd:3","events":10,...}
+ */
+char* event_output_get_stats_json(void);
+
+#endif // EVENT_OUTPUT_H
@@ -0,0 +1,28 @@
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <stdint.h>
+
+/**
+ * Monotonic clock in milliseconds
+ *
+ * Deadlines, rate limits and durations use it, so a clock sync that steps
+ * the wall clock does not shorten or extend them.
+ * @return Milliseconds since an unspecified start (CLOCK_MONOTONIC)
+ */
+uint64_t utils_monotonic_ms(void);
+
+/**
+ * Monotonic clock in microseconds, for measuring short durations
+ * @return Microseconds since an unspecified start (CLOCK_MONOTONIC)
+ */
+uint64_t utils_monotonic_us(void);
+
+/**
+ * Smallest power of two >= n (1 for n <= 1), for tables indexed with a mask
+ * @param n Requested size (at most 2^31)
+ * @return Power of two
+ */
+uint32_t utils_next_pow2(uint32_t n);
+
+#endif // UTILS_H
@@ -0,0 +1,505 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "cs104_slave.h"
+
+/**
+ * Acknowledgement policy and k/w window benchmark
+ *
+ * 1. Window-bound link: the slave streams queued spontaneous data to a master
+ *    through an in-process delay shim (a TCP proxy that holds every chunk for a
+ *    fixed one-way delay, so no tc/netem is needed). With the default k = 12 the
+ *    throughput is limited to about k frames per round trip; a larger k removes
+ *    the limit. The k-window stall statistics must show the difference.
+ *
+ * 2. Ack overhead: the master sends commands in bursts of w, and the slave answers
+ *    each one with return information from the event queue. The immediate policy
+ *    sends an S-frame after every burst although I-frames follow right after; the
+ *    delayed policy lets the I-frames carry the confirmation.
+ */
+
+#define SLAVE_PORT 22472
+#define SHIM_PORT 22473
+#define ONE_WAY_DELAY_MS 25
+#define STREAM_FRAMES 600
+#define COMMANDS 400
+#define BURST 8
+#define TIMEOUT_MS 30000
+
+static const unsigned char STARTDT_ACT[] = { 0x68, 0x04, 0x07, 0x00, 0x00, 0x00 };
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void write_all(int fd, const unsigned char* data, int len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("write");
+            assert(false);
+        }
+        data += n;
+        len -= (int)n;
+    }
+}
+
+static int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+// ---------------------------------------------------------------------------
+// Delay shim: forwards one connection, holding each chunk for delay_ms
+// ---------------------------------------------------------------------------
+
+typedef struct Chunk {
+    uint64_t due;
+    int len;
+    int pos;
+    struct Chunk* next;
+    unsigned char data[4096];
+} Chunk;
+
+typedef struct {
+    Chunk* head;
+    Chunk* tail;
+} ChunkQueue;
+
+typedef struct {
+    int listen_fd;
+    int delay_ms;
+    pthread_t thread;
+} DelayShim;
+
+static bool shim_read(int from, ChunkQueue* q, int delay_ms) {
+    Chunk* c = (Chunk*)malloc(sizeof(Chunk));
+    assert(c != NULL);
+
+    ssize_t n = read(from, c->data, sizeof(c->data));
+    if (n <= 0) {
+        free(c);
+        return false;
+    }
+
+    c->len = (int)n;
+    c->pos = 0;
+    c->due = now_ms() + delay_ms;
+    c->next = NULL;
+
+    if (q->tail) q->tail->next = c;
+    else q->head = c;
+    q->tail = c;
+    return true;
+}
+
+static void shim_flush(int to, ChunkQueue* q, uint64_t now) {
+    while (q->head && q->head->due <= now) {
+        Chunk* c = q->head;
+        write_all(to, c->data, c->len);
+        q->head = c->next;
+        if (!q->head) q->tail = NULL;
+        free(c);
+    }
+}
+
+static void shim_free(ChunkQueue* q) {
+    while (q->head) {
+        Chunk* c = q->head;
+        q->head = c->next;
+        free(c);
+    }
+    q->tail = NULL;
+}
+
+static void* shim_thread(void* arg) {
+    DelayShim* shim = (DelayShim*)arg;
+
+    int client = accept(shim->listen_fd, NULL, NULL);
+    assert(client >= 0);
+    int server = connect_to(SLAVE_PORT);
+
+    int one = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    ChunkQueue to_server = { NULL, NULL };
+    ChunkQueue to_client = { NULL, NULL };
+
+    for (;;) {
+        uint64_t now = now_ms();
+        shim_flush(server, &to_server, now);
+        shim_flush(client, &to_client, now);
+
+        int timeout = 100;
+        if (to_server.head && (int)(to_server.head->due - now) < timeout) timeout = (int)(to_server.head->due - now);
+        if (to_client.head && (int)(to_client.head->due - now) < timeout) timeout = (int)(to_client.head->due - now);
+        if (timeout < 0) timeout = 0;
+
+        struct pollfd fds[2] = { { client, POLLIN, 0 }, { server, POLLIN, 0 } };
+        if (poll(fds, 2, timeout) < 0) continue;
+
+        if ((fds[0].revents & (POLLIN | POLLHUP)) && !shim_read(client, &to_server, shim->delay_ms)) break;
+        if ((fds[1].revents & (POLLIN | POLLHUP)) && !shim_read(server, &to_client, shim->delay_ms)) break;
+    }
+
+    shim_free(&to_server);
+    shim_free(&to_client);
+    close(client);
+    close(server);
+    return NULL;
+}
+
+static void shim_start(DelayShim* shim, int delay_ms) {
+    shim->delay_ms = delay_ms;
+    shim->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(shim->listen_fd >= 0);
+
+    int one = 1;
+    setsockopt(shim->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(SHIM_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    assert(bind(shim->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    assert(listen(shim->listen_fd, 1) == 0);
+    assert(pthread_create(&shim->thread, NULL, shim_thread, shim) == 0);
+}
+
+static void shim_stop(DelayShim* shim) {
+    pthread_join(shim->thread, NULL);
+    close(shim->listen_fd);
+}
+
+// ---------------------------------------------------------------------------
+// Minimal master
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int fd;
+    unsigned char buf[65536];
+    int len;
+    int received_i;         // I-frames received (= N(R) for the slave)
+    int sent_i;             // I-frames sent (= N(S))
+    int received_s;         // S-frames received
+    int acked_i;            // N(R) of the last S-frame sent
+} Master;
+
+static void master_send_s(Master* m) {
+    unsigned char s[] = { 0x68, 0x04, 0x01, 0x00,
+                          (unsigned char)((m->received_i & 0x7f) << 1), (unsigned char)(m->received_i >> 7) };
+    write_all(m->fd, s, sizeof(s));
+    m->acked_i = m->received_i;
+}
+
+/**
+ * Read and count frames until `done` frames are received or the timeout expires
+ * The master confirms every ack_every I-frames with an S-frame (0 = never).
+ */
+static void master_receive(Master* m, int done, int ack_every, uint64_t deadline) {
+    while (m->received_i < done && now_ms() < deadline) {
+        struct pollfd pfd = { m->fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) continue;
+
+        ssize_t n = read(m->fd, m->buf + m->len, sizeof(m->buf) - m->len);
+        assert(n > 0);
+        m->len += (int)n;
+
+        int pos = 0;
+        while (m->len - pos >= 2 && m->len - pos >= m->buf[pos + 1] + 2) {
+            const unsigned char* apdu = m->buf + pos;
+
+            if ((apdu[2] & 0x01) == 0) {
+                m->received_i++;
+                if (ack_every > 0 && m->received_i - m->acked_i >= ack_every) {
+                    master_send_s(m);
+                }
+            } else if ((apdu[2] & 0x03) == 0x01) {
+                m->received_s++;
+            }
+            pos += apdu[1] + 2;
+        }
+        memmove(m->buf, m->buf + pos, m->len - pos);
+        m->len -= pos;
+    }
+}
+
+static void master_start(Master* m, int port) {
+    memset(m, 0, sizeof(*m));
+    m->fd = connect_to(port);
+    write_all(m->fd, STARTDT_ACT, sizeof(STARTDT_ACT));
+
+    // STARTDT_CON
+    unsigned char con[6];
+    int got = 0;
+    while (got < 6) {
+        ssize_t n = read(m->fd, con + got, 6 - got);
+        assert(n > 0);
+        got += (int)n;
+    }
+    assert(con[2] == 0x0b);
+}
+
+// ---------------------------------------------------------------------------
+// Slave
+// ---------------------------------------------------------------------------
+
+static IMasterConnection last_connection = NULL;
+
+static void connection_handler(void* parameter, IMasterConnection connection, CS104_PeerConnectionEvent event) {
+    (void)parameter;
+    if (event == CS104_CON_EVENT_CONNECTION_OPENED) {
+        last_connection = connection;
+    }
+}
+
+// Commands are answered with return information through the event queue
+static bool asdu_handler(void* parameter, IMasterConnection connection, CS101_ASDU asdu) {
+    (void)connection;
+    CS104_Slave slave = (CS104_Slave)parameter;
+
+    // Interrogation is accepted without a response, only the confirmation comes back
+    if (CS101_ASDU_getTypeID(asdu) == C_IC_NA_1) return true;
+    if (CS101_ASDU_getTypeID(asdu) != C_SC_NA_1) return false;
+
+    CS101_ASDU response = CS101_ASDU_create(CS104_Slave_getAppLayerParameters(slave), false,
+                                            CS101_COT_RETURN_INFO_REMOTE, 0, 1, false, false);
+    InformationObject io = (InformationObject)SinglePointInformation_create(NULL, 100, true, IEC60870_QUALITY_GOOD);
+    CS101_ASDU_addInformationObject(response, io);
+    InformationObject_destroy(io);
+
+    CS104_Slave_enqueueASDU(slave, response);
+    CS101_ASDU_destroy(response);
+    return true;
+}
+
+static CS104_Slave create_slave(int k, int w, CS104_AckPolicy policy, int ack_delay_ms, int reactor_threads) {
+    CS104_Slave slave = CS104_Slave_create(1000, 100);
+    assert(slave != NULL);
+
+    CS104_Slave_setLocalAddress(slave, "127.0.0.1");
+    CS104_Slave_setLocalPort(slave, SLAVE_PORT);
+    CS104_Slave_setServerMode(slave, CS104_MODE_SINGLE_REDUNDANCY_GROUP);
+    CS104_Slave_setConnectionEventHandler(slave, connection_handler, NULL);
+    CS104_Slave_setASDUHandler(slave, asdu_handler, slave);
+
+    CS104_APCIParameters apci = CS104_Slave_getConnectionParameters(slave);
+    apci->k = k;
+    apci->w = w;
+
+    CS104_Slave_setAckPolicy(slave, policy, ack_delay_ms);
+
+    if (reactor_threads > 0) {
+        assert(CS104_Slave_setReactorThreads(slave, reactor_threads, false));
+    }
+
+    last_connection = NULL;
+    return slave;
+}
+
+/**
+ * Stream STREAM_FRAMES queued ASDUs through the delay shim
+ * @return elapsed milliseconds
+ */
+static uint64_t run_stream(int k, int w, CS104_ConnectionStatistics* stats) {
+    CS104_Slave slave = create_slave(k, w, CS104_ACK_POLICY_IMMEDIATE, 0, 0);
+    CS101_AppLayerParameters al = CS104_Slave_getAppLayerParameters(slave);
+
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    for (int i = 0; i < STREAM_FRAMES; i++) {
+        CS101_ASDU asdu = CS101_ASDU_create(al, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+        InformationObject io = (InformationObject)MeasuredValueShort_create(NULL, 1000 + i, (float)i, IEC60870_QUALITY_GOOD);
+        CS101_ASDU_addInformationObject(asdu, io);
+        InformationObject_destroy(io);
+        CS104_Slave_enqueueASDU(slave, asdu);
+        CS101_ASDU_destroy(asdu);
+    }
+
+    DelayShim shim;
+    shim_start(&shim, ONE_WAY_DELAY_MS);
+
+    Master m;
+    uint64_t start = now_ms();
+    master_start(&m, SHIM_PORT);
+    master_receive(&m, STREAM_FRAMES, BURST, start + TIMEOUT_MS);
+    uint64_t elapsed = now_ms() - start;
+
+    assert(m.received_i == STREAM_FRAMES);
+
+    // Last confirmation, then read the statistics once it has arrived
+    master_send_s(&m);
+    usleep((ONE_WAY_DELAY_MS + 50) * 1000);
+
+    assert(last_connection != NULL);
+    CS104_Slave_getConnectionStatistics(slave, last_connection, stats);
+
+    close(m.fd);
+    shim_stop(&shim);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    return elapsed;
+}
+
+void test_window_bound_link() {
+    printf("\nTesting %d spontaneous ASDUs over a %d ms RTT link...\n", STREAM_FRAMES, 2 * ONE_WAY_DELAY_MS);
+
+    CS104_ConnectionStatistics small, large;
+
+    uint64_t small_ms = run_stream(12, 8, &small);
+    printf("  k=12 w=8:  %4llu ms, %6.0f I/s, k-window full %llu times for %llu ms\n",
+           (unsigned long long)small_ms, STREAM_FRAMES * 1000.0 / small_ms,
+           (unsigned long long)small.kWindowStalls, (unsigned long long)small.kWindowStallMs);
+
+    uint64_t large_ms = run_stream(128, 85, &large);
+    printf("  k=128 w=85: %4llu ms, %6.0f I/s, k-window full %llu times for %llu ms\n",
+           (unsigned long long)large_ms, STREAM_FRAMES * 1000.0 / large_ms,
+           (unsigned long long)large.kWindowStalls, (unsigned long long)large.kWindowStallMs);
+
+    assert(small.iFramesSent == STREAM_FRAMES && large.iFramesSent == STREAM_FRAMES);
+    assert(small.kWindowStalls > 0);
+    assert(small.kWindowStallMs > large.kWindowStallMs);
+    assert(small.kWindowHighWaterMark == 12);
+    assert(large_ms * 3 < small_ms);
+
+    printf("  ✓ Larger k removes the window limit (%.1fx throughput)\n", (double)small_ms / large_ms);
+}
+
+/**
+ * Send COMMANDS commands in bursts of BURST, each answered by one I-frame
+ * @return S-frames received by the master
+ */
+static int run_commands(CS104_AckPolicy policy, int reactor_threads, CS104_ConnectionStatistics* stats) {
+    CS104_Slave slave = create_slave(12, BURST, policy, 100, reactor_threads);
+
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    Master m;
+    master_start(&m, SLAVE_PORT);
+
+    uint64_t deadline = now_ms() + TIMEOUT_MS;
+
+    for (int b = 0; b < COMMANDS / BURST; b++) {
+        unsigned char burst[BURST * 16];
+
+        for (int i = 0; i < BURST; i++) {
+            // C_SC_NA_1, COT=ACT, CA=1, IOA=5000, SCO=ON; N(R) confirms the slave's I-frames
+            unsigned char cmd[] = {
+                0x68, 0x0e,
+                (unsigned char)((m.sent_i & 0x7f) << 1), (unsigned char)(m.sent_i >> 7),
+                (unsigned char)((m.received_i & 0x7f) << 1), (unsigned char)(m.received_i >> 7),
+                0x2d, 0x01, 0x06, 0x00, 0x01, 0x00, 0x88, 0x13, 0x00, 0x01
+            };
+            memcpy(burst + i * 16, cmd, 16);
+            m.sent_i++;
+        }
+        m.acked_i = m.received_i;
+
+        write_all(m.fd, burst, sizeof(burst));
+        master_receive(&m, (b + 1) * BURST, 0, deadline);
+        assert(m.received_i == (b + 1) * BURST);
+    }
+
+    // Let a pending delayed confirmation expire, it must still arrive
+    unsigned char trailing[] = {
+        0x68, 0x0e, (unsigned char)((m.sent_i & 0x7f) << 1), (unsigned char)(m.sent_i >> 7),
+        (unsigned char)((m.received_i & 0x7f) << 1), (unsigned char)(m.received_i >> 7),
+        0x64, 0x01, 0x06, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x14
+    };
+    int before = m.received_s;
+    for (int i = 0; i < BURST; i++) {
+        write_all(m.fd, trailing, sizeof(trailing));
+        m.sent_i++;
+        trailing[2] = (unsigned char)((m.sent_i & 0x7f) << 1);
+        trailing[3] = (unsigned char)(m.sent_i >> 7);
+    }
+
+    deadline = now_ms() + 2000;
+    while (m.received_s == before && now_ms() < deadline) {
+        struct pollfd pfd = { m.fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t n = read(m.fd, m.buf, sizeof(m.buf));
+        assert(n > 0);
+        for (int pos = 0; pos + 6 <= n; pos += m.buf[pos + 1] + 2) {
+            if ((m.buf[pos + 2] & 0x03) == 0x01) m.received_s++;
+        }
+    }
+    assert(m.received_s > before);
+    int s_frames = before;
+
+    assert(last_connection != NULL);
+    CS104_Slave_getConnectionStatistics(slave, last_connection, stats);
+
+    close(m.fd);
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    return s_frames;
+}
+
+void test_ack_policy(const char* mode, int reactor_threads) {
+    printf("\nTesting %d commands in bursts of %d (%s)...\n", COMMANDS, BURST, mode);
+
+    CS104_ConnectionStatistics immediate, delayed;
+
+    int immediate_s = run_commands(CS104_ACK_POLICY_IMMEDIATE, reactor_threads, &immediate);
+    int delayed_s = run_commands(CS104_ACK_POLICY_DELAYED, reactor_threads, &delayed);
+
+    printf("  immediate: %3d S-frames, %llu confirmations on I-frames\n",
+           immediate_s, (unsigned long long)immediate.acksPiggybacked);
+    printf("  delayed:   %3d S-frames, %llu confirmations on I-frames\n",
+           delayed_s, (unsigned long long)delayed.acksPiggybacked);
+
+    assert(immediate_s >= COMMANDS / BURST / 2);
+    assert(delayed_s * 4 <= immediate_s);
+    assert(delayed.acksPiggybacked > immediate.acksPiggybacked);
+
+    printf("  ✓ Delayed policy lets the responses carry the confirmation\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running ack policy / window test suite\n");
+    printf("===========================================\n");
+
+    test_window_bound_link();
+    test_ack_policy("thread mode", 0);
+    test_ack_policy("reactor mode", 1);
+
+    printf("\n===========================================\n");
+    printf("✓ All ack policy tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
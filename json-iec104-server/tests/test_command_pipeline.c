@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "../src/protocol/command_pipeline.h"
+
+/**
+ * Command pipeline tests
+ *
+ * Holds commands of mock connections and checks the confirmations sent on
+ * success, failure, timeout, a full pipeline and a closed connection. Then
+ * keeps ten thousand commands in flight, completes them in random order
+ * from several threads and compares the cost per command with a nearly
+ * empty pipeline.
+ */
+
+#define RESULT_THREADS 4
+#define MANY_COMMANDS 10000
+
+typedef struct {
+    struct sIMasterConnection base;
+    int act_con;                // Positive ACT_CON
+    int act_con_negative;
+    int act_term;
+} MockConnection;
+
+static bool mock_send_asdu(IMasterConnection self, CS101_ASDU asdu) {
+    MockConnection* con = (MockConnection*)self;
+
+    if (CS101_ASDU_getCOT(asdu) == CS101_COT_ACTIVATION_CON) {
+        if (CS101_ASDU_isNegative(asdu)) {
+            __atomic_add_fetch(&con->act_con_negative, 1, __ATOMIC_RELAXED);
+        } else {
+            __atomic_add_fetch(&con->act_con, 1, __ATOMIC_RELAXED);
+        }
+    } else if (CS101_ASDU_getCOT(asdu) == CS101_COT_ACTIVATION_TERMINATION) {
+        __atomic_add_fetch(&con->act_term, 1, __ATOMIC_RELAXED);
+    }
+    return true;
+}
+
+static void mock_init(MockConnection* con) {
+    memset(con, 0, sizeof(*con));
+    con->base.sendASDU = mock_send_asdu;
+}
+
+static struct sCS101_AppLayerParameters al_parameters = {
+    .sizeOfTypeId = 1, .sizeOfVSQ = 1, .sizeOfCOT = 2, .originatorAddress = 0,
+    .sizeOfCA = 2, .sizeOfIOA = 3, .maxSizeOfASDU = 249
+};
+
+static CS101_ASDU create_command(int ioa) {
+    CS101_ASDU asdu = CS101_ASDU_create(&al_parameters, false, CS101_COT_ACTIVATION, 0, 1, false, false);
+    InformationObject io = (InformationObject)SingleCommand_create(NULL, ioa, true, false, 0);
+    CS101_ASDU_addInformationObject(asdu, io);
+    InformationObject_destroy(io);
+    return asdu;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void test_result_confirmation() {
+    printf("\nTesting command results...\n");
+
+    MockConnection con;
+    mock_init(&con);
+    assert(command_pipeline_init(16, 5000));
+
+    CS101_ASDU asdu = create_command(100);
+    uint32_t ok_id, fail_id;
+    assert(command_pipeline_submit(&con.base, asdu, &ok_id));
+    assert(command_pipeline_submit(&con.base, asdu, &fail_id));
+    assert(ok_id != fail_id);
+    CS101_ASDU_destroy(asdu);
+
+    // Nothing is confirmed before the result
+    usleep(50 * 1000);
+    assert(con.act_con == 0 && con.act_con_negative == 0);
+
+    assert(command_pipeline_complete(fail_id, false));
+    assert(con.act_con_negative == 1 && con.act_term == 0);
+
+    assert(command_pipeline_complete(ok_id, true));
+    assert(con.act_con == 1 && con.act_term == 1);
+
+    // A result is only accepted once
+    assert(command_pipeline_complete(ok_id, true) == false);
+    assert(command_pipeline_complete(12345, true) == false);
+
+    CommandPipelineStats stats;
+    command_pipeline_get_stats(&stats);
+    assert(stats.pending == 0);
+    assert(stats.submitted == 2);
+    assert(stats.succeeded == 1 && stats.failed == 1);
+    assert(stats.unknown_results == 2);
+
+    command_pipeline_cleanup();
+    printf("  ✓ ACT_CON/ACT_TERM sent on success, negative ACT_CON on failure\n");
+}
+
+void test_timeout() {
+    printf("\nTesting command timeout...\n");
+
+    MockConnection con;
+    mock_init(&con);
+    assert(command_pipeline_init(16, 200));
+
+    CS101_ASDU asdu = create_command(100);
+    uint32_t first, second;
+    assert(command_pipeline_submit(&con.base, asdu, &first));
+    usleep(100 * 1000);
+    assert(command_pipeline_submit(&con.base, asdu, &second));
+    CS101_ASDU_destroy(asdu);
+
+    usleep(150 * 1000);
+    assert(con.act_con_negative == 1);
+    assert(command_pipeline_complete(first, true) == false);
+
+    usleep(150 * 1000);
+    assert(con.act_con_negative == 2);
+    assert(con.act_con == 0 && con.act_term == 0);
+
+    CommandPipelineStats stats;
+    command_pipeline_get_stats(&stats);
+    assert(stats.timed_out == 2 && stats.pending == 0);
+
+    command_pipeline_cleanup();
+    printf("  ✓ negative ACT_CON sent when no result arrives in time\n");
+}
+
+void test_capacity() {
+    printf("\nTesting pipeline capacity...\n");
+
+    MockConnection con;
+    mock_init(&con);
+    assert(command_pipeline_init(4, 5000));
+
+    CS101_ASDU asdu = create_command(100);
+    uint32_t ids[4], id;
+    for (int i = 0; i < 4; i++) {
+        assert(command_pipeline_submit(&con.base, asdu, &ids[i]));
+    }
+    assert(command_pipeline_submit(&con.base, asdu, &id) == false);
+
+    // Completing a newer command behind the oldest one frees a place
+    assert(command_pipeline_complete(ids[2], true));
+    assert(command_pipeline_submit(&con.base, asdu, &id));
+    CS101_ASDU_destroy(asdu);
+
+    CommandPipelineStats stats;
+    command_pipeline_get_stats(&stats);
+    assert(stats.pending == 4);
+    assert(stats.rejected == 1);
+
+    command_pipeline_cleanup();
+    printf("  ✓ capacity limit enforced\n");
+}
+
+void test_connection_closed() {
+    printf("\nTesting connection close...\n");
+
+    MockConnection con_a, con_b;
+    mock_init(&con_a);
+    mock_init(&con_b);
+    assert(command_pipeline_init(64, 5000));
+
+    CS101_ASDU asdu = create_command(100);
+    uint32_t ids_a[10], ids_b[10];
+    for (int i = 0; i < 10; i++) {
+        assert(command_pipeline_submit(&con_a.base, asdu, &ids_a[i]));
+        assert(command_pipeline_submit(&con_b.base, asdu, &ids_b[i]));
+    }
+    CS101_ASDU_destroy(asdu);
+
+    command_pipeline_connection_closed(&con_a.base);
+
+    for (int i = 0; i < 10; i++) {
+        assert(command_pipeline_complete(ids_a[i], true) == false);
+        assert(command_pipeline_complete(ids_b[i], true) == true);
+    }
+    assert(con_a.act_con == 0 && con_a.act_con_negative == 0);
+    assert(con_b.act_con == 10 && con_b.act_term == 10);
+
+    command_pipeline_cleanup();
+    printf("  ✓ commands of a closed connection dropped without confirmation\n");
+}
+
+typedef struct {
+    uint32_t* ids;
+    int count;
+} ResultWork;
+
+static void* result_thread(void* arg) {
+    ResultWork* work = (ResultWork*)arg;
+    for (int i = 0; i < work->count; i++) {
+        assert(command_pipeline_complete(work->ids[i], true));
+    }
+    return NULL;
+}
+
+static void shuffle(uint32_t* ids, int count) {
+    for (int i = count - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        uint32_t tmp = ids[i];
+        ids[i] = ids[j];
+        ids[j] = tmp;
+    }
+}
+
+// Average submit + result time per command with `in_flight` commands pending
+static double command_cost_ns(int in_flight, MockConnection* con) {
+    int rounds = MANY_COMMANDS / in_flight;
+    uint32_t* ids = malloc(sizeof(uint32_t) * in_flight);
+    CS101_ASDU asdu = create_command(100);
+
+    assert(command_pipeline_init(in_flight, 60000));
+
+    double start = now_s();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < in_flight; i++) {
+            assert(command_pipeline_submit(&con->base, asdu, &ids[i]));
+        }
+        shuffle(ids, in_flight);
+        for (int i = 0; i < in_flight; i++) {
+            assert(command_pipeline_complete(ids[i], true));
+        }
+    }
+    double ns = (now_s() - start) * 1e9 / (rounds * in_flight);
+
+    command_pipeline_cleanup();
+    CS101_ASDU_destroy(asdu);
+    free(ids);
+    return ns;
+}
+
+void test_many_in_flight() {
+    printf("\nTesting %d commands in flight...\n", MANY_COMMANDS);
+
+    MockConnection con;
+    mock_init(&con);
+    assert(command_pipeline_init(MANY_COMMANDS, 60000));
+
+    CS101_ASDU asdu = create_command(100);
+    uint32_t* ids = malloc(sizeof(uint32_t) * MANY_COMMANDS);
+    for (int i = 0; i < MANY_COMMANDS; i++) {
+        assert(command_pipeline_submit(&con.base, asdu, &ids[i]));
+    }
+    CS101_ASDU_destroy(asdu);
+
+    // Results arrive in random order from several threads
+    shuffle(ids, MANY_COMMANDS);
+
+    pthread_t threads[RESULT_THREADS];
+    ResultWork work[RESULT_THREADS];
+    int per_thread = MANY_COMMANDS / RESULT_THREADS;
+    for (int t = 0; t < RESULT_THREADS; t++) {
+        work[t].ids = ids + t * per_thread;
+        work[t].count = (t == RESULT_THREADS - 1) ? MANY_COMMANDS - t * per_thread : per_thread;
+        pthread_create(&threads[t], NULL, result_thread, &work[t]);
+    }
+    for (int t = 0; t < RESULT_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    CommandPipelineStats stats;
+    command_pipeline_get_stats(&stats);
+    assert(stats.pending == 0);
+    assert(stats.succeeded == MANY_COMMANDS);
+    assert(con.act_con == MANY_COMMANDS && con.act_term == MANY_COMMANDS);
+
+    command_pipeline_cleanup();
+    free(ids);
+
+    double small = command_cost_ns(16, &con);
+    double large = command_cost_ns(MANY_COMMANDS, &con);
+
+    printf("  16 in flight: %.0f ns, %d in flight: %.0f ns per command\n", small, MANY_COMMANDS, large);
+    assert(large < small * 10 + 2000);
+    printf("  ✓ cost per command independent of commands in flight\n");
+}
+
+void test_many_timeouts() {
+    printf("\nTesting mass timeout...\n");
+
+    MockConnection con;
+    mock_init(&con);
+    assert(command_pipeline_init(MANY_COMMANDS, 300));
+
+    CS101_ASDU asdu = create_command(100);
+    uint32_t id;
+    for (int i = 0; i < MANY_COMMANDS; i++) {
+        assert(command_pipeline_submit(&con.base, asdu, &id));
+    }
+    CS101_ASDU_destroy(asdu);
+
+    usleep(200 * 1000);
+    assert(con.act_con_negative == 0);
+
+    // Every timeout is also reported on stdout
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    assert(freopen("/dev/null", "w", stdout) != NULL);
+
+    double start = now_s();
+    while (__atomic_load_n(&con.act_con_negative, __ATOMIC_RELAXED) < MANY_COMMANDS && now_s() - start < 2.0) {
+        usleep(10 * 1000);
+    }
+    double elapsed_ms = (now_s() - start) * 1000;
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    assert(con.act_con_negative == MANY_COMMANDS);
+    printf("  all timed out %.0f ms after the deadline\n", elapsed_ms - 100);
+
+    command_pipeline_cleanup();
+    printf("  ✓ every command answered when its timeout expires\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running command_pipeline test suite\n");
+    printf("===========================================\n");
+
+    test_result_confirmation();
+    test_timeout();
+    test_capacity();
+    test_connection_closed();
+    test_many_in_flight();
+    test_many_timeouts();
+
+    printf("\n===========================================\n");
+    printf("✓ All command_pipeline tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
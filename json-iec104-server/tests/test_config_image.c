@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include "../src/config/config_parser.h"
+#include "../src/config/config_image.h"
+#include "../src/data/data_manager.h"
+#include "../src/protocol/interrogation.h"
+#include "../src/threads/periodic_sender.h"
+#include "../src/utils/logger.h"
+#include "cs104_slave.h"
+
+/**
+ * Station image tests
+ *
+ * Compiles a configuration into an image and checks that loading the image
+ * gives the same settings, point directory, index, packing plans and
+ * periodic groups as parsing the JSON. A changed JSON, a damaged image and
+ * a missing image must fall back to JSON parsing, and so must an image with
+ * a valid checksum but inconsistent IOA lists, plans or index entries.
+ * Finally compares the startup cost of both paths for one million points.
+ */
+
+// Mock global variables that config_parser expects
+uint32_t offline_udt_time = 0;
+float deadband_M_ME_NC_1_percent = 0.0f;
+int ASDU = 1;
+char command_mode[64] = "";
+int tcpPort = 2404;
+char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+CS101_AppLayerParameters alParameters = NULL;
+
+#define CONFIG_FILE "/tmp/test_config_image.json"
+#define IMAGE_FILE "/tmp/test_config_image.json.img"
+
+#define BIG_POINTS 1000000
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void write_file(const char* filename, const char* content) {
+    FILE* f = fopen(filename, "w");
+    assert(f != NULL);
+    fputs(content, f);
+    fclose(f);
+}
+
+static const char* STATION_CONFIG =
+    "{\"ASDU\": 77, \"port\": 2500,"
+    " \"M_ME_NC_1_config\": [[100, 199], 300, 302, [400, 404]],"
+    " \"M_SP_NA_1_config\": [9, 5, 7, 1000],"
+    " \"M_IT_TB_1_config\": [[2000, 2009]],"
+    " \"periodic\": {\"groups\": [{\"name\": \"feeders\", \"type\": \"M_ME_NC_1\","
+    " \"period_ms\": 1000, \"ioas\": [[100, 110]]}]}}";
+
+// Release everything a loaded configuration holds
+static void reset_config(void) {
+    periodic_clear_groups();
+    interrogation_clear_plans();
+    cleanup_data_contexts();
+    config_image_unload();
+    init_data_contexts();
+    ASDU = 1;
+    tcpPort = 2404;
+}
+
+void test_compile_and_load() {
+    printf("\nTesting compile and load...\n");
+
+    write_file(CONFIG_FILE, STATION_CONFIG);
+    remove(IMAGE_FILE);
+
+    init_data_contexts();
+    assert(config_image_compile(CONFIG_FILE, IMAGE_FILE));
+
+    // Reference: the configuration parsed from JSON
+    int counts[10];
+    int* lists[10];
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        counts[i] = g_data_contexts[i].config.count;
+        lists[i] = malloc((counts[i] + 1) * sizeof(int));
+        memcpy(lists[i], g_data_contexts[i].config.ioa_list, counts[i] * sizeof(int));
+    }
+    reset_config();
+
+    assert(config_image_load(CONFIG_FILE, IMAGE_FILE));
+    assert(ASDU == 77 && tcpPort == 2500);
+
+    for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+        DataTypeContext* ctx = &g_data_contexts[i];
+        assert(ctx->config.count == counts[i]);
+        if (counts[i] == 0) {
+            free(lists[i]);
+            continue;
+        }
+
+        assert(ctx->config.mapped);
+        assert(memcmp(ctx->config.ioa_list, lists[i], counts[i] * sizeof(int)) == 0);
+        assert(ctx->data_array != NULL);
+        assert(ctx->data_array[0].type == ctx->type_info->value_type);
+
+        // Every point is found through the mapped index
+        for (int k = 0; k < counts[i]; k++) {
+            DataTypeContext* found;
+            int idx;
+            assert(lookup_ioa(lists[i][k], &found, &idx) && found == ctx && idx == k);
+        }
+
+        // Interrogation uses the plan from the image, identical to a fresh one
+        PackingPlan scratch, fresh;
+        memset(&fresh, 0, sizeof(fresh));
+        const PackingPlan* plan = interrogation_get_plan(ctx, CONFIG_IMAGE_PLAN_ASDU_SIZE, &scratch);
+        assert(plan != NULL && plan != &scratch);
+        assert(packing_plan_build(&fresh, lists[i], NULL, counts[i], ctx->type_info->io_size,
+                                  CONFIG_IMAGE_PLAN_ASDU_SIZE));
+        assert(plan->count == fresh.count && plan->points == counts[i]);
+        for (int c = 0; c < fresh.count; c++) {
+            assert(plan->chunks[c].start == fresh.chunks[c].start);
+            assert(plan->chunks[c].count == fresh.chunks[c].count);
+            assert(plan->chunks[c].sequence == fresh.chunks[c].sequence);
+        }
+        packing_plan_free(&fresh);
+
+        free(lists[i]);
+    }
+
+    // Unsorted config entries are stored sorted
+    DataTypeContext* sp = get_data_context(M_SP_NA_1);
+    assert(sp->config.ioa_list[0] == 5 && sp->config.ioa_list[3] == 1000);
+
+    DataTypeContext* found;
+    int idx;
+    assert(lookup_ioa(301, &found, &idx) == false);
+
+    // Periodic groups come from the settings in the image
+    assert(periodic_get_group_count() == 1);
+    char* stats = periodic_get_stats_json();
+    assert(strstr(stats, "\"name\":\"feeders\"") != NULL);
+    free(stats);
+
+    reset_config();
+    printf("  ✓ image gives the same configuration as the JSON\n");
+}
+
+void test_plan_asdu_size() {
+    printf("\nTesting packing plans for another ASDU size...\n");
+
+    assert(config_image_load(CONFIG_FILE, IMAGE_FILE));
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+
+    // A different ASDU size builds a plan per request until the plans are prepared again
+    PackingPlan scratch;
+    const PackingPlan* plan = interrogation_get_plan(ctx, 120, &scratch);
+    assert(plan == &scratch && plan->max_asdu_size == 120);
+    packing_plan_free(&scratch);
+
+    assert(interrogation_prepare_plans(120));
+    plan = interrogation_get_plan(ctx, 120, &scratch);
+    assert(plan != &scratch && plan->max_asdu_size == 120);
+
+    reset_config();
+    printf("  ✓ plans rebuilt when the ASDU size differs\n");
+}
+
+void test_fallback() {
+    printf("\nTesting fallback to JSON...\n");
+
+    // Stale: the JSON changed after compiling
+    write_file(CONFIG_FILE, STATION_CONFIG);
+    assert(config_image_compile(CONFIG_FILE, IMAGE_FILE));
+    reset_config();
+
+    char changed[1024];
+    snprintf(changed, sizeof(changed), "%s\n", STATION_CONFIG);
+    write_file(CONFIG_FILE, changed);
+    assert(config_image_load(CONFIG_FILE, IMAGE_FILE) == false);
+    assert(get_data_context(M_ME_NC_1)->config.count == 0);
+    assert(ASDU == 1);
+
+    // Missing image
+    remove(IMAGE_FILE);
+    assert(config_image_load(CONFIG_FILE, IMAGE_FILE) == false);
+
+    // Damaged image: wrong magic, then truncated
+    assert(config_image_compile(CONFIG_FILE, IMAGE_FILE));
+    reset_config();
+
+    FILE* f = fopen(IMAGE_FILE, "r+b");
+    assert(f != NULL);
+    fputc('X', f);
+    fclose(f);
+    assert(config_image_load(CONFIG_FILE, IMAGE_FILE) == false);
+
+    assert(config_image_compile(CONFIG_FILE, IMAGE_FILE));
+    reset_config();
+    assert(truncate(IMAGE_FILE, 200) == 0);
+    assert(config_image_load(CONFIG_FILE, IMAGE_FILE) == false);
+    assert(get_data_context(M_ME_NC_1)->config.count == 0);
+
+    // The JSON still loads
+    assert(init_config_from_file(CONFIG_FILE));
+    assert(ASDU == 77);
+
+    reset_config();
+    remove(IMAGE_FILE);
+    printf("  ✓ stale, damaged and missing images are ignored\n");
+}
+
+static unsigned char* read_image(size_t* size) {
+    FILE* f = fopen(IMAGE_FILE, "rb");
+    assert(f != NULL);
+    fseek(f, 0, SEEK_END);
+    *size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* image = malloc(*size);
+    assert(image && fread(image, 1, *size, f) == *size);
+    fclose(f);
+    return image;
+}
+
+// Write an image with a recomputed body hash, so only the entry checks can reject it
+static bool load_patched(const unsigned char* image, size_t size) {
+    ConfigImageHeader header;
+    memcpy(&header, image, sizeof(header));
+    header.body_hash = config_image_body_hash(image + sizeof(header), size - sizeof(header));
+
+    FILE* f = fopen(IMAGE_FILE, "wb");
+    assert(f != NULL);
+    assert(fwrite(&header, 1, sizeof(header), f) == sizeof(header));
+    assert(fwrite(image + sizeof(header), 1, size - sizeof(header), f) == size - sizeof(header));
+    fclose(f);
+
+    bool ok = config_image_load(CONFIG_FILE, IMAGE_FILE);
+    if (!ok) {
+        assert(get_data_context(M_ME_NC_1)->config.count == 0);
+    }
+    reset_config();
+    return ok;
+}
+
+void test_damaged_entries() {
+    printf("\nTesting images with damaged entries...\n");
+
+    write_file(CONFIG_FILE, STATION_CONFIG);
+    assert(config_image_compile(CONFIG_FILE, IMAGE_FILE));
+    reset_config();
+
+    size_t size;
+    unsigned char* image = read_image(&size);
+    unsigned char* patched = malloc(size);
+    assert(patched != NULL);
+
+    const ConfigImageHeader* header = (const ConfigImageHeader*)image;
+    const ConfigImageType* types = (const ConfigImageType*)(image + header->types_offset);
+    int me = 0;
+    while (types[me].type_id != M_ME_NC_1) me++;
+
+    // Unchanged entries with a recomputed hash still load
+    memcpy(patched, image, size);
+    assert(load_patched(patched, size));
+
+    // A flipped byte in the body fails the checksum
+    memcpy(patched, image, size);
+    patched[size - 1] ^= 0x01;
+    FILE* f = fopen(IMAGE_FILE, "wb");
+    assert(f != NULL && fwrite(patched, 1, size, f) == size);
+    fclose(f);
+    assert(config_image_load(CONFIG_FILE, IMAGE_FILE) == false);
+    reset_config();
+    printf("  ✓ body checksum mismatch rejected\n");
+
+    // IOA list out of order
+    memcpy(patched, image, size);
+    int* ioas = (int*)(patched + types[me].ioa_offset);
+    int tmp = ioas[0];
+    ioas[0] = ioas[1];
+    ioas[1] = tmp;
+    assert(!load_patched(patched, size));
+
+    // Plan that runs past the point list
+    memcpy(patched, image, size);
+    PackedChunk* chunks = (PackedChunk*)(patched + types[me].plan_offset);
+    chunks[types[me].plan_count - 1].count++;
+    assert(!load_patched(patched, size));
+
+    // Index entries: position beyond the list, wrong type, IOA not at its position
+    IoaIndexEntry* index = (IoaIndexEntry*)(patched + header->index_offset);
+    uint32_t used = 0;
+    while (index[used].ctx < 0) used++;
+
+    memcpy(patched, image, size);
+    index[used].idx = types[index[used].ctx].count;
+    assert(!load_patched(patched, size));
+
+    memcpy(patched, image, size);
+    index[used].ctx = DATA_TYPE_COUNT;
+    assert(!load_patched(patched, size));
+
+    memcpy(patched, image, size);
+    index[used].ioa++;
+    assert(!load_patched(patched, size));
+
+    // An index without free slots would never end a failed lookup
+    memcpy(patched, image, size);
+    for (uint32_t slot = 0; slot < header->index_capacity; slot++) {
+        index[slot] = index[used];
+    }
+    assert(!load_patched(patched, size));
+    printf("  ✓ unsorted lists, overlong plans and bad index entries rejected\n");
+
+    // The JSON still loads
+    assert(init_config_from_file(CONFIG_FILE));
+    assert(ASDU == 77);
+    reset_config();
+
+    free(image);
+    free(patched);
+    remove(IMAGE_FILE);
+}
+
+void test_startup_time() {
+    printf("\nTesting startup time with %d points...\n", BIG_POINTS);
+
+    FILE* f = fopen(CONFIG_FILE, "w");
+    assert(f != NULL);
+    fprintf(f, "{\"ASDU\": 1, \"M_ME_NC_1_config\": [");
+    for (int i = 0; i < BIG_POINTS; i++) {
+        fprintf(f, i ? ",%d" : "%d", 1 + i * 2);
+    }
+    fprintf(f, "]}");
+    fclose(f);
+
+    double start = now_s();
+    assert(init_config_from_file(CONFIG_FILE));
+    assert(interrogation_prepare_plans(CONFIG_IMAGE_PLAN_ASDU_SIZE));
+    double json_ms = (now_s() - start) * 1000;
+    reset_config();
+
+    assert(config_image_compile(CONFIG_FILE, IMAGE_FILE));
+    reset_config();
+
+    start = now_s();
+    assert(config_image_load(CONFIG_FILE, IMAGE_FILE));
+    assert(interrogation_prepare_plans(CONFIG_IMAGE_PLAN_ASDU_SIZE));
+    double image_ms = (now_s() - start) * 1000;
+
+    DataTypeContext* found;
+    int idx;
+    assert(lookup_ioa(1 + 2 * (BIG_POINTS - 1), &found, &idx) && idx == BIG_POINTS - 1);
+    reset_config();
+
+    remove(CONFIG_FILE);
+    remove(IMAGE_FILE);
+
+    printf("  JSON: %.1f ms, image: %.1f ms\n", json_ms, image_ms);
+    assert(image_ms < json_ms);
+    printf("  ✓ image loads faster than the JSON\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running config_image test suite\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+
+    test_compile_and_load();
+    test_plan_asdu_size();
+    test_fallback();
+    test_damaged_entries();
+    test_startup_time();
+
+    printf("\n===========================================\n");
+    printf("✓ All config_image tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
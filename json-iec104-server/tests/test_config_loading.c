@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/config/config_parser.h"
+#include "../src/data/data_manager.h"
+#include "../src/utils/logger.h"
+#include "cs104_slave.h"
+
+/**
+ * Config loading benchmark
+ *
+ * Writes configs with 10k, 100k and 1M M_ME_NC_1 points, once as explicit
+ * IOAs and once in range syntax, and measures init_config_from_file() for
+ * each. Loading must grow linearly with the number of points.
+ */
+
+// Mock global variables that config_parser expects
+uint32_t offline_udt_time = 0;
+float deadband_M_ME_NC_1_percent = 0.0f;
+int ASDU = 1;
+char command_mode[64] = "";
+int tcpPort = 2404;
+char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+CS101_AppLayerParameters alParameters = NULL;
+
+#define CONFIG_FILE "/tmp/test_config_loading.json"
+
+// Points come in blocks of BLOCK consecutive IOAs with a gap of GAP between blocks
+#define BLOCK 1000
+#define GAP 24
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int ioa_of(int i) {
+    return 1 + (i / BLOCK) * (BLOCK + GAP) + i % BLOCK;
+}
+
+static long write_config(int points, bool ranges) {
+    FILE* f = fopen(CONFIG_FILE, "w");
+    assert(f != NULL);
+
+    fprintf(f, "{\"ASDU\": 1, \"M_ME_NC_1_config\": [");
+    for (int i = 0; i < points; i += ranges ? BLOCK : 1) {
+        if (i > 0) fputc(',', f);
+        if (ranges) {
+            int last = (i + BLOCK <= points) ? i + BLOCK - 1 : points - 1;
+            fprintf(f, "[%d,%d]", ioa_of(i), ioa_of(last));
+        } else {
+            fprintf(f, "%d", ioa_of(i));
+        }
+    }
+    fprintf(f, "]}");
+    fclose(f);
+
+    struct stat st;
+    assert(stat(CONFIG_FILE, &st) == 0);
+    return (long)st.st_size;
+}
+
+// Load the config and check every point, returns the load time in ms
+static double load_config(int points) {
+    init_data_contexts();
+
+    double start = now_s();
+    assert(init_config_from_file(CONFIG_FILE));
+    double ms = (now_s() - start) * 1000;
+
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    assert(ctx->config.count == points);
+    for (int i = 0; i < points; i += 997) {
+        assert(ctx->config.ioa_list[i] == ioa_of(i));
+        assert(find_ioa_index(&ctx->config, ioa_of(i)) == i);
+
+        DataTypeContext* found;
+        int idx;
+        assert(lookup_ioa(ioa_of(i), &found, &idx) && found == ctx && idx == i);
+    }
+
+    cleanup_data_contexts();
+    return ms;
+}
+
+void test_loading_time() {
+    const int sizes[] = { 10000, 100000, 1000000 };
+    double explicit_ms[3];
+
+    printf("\nTesting config load time...\n");
+    printf("  %8s  %12s %10s  %12s %10s\n", "points", "explicit", "load", "ranges", "load");
+
+    for (int i = 0; i < 3; i++) {
+        long explicit_size = write_config(sizes[i], false);
+        explicit_ms[i] = load_config(sizes[i]);
+
+        long range_size = write_config(sizes[i], true);
+        double range_ms = load_config(sizes[i]);
+
+        printf("  %8d  %10ld B %7.1f ms  %10ld B %7.1f ms\n",
+               sizes[i], explicit_size, explicit_ms[i], range_size, range_ms);
+    }
+
+    remove(CONFIG_FILE);
+
+    // Linear: 10x the points may take about 10x the time, quadratic would be 100x
+    assert(explicit_ms[2] < explicit_ms[1] * 30 + 50);
+    printf("  ✓ load time grows linearly with the number of points\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running config loading benchmark\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+
+    test_loading_time();
+
+    printf("\n===========================================\n");
+    printf("✓ All config loading tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
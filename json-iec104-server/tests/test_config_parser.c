@@ -5,6 +5,7 @@
 #include "../src/config/config_parser.h"
 #include "../src/data/data_manager.h"
 #include "../src/data/data_types.h"
+#include "cs104_slave.h"
 
 // Mock global variables that config_parser expects
 uint32_t offline_udt_time = 0;
@@ -13,6 +14,24 @@ int ASDU = 1;
 char command_mode[64] = "";
 int tcpPort = 2404;
 char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+CS101_AppLayerParameters alParameters = NULL;
 
 void test_parse_global_settings() {
     printf("\nTesting parse_global_settings()...\n");
@@ -20,7 +39,7 @@ void test_parse_global_settings() {
     const char* json_str = "{"
         "\"offline_udt_time\": 5000,"
         "\"deadband_M_ME_NC_1_percent\": 1.5,"
-        "\"asdu\": 47,"
+        "\"ASDU\": 47,"
         "\"command_mode\": \"direct\","
         "\"port\": 2404,"
         "\"local_ip\": \"192.168.1.100\""
@@ -44,6 +63,192 @@ void test_parse_global_settings() {
     printf("  ✓ Global settings parsed correctly\n");
 }
 
+void test_parse_reactor_settings() {
+    printf("\nTesting reactor settings...\n");
+
+    cJSON* json = cJSON_Parse("{\"reactor_threads\": 2, \"reactor_pin_threads\": true}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(reactor_threads == 2);
+    assert(reactor_pin_threads == true);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"reactor_threads\": -1}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == false);
+    assert(reactor_threads == 2);
+    cJSON_Delete(json);
+
+    // Reactor mode is opt-in: "auto" enables it, 0 returns to one thread per connection
+    json = cJSON_Parse("{\"reactor_threads\": \"auto\"}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(reactor_threads == REACTOR_THREADS_AUTO);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"reactor_threads\": 0}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(reactor_threads == 0);
+    cJSON_Delete(json);
+
+    reactor_threads = 0;
+    reactor_pin_threads = false;
+    printf("  ✓ Reactor settings parsed correctly\n");
+}
+
+void test_parse_max_connections() {
+    printf("\nTesting max_connections...\n");
+
+    cJSON* json = cJSON_Parse("{\"max_connections\": 500}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(max_connections == 500);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"max_connections\": -5}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == false);
+    assert(max_connections == 500);
+    cJSON_Delete(json);
+
+    max_connections = 0;
+    printf("  ✓ max_connections parsed correctly\n");
+}
+
+void test_parse_capture_settings() {
+    printf("\nTesting capture_file / capture_max_mb...\n");
+
+    cJSON* json = cJSON_Parse("{\"capture_file\": \"/tmp/rtu.pcap\", \"capture_max_mb\": 16}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(strcmp(capture_file, "/tmp/rtu.pcap") == 0);
+    assert(capture_max_mb == 16);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"capture_max_mb\": 0}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == false);
+    assert(capture_max_mb == 16);
+    cJSON_Delete(json);
+
+    capture_file[0] = '\0';
+    capture_max_mb = 64;
+    printf("  ✓ capture settings parsed correctly\n");
+}
+
+void test_parse_apci_and_ack_policy() {
+    printf("\nTesting apci / ack_policy...\n");
+
+    cJSON* json = cJSON_Parse("{\"apci\": {\"k\": 96, \"w\": 64, \"t1\": 30, \"t2\": 5},"
+                              " \"ack_policy\": \"delayed\", \"ack_delay_ms\": 200}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(apci_parameters.k == 96 && apci_parameters.w == 64);
+    assert(apci_parameters.t0 == 10 && apci_parameters.t1 == 30);
+    assert(apci_parameters.t2 == 5 && apci_parameters.t3 == 20);
+    assert(ack_policy == CS104_ACK_POLICY_DELAYED);
+    assert(ack_delay_ms == 200);
+    cJSON_Delete(json);
+
+    // w > k, t2 >= t1, unknown policy, delay beyond t2
+    const char* invalid[] = {
+        "{\"apci\": {\"k\": 8, \"w\": 12}}",
+        "{\"apci\": {\"t1\": 10, \"t2\": 10}}",
+        "{\"apci\": {\"k\": 0}}",
+        "{\"ack_policy\": \"sometimes\"}",
+        "{\"ack_delay_ms\": 5000}"
+    };
+    for (int i = 0; i < 5; i++) {
+        json = cJSON_Parse(invalid[i]);
+        assert(json != NULL);
+        assert(parse_global_settings(json) == false);
+        cJSON_Delete(json);
+    }
+    assert(apci_parameters.k == 96 && apci_parameters.t1 == 30);
+    assert(ack_delay_ms == 200);
+
+    struct sCS104_APCIParameters defaults = { 12, 8, 10, 15, 10, 20 };
+    apci_parameters = defaults;
+    ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+    ack_delay_ms = 50;
+    printf("  ✓ apci and ack policy parsed correctly\n");
+}
+
+void test_parse_select_settings() {
+    printf("\nTesting select_timeout_ms / max_selects...\n");
+
+    cJSON* json = cJSON_Parse("{\"select_timeout_ms\": 10000, \"max_selects\": 4096}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(select_timeout_ms == 10000);
+    assert(max_selects == 4096);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"select_timeout_ms\": 0}");
+    assert(parse_global_settings(json) == false);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"max_selects\": -1}");
+    assert(parse_global_settings(json) == false);
+    cJSON_Delete(json);
+    assert(select_timeout_ms == 10000 && max_selects == 4096);
+
+    select_timeout_ms = 5000;
+    max_selects = 1024;
+    printf("  ✓ select settings parsed correctly\n");
+}
+
+void test_parse_async_command_settings() {
+    printf("\nTesting async_commands / command_timeout_ms / max_pending_commands...\n");
+
+    cJSON* json = cJSON_Parse("{\"async_commands\": true, \"command_timeout_ms\": 3000,"
+                              " \"max_pending_commands\": 8192}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(async_commands == true);
+    assert(command_timeout_ms == 3000);
+    assert(max_pending_commands == 8192);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"command_timeout_ms\": 0}");
+    assert(parse_global_settings(json) == false);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"max_pending_commands\": -5}");
+    assert(parse_global_settings(json) == false);
+    cJSON_Delete(json);
+    assert(command_timeout_ms == 3000 && max_pending_commands == 8192);
+
+    async_commands = false;
+    command_timeout_ms = 10000;
+    max_pending_commands = 1024;
+    printf("  ✓ async command settings parsed correctly\n");
+}
+
+void test_parse_value_snapshot_settings() {
+    printf("\nTesting value_snapshot_file / value_snapshot_sync_ms / value_snapshot_non_topical...\n");
+
+    cJSON* json = cJSON_Parse("{\"value_snapshot_file\": \"/var/lib/iec104/values.snap\","
+                              " \"value_snapshot_sync_ms\": 1000, \"value_snapshot_non_topical\": false}");
+    assert(json != NULL);
+    assert(parse_global_settings(json) == true);
+    assert(strcmp(value_snapshot_file, "/var/lib/iec104/values.snap") == 0);
+    assert(value_snapshot_sync_ms == 1000);
+    assert(value_snapshot_non_topical == false);
+    cJSON_Delete(json);
+
+    json = cJSON_Parse("{\"value_snapshot_sync_ms\": -1}");
+    assert(parse_global_settings(json) == false);
+    cJSON_Delete(json);
+    assert(value_snapshot_sync_ms == 1000);
+
+    value_snapshot_file[0] = '\0';
+    value_snapshot_sync_ms = 0;
+    value_snapshot_non_topical = true;
+    printf("  ✓ value snapshot settings parsed correctly\n");
+}
+
 void test_parse_data_type_config() {
     printf("\nTesting parse_data_type_config()...\n");
     
@@ -75,8 +280,8 @@ void test_parse_data_type_config() {
     assert(ctx->data_array[0].has_quality == true);
     assert(ctx->data_array[0].has_timestamp == true);
     
-    // Verify offline tracking allocated (M_SP_TB_1 has timestamp)
-    assert(ctx->last_offline_update != NULL);
+    // Verify offline buffer allocated (M_SP_TB_1 has timestamp)
+    assert(ctx->offline != NULL);
     
     cJSON_Delete(json);
     cleanup_data_contexts();
@@ -91,7 +296,7 @@ void test_parse_multiple_types() {
     
     const char* json_str = "{"
         "\"offline_udt_time\": 3000,"
-        "\"asdu\": 1,"
+        "\"ASDU\": 1,"
         "\"M_SP_TB_1_config\": [100, 101],"
         "\"M_DP_TB_1_config\": [200, 201, 202],"
         "\"M_ME_NC_1_config\": [300]"
@@ -126,7 +331,7 @@ void test_parse_empty_config() {
     
     const char* json_str = "{"
         "\"offline_udt_time\": 1000,"
-        "\"asdu\": 1"
+        "\"ASDU\": 1"
     "}";
     
     bool result = parse_config_from_json(json_str);
@@ -170,6 +375,46 @@ void test_parse_invalid_ioa() {
     printf("  ✓ Invalid IOA type rejected correctly\n");
 }
 
+void test_parse_ioa_ranges() {
+    printf("\nTesting IOA ranges, sorting and duplicates...\n");
+
+    init_data_contexts();
+
+    // Ranges and single IOAs, out of order
+    assert(parse_config_from_json("{\"M_ME_NC_1_config\": [[1, 5000], 7000, [6001, 6100], 5500]}"));
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    assert(ctx->config.count == 5000 + 100 + 2);
+    assert(ctx->config.ioa_list[0] == 1);
+    assert(ctx->config.ioa_list[4999] == 5000);
+    assert(ctx->config.ioa_list[5000] == 5500);
+    assert(ctx->config.ioa_list[5001] == 6001);
+    assert(ctx->config.ioa_list[5101] == 7000);
+    for (int i = 1; i < ctx->config.count; i++) {
+        assert(ctx->config.ioa_list[i] > ctx->config.ioa_list[i - 1]);
+    }
+    assert(find_ioa_index(&ctx->config, 6050) == 5050);
+    assert(find_ioa_index(&ctx->config, 5999) == -1);
+    cleanup_data_contexts();
+
+    // Duplicates, overlapping ranges, reversed, malformed and out-of-range entries
+    const char* invalid[] = {
+        "{\"M_SP_NA_1_config\": [10, 11, 10]}",
+        "{\"M_SP_NA_1_config\": [[1, 100], [50, 60]]}",
+        "{\"M_SP_NA_1_config\": [[100, 1]]}",
+        "{\"M_SP_NA_1_config\": [[1, 2, 3]]}",
+        "{\"M_SP_NA_1_config\": [[1, \"5\"]]}",
+        "{\"M_SP_NA_1_config\": [16777216]}",
+        "{\"M_SP_NA_1_config\": [-1]}"
+    };
+    for (int i = 0; i < 7; i++) {
+        init_data_contexts();
+        assert(parse_config_from_json(invalid[i]) == false);
+        cleanup_data_contexts();
+    }
+
+    printf("  ✓ IOA ranges expanded, sorted and validated\n");
+}
+
 void test_init_config_from_file() {
     printf("\nTesting init_config_from_file()...\n");
     
@@ -180,7 +425,7 @@ void test_init_config_from_file() {
     
     const char* config_content = "{"
         "\"offline_udt_time\": 2000,"
-        "\"asdu\": 99,"
+        "\"ASDU\": 99,"
         "\"M_SP_TB_1_config\": [500, 501]"
     "}";
     
@@ -226,11 +471,19 @@ int main() {
     printf("===========================================\n");
     
     test_parse_global_settings();
+    test_parse_reactor_settings();
+    test_parse_max_connections();
+    test_parse_capture_settings();
+    test_parse_apci_and_ack_policy();
+    test_parse_select_settings();
+    test_parse_async_command_settings();
+    test_parse_value_snapshot_settings();
     test_parse_data_type_config();
     test_parse_multiple_types();
     test_parse_empty_config();
     test_parse_invalid_json();
     test_parse_invalid_ioa();
+    test_parse_ioa_ranges();
     test_init_config_from_file();
     test_init_config_from_nonexistent_file();
     
@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../src/config/config_parser.h"
+#include "../src/config/config_reload.h"
+#include "../src/data/data_manager.h"
+#include "../src/data/value_snapshot.h"
+#include "../src/protocol/interrogation.h"
+#include "../src/threads/periodic_sender.h"
+#include "../src/utils/logger.h"
+#include "cs104_slave.h"
+
+/**
+ * Configuration reload tests
+ *
+ * Reloads a changed configuration and checks the reported diff, the carried
+ * over values, the swapped index, packing plans and periodic groups. An
+ * invalid file must leave everything unchanged, and the value snapshot must
+ * follow the new point lists. Reader threads use the configuration while it
+ * is reloaded over and over. Finally measures the swap pause for one
+ * million points.
+ */
+
+// Mock global variables that config_parser expects
+uint32_t offline_udt_time = 0;
+float deadband_M_ME_NC_1_percent = 0.0f;
+int ASDU = 1;
+char command_mode[64] = "";
+int tcpPort = 2404;
+char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+CS101_AppLayerParameters alParameters = NULL;
+
+#define CONFIG_FILE "/tmp/test_config_reload.json"
+#define SNAPSHOT_FILE "/tmp/test_config_reload.snap"
+#define PLAN_ASDU_SIZE 249
+#define BIG_POINTS 1000000
+
+static const char* CONFIG_BEFORE =
+    "{\"M_ME_NC_1_config\": [[100, 199]],"
+    " \"M_SP_NA_1_config\": [1, 2, 3],"
+    " \"M_DP_NA_1_config\": [50],"
+    " \"periodic\": {\"groups\": [{\"name\": \"feeders\", \"type\": \"M_ME_NC_1\","
+    " \"period_ms\": 1000, \"ioas\": [[100, 110]]}]}}";
+
+// 150..199 removed, 200..209 added, IOA 3 moved from M_SP_NA_1 to M_DP_NA_1
+static const char* CONFIG_AFTER =
+    "{\"M_ME_NC_1_config\": [[100, 149], [200, 209]],"
+    " \"M_SP_NA_1_config\": [1, 2],"
+    " \"M_DP_NA_1_config\": [3, 50],"
+    " \"periodic\": {\"groups\": [{\"name\": \"feeders\", \"type\": \"M_ME_NC_1\","
+    " \"period_ms\": 1000, \"ioas\": [[100, 110]]},"
+    " {\"name\": \"new\", \"type\": \"M_ME_NC_1\", \"period_ms\": 500, \"ioas\": [[200, 209]]}]}}";
+
+static void write_file(const char* filename, const char* content) {
+    FILE* f = fopen(filename, "w");
+    assert(f != NULL);
+    fputs(content, f);
+    fclose(f);
+}
+
+static void load(const char* content) {
+    write_file(CONFIG_FILE, content);
+    init_data_contexts();
+    assert(init_config_from_file(CONFIG_FILE));
+    assert(interrogation_prepare_plans(PLAN_ASDU_SIZE));
+    config_reload_init(CONFIG_FILE);
+}
+
+static void unload(void) {
+    periodic_clear_groups();
+    interrogation_clear_plans();
+    value_snapshot_close();
+    cleanup_data_contexts();
+}
+
+static void set_value(TypeID type, int ioa, float value) {
+    DataTypeContext* ctx = get_data_context(type);
+    DataValue v;
+    memset(&v, 0, sizeof(v));
+    v.type = ctx->type_info->value_type;
+    v.has_quality = ctx->type_info->has_quality;
+    v.quality = IEC60870_QUALITY_GOOD;
+    if (v.type == DATA_VALUE_TYPE_FLOAT) {
+        v.value.float_val = value;
+    } else {
+        v.value.bool_val = value != 0;
+    }
+    update_data(ctx, NULL, ioa, &v);
+}
+
+static const DataValue* value_of(TypeID type, int ioa) {
+    DataTypeContext* ctx = get_data_context(type);
+    int idx = find_ioa_index(&ctx->config, ioa);
+    assert(idx >= 0);
+    return &ctx->data_array[idx];
+}
+
+void test_reload_diff() {
+    printf("\nTesting reload diff and carried values...\n");
+
+    load(CONFIG_BEFORE);
+    set_value(M_ME_NC_1, 100, 1.5f);
+    set_value(M_ME_NC_1, 149, 2.5f);
+    set_value(M_ME_NC_1, 150, 3.5f);
+    set_value(M_SP_NA_1, 3, 1);
+
+    write_file(CONFIG_FILE, CONFIG_AFTER);
+    ConfigReloadResult result;
+    assert(config_reload(NULL, PLAN_ASDU_SIZE, &result));
+
+    assert(result.points == 64);
+    assert(result.kept == 53);
+    assert(result.added == 10);
+    assert(result.removed == 50);
+    assert(result.retyped == 1);
+
+    // Kept points keep their values, new and retyped points start INVALID
+    assert(value_of(M_ME_NC_1, 100)->value.float_val == 1.5f);
+    assert(value_of(M_ME_NC_1, 149)->value.float_val == 2.5f);
+    assert(value_of(M_ME_NC_1, 149)->quality == IEC60870_QUALITY_GOOD);
+    assert(value_of(M_ME_NC_1, 200)->quality == IEC60870_QUALITY_INVALID);
+    assert(value_of(M_DP_NA_1, 3)->quality == IEC60870_QUALITY_INVALID);
+
+    // Index, plans and periodic groups follow the new lists
+    DataTypeContext* ctx;
+    int idx;
+    assert(lookup_ioa(3, &ctx, &idx) && ctx->type_id == M_DP_NA_1 && idx == 0);
+    assert(lookup_ioa(205, &ctx, &idx) && ctx->type_id == M_ME_NC_1 && idx == 55);
+    assert(lookup_ioa(150, &ctx, &idx) == false);
+
+    PackingPlan scratch;
+    const PackingPlan* plan = interrogation_get_plan(get_data_context(M_ME_NC_1), PLAN_ASDU_SIZE, &scratch);
+    assert(plan != &scratch && plan->points == 60);
+
+    assert(periodic_get_group_count() == 2);
+
+    char* report = config_reload_get_report_json();
+    assert(strstr(report, "\"reload\":\"ok\"") != NULL);
+    assert(strstr(report, "\"added\":{\"M_ME_NC_1\":[[200,209]]}") != NULL);
+    assert(strstr(report, "\"removed\":{\"M_ME_NC_1\":[[150,199]]}") != NULL);
+    assert(strstr(report, "{\"ioa\":3,\"from\":\"M_SP_NA_1\",\"to\":\"M_DP_NA_1\"}") != NULL);
+    printf("  %s\n", report);
+    free(report);
+
+    unload();
+    printf("  ✓ diff reported, values carried over by IOA\n");
+}
+
+void test_reload_failure() {
+    printf("\nTesting invalid configuration...\n");
+
+    load(CONFIG_BEFORE);
+    set_value(M_ME_NC_1, 120, 7.0f);
+    const int* ioa_list = get_data_context(M_ME_NC_1)->config.ioa_list;
+
+    write_file(CONFIG_FILE, "{\"M_ME_NC_1_config\": [100, 100]}");
+    assert(config_reload(NULL, PLAN_ASDU_SIZE, NULL) == false);
+
+    write_file(CONFIG_FILE, "{\"M_ME_NC_1_config\": [");
+    assert(config_reload(NULL, PLAN_ASDU_SIZE, NULL) == false);
+
+    assert(config_reload("/tmp/test_config_reload_missing.json", PLAN_ASDU_SIZE, NULL) == false);
+
+    // A valid point list with an invalid periodic section
+    write_file(CONFIG_FILE, "{\"M_ME_NC_1_config\": [[100, 199]],"
+               " \"periodic\": {\"groups\": [{\"name\": \"bad\", \"period_ms\": 1000}]}}");
+    assert(config_reload(NULL, PLAN_ASDU_SIZE, NULL) == false);
+
+    // Nothing changed
+    assert(get_data_context(M_ME_NC_1)->config.ioa_list == ioa_list);
+    assert(get_data_context(M_ME_NC_1)->config.count == 100);
+    assert(value_of(M_ME_NC_1, 120)->value.float_val == 7.0f);
+    assert(periodic_get_group_count() == 1);
+
+    char* report = config_reload_get_report_json();
+    assert(strstr(report, "\"reload\":\"failed\"") != NULL);
+    free(report);
+
+    unload();
+    printf("  ✓ invalid files rejected, configuration unchanged\n");
+}
+
+void test_reload_snapshot() {
+    printf("\nTesting reload with value snapshot...\n");
+
+    remove(SNAPSHOT_FILE);
+    load(CONFIG_BEFORE);
+    assert(value_snapshot_open(SNAPSHOT_FILE, 0, false));
+    set_value(M_ME_NC_1, 100, 4.5f);
+
+    write_file(CONFIG_FILE, CONFIG_AFTER);
+    assert(config_reload(NULL, PLAN_ASDU_SIZE, NULL));
+
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    assert(ctx->data_mapped);
+    assert(value_of(M_ME_NC_1, 100)->value.float_val == 4.5f);
+
+    // Updates after the reload are written to the new file
+    set_value(M_ME_NC_1, 205, 9.0f);
+
+    ValueSnapshotStats stats;
+    value_snapshot_get_stats(&stats);
+    assert(stats.points == 64);
+    unload();
+
+    // Restart with the reloaded configuration: the file matches as is
+    load(CONFIG_AFTER);
+    assert(value_snapshot_open(SNAPSHOT_FILE, 0, false));
+    value_snapshot_get_stats(&stats);
+    assert(stats.restored == 64);
+    assert(value_of(M_ME_NC_1, 100)->value.float_val == 4.5f);
+    assert(value_of(M_ME_NC_1, 205)->value.float_val == 9.0f);
+
+    unload();
+    remove(SNAPSHOT_FILE);
+    printf("  ✓ snapshot follows the new point lists\n");
+}
+
+static bool readers_running = false;
+
+// Interrogation-like access: every chunk of every plan, plus index lookups
+static void* reader_thread(void* arg) {
+    long* passes = (long*)arg;
+
+    while (__atomic_load_n(&readers_running, __ATOMIC_RELAXED)) {
+        data_config_read_lock();
+
+        for (int i = 0; i < DATA_TYPE_COUNT; i++) {
+            DataTypeContext* ctx = &g_data_contexts[i];
+            PackingPlan scratch;
+            const PackingPlan* plan = interrogation_get_plan(ctx, PLAN_ASDU_SIZE, &scratch);
+            assert(plan != NULL && plan->points == ctx->config.count);
+
+            for (int c = 0; c < plan->count; c++) {
+                for (int k = plan->chunks[c].start; k < plan->chunks[c].start + plan->chunks[c].count; k++) {
+                    DataValue value;
+                    assert(k < ctx->config.count);
+                    read_data_value(ctx, k, &value);
+                    assert(value.type == ctx->type_info->value_type);
+                }
+            }
+            if (plan == &scratch) {
+                packing_plan_free(&scratch);
+            }
+        }
+
+        DataTypeContext* ctx;
+        int idx;
+        if (lookup_ioa(205, &ctx, &idx)) {
+            assert(ctx->config.ioa_list[idx] == 205);
+        }
+
+        data_config_read_unlock();
+        (*passes)++;
+    }
+    return NULL;
+}
+
+void test_concurrent_readers() {
+    printf("\nTesting reload under concurrent readers...\n");
+
+    load(CONFIG_BEFORE);
+
+    pthread_t threads[4];
+    long passes[4] = { 0 };
+    __atomic_store_n(&readers_running, true, __ATOMIC_RELAXED);
+    for (int t = 0; t < 4; t++) {
+        assert(pthread_create(&threads[t], NULL, reader_thread, &passes[t]) == 0);
+    }
+
+    for (int i = 0; i < 200; i++) {
+        write_file(CONFIG_FILE, (i % 2) ? CONFIG_BEFORE : CONFIG_AFTER);
+        assert(config_reload(NULL, PLAN_ASDU_SIZE, NULL));
+    }
+
+    __atomic_store_n(&readers_running, false, __ATOMIC_RELAXED);
+    long total = 0;
+    for (int t = 0; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+        total += passes[t];
+    }
+    assert(get_data_context(M_ME_NC_1)->config.count == 100);
+
+    unload();
+    printf("  ✓ 200 reloads, %ld consistent reader passes\n", total);
+}
+
+void test_swap_pause() {
+    printf("\nTesting swap pause with %d points...\n", BIG_POINTS);
+
+    FILE* f = fopen(CONFIG_FILE, "w");
+    assert(f != NULL);
+    fprintf(f, "{\"M_ME_NC_1_config\": [[1, %d]]}", BIG_POINTS);
+    fclose(f);
+
+    init_data_contexts();
+    assert(init_config_from_file(CONFIG_FILE));
+    assert(interrogation_prepare_plans(PLAN_ASDU_SIZE));
+    set_value(M_ME_NC_1, BIG_POINTS, 5.0f);
+
+    // One point added at the end
+    f = fopen(CONFIG_FILE, "w");
+    assert(f != NULL);
+    fprintf(f, "{\"M_ME_NC_1_config\": [[1, %d]]}", BIG_POINTS + 1);
+    fclose(f);
+
+    ConfigReloadResult result;
+    assert(config_reload(CONFIG_FILE, PLAN_ASDU_SIZE, &result));
+    assert(result.kept == BIG_POINTS && result.added == 1 && result.removed == 0);
+    assert(value_of(M_ME_NC_1, BIG_POINTS)->value.float_val == 5.0f);
+
+    unload();
+    config_reload_cleanup();
+    remove(CONFIG_FILE);
+
+    printf("  built in %.1f ms, swapped in %llu us\n",
+           result.build_us / 1000.0, (unsigned long long)result.swap_us);
+    assert(result.swap_us < 1000);
+    printf("  ✓ readers wait for the swap only\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running config_reload test suite\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+
+    test_reload_diff();
+    test_reload_failure();
+    test_reload_snapshot();
+    test_concurrent_readers();
+    test_swap_pause();
+
+    printf("\n===========================================\n");
+    printf("✓ All config_reload tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include "cs104_slave.h"
+#include "../src/client/client_manager.h"
+#include "../src/utils/logger.h"
+#include "../cJSON/cJSON.h"
+
+/**
+ * Connection scaling load test
+ *
+ * Starts a real CS104 slave on loopback, opens NUM_MASTERS masters at the
+ * same time, runs a station interrogation on every one of them and reports
+ * the resident memory used per open connection.
+ */
+
+#define NUM_MASTERS 500
+#define TEST_PORT 22470
+#define GI_OBJECTS 20
+#define TIMEOUT_MS 30000
+
+typedef enum {
+    MASTER_CONNECTING,
+    MASTER_WAIT_STARTDT_CON,
+    MASTER_WAIT_GI_TERM,
+    MASTER_DONE
+} MasterState;
+
+typedef struct {
+    int fd;
+    MasterState state;
+    unsigned char buf[512];
+    int len;
+    int received_i;         // I-frames received
+    int received_objects;   // Information objects received with COT=20
+} TestMaster;
+
+static TestMaster masters[NUM_MASTERS];
+
+static const unsigned char STARTDT_ACT[] = { 0x68, 0x04, 0x07, 0x00, 0x00, 0x00 };
+
+// C_IC_NA_1, COT=6, CA=1, IOA=0, QOI=20 (I-frame with N(S)=0, N(R)=0)
+static const unsigned char GI_ACT[] = {
+    0x68, 0x0e, 0x00, 0x00, 0x00, 0x00,
+    0x64, 0x01, 0x06, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x14
+};
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static long read_rss_kb(void) {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+
+    char line[256];
+    long rss = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "VmRSS:", 6) == 0) {
+            rss = strtol(line + 6, NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return rss;
+}
+
+static void raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+static bool interrogation_handler(void* parameter, IMasterConnection connection,
+                                  CS101_ASDU asdu, uint8_t qoi) {
+    (void)parameter;
+    (void)qoi;
+
+    CS101_AppLayerParameters alParams = IMasterConnection_getApplicationLayerParameters(connection);
+
+    IMasterConnection_sendACT_CON(connection, asdu, false);
+
+    CS101_ASDU response = CS101_ASDU_create(alParams, false, CS101_COT_INTERROGATED_BY_STATION, 0, 1, false, false);
+    for (int i = 0; i < GI_OBJECTS; i++) {
+        InformationObject io = (InformationObject)MeasuredValueShort_create(NULL, 100 + i * 2, (float)i, IEC60870_QUALITY_GOOD);
+        CS101_ASDU_addInformationObject(response, io);
+        InformationObject_destroy(io);
+    }
+    IMasterConnection_sendASDU(connection, response);
+    CS101_ASDU_destroy(response);
+
+    IMasterConnection_sendACT_TERM(connection, asdu);
+    return true;
+}
+
+static void send_all(int fd, const unsigned char* data, int len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            perror("send");
+            assert(false);
+        }
+        data += n;
+        len -= (int)n;
+    }
+}
+
+// Consume complete APDUs from the master's buffer and advance its state
+static void process_apdus(TestMaster* m) {
+    int pos = 0;
+
+    while (m->len - pos >= 2) {
+        assert(m->buf[pos] == 0x68);
+        int apdu_len = m->buf[pos + 1] + 2;
+        if (m->len - pos < apdu_len) break;
+
+        const unsigned char* apdu = m->buf + pos;
+
+        if ((apdu[2] & 0x01) == 0) {
+            m->received_i++;
+
+            int type = apdu[6];
+            int count = apdu[7] & 0x7f;
+            int cot = apdu[8] & 0x3f;
+
+            if (cot == CS101_COT_INTERROGATED_BY_STATION) {
+                m->received_objects += count;
+            }
+            if (type == C_IC_NA_1 && cot == CS101_COT_ACTIVATION_TERMINATION) {
+                m->state = MASTER_DONE;
+            }
+        }
+        else if (apdu[2] == 0x0b && m->state == MASTER_WAIT_STARTDT_CON) {
+            m->state = MASTER_WAIT_GI_TERM;
+            send_all(m->fd, GI_ACT, sizeof(GI_ACT));
+        }
+
+        pos += apdu_len;
+    }
+
+    memmove(m->buf, m->buf + pos, m->len - pos);
+    m->len -= pos;
+}
+
+static bool open_master(TestMaster* m) {
+    memset(m, 0, sizeof(*m));
+
+    m->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (m->fd < 0) return false;
+
+    int one = 1;
+    setsockopt(m->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(m->fd, F_SETFL, fcntl(m->fd, F_GETFL) | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(m->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        close(m->fd);
+        return false;
+    }
+
+    m->state = MASTER_CONNECTING;
+    return true;
+}
+
+/**
+ * Drive all masters until every one has finished its GI or the timeout hits
+ * Masters already in MASTER_DONE are left alone.
+ * @return number of masters that completed the GI
+ */
+static int run_masters(int count) {
+    struct pollfd* fds = (struct pollfd*)calloc(count, sizeof(struct pollfd));
+    assert(fds != NULL);
+
+    uint64_t deadline = now_ms() + TIMEOUT_MS;
+    int pending = 0;
+    int done = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (masters[i].state != MASTER_DONE) pending++;
+    }
+
+    while (done < pending && now_ms() < deadline) {
+        for (int i = 0; i < count; i++) {
+            fds[i].fd = (masters[i].state == MASTER_DONE) ? -1 : masters[i].fd;
+            fds[i].events = (masters[i].state == MASTER_CONNECTING) ? POLLOUT : POLLIN;
+            fds[i].revents = 0;
+        }
+
+        if (poll(fds, count, 100) <= 0) continue;
+
+        for (int i = 0; i < count; i++) {
+            TestMaster* m = &masters[i];
+            if (fds[i].revents == 0) continue;
+
+            if (m->state == MASTER_CONNECTING) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(m->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                assert(err == 0);
+                m->state = MASTER_WAIT_STARTDT_CON;
+                send_all(m->fd, STARTDT_ACT, sizeof(STARTDT_ACT));
+                continue;
+            }
+
+            ssize_t n = recv(m->fd, m->buf + m->len, sizeof(m->buf) - m->len, 0);
+            if (n > 0) {
+                m->len += (int)n;
+                process_apdus(m);
+                if (m->state == MASTER_DONE) done++;
+            }
+            else if (n == 0) {
+                fprintf(stderr, "  master %d: connection closed by server\n", i);
+                assert(false);
+            }
+        }
+    }
+
+    free(fds);
+    return done;
+}
+
+static void wait_for_open_connections(CS104_Slave slave, int expected) {
+    uint64_t deadline = now_ms() + TIMEOUT_MS;
+    while (CS104_Slave_getOpenConnections(slave) != expected && now_ms() < deadline) {
+        usleep(10000);
+    }
+}
+
+static int clients_json_count(void) {
+    char* json_str = client_manager_get_clients_json();
+    cJSON* json = cJSON_Parse(json_str);
+    int count = cJSON_GetObjectItemCaseSensitive(json, "count")->valueint;
+    cJSON_Delete(json);
+    free(json_str);
+    return count;
+}
+
+static void run_scaling_test(const char* mode, int reactor_threads) {
+    printf("\nTesting %d masters with GI (%s)...\n", NUM_MASTERS, mode);
+
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+    assert(slave != NULL);
+
+    CS104_Slave_setLocalAddress(slave, "127.0.0.1");
+    CS104_Slave_setLocalPort(slave, TEST_PORT);
+    // Every master is its own redundancy group, so all of them can be active at once
+    CS104_Slave_setServerMode(slave, CS104_MODE_CONNECTION_IS_REDUNDANCY_GROUP);
+    CS104_Slave_setMaxOpenConnections(slave, NUM_MASTERS);
+    CS104_Slave_setInterrogationHandler(slave, interrogation_handler, NULL);
+    CS104_Slave_setConnectionEventHandler(slave, client_connection_event_handler, slave);
+
+    if (reactor_threads > 0) {
+        assert(CS104_Slave_setReactorThreads(slave, reactor_threads, false));
+    }
+
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    long rss_before = read_rss_kb();
+
+    for (int i = 0; i < NUM_MASTERS; i++) {
+        assert(open_master(&masters[i]));
+    }
+
+    uint64_t start = now_ms();
+    int done = run_masters(NUM_MASTERS);
+    uint64_t elapsed = now_ms() - start;
+
+    wait_for_open_connections(slave, NUM_MASTERS);
+    long rss_after = read_rss_kb();
+
+    printf("  %d/%d masters completed GI in %llu ms\n", done, NUM_MASTERS, (unsigned long long)elapsed);
+    assert(done == NUM_MASTERS);
+    assert(CS104_Slave_getOpenConnections(slave) == NUM_MASTERS);
+    assert(clients_json_count() == NUM_MASTERS);
+
+    for (int i = 0; i < NUM_MASTERS; i++) {
+        assert(masters[i].received_objects == GI_OBJECTS);
+        assert(masters[i].received_i == 3);
+    }
+
+    if (rss_before > 0 && rss_after > 0) {
+        printf("  RSS: %ld kB -> %ld kB (%.1f kB per connection, both ends)\n",
+               rss_before, rss_after, (double)(rss_after - rss_before) / NUM_MASTERS);
+    }
+
+    // A further master is refused once the table is full
+    TestMaster extra;
+    assert(open_master(&extra));
+    struct pollfd pfd = { extra.fd, POLLIN, 0 };
+    char c;
+    assert(poll(&pfd, 1, 5000) == 1);
+    assert(recv(extra.fd, &c, 1, 0) <= 0);
+    close(extra.fd);
+    assert(CS104_Slave_getOpenConnections(slave) == NUM_MASTERS);
+
+    // Close half of the masters; their slots are reused by new ones
+    for (int i = 0; i < NUM_MASTERS; i += 2) {
+        close(masters[i].fd);
+    }
+    wait_for_open_connections(slave, NUM_MASTERS / 2);
+    assert(CS104_Slave_getOpenConnections(slave) == NUM_MASTERS / 2);
+    assert(clients_json_count() == NUM_MASTERS / 2);
+
+    for (int i = 0; i < NUM_MASTERS; i += 2) {
+        assert(open_master(&masters[i]));
+    }
+    for (int i = 1; i < NUM_MASTERS; i += 2) {
+        masters[i].state = MASTER_DONE;
+    }
+    // Masters that stayed open do not take part in the second round
+    int reopened = 0;
+    for (int i = 0; i < NUM_MASTERS; i++) {
+        if (masters[i].state != MASTER_DONE) reopened++;
+    }
+    assert(run_masters(NUM_MASTERS) == reopened);
+    wait_for_open_connections(slave, NUM_MASTERS);
+    assert(CS104_Slave_getOpenConnections(slave) == NUM_MASTERS);
+
+    for (int i = 0; i < NUM_MASTERS; i++) {
+        close(masters[i].fd);
+    }
+
+    CS104_Slave_stop(slave);
+    assert(CS104_Slave_getOpenConnections(slave) == 0);
+    CS104_Slave_destroy(slave);
+
+    assert(clients_json_count() == 0);
+
+    printf("  ✓ %s handles %d concurrent masters\n", mode, NUM_MASTERS);
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running connection scaling test suite\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+    raise_fd_limit();
+    client_manager_init();
+
+    run_scaling_test("reactor mode", 2);
+    run_scaling_test("thread mode", 0);
+
+    client_manager_cleanup();
+
+    printf("\n===========================================\n");
+    printf("✓ All connection scaling tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
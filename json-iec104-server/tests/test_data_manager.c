@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 
 // Mock global variables
 uint32_t offline_udt_time = 10;
@@ -141,6 +142,104 @@ void test_null_params() {
     printf("  ✓ NULL parameters handled\n");
 }
 
+static void configure_context(DataTypeContext* ctx, int first_ioa, int count, int step) {
+    ctx->config.ioa_list = (int*)malloc(count * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        ctx->config.ioa_list[i] = first_ioa + i * step;
+    }
+    ctx->config.count = count;
+    ctx->data_array = (DataValue*)calloc(count, sizeof(DataValue));
+    for (int i = 0; i < count; i++) {
+        ctx->data_array[i].type = ctx->type_info->value_type;
+    }
+}
+
+void test_ioa_index() {
+    printf("\nTesting IOA index...\n");
+    init_data_contexts();
+
+    DataTypeContext* sp = get_data_context(M_SP_NA_1);
+    DataTypeContext* nc = get_data_context(M_ME_NC_1);
+    configure_context(sp, 1000, 500, 1);
+    configure_context(nc, 100000, 20000, 7);
+
+    DataTypeContext* ctx = NULL;
+    int idx = -1;
+
+    assert(!lookup_ioa(1000, &ctx, &idx));
+    printf("  ✓ Lookup before build finds nothing\n");
+
+    assert(build_ioa_index());
+
+    assert(lookup_ioa(1000, &ctx, &idx) && ctx == sp && idx == 0);
+    assert(lookup_ioa(1499, &ctx, &idx) && ctx == sp && idx == 499);
+    assert(lookup_ioa(100000 + 7 * 12345, &ctx, &idx) && ctx == nc && idx == 12345);
+    assert(!lookup_ioa(1500, &ctx, &idx));
+    assert(!lookup_ioa(100001, &ctx, &idx));
+    printf("  ✓ Lookup across types works\n");
+
+    for (int i = 0; i < nc->config.count; i++) {
+        assert(lookup_ioa(nc->config.ioa_list[i], &ctx, &idx) && idx == i);
+    }
+    printf("  ✓ All %d points found\n", nc->config.count);
+
+    cleanup_data_contexts();
+}
+
+typedef struct {
+    DataTypeContext* ctx;
+    volatile bool stop;
+} WriterArgs;
+
+// Writes values whose two halves always match, a torn read would not
+static void* float_writer(void* arg) {
+    WriterArgs* args = (WriterArgs*)arg;
+    DataValue val;
+    memset(&val, 0, sizeof(val));
+    val.type = DATA_VALUE_TYPE_FLOAT;
+
+    for (int n = 1; !args->stop; n++) {
+        val.value.float_val = (float)n;
+        val.quality = (QualityDescriptor)(n & 0x7f);
+        val.has_quality = true;
+        update_data(args->ctx, NULL, 300, &val);
+    }
+    return NULL;
+}
+
+void test_read_data_value() {
+    printf("\nTesting read_data_value() during updates...\n");
+    init_data_contexts();
+
+    float saved_deadband = deadband_M_ME_NC_1_percent;
+    deadband_M_ME_NC_1_percent = 0.0f;
+
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    configure_context(ctx, 300, 1, 1);
+
+    WriterArgs args = { ctx, false };
+    pthread_t writer;
+    pthread_create(&writer, NULL, float_writer, &args);
+
+    int reads = 0;
+    float last = 0.0f;
+    for (; reads < 200000 || last < 100000.0f; reads++) {
+        DataValue v;
+        read_data_value(ctx, 0, &v);
+        assert(v.type == DATA_VALUE_TYPE_FLOAT);
+        assert(v.value.float_val >= last);
+        assert(v.value.float_val == 0.0f || v.quality == (QualityDescriptor)((int)v.value.float_val & 0x7f));
+        last = v.value.float_val;
+    }
+
+    args.stop = true;
+    pthread_join(writer, NULL);
+    printf("  ✓ %d consistent reads while updating (last value %.0f)\n", reads, last);
+
+    deadband_M_ME_NC_1_percent = saved_deadband;
+    cleanup_data_contexts();
+}
+
 int main() {
     printf("===========================================\n");
     printf("Running data_manager test suite\n");
@@ -153,6 +252,8 @@ int main() {
     test_update_float();
     test_invalid_ioa();
     test_null_params();
+    test_ioa_index();
+    test_read_data_value();
 
     printf("\n===========================================\n");
     printf("✓ All data_manager tests passed!\n");
@@ -27,7 +27,7 @@ void test_lookup_by_type_id() {
     assert(info->value_type == DATA_VALUE_TYPE_BOOL);
     assert(info->has_time_tag == true);
     assert(info->has_quality == true);
-    assert(info->io_size == 8);
+    assert(info->io_size == 11);   // IOA + SIQ + CP56Time2a
     printf("  ✓ M_SP_TB_1 lookup correct\n");
 
     // Test M_ME_NC_1
@@ -38,7 +38,7 @@ void test_lookup_by_type_id() {
     assert(info->value_type == DATA_VALUE_TYPE_FLOAT);
     assert(info->has_time_tag == false);
     assert(info->has_quality == true);
-    assert(info->io_size == 6);
+    assert(info->io_size == 8);    // IOA + float + QDS
     printf("  ✓ M_ME_NC_1 lookup correct\n");
 
     // Test M_IT_TB_1
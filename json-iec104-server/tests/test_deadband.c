@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../src/config/config_parser.h"
+#include "../src/data/data_manager.h"
+#include "../src/data/deadband.h"
+#include "../src/utils/logger.h"
+#include "cs104_slave.h"
+
+/**
+ * Deadband tests
+ *
+ * Checks the absolute, percent (of a range and of the last value) and
+ * integrating modes through store_data_value(), the "deadband" config
+ * entries and their errors, and a change of exactly the band. Finally
+ * counts the events a noisy analogue produces with and without a deadband.
+ */
+
+// Mock global variables that config_parser expects
+uint32_t offline_udt_time = 0;
+float deadband_M_ME_NC_1_percent = 0.0f;
+int ASDU = 1;
+char command_mode[64] = "";
+int tcpPort = 2404;
+char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+CS101_AppLayerParameters alParameters = NULL;
+
+static bool load(const char* json) {
+    init_data_contexts();
+    bool ok = parse_config_from_json(json);
+    if (!ok) {
+        cleanup_data_contexts();
+    }
+    return ok;
+}
+
+static bool set_float(int ioa, float value) {
+    DataValue v;
+    memset(&v, 0, sizeof(v));
+    v.type = DATA_VALUE_TYPE_FLOAT;
+    v.value.float_val = value;
+    v.has_quality = true;
+    v.quality = IEC60870_QUALITY_GOOD;
+    return store_data_value(get_data_context(M_ME_NC_1), ioa, &v, NULL);
+}
+
+static bool set_scaled(int ioa, int16_t value) {
+    DataValue v;
+    memset(&v, 0, sizeof(v));
+    v.type = DATA_VALUE_TYPE_INT16;
+    v.value.int16_val = value;
+    v.has_quality = true;
+    v.quality = IEC60870_QUALITY_GOOD;
+    return store_data_value(get_data_context(M_ME_NB_1), ioa, &v, NULL);
+}
+
+static float stored_float(int ioa) {
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    return ctx->data_array[find_ioa_index(&ctx->config, ioa)].value.float_val;
+}
+
+void test_absolute() {
+    printf("\nTesting absolute deadband...\n");
+
+    assert(load("{\"M_ME_NC_1_config\": [[1, 10]], \"M_ME_NB_1_config\": [7],"
+                " \"deadband\": [{\"type\": \"M_ME_NC_1\", \"mode\": \"absolute\", \"value\": 0.5},"
+                " {\"type\": \"M_ME_NB_1\", \"mode\": \"absolute\", \"value\": 20}]}"));
+
+    assert(set_float(1, 10.0f));          // INVALID -> GOOD always counts
+    assert(!set_float(1, 10.4f));
+    assert(!set_float(1, 9.6f));
+    assert(stored_float(1) == 10.0f);     // Compared with the last reported value
+    assert(set_float(1, 10.6f));
+    assert(!set_float(1, 10.2f));
+    assert(stored_float(1) == 10.6f);
+    printf("  ✓ float changes within 0.5 suppressed\n");
+
+    assert(set_scaled(7, 100));
+    assert(!set_scaled(7, 115));
+    assert(!set_scaled(7, 81));
+    assert(set_scaled(7, 120));           // Exactly the band
+    assert(set_scaled(7, 100));
+    assert(!set_scaled(7, 100));
+    printf("  ✓ scaled changes below 20 suppressed, 20 reported\n");
+
+    cleanup_data_contexts();
+}
+
+void test_percent() {
+    printf("\nTesting percent deadband...\n");
+
+    // 2 % of [0, 500] = 10; IOA 2 has its band removed by a later entry
+    assert(load("{\"M_ME_NC_1_config\": [[1, 3]],"
+                " \"deadband\": [{\"type\": \"M_ME_NC_1\", \"mode\": \"percent\", \"value\": 2, \"range\": [0, 500]},"
+                " {\"type\": \"M_ME_NC_1\", \"mode\": \"none\", \"ioas\": [2, 99]}]}"));
+
+    assert(get_data_context(M_ME_NC_1)->deadband->configured == 2);
+    assert(set_float(1, 100.0f));
+    assert(!set_float(1, 109.0f));
+    assert(set_float(1, 110.0f));         // Exactly 2 % of the range
+    assert(!set_float(1, 119.0f));
+    assert(set_float(1, 121.0f));
+    assert(set_float(2, 100.0f));
+    assert(set_float(2, 100.001f));
+    printf("  ✓ percent of range, later entry overrides\n");
+    cleanup_data_contexts();
+
+    // Global setting: percent of the last value
+    deadband_M_ME_NC_1_percent = 5.0f;
+    assert(load("{\"M_ME_NC_1_config\": [1]}"));
+    assert(set_float(1, 100.0f));
+    assert(!set_float(1, 104.0f));
+    assert(set_float(1, 106.0f));
+    assert(!set_float(1, 111.0f));        // 5 % of 106
+    deadband_M_ME_NC_1_percent = 0.0f;
+    cleanup_data_contexts();
+
+    // Without deadband every change counts, however small
+    assert(load("{\"M_ME_NC_1_config\": [1]}"));
+    assert(get_data_context(M_ME_NC_1)->deadband == NULL);
+    assert(set_float(1, 1.0f));
+    assert(set_float(1, 1.00001f));
+    assert(!set_float(1, 1.00001f));
+    cleanup_data_contexts();
+    printf("  ✓ deadband_M_ME_NC_1_percent relative to the last value\n");
+}
+
+void test_integrating() {
+    printf("\nTesting integrating deadband...\n");
+
+    DeadbandBands* bands = deadband_create(1);
+    assert(bands);
+    assert(deadband_set(bands, 0, DEADBAND_INTEGRATING, 10.0f, NULL));
+    assert(!deadband_set(bands, 0, DEADBAND_INTEGRATING, 0.0f, NULL));
+
+    // A deviation of 1 is reported once it has lasted 10 s ...
+    deadband_reset(bands, 0, 0);
+    assert(!deadband_check(bands, 0, 0.0f, 1.0f, 1000));
+    assert(!deadband_check(bands, 0, 0.0f, 1.0f, 5000));
+    assert(!deadband_check(bands, 0, 0.0f, 1.0f, 10000));
+    assert(deadband_check(bands, 0, 0.0f, 1.0f, 11000));
+
+    // ... a deviation of 50 after 200 ms
+    assert(!deadband_check(bands, 0, 1.0f, 51.0f, 11100));
+    assert(deadband_check(bands, 0, 1.0f, 51.0f, 11300));
+
+    // Returning to the reported value clears the integral
+    deadband_reset(bands, 0, 20000);
+    assert(!deadband_check(bands, 0, 5.0f, 6.0f, 25000));
+    assert(!deadband_check(bands, 0, 5.0f, 5.0f, 29000));
+    assert(!deadband_check(bands, 0, 5.0f, 6.0f, 60000));
+    assert(!deadband_check(bands, 0, 5.0f, 6.0f, 65000));
+    assert(deadband_check(bands, 0, 5.0f, 6.0f, 70000));
+
+    // A small step after a long idle period only counts from the step on
+    deadband_reset(bands, 0, 100000);
+    assert(!deadband_check(bands, 0, 5.0f, 5.5f, 400000));
+    assert(!deadband_check(bands, 0, 5.0f, 5.5f, 410000));
+    assert(deadband_check(bands, 0, 5.0f, 5.5f, 420000));
+
+    deadband_free(bands);
+    printf("  ✓ reported when deviation x time reaches the limit\n");
+}
+
+void test_config_errors() {
+    printf("\nTesting invalid deadband entries...\n");
+
+    assert(!load("{\"M_ME_NC_1_config\": [1], \"deadband\": [{\"type\": \"M_ME_NC_1\", \"mode\": \"bogus\", \"value\": 1}]}"));
+    assert(!load("{\"M_SP_NA_1_config\": [1], \"deadband\": [{\"type\": \"M_SP_NA_1\", \"mode\": \"absolute\", \"value\": 1}]}"));
+    assert(!load("{\"M_ME_NC_1_config\": [1], \"deadband\": [{\"type\": \"M_ME_NC_1\", \"mode\": \"absolute\"}]}"));
+    assert(!load("{\"M_ME_NC_1_config\": [1], \"deadband\": [{\"type\": \"M_ME_NC_1\", \"mode\": \"absolute\", \"value\": -1}]}"));
+    assert(!load("{\"M_ME_NC_1_config\": [1], \"deadband\": [{\"type\": \"M_ME_NC_1\", \"mode\": \"percent\", \"value\": 1, \"range\": [5, 5]}]}"));
+    assert(!load("{\"M_ME_NC_1_config\": [1], \"deadband\": [{\"type\": \"M_ME_NC_1\", \"mode\": \"integrating\", \"value\": 0}]}"));
+    printf("  ✓ unknown mode, non-measurand, missing or negative value, empty range rejected\n");
+
+    // Types without points and unknown IOAs are skipped
+    assert(load("{\"M_ME_NC_1_config\": [1], \"deadband\": [{\"type\": \"M_ME_NA_1\", \"mode\": \"absolute\", \"value\": 1},"
+                " {\"type\": \"M_ME_NC_1\", \"mode\": \"absolute\", \"value\": 1, \"ioas\": [[1, 5]]}]}"));
+    assert(get_data_context(M_ME_NA_1)->deadband == NULL);
+    assert(get_data_context(M_ME_NC_1)->deadband->configured == 1);
+    cleanup_data_contexts();
+    printf("  ✓ unconfigured type and IOAs skipped\n");
+}
+
+// Events of 1000 noisy analogues (noise +-0.2, slow drift) over 200 samples
+static int count_events(const char* json) {
+    assert(load(json));
+    srand(7);
+    int events = 0;
+    for (int round = 0; round < 200; round++) {
+        for (int ioa = 1; ioa <= 1000; ioa++) {
+            float noise = (float)(rand() % 41 - 20) / 100.0f;
+            events += set_float(ioa, 230.0f + round * 0.02f + noise);
+        }
+    }
+    cleanup_data_contexts();
+    return events;
+}
+
+void test_event_flood() {
+    printf("\nTesting events of noisy analogues...\n");
+
+    int without = count_events("{\"M_ME_NC_1_config\": [[1, 1000]]}");
+    int with = count_events("{\"M_ME_NC_1_config\": [[1, 1000]],"
+                            " \"deadband\": [{\"type\": \"M_ME_NC_1\", \"mode\": \"absolute\", \"value\": 1.0}]}");
+
+    printf("  %d events without deadband, %d with 1.0 absolute\n", without, with);
+    assert(with * 20 < without);
+    assert(with >= 1000 * 2);     // The drift of 4.0 is still reported
+    printf("  ✓ noise suppressed, drift reported\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running deadband test suite\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+
+    test_absolute();
+    test_percent();
+    test_integrating();
+    test_config_errors();
+    test_event_flood();
+
+    printf("\n===========================================\n");
+    printf("✓ All deadband tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../src/config/config_parser.h"
+#include "../src/utils/event_output.h"
+#include "../src/utils/logger.h"
+#include "../cJSON/cJSON.h"
+
+/**
+ * Event output tests
+ *
+ * Checks the stdout fallback, the "fd:N", FIFO and file targets, that
+ * events from several threads arrive complete and numbered in order with
+ * few writes, that a stalled consumer loses events (seen as sequence gaps
+ * and reported to the emitter) without blocking the emitters or shutdown,
+ * and compares the cost per event with the
+ * printf and fflush per line on stdout.
+ */
+
+// Mock global variables that config_parser expects
+struct sCS101_AppLayerParameters alParams_struct = { 1, 1, 2, 0, 2, 3, 249 };
+CS101_AppLayerParameters alParameters = &alParams_struct;
+uint32_t offline_udt_time = 3600;
+float deadband_M_ME_NC_1_percent = 0.0f;
+int ASDU = 1;
+char command_mode[64] = "";
+int tcpPort = 2404;
+char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+
+#define TEST_FIFO "/tmp/test_event_output.fifo"
+#define TEST_FILE "/tmp/test_event_output.jsonl"
+#define EMIT_THREADS 4
+#define EVENTS_PER_THREAD 2000
+#define BENCH_EVENTS 10000
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Reader of a pipe, collects everything until end of file
+ */
+typedef struct {
+    int fd;
+    char* data;
+    size_t len;
+    size_t capacity;
+    pthread_t thread;
+} Reader;
+
+static void* reader_thread(void* arg) {
+    Reader* r = (Reader*)arg;
+    for (;;) {
+        if (r->capacity - r->len < 65536) {
+            r->capacity = r->capacity ? r->capacity * 2 : 1 << 20;
+            r->data = (char*)realloc(r->data, r->capacity);
+            assert(r->data != NULL);
+        }
+        ssize_t n = read(r->fd, r->data + r->len, r->capacity - r->len - 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        r->len += (size_t)n;
+    }
+    r->data[r->len] = '\0';
+    return NULL;
+}
+
+static void reader_start(Reader* r, int fd) {
+    memset(r, 0, sizeof(*r));
+    r->fd = fd;
+    assert(pthread_create(&r->thread, NULL, reader_thread, r) == 0);
+}
+
+static void reader_join(Reader* r) {
+    pthread_join(r->thread, NULL);
+    close(r->fd);
+}
+
+/**
+ * Check every line is a JSON object with ascending sequence numbers
+ *
+ * @return number of lines; *gaps receives the sequence numbers missing
+ */
+static int check_lines(char* data, uint64_t* last_seq, uint64_t* gaps) {
+    int lines = 0;
+    uint64_t expected = 1;
+    *gaps = 0;
+
+    char* save = NULL;
+    for (char* line = strtok_r(data, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        cJSON* obj = cJSON_Parse(line);
+        assert(obj != NULL);
+        cJSON* seq = cJSON_GetObjectItem(obj, "seq");
+        assert(cJSON_IsNumber(seq));
+        assert((uint64_t)seq->valuedouble >= expected);
+        *gaps += (uint64_t)seq->valuedouble - expected;
+        expected = (uint64_t)seq->valuedouble + 1;
+        assert(cJSON_GetObjectItem(obj, "type") != NULL);
+        cJSON_Delete(obj);
+        lines++;
+    }
+    *last_seq = expected - 1;
+    return lines;
+}
+
+void test_config() {
+    printf("\nTesting event_output configuration...\n");
+
+    cJSON* root = cJSON_Parse("{\"event_output\": \"fd:3\"}");
+    assert(parse_global_settings(root));
+    cJSON_Delete(root);
+    assert(strcmp(event_output, "fd:3") == 0);
+    event_output[0] = '\0';
+    printf("  ✓ event_output parsed\n");
+
+    assert(!event_output_open(NULL));
+    assert(!event_output_open(""));
+    assert(!event_output_open("fd:"));
+    assert(!event_output_open("fd:x"));
+    assert(!event_output_open("fd:-1"));
+    assert(!event_output_open("fd:1000"));
+    assert(!event_output_open("/nonexistent/dir/events"));
+
+    EventOutputStats stats;
+    event_output_get_stats(&stats);
+    assert(!stats.active);
+    printf("  ✓ Invalid targets rejected\n");
+}
+
+void test_stdout_fallback() {
+    printf("\nTesting stdout without a channel...\n");
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    dup2(fds[1], STDOUT_FILENO);
+
+    event_output_emit("\"type\":\"C_RP_NA_1\",\"action\":\"reset\",\"address\":%d,\"qrp\":%d", 0, 1);
+
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(fds[1]);
+
+    char buf[256];
+    ssize_t n = read(fds[0], buf, sizeof(buf) - 1);
+    close(fds[0]);
+    assert(n > 0);
+    buf[n] = '\0';
+    assert(strcmp(buf, "{\"type\":\"C_RP_NA_1\",\"action\":\"reset\",\"address\":0,\"qrp\":1}\n") == 0);
+    printf("  ✓ Printed on stdout as before, without sequence number\n");
+}
+
+static void* emit_thread(void* arg) {
+    int base = *(int*)arg;
+    for (int i = 0; i < EVENTS_PER_THREAD; i++) {
+        event_output_emit("\"type\":\"C_SC_NA_1\",\"action\":\"execute\",\"mode\":\"direct\",\"address\":%d,\"value\":\"on\"",
+                          base + i);
+    }
+    return NULL;
+}
+
+void test_descriptor() {
+    printf("\nTesting fd target with %d threads...\n", EMIT_THREADS);
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+    Reader reader;
+    reader_start(&reader, fds[0]);
+
+    char target[32];
+    snprintf(target, sizeof(target), "fd:%d", fds[1]);
+    assert(event_output_open(target));
+    assert(!event_output_open(target));
+
+    pthread_t threads[EMIT_THREADS];
+    int bases[EMIT_THREADS];
+    for (int t = 0; t < EMIT_THREADS; t++) {
+        bases[t] = t * EVENTS_PER_THREAD;
+        assert(pthread_create(&threads[t], NULL, emit_thread, &bases[t]) == 0);
+    }
+    for (int t = 0; t < EMIT_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    event_output_close();
+    EventOutputStats stats;
+    event_output_get_stats(&stats);
+
+    // Not owned: the descriptor stays open until the test closes it
+    assert(fcntl(fds[1], F_GETFD) >= 0);
+    close(fds[1]);
+    reader_join(&reader);
+
+    uint64_t last_seq, gaps;
+    int lines = check_lines(reader.data, &last_seq, &gaps);
+    free(reader.data);
+
+    printf("  %d events in %llu writes (%.1f events per write)\n", lines,
+           (unsigned long long)stats.writes, (double)lines / stats.writes);
+    assert(lines == EMIT_THREADS * EVENTS_PER_THREAD);
+    assert(gaps == 0 && last_seq == (uint64_t)lines);
+    assert(stats.events == (uint64_t)lines && stats.dropped == 0 && stats.write_errors == 0);
+    assert(stats.writes < stats.events);
+    printf("  ✓ All events complete, numbered 1..%d in order\n", lines);
+}
+
+void test_fifo_and_file() {
+    printf("\nTesting FIFO and file targets...\n");
+
+    // The FIFO opens without a consumer, events wait in the pipe
+    unlink(TEST_FIFO);
+    assert(mkfifo(TEST_FIFO, 0600) == 0);
+    assert(event_output_open(TEST_FIFO));
+    event_output_emit("\"type\":\"C_CS_NA_1\",\"value\":\"%s\"", "2026-01-01T00:00:00+0000");
+
+    int fd = open(TEST_FIFO, O_RDONLY);
+    assert(fd >= 0);
+    char buf[256];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    assert(n > 0);
+    buf[n] = '\0';
+    assert(strcmp(buf, "{\"seq\":1,\"type\":\"C_CS_NA_1\",\"value\":\"2026-01-01T00:00:00+0000\"}\n") == 0);
+    close(fd);
+    event_output_close();
+    unlink(TEST_FIFO);
+    printf("  ✓ FIFO opened before its consumer\n");
+
+    // Files are appended; numbering restarts with each open
+    unlink(TEST_FILE);
+    for (int run = 0; run < 2; run++) {
+        assert(event_output_open(TEST_FILE));
+        event_output_emit("\"type\":\"C_RP_NA_1\",\"address\":%d", run);
+        event_output_close();
+    }
+
+    FILE* f = fopen(TEST_FILE, "r");
+    assert(f != NULL);
+    char line1[128], line2[128];
+    assert(fgets(line1, sizeof(line1), f) && fgets(line2, sizeof(line2), f));
+    fclose(f);
+    unlink(TEST_FILE);
+    assert(strcmp(line1, "{\"seq\":1,\"type\":\"C_RP_NA_1\",\"address\":0}\n") == 0);
+    assert(strcmp(line2, "{\"seq\":1,\"type\":\"C_RP_NA_1\",\"address\":1}\n") == 0);
+    printf("  ✓ File appended\n");
+}
+
+void test_stalled_consumer() {
+    printf("\nTesting a stalled consumer...\n");
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+    char target[32];
+    snprintf(target, sizeof(target), "fd:%d", fds[1]);
+    assert(event_output_open(target));
+
+    // Nobody reads: the pipe and then the ring fill up
+    char padding[301];
+    memset(padding, 'x', sizeof(padding) - 1);
+    padding[sizeof(padding) - 1] = '\0';
+
+    int total = (EVENT_OUTPUT_RING_BYTES / 300) * 4;
+    uint64_t rejected = 0;
+    double start = now_s();
+    for (int i = 0; i < total; i++) {
+        if (!event_output_emit("\"type\":\"C_SE_NC_1\",\"address\":%d,\"pad\":\"%s\"", i, padding)) {
+            rejected++;
+        }
+    }
+    double elapsed = now_s() - start;
+
+    EventOutputStats stats;
+    event_output_get_stats(&stats);
+    printf("  %d events in %.1f ms while stalled, %llu dropped\n", total, elapsed * 1000,
+           (unsigned long long)stats.dropped);
+    assert(stats.dropped > 0);
+    assert(rejected == stats.dropped);
+    assert(stats.last_seq == (uint64_t)total);
+    assert(elapsed < 5.0);
+
+    // Once the consumer reads again, every event that was kept arrives
+    Reader reader;
+    reader_start(&reader, fds[0]);
+    event_output_close();
+    event_output_get_stats(&stats);
+    close(fds[1]);
+    reader_join(&reader);
+
+    uint64_t last_seq, gaps;
+    int lines = check_lines(reader.data, &last_seq, &gaps);
+    free(reader.data);
+
+    assert((uint64_t)lines == stats.events);
+    assert(gaps + (total - last_seq) == stats.dropped);
+    printf("  ✓ Emitters not blocked, %llu lost events seen as sequence gaps\n",
+           (unsigned long long)stats.dropped);
+}
+
+void test_close_without_consumer() {
+    printf("\nTesting close with a FIFO nobody reads...\n");
+
+    unlink(TEST_FIFO);
+    assert(mkfifo(TEST_FIFO, 0600) == 0);
+    assert(event_output_open(TEST_FIFO));
+
+    // Far more than the pipe holds, so the writer waits for a reader
+    char padding[301];
+    memset(padding, 'x', sizeof(padding) - 1);
+    padding[sizeof(padding) - 1] = '\0';
+    for (int i = 0; i < 2000; i++) {
+        assert(event_output_emit("\"type\":\"C_SE_NC_1\",\"address\":%d,\"pad\":\"%s\"", i, padding));
+    }
+
+    double start = now_s();
+    event_output_close();
+    double elapsed = now_s() - start;
+    unlink(TEST_FIFO);
+
+    EventOutputStats stats;
+    event_output_get_stats(&stats);
+    printf("  close took %.0f ms, %llu bytes written\n", elapsed * 1000,
+           (unsigned long long)stats.bytes);
+    assert(!stats.active);
+    assert(elapsed >= EVENT_OUTPUT_CLOSE_MS / 1000.0 * 0.9);
+    assert(elapsed < EVENT_OUTPUT_CLOSE_MS / 1000.0 + 1.0);
+    assert(stats.bytes < 2000 * 300);
+
+    // Without a channel events go to stdout again
+    assert(event_output_emit("\"info\":\"after close\""));
+    printf("  ✓ Close bounded, unread events discarded\n");
+}
+
+/**
+ * Emitter cost per event against a printf and fflush per line into a pipe,
+ * with a consumer draining the pipe in both cases
+ */
+void test_throughput() {
+    printf("\nTesting emitter cost (%d events)...\n", BENCH_EVENTS);
+
+    int fds[2];
+    Reader reader;
+
+    // printf per line on stdout
+    assert(pipe(fds) == 0);
+    reader_start(&reader, fds[0]);
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    dup2(fds[1], STDOUT_FILENO);
+
+    double start = now_s();
+    for (int i = 0; i < BENCH_EVENTS; i++) {
+        event_output_emit("\"type\":\"C_SC_NA_1\",\"action\":\"execute\",\"address\":%d,\"value\":\"on\"", i);
+    }
+    double stdout_s = now_s() - start;
+
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(fds[1]);
+    reader_join(&reader);
+    free(reader.data);
+
+    // Channel
+    assert(pipe(fds) == 0);
+    reader_start(&reader, fds[0]);
+    char target[32];
+    snprintf(target, sizeof(target), "fd:%d", fds[1]);
+    assert(event_output_open(target));
+
+    start = now_s();
+    for (int i = 0; i < BENCH_EVENTS; i++) {
+        event_output_emit("\"type\":\"C_SC_NA_1\",\"action\":\"execute\",\"address\":%d,\"value\":\"on\"", i);
+    }
+    double channel_s = now_s() - start;
+
+    event_output_close();
+    EventOutputStats stats;
+    event_output_get_stats(&stats);
+    close(fds[1]);
+    reader_join(&reader);
+    free(reader.data);
+
+    printf("  stdout, fflush per line: %6.0f ns/event, %d writes\n", stdout_s * 1e9 / BENCH_EVENTS, BENCH_EVENTS);
+    printf("  event channel:           %6.0f ns/event, %llu writes, %llu dropped\n",
+           channel_s * 1e9 / BENCH_EVENTS, (unsigned long long)stats.writes, (unsigned long long)stats.dropped);
+    assert(stats.events == BENCH_EVENTS && stats.dropped == 0);
+    printf("  ✓ Measured\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running event output test suite\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+
+    test_config();
+    test_stdout_fallback();
+    test_descriptor();
+    test_fifo_and_file();
+    test_stalled_consumer();
+    test_close_without_consumer();
+    test_throughput();
+
+    printf("\n===========================================\n");
+    printf("✓ All event output tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
@@ -3,6 +3,8 @@
 #include <string.h>
 #include <assert.h>
 #include "../src/protocol/interrogation.h"
+#include "../src/protocol/counter_interrogation.h"
+#include "../src/protocol/asdu_pool.h"
 #include "../src/data/data_manager.h"
 #include "../src/data/data_types.h"
 
@@ -22,10 +24,18 @@ typedef struct {
     bool act_con_sent;
     bool act_term_sent;
     bool negative_con;
+    int last_cot;
+    int counter_count;          // Integrated totals received
+    uint32_t counter_values[16];
+    int counter_sequence;       // Sequence number of the last counter reading
+    int locked_sends;           // ASDUs sent while probe_ctx->mutex was held
 } MockConnection;
 
 static MockConnection mock_conn;
 
+// When set, every sent ASDU checks whether this context's mutex is held
+static DataTypeContext* probe_ctx = NULL;
+
 // Mock IMasterConnection_sendASDU - must return bool
 bool IMasterConnection_sendASDU(IMasterConnection connection, CS101_ASDU asdu) {
     (void)connection;
@@ -34,6 +44,28 @@ bool IMasterConnection_sendASDU(IMasterConnection connection, CS101_ASDU asdu) {
     // Count IOs in this ASDU
     int num_ios = CS101_ASDU_getNumberOfElements(asdu);
     mock_conn.io_count += num_ios;
+    mock_conn.last_cot = CS101_ASDU_getCOT(asdu);
+
+    if (CS101_ASDU_getTypeID(asdu) == M_IT_TB_1) {
+        for (int i = 0; i < num_ios; i++) {
+            InformationObject io = CS101_ASDU_getElement(asdu, i);
+            BinaryCounterReading bcr = IntegratedTotals_getBCR((IntegratedTotals)io);
+            if (mock_conn.counter_count < 16) {
+                mock_conn.counter_values[mock_conn.counter_count] = (uint32_t)BinaryCounterReading_getValue(bcr);
+            }
+            mock_conn.counter_count++;
+            mock_conn.counter_sequence = BinaryCounterReading_getSequenceNumber(bcr);
+            InformationObject_destroy(io);
+        }
+    }
+
+    if (probe_ctx) {
+        if (pthread_mutex_trylock(&probe_ctx->mutex) == 0) {
+            pthread_mutex_unlock(&probe_ctx->mutex);
+        } else {
+            mock_conn.locked_sends++;
+        }
+    }
     
     printf("  Mock: Sent ASDU with %d IOs (total: %d ASDUs, %d IOs)\n",
            num_ios, mock_conn.asdu_count, mock_conn.io_count);
@@ -201,11 +233,12 @@ void test_send_interrogation_chunking() {
     init_data_contexts();
     
     // Create a large dataset that will require multiple ASDUs
+    // (IOAs with gaps, consecutive ones would pack into one SQ=1 ASDU)
     DataTypeContext* ctx = get_data_context(M_SP_NA_1);
     int large_count = 100;
     ctx->config.ioa_list = (int*)malloc(large_count * sizeof(int));
     for (int i = 0; i < large_count; i++) {
-        ctx->config.ioa_list[i] = 1000 + i;
+        ctx->config.ioa_list[i] = 1000 + 2 * i;
     }
     ctx->config.count = large_count;
     ctx->data_array = (DataValue*)calloc(large_count, sizeof(DataValue));
@@ -245,6 +278,166 @@ void test_send_interrogation_null_params() {
     printf("  ✓ NULL parameters handled correctly\n");
 }
 
+void test_asdu_pool_reuse() {
+    printf("\nTesting asdu_pool_acquire() buffer reuse...\n");
+
+    CS101_ASDU first = asdu_pool_acquire(alParameters, true, CS101_COT_PERIODIC, 7);
+    assert(first != NULL);
+
+    InformationObject io = (InformationObject)SinglePointInformation_create(
+        NULL, 500, true, IEC60870_QUALITY_GOOD);
+    assert(CS101_ASDU_addInformationObject(first, io) == true);
+    InformationObject_destroy(io);
+    assert(CS101_ASDU_getNumberOfElements(first) == 1);
+
+    // Same thread gets the same buffer back, with a fresh header and no elements
+    CS101_ASDU second = asdu_pool_acquire(alParameters, false, CS101_COT_SPONTANEOUS, 3);
+    assert(second == first);
+    assert(CS101_ASDU_getNumberOfElements(second) == 0);
+    assert(CS101_ASDU_isSequence(second) == false);
+    assert(CS101_ASDU_getCOT(second) == CS101_COT_SPONTANEOUS);
+    assert(CS101_ASDU_getCA(second) == 3);
+
+    printf("  ✓ Thread-local ASDU is reused and re-initialized\n");
+}
+
+void test_interrogation_packs_scattered_ioas() {
+    printf("\nTesting interrogation packing of scattered IOAs...\n");
+
+    reset_mock_connection();
+    init_data_contexts();
+
+    // 4 scattered IOAs share one SQ=0 ASDU, 20-22 go into one SQ=1 ASDU
+    int ioas[] = {1, 5, 9, 13, 20, 21, 22};
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    ctx->config.ioa_list = (int*)malloc(7 * sizeof(int));
+    memcpy(ctx->config.ioa_list, ioas, sizeof(ioas));
+    ctx->config.count = 7;
+    ctx->data_array = (DataValue*)calloc(7, sizeof(DataValue));
+    for (int i = 0; i < 7; i++) {
+        ctx->data_array[i].type = DATA_VALUE_TYPE_FLOAT;
+        ctx->data_array[i].has_quality = true;
+    }
+
+    bool result = send_interrogation_for_type((IMasterConnection)&mock_conn, ctx, 1);
+
+    assert(result == true);
+    assert(mock_conn.asdu_count == 2);
+    assert(mock_conn.io_count == 7);
+
+    cleanup_data_contexts();
+
+    printf("  ✓ Scattered IOAs packed into %d ASDUs\n", mock_conn.asdu_count);
+}
+
+// Configure M_IT_TB_1 counters 400.. with values 10, 20, 30, ...
+static DataTypeContext* setup_counters(int count) {
+    DataTypeContext* ctx = get_data_context(M_IT_TB_1);
+    ctx->config.ioa_list = (int*)malloc(count * sizeof(int));
+    ctx->data_array = (DataValue*)calloc(count, sizeof(DataValue));
+    for (int i = 0; i < count; i++) {
+        ctx->config.ioa_list[i] = 400 + i;
+        ctx->data_array[i].type = DATA_VALUE_TYPE_UINT32;
+        ctx->data_array[i].value.uint32_val = (uint32_t)(10 * (i + 1));
+        ctx->data_array[i].has_timestamp = true;
+    }
+    ctx->config.count = count;
+    return ctx;
+}
+
+static void send_counter_command(QualifierOfCIC qcc) {
+    reset_mock_connection();
+
+    CS101_ASDU asdu = CS101_ASDU_create(alParameters, false, CS101_COT_ACTIVATION,
+                                        0, 1, false, false);
+    counterInterrogationHandler(NULL, (IMasterConnection)&mock_conn, asdu, qcc);
+    CS101_ASDU_destroy(asdu);
+}
+
+void test_counter_interrogation() {
+    printf("\nTesting counter interrogation (C_CI_NA_1)...\n");
+
+    init_data_contexts();
+    DataTypeContext* ctx = setup_counters(4);
+
+    // Read without a prior freeze reports the current values
+    send_counter_command(IEC60870_QCC_RQT_GENERAL | IEC60870_QCC_FRZ_READ);
+    assert(mock_conn.act_con_sent && !mock_conn.negative_con && mock_conn.act_term_sent);
+    assert(mock_conn.asdu_count == 1);
+    assert(mock_conn.counter_count == 4);
+    assert(mock_conn.last_cot == CS101_COT_REQUESTED_BY_GENERAL_COUNTER);
+    assert(mock_conn.counter_values[0] == 10 && mock_conn.counter_values[3] == 40);
+
+    // Live updates do not change the frozen values
+    DataValue value;
+    memset(&value, 0, sizeof(value));
+    value.type = DATA_VALUE_TYPE_UINT32;
+    value.value.uint32_val = 15;
+    update_data(ctx, NULL, 400, &value);
+
+    send_counter_command(IEC60870_QCC_RQT_GENERAL | IEC60870_QCC_FRZ_READ);
+    assert(mock_conn.counter_values[0] == 10);
+    int first_sequence = mock_conn.counter_sequence;
+
+    // Freeze without reset: no data, next read sees the update
+    send_counter_command(IEC60870_QCC_RQT_GENERAL | IEC60870_QCC_FRZ_FREEZE_WITHOUT_RESET);
+    assert(mock_conn.act_con_sent && !mock_conn.negative_con && mock_conn.act_term_sent);
+    assert(mock_conn.asdu_count == 0);
+
+    send_counter_command(IEC60870_QCC_RQT_GENERAL | IEC60870_QCC_FRZ_READ);
+    assert(mock_conn.counter_values[0] == 15);
+    assert(mock_conn.counter_sequence == ((first_sequence + 1) & 0x1f));
+    assert(ctx->data_array[0].value.uint32_val == 15);
+
+    // Freeze with reset: frozen keeps the values, live counters restart at 0
+    send_counter_command(IEC60870_QCC_RQT_GENERAL | IEC60870_QCC_FRZ_FREEZE_WITH_RESET);
+    assert(ctx->data_array[0].value.uint32_val == 0);
+    assert(ctx->data_array[3].value.uint32_val == 0);
+
+    send_counter_command(IEC60870_QCC_RQT_GENERAL | IEC60870_QCC_FRZ_READ);
+    assert(mock_conn.counter_values[0] == 15 && mock_conn.counter_values[3] == 40);
+
+    // Counter reset only touches the live values
+    ctx->data_array[1].value.uint32_val = 99;
+    send_counter_command(IEC60870_QCC_RQT_GENERAL | IEC60870_QCC_FRZ_COUNTER_RESET);
+    assert(mock_conn.asdu_count == 0);
+    assert(ctx->data_array[1].value.uint32_val == 0);
+
+    // Counter groups are not supported
+    send_counter_command(IEC60870_QCC_RQT_GROUP_1 | IEC60870_QCC_FRZ_READ);
+    assert(mock_conn.negative_con == true);
+    assert(mock_conn.act_term_sent == false);
+
+    cleanup_data_contexts();
+
+    printf("  ✓ Read, freeze, freeze with reset and counter reset handled\n");
+}
+
+void test_counter_read_does_not_lock_updates() {
+    printf("\nTesting counter read without locking counter updates...\n");
+
+    init_data_contexts();
+    DataTypeContext* ctx = setup_counters(1000);
+
+    assert(counter_freeze_all(false));
+
+    reset_mock_connection();
+    probe_ctx = ctx;
+    bool result = send_counter_interrogation_for_type((IMasterConnection)&mock_conn, ctx,
+                                                      CS101_COT_REQUESTED_BY_GENERAL_COUNTER);
+    probe_ctx = NULL;
+
+    assert(result == true);
+    assert(mock_conn.io_count == 1000);
+    assert(mock_conn.asdu_count > 1);
+    assert(mock_conn.locked_sends == 0);
+
+    cleanup_data_contexts();
+
+    printf("  ✓ %d ASDUs streamed from the frozen buffer, live mutex never held\n",
+           mock_conn.asdu_count);
+}
+
 int main() {
     printf("===========================================\n");
     printf("Running interrogation test suite\n");
@@ -261,6 +454,10 @@ int main() {
     test_interrogation_with_data();
     test_interrogation_unsupported_qoi();
     test_send_interrogation_for_type();
+    test_interrogation_packs_scattered_ioas();
+    test_counter_interrogation();
+    test_counter_read_does_not_lock_updates();
+    test_asdu_pool_reuse();
     test_send_interrogation_chunking();
     test_send_interrogation_null_params();
     
@@ -0,0 +1,397 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../src/config/config_parser.h"
+#include "../src/data/data_manager.h"
+#include "../src/data/offline_buffer.h"
+#include "../src/protocol/offline_sender.h"
+#include "../src/utils/logger.h"
+#include "../cJSON/cJSON.h"
+#include "cs104_slave.h"
+
+/**
+ * Offline buffering tests
+ *
+ * Checks the three offline policies through update_data_send_type() (send
+ * type, rate limit, per-point intervals), the flush of held values on
+ * activation and its ordering against a concurrent update, the coalescing
+ * queue mode, the "offline" config entries and
+ * their errors, and the number of events each policy queues for a burst of
+ * updates while offline.
+ */
+
+// Mock global variables that config_parser expects
+struct sCS101_AppLayerParameters alParams_struct = { 1, 1, 2, 0, 2, 3, 249 };
+CS101_AppLayerParameters alParameters = &alParams_struct;
+uint32_t offline_udt_time = 3600;
+float deadband_M_ME_NC_1_percent = 0.0f;
+int ASDU = 1;
+char command_mode[64] = "";
+int tcpPort = 2404;
+char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+
+// Mock slave: counts enqueued ASDUs/IOs and records the type sent
+static int mock_slave_dummy;
+static CS104_Slave mock_slave = (CS104_Slave)&mock_slave_dummy;
+static int mock_open_connections = 0;
+static int mock_asdu_count = 0;
+static int mock_io_count = 0;
+static TypeID mock_last_type = 0;
+
+int CS104_Slave_getOpenConnections(CS104_Slave self) {
+    (void)self;
+    return mock_open_connections;
+}
+
+CS101_AppLayerParameters CS104_Slave_getAppLayerParameters(CS104_Slave self) {
+    (void)self;
+    return alParameters;
+}
+
+void CS104_Slave_enqueueASDU(CS104_Slave self, CS101_ASDU asdu) {
+    (void)self;
+    mock_asdu_count++;
+    mock_io_count += CS101_ASDU_getNumberOfElements(asdu);
+    mock_last_type = CS101_ASDU_getTypeID(asdu);
+}
+
+int CS104_Slave_getNumberOfQueueEntries(CS104_Slave self, CS104_RedundancyGroup redGroup) {
+    (void)self;
+    (void)redGroup;
+    return 0;
+}
+
+static void reset_mock(void) {
+    mock_asdu_count = 0;
+    mock_io_count = 0;
+    mock_last_type = 0;
+}
+
+static bool load(const char* json) {
+    init_data_contexts();
+    bool ok = parse_config_from_json(json);
+    if (!ok) {
+        cleanup_data_contexts();
+    }
+    return ok;
+}
+
+static TypeID send_float(int ioa, float value) {
+    DataValue v;
+    memset(&v, 0, sizeof(v));
+    v.type = DATA_VALUE_TYPE_FLOAT;
+    v.value.float_val = value;
+    v.has_quality = true;
+    v.quality = IEC60870_QUALITY_GOOD;
+    return update_data_send_type(get_data_context(M_ME_NC_1), mock_slave, ioa, &v);
+}
+
+static TypeID send_bool(TypeID type, int ioa, bool value) {
+    DataValue v;
+    memset(&v, 0, sizeof(v));
+    v.type = DATA_VALUE_TYPE_BOOL;
+    v.value.bool_val = value;
+    v.has_quality = true;
+    v.quality = IEC60870_QUALITY_GOOD;
+    v.has_timestamp = get_data_type_info(type)->has_time_tag;
+    return update_data_send_type(get_data_context(type), mock_slave, ioa, &v);
+}
+
+void test_rate_limited() {
+    printf("\nTesting rate_limited policy (default)...\n");
+
+    // IOA 3 has no rate limit of its own
+    assert(load("{\"M_ME_NC_1_config\": [[1, 3]], \"M_SP_TB_1_config\": [20], \"M_ME_ND_1_config\": [30],"
+                " \"offline\": [{\"type\": \"M_ME_NC_1\", \"ioas\": [3], \"interval_ms\": 0}]}"));
+
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    assert(ctx->offline->policy == OFFLINE_POLICY_RATE_LIMITED);
+    assert(ctx->offline->interval_ms == 3600 * 1000);
+
+    mock_open_connections = 1;
+    assert(send_float(1, 1.0f) == M_ME_NC_1);
+    assert(send_float(1, 1.0f) == 0);               // Unchanged
+    printf("  ✓ connected: own type\n");
+
+    mock_open_connections = 0;
+    assert(send_float(1, 2.0f) == M_ME_TF_1);
+    assert(send_float(1, 3.0f) == 0);
+    assert(send_float(2, 1.0f) == M_ME_TF_1);       // Own rate limit per point
+    assert(send_float(3, 1.0f) == M_ME_TF_1);
+    assert(send_float(3, 2.0f) == M_ME_TF_1);
+    assert(ctx->offline->stats.queued == 4);
+    assert(ctx->offline->stats.dropped == 1);
+    assert(ctx->data_array[0].value.float_val == 3.0f);   // Stored even when dropped
+    printf("  ✓ offline: offline type, once per interval, per-point interval\n");
+
+    assert(send_bool(M_SP_TB_1, 20, true) == M_SP_TB_1);
+    assert(send_bool(M_SP_TB_1, 20, false) == 0);
+    printf("  ✓ time-tagged type keeps its type offline\n");
+
+    // No offline form: stored, never sent offline
+    DataValue v;
+    memset(&v, 0, sizeof(v));
+    v.type = DATA_VALUE_TYPE_FLOAT;
+    v.value.float_val = 5.0f;
+    assert(get_data_context(M_ME_ND_1)->offline == NULL);
+    assert(update_data_send_type(get_data_context(M_ME_ND_1), mock_slave, 30, &v) == 0);
+    printf("  ✓ M_ME_ND_1 not sent offline\n");
+
+    cleanup_data_contexts();
+}
+
+void test_history() {
+    printf("\nTesting history policy...\n");
+
+    assert(load("{\"M_SP_NA_1_config\": [[1, 2]],"
+                " \"offline\": [{\"type\": \"M_SP_NA_1\", \"policy\": \"history\"}]}"));
+
+    mock_open_connections = 0;
+    for (int i = 0; i < 10; i++) {
+        assert(send_bool(M_SP_NA_1, 1, i % 2 == 0) == M_SP_TB_1);
+    }
+    assert(get_data_context(M_SP_NA_1)->offline->stats.queued == 10);
+    printf("  ✓ every change queued as M_SP_TB_1\n");
+
+    cleanup_data_contexts();
+}
+
+void test_latest() {
+    printf("\nTesting latest policy...\n");
+
+    assert(load("{\"M_ME_NC_1_config\": [[1, 100]],"
+                " \"offline\": [{\"type\": \"M_ME_NC_1\", \"policy\": \"latest\"}]}"));
+
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    mock_open_connections = 0;
+    reset_mock();
+
+    for (int round = 0; round < 5; round++) {
+        for (int ioa = 1; ioa <= 50; ioa++) {
+            assert(send_float(ioa, (float)(round * 1000 + ioa)) == 0);
+        }
+    }
+    assert(offline_buffer_pending(ctx->offline) == 50);
+    assert(ctx->offline->stats.held == 250);
+    printf("  ✓ nothing queued offline, 50 points held\n");
+
+    // A newer value sent online supersedes the held one
+    mock_open_connections = 1;
+    assert(send_float(1, -1.0f) == M_ME_NC_1);
+    assert(offline_buffer_pending(ctx->offline) == 49);
+
+    assert(offline_send_pending(mock_slave) == 49);
+    assert(mock_io_count == 49);
+    assert(mock_asdu_count < 49);                   // Packed, not one ASDU per point
+    assert(mock_last_type == M_ME_TF_1);
+    assert(offline_buffer_pending(ctx->offline) == 0);
+    assert(ctx->offline->stats.flushed == 49);
+    printf("  ✓ flush sent 49 latest values in %d ASDUs\n", mock_asdu_count);
+
+    reset_mock();
+    assert(offline_send_pending(mock_slave) == 0);
+    assert(mock_asdu_count == 0);
+    printf("  ✓ second activation sends nothing\n");
+
+    char* json = offline_get_stats_json();
+    assert(json && strstr(json, "\"policy\":\"latest\"") && strstr(json, "\"flushed\":49"));
+    free(json);
+    printf("  ✓ stats JSON\n");
+
+    cleanup_data_contexts();
+}
+
+void test_coalesce_mode() {
+    printf("\nTesting coalescing queue mode...\n");
+
+    assert(!load("{\"M_ME_NC_1_config\": [1], \"offline_queue_mode\": \"lifo\"}"));
+
+    // M_ME_NB_1 keeps a rate limit of its own
+    assert(load("{\"M_ME_NC_1_config\": [[1, 10]], \"M_SP_NA_1_config\": [20], \"M_ME_NB_1_config\": [30],"
+                " \"M_IT_TB_1_config\": [40], \"offline_queue_mode\": \"coalesce\","
+                " \"offline\": [{\"type\": \"M_ME_NB_1\", \"policy\": \"rate_limited\"}]}"));
+
+    assert(get_data_context(M_ME_NC_1)->offline->policy == OFFLINE_POLICY_LATEST);
+    assert(get_data_context(M_SP_NA_1)->offline->policy == OFFLINE_POLICY_HISTORY);
+    assert(get_data_context(M_IT_TB_1)->offline->policy == OFFLINE_POLICY_HISTORY);
+    assert(get_data_context(M_ME_NB_1)->offline->policy == OFFLINE_POLICY_RATE_LIMITED);
+    printf("  ✓ analogues latest, digitals and counters history, entries override\n");
+
+    mock_open_connections = 0;
+    reset_mock();
+
+    // 1000 analogue changes and 10 digital ones during the outage
+    int queued = 0;
+    for (int i = 0; i < 100; i++) {
+        for (int ioa = 1; ioa <= 10; ioa++) {
+            queued += send_float(ioa, (float)(i + 1)) != 0;
+        }
+        if (i % 10 == 0) {
+            assert(send_bool(M_SP_NA_1, 20, (i / 10) % 2 == 0) == M_SP_TB_1);
+            queued++;
+        }
+    }
+    assert(queued == 10);
+
+    // A quality that turns bad is an event of its own
+    DataValue v;
+    memset(&v, 0, sizeof(v));
+    v.type = DATA_VALUE_TYPE_FLOAT;
+    v.value.float_val = 100.0f;
+    v.has_quality = true;
+    v.quality = IEC60870_QUALITY_INVALID;
+    assert(update_data_send_type(get_data_context(M_ME_NC_1), mock_slave, 3, &v) == M_ME_TF_1);
+    assert(offline_buffer_pending(get_data_context(M_ME_NC_1)->offline) == 9);
+    printf("  ✓ 1000 analogue changes held for 10 points, digitals and invalid quality queued\n");
+
+    mock_open_connections = 1;
+    assert(offline_send_pending(mock_slave) == 9);
+    assert(mock_asdu_count == 1);
+    printf("  ✓ catch-up in one ASDU\n");
+
+    cleanup_data_contexts();
+}
+
+void test_config_errors() {
+    printf("\nTesting offline config errors...\n");
+
+    const char* bad[] = {
+        "{\"M_ME_NC_1_config\": [1], \"offline\": [{\"type\": \"M_ME_NC_1\", \"policy\": \"forever\"}]}",
+        "{\"M_ME_NC_1_config\": [1], \"offline\": [{\"type\": \"M_XX_1\", \"policy\": \"latest\"}]}",
+        "{\"M_ME_NC_1_config\": [1], \"offline\": [{\"type\": \"M_ME_NC_1\"}]}",
+        "{\"M_ME_NC_1_config\": [1], \"offline\": [{\"type\": \"M_ME_NC_1\", \"ioas\": [1]}]}",
+        "{\"M_ME_NC_1_config\": [1], \"offline\": [{\"type\": \"M_ME_NC_1\", \"policy\": \"latest\", \"ioas\": [1], \"interval_ms\": 5}]}",
+        "{\"M_ME_NC_1_config\": [1], \"offline\": [{\"type\": \"M_ME_NC_1\", \"policy\": \"history\", \"interval_ms\": -1}]}",
+        "{\"M_ME_ND_1_config\": [1], \"offline\": [{\"type\": \"M_ME_ND_1\", \"policy\": \"latest\"}]}"
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        assert(!load(bad[i]));
+    }
+    printf("  ✓ %zu invalid entries rejected\n", sizeof(bad) / sizeof(bad[0]));
+
+    // Types without points and unknown IOAs are skipped
+    assert(load("{\"M_ME_NC_1_config\": [1],"
+                " \"offline\": [{\"type\": \"M_SP_NA_1\", \"policy\": \"latest\"},"
+                " {\"type\": \"M_ME_NC_1\", \"ioas\": [1, 99], \"interval_ms\": 10}]}"));
+    assert(get_data_context(M_ME_NC_1)->offline->point_interval_ms[0] == 10);
+    cleanup_data_contexts();
+    printf("  ✓ empty types and unknown IOAs skipped\n");
+}
+
+void test_event_counts() {
+    printf("\nTesting events queued for a burst of offline updates...\n");
+
+    const char* policies[] = { "rate_limited", "latest", "history" };
+    int events[3];
+
+    for (int p = 0; p < 3; p++) {
+        char json[256];
+        snprintf(json, sizeof(json), "{\"M_ME_NC_1_config\": [[1, 1000]],"
+                 " \"offline\": [{\"type\": \"M_ME_NC_1\", \"policy\": \"%s\"}]}", policies[p]);
+        assert(load(json));
+
+        mock_open_connections = 0;
+        reset_mock();
+        events[p] = 0;
+
+        // 100 changes of each of 1000 points while offline
+        for (int round = 0; round < 100; round++) {
+            for (int ioa = 1; ioa <= 1000; ioa++) {
+                events[p] += send_float(ioa, (float)(round + 1)) != 0;
+            }
+        }
+
+        mock_open_connections = 1;
+        offline_send_pending(mock_slave);
+        events[p] += mock_io_count;
+
+        printf("  %-12s %6d events\n", policies[p], events[p]);
+        cleanup_data_contexts();
+    }
+
+    assert(events[0] == 1000);
+    assert(events[1] == 1000);
+    assert(events[2] == 100000);
+    printf("  ✓ rate_limited and latest bounded by the point count\n");
+}
+
+static TypeID race_result;
+
+static void* update_thread(void* arg) {
+    (void)arg;
+    race_result = send_float(7, 7.0f);
+    return NULL;
+}
+
+void test_activation_race() {
+    printf("\nTesting an update racing the flush on activation...\n");
+
+    assert(load("{\"M_ME_NC_1_config\": [[1, 10]],"
+                " \"offline\": [{\"type\": \"M_ME_NC_1\", \"policy\": \"latest\"}]}"));
+
+    DataTypeContext* ctx = get_data_context(M_ME_NC_1);
+    mock_open_connections = 0;
+    reset_mock();
+
+    // The flush holds the lock: an update that found no connection must
+    // not mark its value until the flush is over
+    offline_mark_lock();
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, update_thread, NULL) == 0);
+    usleep(50000);
+    assert(offline_buffer_pending(ctx->offline) == 0);
+
+    // The connection is open by the time the flush ends
+    mock_open_connections = 1;
+    offline_mark_unlock();
+    pthread_join(thread, NULL);
+
+    assert(race_result == M_ME_NC_1);
+    assert(offline_buffer_pending(ctx->offline) == 0);
+    printf("  ✓ update waits for the flush and is sent directly\n");
+
+    mock_open_connections = 0;
+    cleanup_data_contexts();
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running offline buffer test suite\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+
+    test_rate_limited();
+    test_history();
+    test_latest();
+    test_activation_race();
+    test_coalesce_mode();
+    test_config_errors();
+    test_event_counts();
+
+    printf("\n===========================================\n");
+    printf("✓ All offline buffer tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
@@ -0,0 +1,444 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+#include "../src/threads/periodic_sender.h"
+#include "../src/data/data_manager.h"
+#include "../src/data/data_types.h"
+#include "../src/protocol/packing_plan.h"
+#include "../cJSON/cJSON.h"
+
+// Mock global variables
+struct sCS101_AppLayerParameters alParams_struct;
+CS101_AppLayerParameters alParameters = &alParams_struct;
+int ASDU = 1;
+uint32_t offline_udt_time = 0;
+float deadband_M_ME_NC_1_percent = 0.0f;
+
+// Mock slave: counts enqueued ASDUs/IOs instead of talking to lib60870
+static int mock_slave_dummy;
+static CS104_Slave mock_slave = (CS104_Slave)&mock_slave_dummy;
+static int mock_open_connections = 1;
+static int mock_asdu_count = 0;
+static int mock_io_count = 0;
+static int mock_pending = 0;
+static uint64_t mock_enqueue_ms[256];
+static pthread_mutex_t mock_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int CS104_Slave_getOpenConnections(CS104_Slave self) {
+    (void)self;
+    return mock_open_connections;
+}
+
+CS101_AppLayerParameters CS104_Slave_getAppLayerParameters(CS104_Slave self) {
+    (void)self;
+    return alParameters;
+}
+
+void CS104_Slave_enqueueASDU(CS104_Slave self, CS101_ASDU asdu) {
+    (void)self;
+    pthread_mutex_lock(&mock_mutex);
+    if (mock_asdu_count < 256) {
+        mock_enqueue_ms[mock_asdu_count] = now_ms();
+    }
+    mock_asdu_count++;
+    mock_io_count += CS101_ASDU_getNumberOfElements(asdu);
+    mock_pending++;
+    pthread_mutex_unlock(&mock_mutex);
+}
+
+// The mock queue is fully drained after each sample, so the reported
+// occupancy is the number of ASDUs enqueued by one tick
+int CS104_Slave_getNumberOfQueueEntries(CS104_Slave self, CS104_RedundancyGroup redGroup) {
+    (void)self;
+    (void)redGroup;
+    pthread_mutex_lock(&mock_mutex);
+    int pending = mock_pending;
+    mock_pending = 0;
+    pthread_mutex_unlock(&mock_mutex);
+    return pending;
+}
+
+static void reset_mock(void) {
+    pthread_mutex_lock(&mock_mutex);
+    mock_asdu_count = 0;
+    mock_io_count = 0;
+    mock_pending = 0;
+    pthread_mutex_unlock(&mock_mutex);
+}
+
+static void configure_type(TypeID type_id, const int* ioas, int count) {
+    DataTypeContext* ctx = get_data_context(type_id);
+    ctx->config.ioa_list = (int*)malloc(count * sizeof(int));
+    memcpy(ctx->config.ioa_list, ioas, count * sizeof(int));
+    ctx->config.count = count;
+    ctx->data_array = (DataValue*)calloc(count, sizeof(DataValue));
+    for (int i = 0; i < count; i++) {
+        ctx->data_array[i].type = ctx->type_info->value_type;
+        ctx->data_array[i].has_quality = ctx->type_info->has_quality;
+    }
+}
+
+// Read one numeric field of a named group from the stats JSON
+static double get_group_stat(const char* group_name, const char* field) {
+    char* json_str = periodic_get_stats_json();
+    cJSON* json = cJSON_Parse(json_str);
+    free(json_str);
+
+    double result = -1;
+    cJSON* group = NULL;
+    cJSON_ArrayForEach(group, cJSON_GetObjectItem(json, "periodic_groups")) {
+        if (strcmp(cJSON_GetObjectItem(group, "name")->valuestring, group_name) == 0) {
+            result = cJSON_GetObjectItem(group, field)->valuedouble;
+        }
+    }
+
+    cJSON_Delete(json);
+    return result;
+}
+
+void test_add_group_resolves_ioas() {
+    printf("\nTesting periodic_add_group() IOA resolution...\n");
+
+    init_data_contexts();
+    int ioas[] = {1, 2, 3, 4, 5, 20};
+    configure_type(M_ME_NC_1, ioas, 6);
+
+    int group_ioas[] = {20, 3, 4, 99};
+    assert(periodic_add_group("subset", M_ME_NC_1, 1000, group_ioas, 4, PERIODIC_SPREAD_NONE) == true);
+    assert(periodic_add_group("all", M_ME_NC_1, 1000, NULL, 0, PERIODIC_SPREAD_NONE) == true);
+    assert(periodic_get_group_count() == 2);
+
+    // 99 is not configured and must be skipped
+    assert(get_group_stat("subset", "period_ms") == 1000);
+    assert(get_group_stat("subset", "cycles") == 0);
+
+    periodic_clear_groups();
+    assert(periodic_get_group_count() == 0);
+    cleanup_data_contexts();
+
+    printf("  ✓ Group IOAs resolved, unknown IOAs skipped\n");
+}
+
+void test_add_group_duplicate_ioas() {
+    printf("\nTesting periodic group with duplicate IOAs...\n");
+
+    init_data_contexts();
+    int ioas[] = {1, 2, 3, 4, 5, 20};
+    configure_type(M_ME_NC_1, ioas, 6);
+
+    PeriodicGroupList list = { NULL, 0, 0 };
+    int group_ioas[] = {4, 20, 3, 4, 20, 4};
+    assert(periodic_stage_group(&list, g_data_contexts, "dup", M_ME_NC_1, 1000,
+                                group_ioas, 6, PERIODIC_SPREAD_NONE));
+    assert(list.count == 1);
+
+    // Each IOA once, in config order
+    const PeriodicGroup* group = &list.groups[0];
+    assert(group->count == 3);
+    assert(group->indices[0] == 2);
+    assert(group->indices[1] == 3);
+    assert(group->indices[2] == 5);
+
+    periodic_free_groups(&list);
+    cleanup_data_contexts();
+
+    printf("  ✓ Duplicate IOAs sent once per cycle\n");
+}
+
+void test_add_group_invalid() {
+    printf("\nTesting periodic_add_group() with invalid parameters...\n");
+
+    init_data_contexts();
+
+    assert(periodic_add_group("bad_period", M_ME_NC_1, 0, NULL, 0, PERIODIC_SPREAD_NONE) == false);
+    assert(periodic_add_group("bad_type", C_SC_NA_1, 1000, NULL, 0, PERIODIC_SPREAD_NONE) == false);
+    assert(periodic_add_group(NULL, M_ME_NC_1, 1000, NULL, 0, PERIODIC_SPREAD_NONE) == false);
+    assert(periodic_add_group("bad_spread", M_ME_NC_1, 1000, NULL, 0, -2) == false);
+    assert(periodic_get_group_count() == 0);
+
+    cleanup_data_contexts();
+
+    printf("  ✓ Invalid groups rejected\n");
+}
+
+void test_multi_rate_scheduling() {
+    printf("\nTesting multi-rate scheduling...\n");
+
+    init_data_contexts();
+    reset_mock();
+    mock_open_connections = 1;
+
+    int me_ioas[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    configure_type(M_ME_NC_1, me_ioas, 10);
+    int sp_ioas[] = {100, 200, 300};
+    configure_type(M_SP_NA_1, sp_ioas, 3);
+
+    int fast_ioas[] = {1, 2, 3};
+    assert(periodic_add_group("fast", M_ME_NC_1, 50, fast_ioas, 3, PERIODIC_SPREAD_NONE));
+    assert(periodic_add_group("slow", M_SP_NA_1, 250, NULL, 0, PERIODIC_SPREAD_NONE));
+
+    start_periodic_sender(mock_slave);
+    usleep(1020 * 1000);
+    stop_periodic_sender();
+
+    double fast_cycles = get_group_stat("fast", "cycles");
+    double slow_cycles = get_group_stat("slow", "cycles");
+    printf("  fast: %.0f cycles, slow: %.0f cycles, missed: %.0f/%.0f\n",
+           fast_cycles, slow_cycles,
+           get_group_stat("fast", "missed_deadlines"),
+           get_group_stat("slow", "missed_deadlines"));
+
+    // 1 s at 50 ms and 250 ms periods (allow some scheduling slack)
+    assert(fast_cycles >= 17 && fast_cycles <= 20);
+    assert(slow_cycles >= 3 && slow_cycles <= 4);
+
+    // fast: 3 consecutive IOAs -> one SQ=1 ASDU; slow: 3 scattered IOAs -> one SQ=0 ASDU
+    assert(mock_asdu_count == (int)(fast_cycles + slow_cycles));
+    assert(mock_io_count == (int)(fast_cycles * 3 + slow_cycles * 3));
+
+    periodic_clear_groups();
+    cleanup_data_contexts();
+
+    printf("  ✓ Each group cycles at its own rate\n");
+}
+
+void test_packing_plan() {
+    printf("\nTesting packing_plan_build()...\n");
+
+    PackingPlan plan;
+    memset(&plan, 0, sizeof(plan));
+
+    // Scattered points share one SQ=0 ASDU, the run 10..14 gets SQ=1
+    int ioas[] = {1, 3, 10, 11, 12, 13, 14, 20, 21, 30};
+    assert(packing_plan_build(&plan, ioas, NULL, 10, 8, 249));
+    assert(plan.count == 3);
+    assert(plan.chunks[0].start == 0 && plan.chunks[0].count == 2 && !plan.chunks[0].sequence);
+    assert(plan.chunks[1].start == 2 && plan.chunks[1].count == 5 && plan.chunks[1].sequence);
+    assert(plan.chunks[2].start == 7 && plan.chunks[2].count == 3 && !plan.chunks[2].sequence);
+
+    // Index list selecting 1, 10, 11, 12 out of the same IOAs
+    int indices[] = {0, 2, 3, 4};
+    assert(packing_plan_build(&plan, ioas, indices, 4, 8, 249));
+    assert(plan.count == 2);
+    assert(plan.chunks[1].start == 1 && plan.chunks[1].count == 3 && plan.chunks[1].sequence);
+
+    // SQ=1 runs are split at 127 objects (VSQ limit), SQ=0 at the ASDU size
+    int run[300];
+    for (int i = 0; i < 300; i++) run[i] = 1000 + i;
+    assert(packing_plan_build(&plan, run, NULL, 300, 4, 249));
+    assert(plan.count == 3);
+    assert(plan.chunks[0].count == 127 && plan.chunks[2].count == 46);
+
+    for (int i = 0; i < 300; i++) run[i] = 1000 + i * 2;
+    assert(packing_plan_build(&plan, run, NULL, 300, 8, 249));
+    assert(plan.count == 10);   // (249 - 6) / 8 = 30 objects per ASDU
+    assert(plan.chunks[0].count == 30 && !plan.chunks[0].sequence);
+    assert(plan.points == 300);
+
+    packing_plan_free(&plan);
+    assert(plan.chunks == NULL && plan.count == 0);
+
+    printf("  ✓ Points packed into the minimum number of ASDUs\n");
+}
+
+void test_spread_ticks() {
+    printf("\nTesting spread transmission...\n");
+
+    init_data_contexts();
+    reset_mock();
+    mock_open_connections = 1;
+
+    // Five runs of three consecutive IOAs -> five SQ=1 ASDUs
+    int ioas[15];
+    for (int i = 0; i < 15; i++) ioas[i] = (i / 3) * 100 + (i % 3);
+    configure_type(M_SP_NA_1, ioas, 15);
+    configure_type(M_ME_NC_1, ioas, 15);
+
+    assert(periodic_add_group("spread", M_SP_NA_1, 500, NULL, 0, PERIODIC_SPREAD_AUTO));
+    assert(periodic_add_group("burst", M_ME_NC_1, 500, NULL, 0, PERIODIC_SPREAD_NONE));
+
+    start_periodic_sender(mock_slave);
+    usleep(980 * 1000);
+    stop_periodic_sender();
+
+    assert(get_group_stat("spread", "asdus_per_cycle") == 5);
+    assert(get_group_stat("spread", "spread_ticks") == 5);
+    assert(get_group_stat("spread", "cycles") == 1);
+    assert(get_group_stat("burst", "spread_ticks") == 1);
+    assert(get_group_stat("burst", "cycles") == 1);
+
+    // Burst: all 5 ASDUs in one tick; spread: one ASDU per 100 ms tick
+    printf("  queue hwm: burst=%.0f, spread=%.0f\n",
+           get_group_stat("burst", "queue_hwm"), get_group_stat("spread", "queue_hwm"));
+    assert(get_group_stat("burst", "queue_hwm") == 5);
+    assert(get_group_stat("spread", "queue_hwm") == 1);
+    assert(mock_asdu_count == 10);
+
+    // The spread ASDUs are the ones not sent in the burst at t=500 ms
+    uint64_t burst_time = mock_enqueue_ms[0];
+    int late = 0;
+    uint64_t last = 0;
+    for (int i = 0; i < mock_asdu_count; i++) {
+        if (mock_enqueue_ms[i] - burst_time < 50) continue;
+        if (last) {
+            uint64_t gap = mock_enqueue_ms[i] - last;
+            assert(gap >= 80 && gap <= 120);
+        }
+        last = mock_enqueue_ms[i];
+        late++;
+    }
+    assert(late == 4);
+
+    periodic_clear_groups();
+    cleanup_data_contexts();
+
+    printf("  ✓ ASDUs distributed evenly across the period\n");
+}
+
+#define LATENCY_POINTS 50000
+
+static volatile bool updater_running = false;
+static uint64_t updater_max_us = 0;
+static uint64_t updater_calls = 0;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Simulates the stdin handler: continuous updates on random IOAs
+static void* updater_thread(void* arg) {
+    DataTypeContext* ctx = (DataTypeContext*)arg;
+    DataValue value;
+    memset(&value, 0, sizeof(value));
+    value.type = DATA_VALUE_TYPE_FLOAT;
+    unsigned int seed = 1;
+
+    while (updater_running) {
+        int ioa = 1 + rand_r(&seed) % LATENCY_POINTS;
+        value.value.float_val += 1.0f;
+
+        uint64_t start = now_us();
+        update_data(ctx, mock_slave, ioa, &value);
+        uint64_t latency = now_us() - start;
+
+        if (latency > updater_max_us) updater_max_us = latency;
+        updater_calls++;
+    }
+    return NULL;
+}
+
+void test_update_latency_during_cycle() {
+    printf("\nTesting update_data() latency during a %d-point cycle...\n", LATENCY_POINTS);
+
+    init_data_contexts();
+    reset_mock();
+    mock_open_connections = 1;
+
+    int* ioas = (int*)malloc(LATENCY_POINTS * sizeof(int));
+    for (int i = 0; i < LATENCY_POINTS; i++) ioas[i] = i + 1;
+    configure_type(M_ME_NC_1, ioas, LATENCY_POINTS);
+    free(ioas);
+
+    assert(periodic_add_group("bulk", M_ME_NC_1, 100, NULL, 0, PERIODIC_SPREAD_NONE));
+
+    updater_running = true;
+    updater_max_us = 0;
+    updater_calls = 0;
+    pthread_t updater;
+    pthread_create(&updater, NULL, updater_thread, get_data_context(M_ME_NC_1));
+
+    start_periodic_sender(mock_slave);
+    usleep(1050 * 1000);
+    stop_periodic_sender();
+
+    updater_running = false;
+    pthread_join(updater, NULL);
+
+    double cycles = get_group_stat("bulk", "cycles");
+    double max_cycle_us = get_group_stat("bulk", "max_cycle_us");
+    double max_lock_us = get_group_stat("bulk", "max_lock_us");
+    printf("  cycles: %.0f, max cycle: %.0f us, max lock: %.0f us, updates: %llu, worst update_data(): %llu us\n",
+           cycles, max_cycle_us, max_lock_us, (unsigned long long)updater_calls,
+           (unsigned long long)updater_max_us);
+
+    assert(cycles >= 5);
+    assert(mock_io_count == (int)cycles * LATENCY_POINTS);
+
+    // The mutex is only held for the snapshot copy, not the whole encode cycle
+    assert(max_lock_us < max_cycle_us / 4);
+
+    // With a single CPU the updater also waits for the sender's time slice,
+    // so the end-to-end latency is only meaningful on multi-core machines
+    if (sysconf(_SC_NPROCESSORS_ONLN) > 1) {
+        assert(updater_max_us < max_cycle_us / 4);
+    }
+
+    periodic_clear_groups();
+    cleanup_data_contexts();
+
+    printf("  ✓ update_data() not blocked by periodic encoding\n");
+}
+
+void test_no_send_without_client() {
+    printf("\nTesting periodic sending without connected client...\n");
+
+    init_data_contexts();
+    reset_mock();
+    mock_open_connections = 0;
+
+    int ioas[] = {1, 2, 3};
+    configure_type(M_ME_NC_1, ioas, 3);
+    assert(periodic_add_group("offline", M_ME_NC_1, 20, NULL, 0, PERIODIC_SPREAD_NONE));
+
+    start_periodic_sender(mock_slave);
+    usleep(200 * 1000);
+    stop_periodic_sender();
+
+    assert(mock_asdu_count == 0);
+    assert(get_group_stat("offline", "cycles") == 0);
+    assert(get_group_stat("offline", "missed_deadlines") == 0);
+
+    periodic_clear_groups();
+    cleanup_data_contexts();
+    mock_open_connections = 1;
+
+    printf("  ✓ Nothing sent while no client is connected\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running periodic sender test suite\n");
+    printf("===========================================\n");
+
+    alParameters->maxSizeOfASDU = 249;
+    alParameters->sizeOfCOT = 2;
+    alParameters->sizeOfCA = 2;
+    alParameters->sizeOfIOA = 3;
+    alParameters->originatorAddress = 0;
+
+    test_add_group_resolves_ioas();
+    test_add_group_duplicate_ioas();
+    test_add_group_invalid();
+    test_multi_rate_scheduling();
+    test_packing_plan();
+    test_spread_ticks();
+    test_update_latency_during_cycle();
+    test_no_send_without_client();
+
+    printf("\n===========================================\n");
+    printf("✓ All periodic sender tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
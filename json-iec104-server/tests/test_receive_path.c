@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include "cs104_slave.h"
+
+/**
+ * Slave receive path benchmark
+ *
+ * A master on loopback sends bursts of TESTFR and I-frames (C_IC_NA_1) to a real
+ * CS104 slave. The test checks that every frame is handled, including frames split
+ * across TCP writes, and reports how many frames the slave gets per recv() call and
+ * the CPU time per 10k received APDUs. The per-connection statistics must account
+ * for every frame and byte of the burst.
+ *
+ * recv() is wrapped at link time (-Wl,--wrap=recv) to count the slave's socket reads;
+ * the master side uses read()/write() so it is not counted.
+ */
+
+#define TEST_PORT 22471
+#define NUM_FRAMES 10000
+#define WRITE_CHUNK 997         // Odd size so that frames are split across writes
+#define TIMEOUT_MS 30000
+
+static const unsigned char STARTDT_ACT[] = { 0x68, 0x04, 0x07, 0x00, 0x00, 0x00 };
+static const unsigned char TESTFR_ACT[] = { 0x68, 0x04, 0x43, 0x00, 0x00, 0x00 };
+
+static volatile int recv_calls = 0;
+static volatile int slave_frames = 0;
+static IMasterConnection slave_connection = NULL;
+
+// Counted by the reader thread
+static volatile int testfr_con_received = 0;
+static volatile int last_s_frame_nr = -1;
+static volatile bool reader_running = false;
+
+ssize_t __real_recv(int fd, void* buf, size_t len, int flags);
+
+ssize_t __wrap_recv(int fd, void* buf, size_t len, int flags) {
+    __atomic_add_fetch(&recv_calls, 1, __ATOMIC_RELAXED);
+    return __real_recv(fd, buf, len, flags);
+}
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static double cpu_seconds(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static void raw_message_handler(void* parameter, IMasterConnection connection,
+                                uint8_t* msg, int msgSize, bool sent) {
+    (void)parameter;
+    (void)msgSize;
+
+    slave_connection = connection;
+
+    if (!sent && msg[0] == 0x68) {
+        __atomic_add_fetch(&slave_frames, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Accept the command without sending a response, so only S-frames come back
+static bool interrogation_handler(void* parameter, IMasterConnection connection,
+                                  CS101_ASDU asdu, uint8_t qoi) {
+    (void)parameter;
+    (void)connection;
+    (void)asdu;
+    (void)qoi;
+    return true;
+}
+
+static void write_all(int fd, const unsigned char* data, int len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("write");
+            assert(false);
+        }
+        data += n;
+        len -= (int)n;
+    }
+}
+
+static void* reader_thread(void* parameter) {
+    int fd = *(int*)parameter;
+    unsigned char buf[4096];
+    int len = 0;
+
+    while (reader_running) {
+        ssize_t n = read(fd, buf + len, sizeof(buf) - len);
+        if (n <= 0) break;
+        len += (int)n;
+
+        int pos = 0;
+        while (len - pos >= 2 && len - pos >= buf[pos + 1] + 2) {
+            const unsigned char* apdu = buf + pos;
+
+            if (apdu[2] == 0x83) {
+                __atomic_add_fetch(&testfr_con_received, 1, __ATOMIC_RELAXED);
+            }
+            else if (apdu[2] == 0x01) {
+                last_s_frame_nr = (apdu[4] >> 1) + (apdu[5] << 7);
+            }
+            pos += apdu[1] + 2;
+        }
+        memmove(buf, buf + pos, len - pos);
+        len -= pos;
+    }
+
+    return NULL;
+}
+
+static int open_master(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+/**
+ * Build the burst: every fourth frame is a TESTFR, the others are I-frames
+ * @return number of bytes in the stream
+ */
+static int build_stream(unsigned char* stream, int* testfr_count, int* iframe_count) {
+    int pos = 0;
+    *testfr_count = 0;
+    *iframe_count = 0;
+
+    for (int i = 0; i < NUM_FRAMES; i++) {
+        if (i % 4 == 0) {
+            memcpy(stream + pos, TESTFR_ACT, sizeof(TESTFR_ACT));
+            pos += sizeof(TESTFR_ACT);
+            (*testfr_count)++;
+        } else {
+            int ns = *iframe_count % 32768;
+            unsigned char iframe[] = {
+                0x68, 0x0e, (unsigned char)((ns & 0x7f) << 1), (unsigned char)(ns >> 7), 0x00, 0x00,
+                0x64, 0x01, 0x06, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x14
+            };
+            memcpy(stream + pos, iframe, sizeof(iframe));
+            pos += sizeof(iframe);
+            (*iframe_count)++;
+        }
+    }
+
+    return pos;
+}
+
+static void run_receive_test(const char* mode, int reactor_threads) {
+    printf("\nTesting %d received APDUs (%s)...\n", NUM_FRAMES, mode);
+
+    CS104_Slave slave = CS104_Slave_create(100, 100);
+    assert(slave != NULL);
+
+    CS104_Slave_setLocalAddress(slave, "127.0.0.1");
+    CS104_Slave_setLocalPort(slave, TEST_PORT);
+    CS104_Slave_setServerMode(slave, CS104_MODE_SINGLE_REDUNDANCY_GROUP);
+    CS104_Slave_setInterrogationHandler(slave, interrogation_handler, NULL);
+    CS104_Slave_setRawMessageHandler(slave, raw_message_handler, NULL);
+
+    if (reactor_threads > 0) {
+        assert(CS104_Slave_setReactorThreads(slave, reactor_threads, false));
+    }
+
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    int fd = open_master();
+
+    slave_frames = 0;
+    slave_connection = NULL;
+    testfr_con_received = 0;
+    last_s_frame_nr = -1;
+    reader_running = true;
+
+    pthread_t reader;
+    assert(pthread_create(&reader, NULL, reader_thread, &fd) == 0);
+
+    write_all(fd, STARTDT_ACT, sizeof(STARTDT_ACT));
+
+    uint64_t deadline = now_ms() + TIMEOUT_MS;
+    while (slave_frames < 1 && now_ms() < deadline) {
+        usleep(1000);
+    }
+
+    unsigned char* stream = (unsigned char*)malloc(NUM_FRAMES * 16);
+    assert(stream != NULL);
+
+    int testfr_count, iframe_count;
+    int stream_len = build_stream(stream, &testfr_count, &iframe_count);
+
+    slave_frames = 0;
+    recv_calls = 0;
+    double cpu_start = cpu_seconds();
+
+    for (int pos = 0; pos < stream_len; pos += WRITE_CHUNK) {
+        int len = (stream_len - pos < WRITE_CHUNK) ? stream_len - pos : WRITE_CHUNK;
+        write_all(fd, stream + pos, len);
+    }
+
+    deadline = now_ms() + TIMEOUT_MS;
+    while ((slave_frames < NUM_FRAMES || testfr_con_received < testfr_count) && now_ms() < deadline) {
+        usleep(1000);
+    }
+
+    double cpu_used = cpu_seconds() - cpu_start;
+    int calls = recv_calls;
+
+    printf("  Slave handled %d/%d APDUs, %d TESTFR_CON received\n",
+           slave_frames, NUM_FRAMES, testfr_con_received);
+    printf("  %d recv() calls, %.1f APDUs per call\n", calls, (double)NUM_FRAMES / (calls ? calls : 1));
+    printf("  CPU: %.1f ms per 10k APDUs (master and slave)\n", cpu_used * 1000.0 * 10000.0 / NUM_FRAMES);
+
+    assert(slave_frames == NUM_FRAMES);
+    assert(testfr_con_received == testfr_count);
+    assert(calls > 0 && calls < NUM_FRAMES);
+
+    // The slave acknowledges I-frames every w (= 8) frames
+    int expected_nr = iframe_count - iframe_count % 8;
+    deadline = now_ms() + TIMEOUT_MS;
+    while (last_s_frame_nr < expected_nr && now_ms() < deadline) {
+        usleep(1000);
+    }
+    assert(last_s_frame_nr >= expected_nr);
+
+    CS104_ConnectionStatistics stats;
+    assert(slave_connection != NULL);
+    CS104_Slave_getConnectionStatistics(slave, slave_connection, &stats);
+
+    printf("  Stats: I rx %llu, U rx %llu, U tx %llu, S tx %llu, %llu bytes rx\n",
+           (unsigned long long)stats.iFramesReceived, (unsigned long long)stats.uFramesReceived,
+           (unsigned long long)stats.uFramesSent, (unsigned long long)stats.sFramesSent,
+           (unsigned long long)stats.bytesReceived);
+
+    assert(stats.iFramesReceived == (uint64_t)iframe_count);
+    assert(stats.uFramesReceived == (uint64_t)testfr_count + 1);    // + STARTDT_ACT
+    assert(stats.uFramesSent == (uint64_t)testfr_count + 1);        // + STARTDT_CON
+    assert(stats.sFramesSent >= (uint64_t)(iframe_count / 8));
+    assert(stats.bytesReceived == (uint64_t)stream_len + sizeof(STARTDT_ACT));
+    assert(stats.iFramesSent == 0 && stats.kWindowOccupancy == 0);
+
+    reader_running = false;
+    shutdown(fd, SHUT_RDWR);
+    pthread_join(reader, NULL);
+    close(fd);
+    free(stream);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    printf("  ✓ %s receives bursts correctly\n", mode);
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running receive path test suite\n");
+    printf("===========================================\n");
+
+    run_receive_test("thread mode", 0);
+    run_receive_test("reactor mode", 1);
+
+    printf("\n===========================================\n");
+    printf("✓ All receive path tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+#include "../src/protocol/select_table.h"
+
+/**
+ * Select table tests
+ *
+ * Select, execute, reselect, deactivation, expiry, capacity limit and
+ * connection close cleanup, then compares the cost of a select/execute pair
+ * with a few pending selects against tens of thousands.
+ */
+
+// Only the pointer identity of a connection is used by the table
+static struct sIMasterConnection con_a, con_b;
+#define CON_A (&con_a)
+#define CON_B (&con_b)
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void test_store_and_take() {
+    printf("\nTesting select / execute...\n");
+
+    assert(select_table_init(16, 5000));
+
+    // Execute without select
+    assert(select_table_take(CON_A, C_SC_NA_1, 100) == false);
+
+    assert(select_table_store(CON_A, C_SC_NA_1, 100));
+    // Different connection, type or IOA do not match
+    assert(select_table_take(CON_B, C_SC_NA_1, 100) == false);
+    assert(select_table_take(CON_A, C_SE_NC_1, 100) == false);
+    assert(select_table_take(CON_A, C_SC_NA_1, 101) == false);
+
+    // Execute consumes the select
+    assert(select_table_take(CON_A, C_SC_NA_1, 100) == true);
+    assert(select_table_take(CON_A, C_SC_NA_1, 100) == false);
+
+    // Reselect does not take a second entry
+    assert(select_table_store(CON_A, C_SE_NC_1, 200));
+    assert(select_table_store(CON_A, C_SE_NC_1, 200));
+
+    SelectTableStats stats;
+    select_table_get_stats(&stats);
+    assert(stats.active == 1);
+    assert(stats.capacity == 16);
+    assert(stats.selects == 3);
+    assert(stats.executes == 1);
+
+    // Deactivation
+    select_table_clear(CON_A, C_SE_NC_1, 200);
+    assert(select_table_take(CON_A, C_SE_NC_1, 200) == false);
+
+    select_table_cleanup();
+    printf("  ✓ select / execute work correctly\n");
+}
+
+void test_expiry() {
+    printf("\nTesting select timeout...\n");
+
+    assert(select_table_init(16, 200));
+
+    assert(select_table_store(CON_A, C_SC_NA_1, 1));
+    assert(select_table_store(CON_A, C_SC_NA_1, 2));
+    usleep(100 * 1000);
+    assert(select_table_take(CON_A, C_SC_NA_1, 1) == true);
+
+    // Restart the timeout of IOA 2 and let IOA 3 run out
+    assert(select_table_store(CON_A, C_SC_NA_1, 3));
+    assert(select_table_store(CON_A, C_SC_NA_1, 2));
+    usleep(150 * 1000);
+    assert(select_table_take(CON_A, C_SC_NA_1, 2) == true);
+    usleep(100 * 1000);
+    assert(select_table_take(CON_A, C_SC_NA_1, 3) == false);
+
+    SelectTableStats stats;
+    select_table_get_stats(&stats);
+    assert(stats.active == 0);
+    assert(stats.expired == 1);
+
+    // Expired selects free their entries for new ones
+    select_table_cleanup();
+    assert(select_table_init(4, 100));
+    for (int i = 0; i < 4; i++) {
+        assert(select_table_store(CON_A, C_SC_NA_1, i));
+    }
+    assert(select_table_store(CON_A, C_SC_NA_1, 10) == false);
+    usleep(200 * 1000);
+    for (int i = 10; i < 14; i++) {
+        assert(select_table_store(CON_A, C_SC_NA_1, i));
+    }
+
+    select_table_cleanup();
+    printf("  ✓ selects expire after the timeout\n");
+}
+
+void test_capacity() {
+    printf("\nTesting capacity limit...\n");
+
+    assert(select_table_init(8, 5000));
+
+    for (int i = 0; i < 8; i++) {
+        assert(select_table_store(CON_A, C_SC_NA_1, i));
+    }
+    assert(select_table_store(CON_B, C_SC_NA_1, 0) == false);
+
+    // A pending select can still be refreshed when the table is full
+    assert(select_table_store(CON_A, C_SC_NA_1, 3));
+
+    SelectTableStats stats;
+    select_table_get_stats(&stats);
+    assert(stats.active == 8);
+    assert(stats.rejected == 1);
+
+    assert(select_table_take(CON_A, C_SC_NA_1, 3));
+    assert(select_table_store(CON_B, C_SC_NA_1, 0));
+
+    select_table_cleanup();
+    printf("  ✓ capacity limit enforced\n");
+}
+
+void test_connection_closed() {
+    printf("\nTesting connection close cleanup...\n");
+
+    assert(select_table_init(64, 5000));
+
+    for (int i = 0; i < 20; i++) {
+        assert(select_table_store(CON_A, C_SC_NA_1, i));
+        assert(select_table_store(CON_B, C_SC_NA_1, i));
+    }
+
+    select_table_connection_closed(CON_A);
+
+    SelectTableStats stats;
+    select_table_get_stats(&stats);
+    assert(stats.active == 20);
+
+    for (int i = 0; i < 20; i++) {
+        assert(select_table_take(CON_A, C_SC_NA_1, i) == false);
+        assert(select_table_take(CON_B, C_SC_NA_1, i) == true);
+    }
+
+    select_table_connection_closed(NULL);
+    select_table_cleanup();
+    printf("  ✓ selects of a closed connection released\n");
+}
+
+// Average time of a select/execute pair with `pending` other selects in the table
+static double select_execute_ns(int pending) {
+    const int rounds = 200000;
+
+    assert(select_table_init(pending + 1, 60000));
+    for (int i = 0; i < pending; i++) {
+        assert(select_table_store(CON_B, C_SC_NA_1, i));
+    }
+
+    double start = now_s();
+    for (int i = 0; i < rounds; i++) {
+        select_table_store(CON_A, C_SE_NC_1, i % pending);
+        assert(select_table_take(CON_A, C_SE_NC_1, i % pending));
+    }
+    double ns = (now_s() - start) * 1e9 / rounds;
+
+    select_table_cleanup();
+    return ns;
+}
+
+void test_scaling() {
+    printf("\nTesting select / execute cost...\n");
+
+    double small = select_execute_ns(16);
+    double large = select_execute_ns(50000);
+
+    printf("  16 pending: %.0f ns, 50000 pending: %.0f ns per select/execute\n", small, large);
+
+    // Constant time: a linear table would be thousands of times slower
+    assert(large < small * 10 + 1000);
+    printf("  ✓ select / execute cost independent of table size\n");
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running select_table test suite\n");
+    printf("===========================================\n");
+
+    test_store_and_take();
+    test_expiry();
+    test_capacity();
+    test_connection_closed();
+    test_scaling();
+
+    printf("\n===========================================\n");
+    printf("✓ All select_table tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
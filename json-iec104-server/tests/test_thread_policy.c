@@ -0,0 +1,532 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "../src/config/config_parser.h"
+#include "../src/threads/thread_policy.h"
+#include "../src/utils/logger.h"
+#include "../cJSON/cJSON.h"
+#include "cs104_slave.h"
+#include "hal_thread.h"
+
+/**
+ * Thread policy tests
+ *
+ * Checks the "threads" configuration and its errors, the affinity each
+ * class applies to itself (and the return to the process affinity of an
+ * unconfigured class), SCHED_FIFO or its fallback without CAP_SYS_NICE,
+ * and that lib60870 connection, listener and reactor threads run the
+ * policy of their class through the hal_thread start handler.
+ *
+ * The benchmark enqueues one spontaneous ASDU at a time on a loopback slave
+ * and measures the time until the master has read it (enqueue-to-wire),
+ * reporting p50/p99/p999 with default scheduling and with the connection
+ * thread pinned (and SCHED_FIFO if permitted).
+ */
+
+// Mock global variables that config_parser expects
+struct sCS101_AppLayerParameters alParams_struct = { 1, 1, 2, 0, 2, 3, 249 };
+CS101_AppLayerParameters alParameters = &alParams_struct;
+uint32_t offline_udt_time = 3600;
+float deadband_M_ME_NC_1_percent = 0.0f;
+int ASDU = 1;
+char command_mode[64] = "";
+int tcpPort = 2404;
+char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+
+#define SLAVE_PORT 22474
+#define SAMPLES 2000
+// Thread per connection mostly waits out its socket timeout, fewer samples
+#define THREAD_MODE_SAMPLES 400
+#define TIMEOUT_MS 30000
+
+static const unsigned char STARTDT_ACT[] = { 0x68, 0x04, 0x07, 0x00, 0x00, 0x00 };
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// First CPU the process may run on
+static int allowed_cpu(void) {
+    cpu_set_t set;
+    assert(sched_getaffinity(0, sizeof(set), &set) == 0);
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &set)) return c;
+    }
+    assert(false);
+    return -1;
+}
+
+static int process_cpu_count(void) {
+    cpu_set_t set;
+    assert(sched_getaffinity(0, sizeof(set), &set) == 0);
+    return CPU_COUNT(&set);
+}
+
+static bool parse(const char* json) {
+    cJSON* root = cJSON_Parse(json);
+    assert(root != NULL);
+    bool ok = parse_global_settings(root);
+    cJSON_Delete(root);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Threads that apply a class and report what they got
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    ThreadClass thread_class;
+    bool applied;
+    int cpu_count;
+    int first_cpu;
+    int policy;
+} Probe;
+
+static void probe_record(Probe* p) {
+    cpu_set_t set;
+    assert(sched_getaffinity(0, sizeof(set), &set) == 0);
+    p->cpu_count = CPU_COUNT(&set);
+    p->first_cpu = -1;
+    for (int c = 0; c < CPU_SETSIZE && p->first_cpu < 0; c++) {
+        if (CPU_ISSET(c, &set)) p->first_cpu = c;
+    }
+    p->policy = sched_getscheduler(0);
+}
+
+static void* probe_thread(void* arg) {
+    Probe* p = (Probe*)arg;
+    p->applied = thread_policy_apply(p->thread_class);
+    probe_record(p);
+    return NULL;
+}
+
+static Probe run_probe(ThreadClass thread_class) {
+    Probe p;
+    memset(&p, 0, sizeof(p));
+    p.thread_class = thread_class;
+
+    pthread_t t;
+    assert(pthread_create(&t, NULL, probe_thread, &p) == 0);
+    pthread_join(t, NULL);
+    return p;
+}
+
+void test_config() {
+    printf("\nTesting threads configuration...\n");
+
+    thread_policy_reset();
+    assert(parse("{\"ASDU\": 1}"));
+    assert(!thread_policy_configured());
+
+    char json[256];
+    int cpu = allowed_cpu();
+    snprintf(json, sizeof(json),
+             "{\"threads\": {\"periodic\": {\"cpus\": [%d]}, \"connection\": {\"cpus\": [[%d, %d]], \"priority\": 0}}}",
+             cpu, cpu, cpu);
+    assert(parse(json));
+    assert(thread_policy_configured());
+    printf("  ✓ CPUs and ranges accepted\n");
+
+    assert(!parse("{\"threads\": {\"gui\": {\"cpus\": [0]}}}"));
+    assert(!parse("{\"threads\": [1]}"));
+    assert(!parse("{\"threads\": {\"input\": 1}}"));
+    assert(!parse("{\"threads\": {\"input\": {\"cpus\": []}}}"));
+    assert(!parse("{\"threads\": {\"input\": {\"cpus\": [-1]}}}"));
+    assert(!parse("{\"threads\": {\"input\": {\"cpus\": [[3, 2]]}}}"));
+    assert(!parse("{\"threads\": {\"input\": {\"cpus\": [1024]}}}"));
+    assert(!parse("{\"threads\": {\"input\": {\"cpus\": [\"0\"]}}}"));
+    assert(!parse("{\"threads\": {\"input\": {\"priority\": 100}}}"));
+    assert(!parse("{\"threads\": {\"input\": {\"priority\": -1}}}"));
+    printf("  ✓ Unknown classes, bad CPUs and priorities rejected\n");
+
+    ThreadClass c;
+    for (int i = 0; i < THREAD_CLASS_COUNT; i++) {
+        assert(thread_class_from_string(thread_class_to_string((ThreadClass)i), &c) && c == (ThreadClass)i);
+    }
+    assert(!thread_class_from_string(NULL, &c));
+    printf("  ✓ Class names round-trip\n");
+}
+
+void test_affinity() {
+    printf("\nTesting affinity per class...\n");
+
+    int cpu = allowed_cpu();
+    thread_policy_reset();
+    thread_policy_init();
+    assert(thread_policy_set(THREAD_CLASS_PERIODIC, &cpu, 1, 0));
+
+    Probe p = run_probe(THREAD_CLASS_PERIODIC);
+    assert(p.applied);
+    assert(p.cpu_count == 1 && p.first_cpu == cpu);
+    printf("  ✓ periodic thread pinned to CPU %d\n", cpu);
+
+    // A thread created by a pinned thread returns to the process CPUs
+    cpu_set_t saved, one;
+    assert(sched_getaffinity(0, sizeof(saved), &saved) == 0);
+    CPU_ZERO(&one);
+    CPU_SET(cpu, &one);
+    assert(sched_setaffinity(0, sizeof(one), &one) == 0);
+
+    p = run_probe(THREAD_CLASS_BACKGROUND);
+    assert(p.applied);
+    assert(p.cpu_count == process_cpu_count());
+    assert(sched_setaffinity(0, sizeof(saved), &saved) == 0);
+    printf("  ✓ unconfigured class does not inherit its creator's CPUs (%d CPU(s))\n", p.cpu_count);
+
+    // CPUs outside the machine are refused by the kernel; the thread keeps running
+    int missing = THREAD_POLICY_MAX_CPUS - 1;
+    assert(thread_policy_set(THREAD_CLASS_WORKER, &missing, 1, 0));
+    p = run_probe(THREAD_CLASS_WORKER);
+    p = run_probe(THREAD_CLASS_WORKER);
+    assert(!p.applied);
+
+    ThreadClassStats stats;
+    thread_policy_get_stats(THREAD_CLASS_WORKER, &stats);
+    assert(stats.started == 2 && stats.affinity_failed == 2);
+    printf("  ✓ failure counted per thread, warned once\n");
+
+    assert(!thread_policy_set(THREAD_CLASS_COUNT, NULL, 0, 0));
+    assert(!thread_policy_set(THREAD_CLASS_INPUT, NULL, 0, THREAD_POLICY_MAX_PRIORITY + 1));
+}
+
+void test_priority() {
+    printf("\nTesting SCHED_FIFO priority...\n");
+
+    thread_policy_reset();
+    assert(thread_policy_set(THREAD_CLASS_WORKER, NULL, 0, 10));
+
+    Probe p = run_probe(THREAD_CLASS_WORKER);
+    ThreadClassStats stats;
+    thread_policy_get_stats(THREAD_CLASS_WORKER, &stats);
+
+    if (p.applied) {
+        assert(p.policy == SCHED_FIFO);
+        assert(stats.priority_failed == 0);
+        printf("  ✓ worker thread runs SCHED_FIFO 10\n");
+    } else {
+        assert(p.policy == SCHED_OTHER);
+        assert(stats.priority_failed == 1);
+        printf("  ✓ not permitted here, worker thread keeps SCHED_OTHER\n");
+    }
+
+    // Unprioritised classes are put back to SCHED_OTHER
+    p = run_probe(THREAD_CLASS_BACKGROUND);
+    assert(p.applied && p.policy == SCHED_OTHER);
+}
+
+// ---------------------------------------------------------------------------
+// lib60870 threads
+// ---------------------------------------------------------------------------
+
+static Probe hal_probe;
+
+static void* hal_thread_function(void* parameter) {
+    (void)parameter;
+    probe_record(&hal_probe);
+    return NULL;
+}
+
+static int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+static void write_all(int fd, const unsigned char* data, int len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("write");
+            assert(false);
+        }
+        data += n;
+        len -= (int)n;
+    }
+}
+
+static void startdt(int fd) {
+    write_all(fd, STARTDT_ACT, sizeof(STARTDT_ACT));
+
+    unsigned char con[6];
+    int got = 0;
+    while (got < 6) {
+        ssize_t n = read(fd, con + got, 6 - got);
+        assert(n > 0);
+        got += (int)n;
+    }
+    assert(con[2] == 0x0b);
+}
+
+static CS104_Slave create_slave(int reactors) {
+    CS104_Slave slave = CS104_Slave_create(1000, 100);
+    assert(slave != NULL);
+
+    CS104_Slave_setLocalAddress(slave, "127.0.0.1");
+    CS104_Slave_setLocalPort(slave, SLAVE_PORT);
+    CS104_Slave_setServerMode(slave, CS104_MODE_SINGLE_REDUNDANCY_GROUP);
+
+    if (reactors > 0) {
+        assert(CS104_Slave_setReactorThreads(slave, reactors, false));
+    }
+    return slave;
+}
+
+void test_hal_start_handler() {
+    printf("\nTesting lib60870 threads...\n");
+
+    int cpu = allowed_cpu();
+    thread_policy_reset();
+    thread_policy_init();
+    assert(thread_policy_set(THREAD_CLASS_CONNECTION, &cpu, 1, 0));
+
+    // A classed hal_thread applies its policy before the start function
+    memset(&hal_probe, 0, sizeof(hal_probe));
+    Thread t = Thread_create(hal_thread_function, NULL, false);
+    Thread_setClass(t, "connection");
+    Thread_start(t);
+    Thread_destroy(t);
+    assert(hal_probe.cpu_count == 1 && hal_probe.first_cpu == cpu);
+
+    ThreadClassStats stats;
+    thread_policy_get_stats(THREAD_CLASS_CONNECTION, &stats);
+    assert(stats.started == 1);
+    printf("  ✓ hal_thread start handler applies the class\n");
+
+    // Thread per connection
+    CS104_Slave slave = create_slave(0);
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    int fd = connect_to(SLAVE_PORT);
+    startdt(fd);
+    close(fd);
+
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    thread_policy_get_stats(THREAD_CLASS_CONNECTION, &stats);
+    assert(stats.started == 2 && stats.affinity_failed == 0);
+    thread_policy_get_stats(THREAD_CLASS_LISTENER, &stats);
+    assert(stats.started == 1);
+    printf("  ✓ connection and listener threads of the slave\n");
+
+    // Reactor mode: the listener serves reactor 0, one more reactor thread
+    slave = create_slave(2);
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    thread_policy_get_stats(THREAD_CLASS_REACTOR, &stats);
+    assert(stats.started == 1);
+    thread_policy_get_stats(THREAD_CLASS_LISTENER, &stats);
+    assert(stats.started == 2);
+    printf("  ✓ reactor threads of the slave\n");
+
+    Thread_setStartHandler(NULL, NULL);
+}
+
+// ---------------------------------------------------------------------------
+// Enqueue-to-wire latency
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int fd;
+    unsigned char buf[4096];
+    int len;
+    int received_i;
+    int acked_i;
+} Master;
+
+// Read until the next I-frame, confirming every 8 like the slave's w
+static void master_wait_i_frame(Master* m, uint64_t deadline_ns) {
+    int target = m->received_i + 1;
+
+    while (m->received_i < target) {
+        assert(now_ns() < deadline_ns);
+
+        struct pollfd pfd = { m->fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) continue;
+
+        ssize_t n = read(m->fd, m->buf + m->len, sizeof(m->buf) - m->len);
+        assert(n > 0);
+        m->len += (int)n;
+
+        int pos = 0;
+        while (m->len - pos >= 2 && m->len - pos >= m->buf[pos + 1] + 2) {
+            if ((m->buf[pos + 2] & 0x01) == 0) {
+                m->received_i++;
+            }
+            pos += m->buf[pos + 1] + 2;
+        }
+        memmove(m->buf, m->buf + pos, m->len - pos);
+        m->len -= pos;
+    }
+
+    if (m->received_i - m->acked_i >= 8) {
+        unsigned char s[] = { 0x68, 0x04, 0x01, 0x00,
+                              (unsigned char)((m->received_i & 0x7f) << 1), (unsigned char)(m->received_i >> 7) };
+        write_all(m->fd, s, sizeof(s));
+        m->acked_i = m->received_i;
+    }
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    uint64_t p50, p99, p999, max;
+} Latency;
+
+static Latency measure_latency(int reactors, int count) {
+    CS104_Slave slave = create_slave(reactors);
+    CS101_AppLayerParameters al = CS104_Slave_getAppLayerParameters(slave);
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    Master m;
+    memset(&m, 0, sizeof(m));
+    m.fd = connect_to(SLAVE_PORT);
+    startdt(m.fd);
+
+    uint64_t* samples = (uint64_t*)malloc(count * sizeof(uint64_t));
+    assert(samples != NULL);
+    uint64_t deadline = now_ns() + (uint64_t)TIMEOUT_MS * 1000000;
+
+    for (int i = 0; i < count; i++) {
+        CS101_ASDU asdu = CS101_ASDU_create(al, false, CS101_COT_SPONTANEOUS, 0, 1, false, false);
+        InformationObject io = (InformationObject)MeasuredValueShort_create(NULL, 1000 + i, (float)i, IEC60870_QUALITY_GOOD);
+        CS101_ASDU_addInformationObject(asdu, io);
+        InformationObject_destroy(io);
+
+        uint64_t start = now_ns();
+        CS104_Slave_enqueueASDU(slave, asdu);
+        master_wait_i_frame(&m, deadline);
+        samples[i] = now_ns() - start;
+
+        CS101_ASDU_destroy(asdu);
+    }
+
+    close(m.fd);
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    qsort(samples, count, sizeof(uint64_t), compare_u64);
+    Latency l;
+    l.p50 = samples[count / 2];
+    l.p99 = samples[count * 99 / 100];
+    l.p999 = samples[count * 999 / 1000];
+    l.max = samples[count - 1];
+    free(samples);
+    return l;
+}
+
+static void print_latency(const char* label, Latency l) {
+    printf("  %-24s p50 %7.1f us  p99 %7.1f us  p999 %7.1f us  max %8.1f us\n", label,
+           l.p50 / 1000.0, l.p99 / 1000.0, l.p999 / 1000.0, l.max / 1000.0);
+}
+
+static void run_latency(const char* mode, int reactors, int count) {
+    printf("  %s (%d ASDUs):\n", mode, count);
+
+    thread_policy_reset();
+    thread_policy_init();
+    Latency unpinned = measure_latency(reactors, count);
+    print_latency("  default scheduling:", unpinned);
+
+    // Every lib60870 class on one CPU, with SCHED_FIFO if permitted
+    int cpu = allowed_cpu();
+    assert(thread_policy_set(THREAD_CLASS_CONNECTION, &cpu, 1, 50));
+    assert(thread_policy_set(THREAD_CLASS_LISTENER, &cpu, 1, 50));
+    assert(thread_policy_set(THREAD_CLASS_REACTOR, &cpu, 1, 50));
+    Latency pinned = measure_latency(reactors, count);
+
+    ThreadClassStats stats;
+    thread_policy_get_stats(reactors > 0 ? THREAD_CLASS_LISTENER : THREAD_CLASS_CONNECTION, &stats);
+    print_latency(stats.priority_failed ? "  pinned:" : "  pinned, SCHED_FIFO 50:", pinned);
+
+    assert(unpinned.p50 <= unpinned.p99 && unpinned.p99 <= unpinned.p999);
+    assert(pinned.p50 <= pinned.p99 && pinned.p99 <= pinned.p999);
+    assert(stats.started == 2 && stats.affinity_failed == 0);
+}
+
+/**
+ * A connection thread only looks at its queue between socket waits of up
+ * to 100 ms, which shows in the tail; reactors are woken by the enqueue.
+ */
+void test_latency_jitter() {
+    printf("\nTesting enqueue-to-wire latency (one ASDU at a time)...\n");
+
+    run_latency("thread per connection", 0, THREAD_MODE_SAMPLES);
+    run_latency("reactor mode", 1, SAMPLES);
+    printf("  ✓ All ASDUs delivered with both policies\n");
+
+    Thread_setStartHandler(NULL, NULL);
+    thread_policy_reset();
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running thread policy test suite\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+
+    test_config();
+    test_affinity();
+    test_priority();
+    test_hal_start_handler();
+    test_latency_jitter();
+
+    printf("\n===========================================\n");
+    printf("✓ All thread policy tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}
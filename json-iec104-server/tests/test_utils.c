@@ -3,6 +3,8 @@
 #include <string.h>
 #include "../src/utils/error_codes.h"
 #include "../src/utils/logger.h"
+#include "../src/utils/utils.h"
+#include <unistd.h>
 
 void test_error_code_to_string() {
     printf("\nTesting error_code_to_string()...\n");
@@ -106,6 +108,32 @@ void test_log_filtering() {
     printf("  ✓ Log filtering works correctly\n");
 }
 
+void test_monotonic_clock() {
+    printf("\nTesting monotonic clock...\n");
+
+    uint64_t ms = utils_monotonic_ms();
+    uint64_t us = utils_monotonic_us();
+    assert(us / 1000 >= ms);
+
+    usleep(20000);
+    assert(utils_monotonic_ms() - ms >= 20);
+    assert(utils_monotonic_us() - us >= 20000);
+
+    printf("  ✓ ms and us clocks advance together\n");
+}
+
+void test_next_pow2() {
+    printf("\nTesting utils_next_pow2()...\n");
+
+    assert(utils_next_pow2(0) == 1);
+    assert(utils_next_pow2(1) == 1);
+    assert(utils_next_pow2(3) == 4);
+    assert(utils_next_pow2(1024) == 1024);
+    assert(utils_next_pow2(1025) == 2048);
+
+    printf("  ✓ Rounds up to a power of two\n");
+}
+
 int main() {
     printf("===========================================\n");
     printf("Running utils test suite\n");
@@ -118,6 +146,8 @@ int main() {
     test_log_json();
     test_log_json_obj();
     test_log_filtering();
+    test_monotonic_clock();
+    test_next_pow2();
     
     printf("\n===========================================\n");
     printf("✓ All utils tests passed!\n");
@@ -0,0 +1,443 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "../src/config/config_parser.h"
+#include "../src/threads/thread_policy.h"
+#include "../src/utils/logger.h"
+#include "../cJSON/cJSON.h"
+#include "cs104_slave.h"
+
+/**
+ * Connection worker pool tests
+ *
+ * In reactor mode a fixed number of reactor threads serve all masters.
+ * Checks the "auto" pool size, that new connections go to the reactor with
+ * the fewest connections (also after one reactor lost all of its masters),
+ * that a master flooding its reactor cannot starve the other masters of
+ * that reactor, and that the thread count does not grow with the masters.
+ */
+
+// Mock global variables that config_parser expects
+struct sCS101_AppLayerParameters alParams_struct = { 1, 1, 2, 0, 2, 3, 249 };
+CS101_AppLayerParameters alParameters = &alParams_struct;
+uint32_t offline_udt_time = 3600;
+float deadband_M_ME_NC_1_percent = 0.0f;
+int ASDU = 1;
+char command_mode[64] = "";
+int tcpPort = 2404;
+char local_ip[64] = "0.0.0.0";
+int reactor_threads = 0;
+bool reactor_pin_threads = false;
+int max_connections = 0;
+char capture_file[256] = "";
+int capture_max_mb = 64;
+char event_output[256] = "";
+struct sCS104_APCIParameters apci_parameters = { 12, 8, 10, 15, 10, 20 };
+CS104_AckPolicy ack_policy = CS104_ACK_POLICY_IMMEDIATE;
+int ack_delay_ms = 50;
+int select_timeout_ms = 5000;
+int max_selects = 1024;
+bool async_commands = false;
+int command_timeout_ms = 10000;
+int max_pending_commands = 1024;
+char value_snapshot_file[256] = "";
+int value_snapshot_sync_ms = 0;
+bool value_snapshot_non_topical = true;
+
+#define SLAVE_PORT 22476
+#define MAX_MASTERS 64
+#define FLOOD_MS 2000
+#define PROBES 50
+// Round trip of a TESTFR while another master floods the same reactor
+#define MAX_PROBE_MS 500
+
+static const unsigned char STARTDT_ACT[] = { 0x68, 0x04, 0x07, 0x00, 0x00, 0x00 };
+static const unsigned char TESTFR_ACT[] = { 0x68, 0x04, 0x43, 0x00, 0x00, 0x00 };
+static const unsigned char S_FRAME[] = { 0x68, 0x04, 0x01, 0x00, 0x00, 0x00 };
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool parse(const char* json) {
+    cJSON* root = cJSON_Parse(json);
+    assert(root != NULL);
+    bool ok = parse_global_settings(root);
+    cJSON_Delete(root);
+    return ok;
+}
+
+static int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    assert(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    return fd;
+}
+
+static int local_port(int fd) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    assert(getsockname(fd, (struct sockaddr*)&addr, &len) == 0);
+    return ntohs(addr.sin_port);
+}
+
+static void write_all(int fd, const unsigned char* data, int len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("write");
+            assert(false);
+        }
+        data += n;
+        len -= (int)n;
+    }
+}
+
+// Send a U-frame and wait for its confirmation (control byte con)
+static void u_frame(int fd, const unsigned char* act, unsigned char con) {
+    write_all(fd, act, 6);
+
+    unsigned char buf[6];
+    int got = 0;
+    while (got < 6) {
+        ssize_t n = read(fd, buf + got, 6 - got);
+        assert(n > 0);
+        got += (int)n;
+    }
+    assert(buf[2] == con);
+}
+
+static int count_threads(void) {
+    DIR* dir = opendir("/proc/self/task");
+    assert(dir != NULL);
+
+    int count = 0;
+    struct dirent* e;
+    while ((e = readdir(dir)) != NULL) {
+        if (e->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Connections of the slave, by the port of the master
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    IMasterConnection connection;
+    int port;
+} OpenConnection;
+
+static OpenConnection open_connections[MAX_MASTERS];
+static pthread_mutex_t open_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void connection_event_handler(void* parameter, IMasterConnection connection, CS104_PeerConnectionEvent event) {
+    (void)parameter;
+
+    if (event != CS104_CON_EVENT_CONNECTION_OPENED && event != CS104_CON_EVENT_CONNECTION_CLOSED) {
+        return;
+    }
+
+    char addr[64];
+    IMasterConnection_getPeerAddress(connection, addr, sizeof(addr));
+    const char* colon = strrchr(addr, ':');
+    int port = colon ? atoi(colon + 1) : 0;
+
+    pthread_mutex_lock(&open_lock);
+    for (int i = 0; i < MAX_MASTERS; i++) {
+        if (event == CS104_CON_EVENT_CONNECTION_OPENED && open_connections[i].connection == NULL) {
+            open_connections[i].connection = connection;
+            open_connections[i].port = port;
+            break;
+        }
+        if (event == CS104_CON_EVENT_CONNECTION_CLOSED && open_connections[i].connection == connection) {
+            open_connections[i].connection = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&open_lock);
+}
+
+// Reactor serving the master connected from fd (after its STARTDT)
+static int reactor_of(CS104_Slave slave, int fd) {
+    int port = local_port(fd);
+    int reactor = -2;
+
+    pthread_mutex_lock(&open_lock);
+    for (int i = 0; i < MAX_MASTERS; i++) {
+        if (open_connections[i].connection && open_connections[i].port == port) {
+            CS104_ConnectionStatistics stats;
+            CS104_Slave_getConnectionStatistics(slave, open_connections[i].connection, &stats);
+            reactor = stats.reactor;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&open_lock);
+    return reactor;
+}
+
+// Wait until the slave counts the given number of connections on a reactor
+static bool wait_reactor_connections(CS104_Slave slave, int reactor, int expected) {
+    uint64_t deadline = now_ms() + 5000;
+    while (now_ms() < deadline) {
+        if (CS104_Slave_getReactorConnections(slave, reactor) == expected) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return false;
+}
+
+static CS104_Slave create_slave(int reactors) {
+    CS104_Slave slave = CS104_Slave_create(1000, 100);
+    assert(slave != NULL);
+
+    CS104_Slave_setLocalAddress(slave, "127.0.0.1");
+    CS104_Slave_setLocalPort(slave, SLAVE_PORT);
+    CS104_Slave_setServerMode(slave, CS104_MODE_SINGLE_REDUNDANCY_GROUP);
+    CS104_Slave_setMaxOpenConnections(slave, MAX_MASTERS);
+    CS104_Slave_setConnectionEventHandler(slave, connection_event_handler, NULL);
+
+    memset(open_connections, 0, sizeof(open_connections));
+    assert(CS104_Slave_setReactorThreads(slave, reactors, false));
+    return slave;
+}
+
+void test_config() {
+    printf("\nTesting reactor_threads configuration...\n");
+
+    assert(reactor_threads == 0);
+    assert(parse("{\"reactor_threads\": 3}"));
+    assert(reactor_threads == 3);
+    assert(parse("{\"reactor_threads\": \"auto\"}"));
+    assert(reactor_threads == REACTOR_THREADS_AUTO);
+    assert(parse("{\"reactor_threads\": 0}"));
+    assert(reactor_threads == 0);
+    printf("  ✓ Number, \"auto\" and 0 accepted\n");
+
+    assert(!parse("{\"reactor_threads\": -1}"));
+    assert(!parse("{\"reactor_threads\": \"all\"}"));
+    printf("  ✓ Negative numbers and other strings rejected\n");
+    reactor_threads = 0;
+
+    // "auto" resolves to the CPUs the reactor threads may use
+    cpu_set_t set;
+    assert(sched_getaffinity(0, sizeof(set), &set) == 0);
+    thread_policy_reset();
+    assert(thread_policy_cpu_count(THREAD_CLASS_REACTOR) == CPU_COUNT(&set));
+
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &set)) cpu++;
+    assert(thread_policy_set(THREAD_CLASS_REACTOR, &cpu, 1, 0));
+    assert(thread_policy_cpu_count(THREAD_CLASS_REACTOR) == 1);
+    thread_policy_reset();
+    printf("  ✓ \"auto\" = %d CPU(s) of the process, or the CPUs of the reactor class\n", CPU_COUNT(&set));
+}
+
+void test_least_loaded() {
+    printf("\nTesting connection assignment...\n");
+
+    CS104_Slave slave = create_slave(2);
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    int fds[6];
+    for (int i = 0; i < 6; i++) {
+        fds[i] = connect_to(SLAVE_PORT);
+        u_frame(fds[i], STARTDT_ACT, 0x0b);
+
+        // Counts never differ by more than one while connections are added
+        int a = CS104_Slave_getReactorConnections(slave, 0);
+        int b = CS104_Slave_getReactorConnections(slave, 1);
+        assert(a + b == i + 1);
+        assert(abs(a - b) <= 1);
+    }
+    assert(CS104_Slave_getReactorConnections(slave, 2) == -1);
+    printf("  ✓ 6 masters spread 3/3\n");
+
+    // Close every master of reactor 0
+    int closed = 0;
+    for (int i = 0; i < 6; i++) {
+        int reactor = reactor_of(slave, fds[i]);
+        assert(reactor == 0 || reactor == 1);
+        if (reactor == 0) {
+            close(fds[i]);
+            fds[i] = -1;
+            closed++;
+        }
+    }
+    assert(closed == 3);
+    assert(wait_reactor_connections(slave, 0, 0));
+    assert(CS104_Slave_getReactorConnections(slave, 1) == 3);
+
+    // Round robin would put every other new master on the busy reactor
+    for (int i = 0; i < 6; i++) {
+        if (fds[i] >= 0) continue;
+        fds[i] = connect_to(SLAVE_PORT);
+        u_frame(fds[i], STARTDT_ACT, 0x0b);
+        assert(reactor_of(slave, fds[i]) == 0);
+    }
+    assert(CS104_Slave_getReactorConnections(slave, 0) == 3);
+    assert(CS104_Slave_getReactorConnections(slave, 1) == 3);
+    printf("  ✓ After reactor 0 lost its masters, new masters go to reactor 0\n");
+
+    for (int i = 0; i < 6; i++) {
+        close(fds[i]);
+    }
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+
+    // Thread per connection has no reactors
+    slave = CS104_Slave_create(10, 10);
+    assert(CS104_Slave_getReactorConnections(slave, 0) == -1);
+    CS104_Slave_destroy(slave);
+}
+
+// ---------------------------------------------------------------------------
+// Fairness
+// ---------------------------------------------------------------------------
+
+static volatile bool flooding;
+static uint64_t flood_frames;
+
+static void* flood_thread(void* arg) {
+    int fd = *(int*)arg;
+    unsigned char burst[6 * 1024];
+    for (int i = 0; i < 1024; i++) {
+        memcpy(burst + i * 6, S_FRAME, 6);
+    }
+
+    while (flooding) {
+        ssize_t n = send(fd, burst, sizeof(burst), MSG_NOSIGNAL);
+        if (n <= 0) break;
+        flood_frames += (uint64_t)n / 6;
+    }
+    return NULL;
+}
+
+/**
+ * One reactor serves a master that sends S-frames as fast as it can and a
+ * second master that measures TESTFR round trips. The reactor reads a
+ * limited number of times from a connection before it serves the others.
+ */
+void test_fairness() {
+    printf("\nTesting fairness with a flooding master...\n");
+
+    CS104_Slave slave = create_slave(1);
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    int flooder = connect_to(SLAVE_PORT);
+    u_frame(flooder, STARTDT_ACT, 0x0b);
+    int prober = connect_to(SLAVE_PORT);
+    u_frame(prober, STARTDT_ACT, 0x0b);
+    assert(CS104_Slave_getReactorConnections(slave, 0) == 2);
+
+    flooding = true;
+    flood_frames = 0;
+    pthread_t t;
+    assert(pthread_create(&t, NULL, flood_thread, &flooder) == 0);
+    usleep(100000);
+
+    uint64_t worst = 0;
+    uint64_t total = 0;
+    for (int i = 0; i < PROBES; i++) {
+        uint64_t start = now_ms();
+        u_frame(prober, TESTFR_ACT, 0x83);
+        uint64_t rtt = now_ms() - start;
+        total += rtt;
+        if (rtt > worst) worst = rtt;
+        usleep(FLOOD_MS * 1000 / PROBES);
+    }
+
+    flooding = false;
+    shutdown(flooder, SHUT_RDWR);
+    pthread_join(t, NULL);
+
+    printf("  %d TESTFR round trips during %llu flood frames: avg %.1f ms, max %llu ms\n",
+           PROBES, (unsigned long long)flood_frames, (double)total / PROBES, (unsigned long long)worst);
+    assert(flood_frames > 0);
+    assert(worst < MAX_PROBE_MS);
+    printf("  ✓ Second master answered within %d ms\n", MAX_PROBE_MS);
+
+    close(flooder);
+    close(prober);
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+}
+
+void test_thread_count() {
+    printf("\nTesting threads per master...\n");
+
+    CS104_Slave slave = create_slave(2);
+    CS104_Slave_start(slave);
+    assert(CS104_Slave_isRunning(slave));
+
+    int fds[MAX_MASTERS];
+    fds[0] = connect_to(SLAVE_PORT);
+    u_frame(fds[0], STARTDT_ACT, 0x0b);
+    int with_one = count_threads();
+
+    for (int i = 1; i < MAX_MASTERS; i++) {
+        fds[i] = connect_to(SLAVE_PORT);
+        u_frame(fds[i], STARTDT_ACT, 0x0b);
+    }
+    int with_all = count_threads();
+    printf("  %d thread(s) with 1 master, %d with %d masters\n", with_one, with_all, MAX_MASTERS);
+    assert(with_all == with_one);
+    assert(CS104_Slave_getReactorConnections(slave, 0) == MAX_MASTERS / 2);
+    assert(CS104_Slave_getReactorConnections(slave, 1) == MAX_MASTERS / 2);
+    printf("  ✓ Thread count independent of the number of masters\n");
+
+    for (int i = 0; i < MAX_MASTERS; i++) {
+        close(fds[i]);
+    }
+    CS104_Slave_stop(slave);
+    CS104_Slave_destroy(slave);
+}
+
+int main() {
+    printf("===========================================\n");
+    printf("Running worker pool test suite\n");
+    printf("===========================================\n");
+
+    logger_init(LOG_LEVEL_ERROR);
+
+    test_config();
+    test_least_loaded();
+    test_fairness();
+    test_thread_count();
+
+    printf("\n===========================================\n");
+    printf("✓ All worker pool tests passed!\n");
+    printf("===========================================\n");
+
+    return 0;
+}